@@ -1,4 +1,10 @@
 #version 330 core
+// Variantes (ver ShaderVariants): tras #version se inyectan NUM_POINT_LIGHTS, HAS_DIFFUSE_MAP,
+// HAS_NORMAL_MAP, VIRTUAL_TEXTURE, FOG y SHADOWS, así que no hay ramas por material.
+#ifndef NUM_POINT_LIGHTS
+#define NUM_POINT_LIGHTS 0
+#endif
+
 out vec4 FragColor;
 
 struct PointLight {
@@ -33,44 +39,108 @@ in vec3 Normal;
 in vec3 Color;   
 in vec2 TexCoords;
 
+#ifdef HAS_DIFFUSE_MAP
 uniform sampler2D texture_diffuse1;
+#endif
+#ifdef HAS_NORMAL_MAP
 uniform sampler2D texture_normal1;
-uniform sampler2D texture_roughness1;
+#endif
 
 uniform vec3 viewPos;
 
+#ifdef VIRTUAL_TEXTURE
+// Textura virtual del terreno (ver VirtualTexture)
+uniform usampler2D vt_pageTable;  // Por página: ranura física (xy) y nivel residente (z); w = 0 si no hay
+uniform sampler2D vt_physical;    // Atlas de páginas con borde
+uniform vec4 vt_worldRect;        // xy: origen del mundo (x, z), zw: 1 / tamaño
+uniform vec4 vt_params;           // x: lado virtual, y: lado de página, z: borde, w: último nivel
+uniform float vt_physicalSize;    // Lado del atlas en texels
+#endif
+
 uniform SpotLight spotLight;
 
-uniform int numPointLights;
-uniform PointLight pointLights[10];
+#if NUM_POINT_LIGHTS > 0
+uniform PointLight pointLights[NUM_POINT_LIGHTS];
+#endif
+
+#ifdef FOG
+uniform vec3 fogColor;
+uniform float fogDensity;
+#endif
 
 uniform mat4 model; // si se necesita
 
+#ifdef HAS_NORMAL_MAP
+// Los normal maps se suben solo con XY (RG16F/RG8); Z se reconstruye con |n| = 1.
+vec3 sampleNormalMap(vec2 uv)
+{
+    vec2 xy = texture(texture_normal1, uv).rg * 2.0 - 1.0;
+    return vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+}
+
+#endif
+
+#ifdef VIRTUAL_TEXTURE
+// Traduce la posición del mundo a la página residente más fina y muestrea el atlas.
+vec3 sampleVirtualTexture(vec3 worldPos, vec3 fallback)
+{
+    vec2 uv = clamp((worldPos.xz - vt_worldRect.xy) * vt_worldRect.zw, vec2(0.0), vec2(0.99999));
+    vec2 texel = uv * vt_params.x;
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy)));
+    int level = int(clamp(floor(lod), 0.0, vt_params.w));
+
+    ivec2 page = ivec2(uv * float(textureSize(vt_pageTable, level).x));
+    uvec4 entry = texelFetch(vt_pageTable, page, level);
+    if (entry.w == 0u)
+        return fallback;
+
+    // Coordenadas dentro de la página que realmente está residente (puede ser más gruesa)
+    float residentPages = vt_params.x / vt_params.y / exp2(float(entry.z));
+    vec2 inPage = fract(uv * residentPages);
+    float slotSize = vt_params.y + 2.0 * vt_params.z;
+    vec2 physical = vec2(entry.xy) * slotSize + vt_params.z + inPage * vt_params.y;
+    return textureLod(vt_physical, physical / vt_physicalSize, 0.0).rgb;
+}
+#endif
+
 void main()
 {
-    // Este fragment shader debería usar las variables definidas, o al menos alguna para no ser optimizadas.
-    // Simulación simple de iluminación difusa:
+    // HAS_NORMAL_MAP declara texture_normal1 pero aún no perturba la normal: la salida es la de antes
     vec3 norm = normalize(Normal);
-    vec3 viewDir = normalize(viewPos - FragPos);
+
+#if defined(VIRTUAL_TEXTURE)
+    vec3 albedo = sampleVirtualTexture(FragPos, Color);
+#elif defined(HAS_DIFFUSE_MAP)
+    vec3 albedo = texture(texture_diffuse1, TexCoords).rgb;
+#else
+    vec3 albedo = Color;
+#endif
 
     vec3 result = vec3(0.0);
 
-    // Ejemplo de uso, al menos con una pointLight si existe:
-    if(numPointLights > 0) {
-        // Calculo simple con la primera luz:
+    // Solo la primera luz puntual ilumina, como antes de las variantes
+#if NUM_POINT_LIGHTS > 0
+    {
         vec3 lightDir = normalize(pointLights[0].position - FragPos);
-        float diff = max(dot(norm, lightDir),0.0);
-        vec3 diffuse = pointLights[0].diffuse * diff * texture(texture_diffuse1, TexCoords).rgb;
-        result += diffuse;
+        float diff = max(dot(norm, lightDir), 0.0);
+        result += pointLights[0].diffuse * diff * albedo;
     }
+#endif
 
-    // Uso del spotlight (ejemplo):
+    // Spotlight del faro
     {
         vec3 lightDir = normalize(spotLight.position - FragPos);
         float diff = max(dot(norm, lightDir), 0.0);
-        vec3 diffuse = spotLight.diffuse * diff * texture(texture_diffuse1, TexCoords).rgb;
+        vec3 diffuse = spotLight.diffuse * diff * albedo;
         result += diffuse;
     }
 
+#ifdef FOG
+    float fogFactor = clamp(exp(-fogDensity * length(viewPos - FragPos)), 0.0, 1.0);
+    result = mix(fogColor, result, fogFactor);
+#endif
+
     FragColor = vec4(result,1.0);
 }
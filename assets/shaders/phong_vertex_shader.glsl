@@ -10,13 +10,14 @@ out vec3 Color;
 out vec2 TexCoords;
 
 uniform mat4 model;
+uniform mat3 normalMatrix; // transpose(inverse(mat3(model))), calculada en CPU al cambiar la transformación
 uniform mat4 view;
 uniform mat4 projection;
 
 void main()
 {
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
+    Normal = normalMatrix * aNormal;
     Color = aColor;
     TexCoords = aTexCoords;    
 
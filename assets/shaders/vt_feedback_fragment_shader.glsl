@@ -0,0 +1,26 @@
+#version 330 core
+layout (location = 0) out uvec4 Feedback;
+
+in vec3 FragPos;
+
+uniform vec4 vt_worldRect;     // xy: origen del mundo (x, z), zw: 1 / tamaño
+uniform vec4 vt_params;        // x: lado virtual, y: lado de página, z: borde, w: último nivel
+uniform float vt_feedbackBias; // Compensa la resolución reducida del pase
+
+// Escribe la página (x, y, nivel) que necesita este píxel; alfa 0 significa "sin petición".
+void main()
+{
+    vec2 uv = (FragPos.xz - vt_worldRect.xy) * vt_worldRect.zw;
+    if (any(lessThan(uv, vec2(0.0))) || any(greaterThanEqual(uv, vec2(1.0))))
+        discard;
+
+    vec2 texel = uv * vt_params.x;
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + vt_feedbackBias;
+    int level = int(clamp(floor(lod), 0.0, vt_params.w));
+
+    int pages = max(int(vt_params.x / vt_params.y) >> level, 1);
+    ivec2 page = clamp(ivec2(uv * float(pages)), ivec2(0), ivec2(pages - 1));
+    Feedback = uvec4(uvec2(page), uint(level), 1u);
+}
@@ -0,0 +1,550 @@
+// AllocTracker.cpp
+
+#include "alloc_tracker.h"
+
+#if ALLOC_TRACKING
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#define ALLOC_TRACKER_HAS_BACKTRACE 1
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* pointer);
+}
+#else
+#define ALLOC_TRACKER_HAS_BACKTRACE 0
+#endif
+
+namespace {
+
+constexpr int kMaxThreads = 64;         // Threads with their own counters; later ones share the last slot
+constexpr int kMaxTags = 32;            // Distinct ALLOC_SCOPE tags; later ones count as untagged
+constexpr int kSiteDepth = 10;          // Caller frames kept per call site
+constexpr int kSiteSkip = 2;            // recordAllocation() and the hook (the helpers below are inlined)
+constexpr int kSiteTableSize = 4096;    // Open-addressing table of call sites (power of two)
+constexpr int kHistogramBuckets = 21;   // 0, 1, 2-3, 4-7, ... allocations per frame
+constexpr int kReportedSites = 20;
+constexpr int kPrintedViolations = 16;
+
+struct ThreadSlot {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> frees{0};
+    std::atomic<uint64_t> bytes{0};
+};
+
+struct TagSlot {
+    std::atomic<const char*> tag{nullptr};
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> bytes{0};
+};
+
+struct SiteSlot {
+    std::atomic<uint64_t> hash{0};
+    std::atomic<bool> ready{false};
+    void* frames[kSiteDepth];
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> bytes{0};
+};
+
+// Only trivially-initialized thread_local state: it is touched from inside malloc
+struct ThreadState {
+    ThreadSlot* slot;
+    const char* tag;
+    const char* noAlloc;
+    bool busy;
+};
+
+ThreadSlot threadSlots[kMaxThreads];
+std::atomic<int> threadSlotCount{0};
+TagSlot tagSlots[kMaxTags];
+TagSlot untagged;
+SiteSlot siteSlots[kSiteTableSize];
+std::atomic<uint64_t> droppedSites{0};
+std::atomic<bool> noAllocArmed{false};
+std::atomic<uint64_t> violations{0};
+
+thread_local ThreadState tls = {nullptr, nullptr, nullptr, false};
+
+// Frame statistics, only touched by the render thread
+struct FrameHistogram {
+    uint64_t allocations[kHistogramBuckets] = {};
+    uint64_t bytes[kHistogramBuckets] = {};
+    uint64_t frames = 0;
+    uint64_t maxAllocations = 0;
+    uint64_t maxBytes = 0;
+    uint64_t startAllocations = 0;
+    uint64_t startBytes = 0;
+    bool open = false;
+} frameHistogram;
+
+ThreadSlot& threadSlot()
+{
+    if (!tls.slot)
+    {
+        const int index = threadSlotCount.fetch_add(1, std::memory_order_relaxed);
+        tls.slot = &threadSlots[std::min(index, kMaxThreads - 1)];
+    }
+    return *tls.slot;
+}
+
+TagSlot& tagSlot(const char* tag)
+{
+    if (!tag)
+        return untagged;
+    for (TagSlot& slot : tagSlots)
+    {
+        const char* current = slot.tag.load(std::memory_order_acquire);
+        if (current == tag)
+            return slot;
+        if (!current)
+        {
+            const char* expected = nullptr;
+            if (slot.tag.compare_exchange_strong(expected, tag, std::memory_order_acq_rel) || expected == tag)
+                return slot;
+        }
+    }
+    return untagged;
+}
+
+#if ALLOC_TRACKER_HAS_BACKTRACE
+void recordSite(void* const* frames, int count, size_t size)
+{
+    uint64_t hash = 1469598103934665603ull;
+    for (int i = 0; i < count; ++i)
+        hash = (hash ^ reinterpret_cast<uintptr_t>(frames[i])) * 1099511628211ull;
+    hash |= 1; // 0 marks an empty slot
+
+    for (int probe = 0; probe < kSiteTableSize; ++probe)
+    {
+        SiteSlot& slot = siteSlots[(hash + probe) & (kSiteTableSize - 1)];
+        uint64_t current = slot.hash.load(std::memory_order_acquire);
+        if (current == 0)
+        {
+            if (slot.hash.compare_exchange_strong(current, hash, std::memory_order_acq_rel))
+            {
+                std::fill(slot.frames, slot.frames + kSiteDepth, nullptr);
+                std::copy(frames, frames + count, slot.frames);
+                slot.ready.store(true, std::memory_order_release);
+                current = hash;
+            }
+        }
+        if (current == hash)
+        {
+            slot.allocations.fetch_add(1, std::memory_order_relaxed);
+            slot.bytes.fetch_add(size, std::memory_order_relaxed);
+            return;
+        }
+    }
+    droppedSites.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+__attribute__((noinline)) void recordAllocation(size_t size)
+{
+    // backtrace() and the report may allocate themselves
+    if (tls.busy)
+        return;
+    tls.busy = true;
+
+    ThreadSlot& slot = threadSlot();
+    slot.allocations.fetch_add(1, std::memory_order_relaxed);
+    slot.bytes.fetch_add(size, std::memory_order_relaxed);
+    TagSlot& tag = tagSlot(tls.tag);
+    tag.allocations.fetch_add(1, std::memory_order_relaxed);
+    tag.bytes.fetch_add(size, std::memory_order_relaxed);
+
+#if ALLOC_TRACKER_HAS_BACKTRACE
+    void* frames[kSiteSkip + kSiteDepth];
+    const int count = backtrace(frames, kSiteSkip + kSiteDepth);
+    if (count > kSiteSkip)
+        recordSite(frames + kSiteSkip, count - kSiteSkip, size);
+#endif
+
+    if (tls.noAlloc && noAllocArmed.load(std::memory_order_relaxed))
+    {
+        const uint64_t index = violations.fetch_add(1, std::memory_order_relaxed);
+        if (index < kPrintedViolations)
+        {
+            std::fprintf(stderr, "Heap allocation of %zu bytes inside RENDER_NO_ALLOC scope (%s):\n", size, tls.noAlloc);
+#if ALLOC_TRACKER_HAS_BACKTRACE
+            if (count > kSiteSkip)
+                backtrace_symbols_fd(frames + kSiteSkip, count - kSiteSkip, 2);
+#endif
+        }
+        assert(!"heap allocation inside RENDER_NO_ALLOC scope");
+    }
+
+    tls.busy = false;
+}
+
+void recordFree(void* pointer)
+{
+    if (!pointer || tls.busy)
+        return;
+    threadSlot().frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* rawMalloc(size_t size)
+{
+#if defined(__GLIBC__)
+    return __libc_malloc(size);
+#else
+    return std::malloc(size);
+#endif
+}
+
+void* rawAlignedMalloc(size_t size, size_t alignment)
+{
+#if defined(__GLIBC__)
+    return __libc_memalign(alignment, size);
+#else
+    return std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+#endif
+}
+
+void rawFree(void* pointer)
+{
+#if defined(__GLIBC__)
+    __libc_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+// Inlined so that every hook sits exactly kSiteSkip frames above the caller
+__attribute__((always_inline)) inline void* trackedNew(size_t size)
+{
+    void* pointer = rawMalloc(size ? size : 1);
+    if (!pointer)
+        throw std::bad_alloc();
+    recordAllocation(size);
+    return pointer;
+}
+
+__attribute__((always_inline)) inline void* trackedAlignedNew(size_t size, std::align_val_t alignment)
+{
+    void* pointer = rawAlignedMalloc(size ? size : 1, static_cast<size_t>(alignment));
+    if (!pointer)
+        throw std::bad_alloc();
+    recordAllocation(size);
+    return pointer;
+}
+
+__attribute__((always_inline)) inline void* trackedNothrowNew(size_t size, size_t alignment)
+{
+    void* pointer = alignment ? rawAlignedMalloc(size ? size : 1, alignment) : rawMalloc(size ? size : 1);
+    if (pointer)
+        recordAllocation(size);
+    return pointer;
+}
+
+void trackedDelete(void* pointer)
+{
+    recordFree(pointer);
+    rawFree(pointer);
+}
+
+int bucketOf(uint64_t value)
+{
+    int bucket = 0;
+    while (value > 0 && bucket < kHistogramBuckets - 1)
+    {
+        value >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+void writeHistogram(std::ostream& out, const char* title, const uint64_t* buckets, const char* unit)
+{
+    out << "  " << title << ":\n";
+    for (int i = 0; i < kHistogramBuckets; ++i)
+    {
+        if (buckets[i] == 0)
+            continue;
+        const uint64_t low = i == 0 ? 0 : (1ull << (i - 1));
+        const uint64_t high = i == 0 ? 0 : (1ull << i) - 1;
+        out << "    " << low;
+        if (high != low)
+            out << '-' << (i == kHistogramBuckets - 1 ? std::string("inf") : std::to_string(high));
+        out << ' ' << unit << ": " << buckets[i] << " frames\n";
+    }
+}
+
+#if ALLOC_TRACKER_HAS_BACKTRACE
+void writeFrame(std::ostream& out, void* address)
+{
+    Dl_info info;
+    if (dladdr(address, &info) && info.dli_sname)
+    {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        out << (status == 0 && demangled ? demangled : info.dli_sname)
+            << " +0x" << std::hex << (static_cast<char*>(address) - static_cast<char*>(info.dli_saddr)) << std::dec;
+        std::free(demangled);
+    }
+    else if (info.dli_fname)
+    {
+        // Module offset, for addr2line -e <module>
+        out << info.dli_fname << " +0x" << std::hex
+            << (static_cast<char*>(address) - static_cast<char*>(info.dli_fbase)) << std::dec;
+    }
+    else
+    {
+        out << address;
+    }
+}
+#endif
+
+} // namespace
+
+AllocCounters AllocTracker::threadCounters()
+{
+    ThreadSlot& slot = threadSlot();
+    AllocCounters counters;
+    counters.allocations = slot.allocations.load(std::memory_order_relaxed);
+    counters.frees = slot.frees.load(std::memory_order_relaxed);
+    counters.bytes = slot.bytes.load(std::memory_order_relaxed);
+    return counters;
+}
+
+AllocCounters AllocTracker::globalCounters()
+{
+    AllocCounters counters;
+    const int count = std::min(threadSlotCount.load(std::memory_order_relaxed), kMaxThreads);
+    for (int i = 0; i < count; ++i)
+    {
+        counters.allocations += threadSlots[i].allocations.load(std::memory_order_relaxed);
+        counters.frees += threadSlots[i].frees.load(std::memory_order_relaxed);
+        counters.bytes += threadSlots[i].bytes.load(std::memory_order_relaxed);
+    }
+    return counters;
+}
+
+void AllocTracker::beginFrame()
+{
+    const AllocCounters counters = threadCounters();
+    frameHistogram.startAllocations = counters.allocations;
+    frameHistogram.startBytes = counters.bytes;
+    frameHistogram.open = true;
+}
+
+void AllocTracker::endFrame()
+{
+    if (!frameHistogram.open)
+        return;
+    const AllocCounters counters = threadCounters();
+    const uint64_t allocations = counters.allocations - frameHistogram.startAllocations;
+    const uint64_t bytes = counters.bytes - frameHistogram.startBytes;
+    ++frameHistogram.allocations[bucketOf(allocations)];
+    ++frameHistogram.bytes[bucketOf(bytes)];
+    frameHistogram.maxAllocations = std::max(frameHistogram.maxAllocations, allocations);
+    frameHistogram.maxBytes = std::max(frameHistogram.maxBytes, bytes);
+    ++frameHistogram.frames;
+    frameHistogram.open = false;
+}
+
+void AllocTracker::armNoAlloc(bool armed)
+{
+    noAllocArmed.store(armed, std::memory_order_relaxed);
+}
+
+uint64_t AllocTracker::noAllocViolations()
+{
+    return violations.load(std::memory_order_relaxed);
+}
+
+void AllocTracker::report(std::ostream& out)
+{
+    // The report's own allocations are not counted
+    const bool wasBusy = tls.busy;
+    tls.busy = true;
+
+    const AllocCounters total = globalCounters();
+    out << "Allocation tracker: " << total.allocations << " allocations (" << total.bytes << " bytes), "
+        << total.frees << " frees\n";
+
+    const int threads = std::min(threadSlotCount.load(std::memory_order_relaxed), kMaxThreads);
+    out << " Per thread:\n";
+    for (int i = 0; i < threads; ++i)
+    {
+        out << "  thread " << i << (i == kMaxThreads - 1 ? "+" : "") << ": "
+            << threadSlots[i].allocations.load(std::memory_order_relaxed) << " allocations, "
+            << threadSlots[i].bytes.load(std::memory_order_relaxed) << " bytes, "
+            << threadSlots[i].frees.load(std::memory_order_relaxed) << " frees\n";
+    }
+
+    out << " Per scope:\n";
+    for (const TagSlot& slot : tagSlots)
+    {
+        const char* tag = slot.tag.load(std::memory_order_acquire);
+        if (!tag)
+            break;
+        out << "  " << tag << ": " << slot.allocations.load(std::memory_order_relaxed) << " allocations, "
+            << slot.bytes.load(std::memory_order_relaxed) << " bytes\n";
+    }
+    out << "  (untagged): " << untagged.allocations.load(std::memory_order_relaxed) << " allocations, "
+        << untagged.bytes.load(std::memory_order_relaxed) << " bytes\n";
+
+    if (frameHistogram.frames > 0)
+    {
+        out << " Render thread, " << frameHistogram.frames << " frames (max " << frameHistogram.maxAllocations
+            << " allocations / " << frameHistogram.maxBytes << " bytes in one frame):\n";
+        writeHistogram(out, "allocations per frame", frameHistogram.allocations, "allocations");
+        writeHistogram(out, "bytes per frame", frameHistogram.bytes, "bytes");
+    }
+
+    const uint64_t noAllocCount = violations.load(std::memory_order_relaxed);
+    out << " RENDER_NO_ALLOC violations: " << noAllocCount << "\n";
+
+#if ALLOC_TRACKER_HAS_BACKTRACE
+    std::vector<int> sites;
+    for (int i = 0; i < kSiteTableSize; ++i)
+        if (siteSlots[i].ready.load(std::memory_order_acquire))
+            sites.push_back(i);
+    std::sort(sites.begin(), sites.end(), [](int a, int b) {
+        return siteSlots[a].allocations.load(std::memory_order_relaxed) > siteSlots[b].allocations.load(std::memory_order_relaxed);
+    });
+    if (sites.size() > static_cast<size_t>(kReportedSites))
+        sites.resize(kReportedSites);
+
+    out << " Hot call sites:\n";
+    for (int index : sites)
+    {
+        const SiteSlot& slot = siteSlots[index];
+        out << "  " << slot.allocations.load(std::memory_order_relaxed) << " allocations, "
+            << slot.bytes.load(std::memory_order_relaxed) << " bytes\n";
+        for (void* frame : slot.frames)
+        {
+            if (!frame)
+                break;
+            out << "      ";
+            writeFrame(out, frame);
+            out << '\n';
+        }
+    }
+    const uint64_t dropped = droppedSites.load(std::memory_order_relaxed);
+    if (dropped > 0)
+        out << "  (" << dropped << " allocations from call sites beyond the table)\n";
+#endif
+
+    tls.busy = wasBusy;
+}
+
+AllocScope::AllocScope(const char* tag) : previous(tls.tag)
+{
+    tls.tag = tag;
+}
+
+AllocScope::~AllocScope()
+{
+    tls.tag = previous;
+}
+
+NoAllocScope::NoAllocScope(const char* where) : previous(tls.noAlloc)
+{
+    tls.noAlloc = where;
+}
+
+NoAllocScope::~NoAllocScope()
+{
+    tls.noAlloc = previous;
+}
+
+// === Replacement operator new / delete ===
+
+void* operator new(size_t size) { return trackedNew(size); }
+void* operator new[](size_t size) { return trackedNew(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return trackedAlignedNew(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return trackedAlignedNew(size, alignment); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return trackedNothrowNew(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return trackedNothrowNew(size, 0); }
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return trackedNothrowNew(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return trackedNothrowNew(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept { trackedDelete(pointer); }
+void operator delete[](void* pointer) noexcept { trackedDelete(pointer); }
+void operator delete(void* pointer, size_t) noexcept { trackedDelete(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { trackedDelete(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { trackedDelete(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { trackedDelete(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { trackedDelete(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { trackedDelete(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { trackedDelete(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { trackedDelete(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { trackedDelete(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { trackedDelete(pointer); }
+
+// === Replacement malloc family (glibc) ===
+// C code (stb_image, the GL driver, libc itself) allocates through these; operator new
+// above goes straight to __libc_malloc, so each allocation is counted once.
+
+#if defined(__GLIBC__)
+extern "C" {
+
+void* malloc(size_t size)
+{
+    void* pointer = __libc_malloc(size);
+    if (pointer)
+        recordAllocation(size);
+    return pointer;
+}
+
+void* calloc(size_t count, size_t size)
+{
+    void* pointer = __libc_calloc(count, size);
+    if (pointer)
+        recordAllocation(count * size);
+    return pointer;
+}
+
+void* realloc(void* pointer, size_t size)
+{
+    void* moved = __libc_realloc(pointer, size);
+    if (size == 0)
+    {
+        recordFree(pointer);
+        return moved;
+    }
+    if (moved)
+    {
+        recordFree(pointer);
+        recordAllocation(size);
+    }
+    return moved;
+}
+
+void free(void* pointer)
+{
+    recordFree(pointer);
+    __libc_free(pointer);
+}
+
+} // extern "C"
+#endif
+
+#endif // ALLOC_TRACKING
@@ -0,0 +1,147 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @file alloc_tracker.h
+ * @brief Contador de reservas en el heap (build opcional con @c ALLOC_TRACKING=1).
+ *
+ * Con @c ALLOC_TRACKING el build reemplaza @c operator new / @c delete y, con glibc,
+ * @c malloc / @c calloc / @c realloc / @c free. Cada reserva se cuenta:
+ * - por hilo (@ref AllocTracker::threadCounters),
+ * - por ámbito etiquetado (@ref ALLOC_SCOPE),
+ * - por frame del hilo de render, en un histograma (@ref AllocTracker::endFrame),
+ * - por punto de llamada (pila corta), para listar los más frecuentes.
+ *
+ * @ref RENDER_NO_ALLOC marca un ámbito que no debe reservar; una vez armado
+ * (@ref AllocTracker::armNoAlloc), cualquier reserva dentro imprime su pila y, en builds
+ * de depuración, falla con @c assert. Sin @c ALLOC_TRACKING todo se compila a nada.
+ */
+
+/**
+ * @struct AllocCounters
+ * @brief Reservas y liberaciones acumuladas.
+ */
+struct AllocCounters {
+    uint64_t allocations = 0;   /**< Reservas */
+    uint64_t frees = 0;         /**< Liberaciones */
+    uint64_t bytes = 0;         /**< Bytes reservados */
+};
+
+#if ALLOC_TRACKING
+
+/**
+ * @class AllocTracker
+ * @brief Consultas y control del contador de reservas.
+ */
+class AllocTracker {
+public:
+    /**
+     * @brief Contadores del hilo que llama.
+     */
+    static AllocCounters threadCounters();
+
+    /**
+     * @brief Contadores de todos los hilos.
+     */
+    static AllocCounters globalCounters();
+
+    /**
+     * @brief Empieza un frame en el hilo de render.
+     */
+    static void beginFrame();
+
+    /**
+     * @brief Cierra el frame: suma las reservas del hilo durante el frame al histograma.
+     */
+    static void endFrame();
+
+    /**
+     * @brief Activa o desactiva las comprobaciones de @ref RENDER_NO_ALLOC.
+     *
+     * Se arma cuando la escena ya está en régimen estable (carga y calentamiento terminados).
+     */
+    static void armNoAlloc(bool armed);
+
+    /**
+     * @brief Reservas detectadas dentro de ámbitos @ref RENDER_NO_ALLOC armados.
+     */
+    static uint64_t noAllocViolations();
+
+    /**
+     * @brief Escribe los histogramas por frame, los ámbitos etiquetados y los puntos de llamada más frecuentes.
+     * @param out Flujo de salida.
+     */
+    static void report(std::ostream& out);
+};
+
+/**
+ * @class AllocScope
+ * @brief Etiqueta las reservas del hilo mientras vive (se anidan; cuenta la más interna).
+ */
+class AllocScope {
+public:
+    /**
+     * @param tag Nombre del ámbito; debe ser un literal (se compara por dirección).
+     */
+    explicit AllocScope(const char* tag);
+    ~AllocScope();
+
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+private:
+    const char* previous;   /**< Etiqueta exterior */
+};
+
+/**
+ * @class NoAllocScope
+ * @brief Ámbito en el que el hilo no debe reservar memoria (ver @ref RENDER_NO_ALLOC).
+ */
+class NoAllocScope {
+public:
+    /**
+     * @param where Ubicación para el diagnóstico; debe ser un literal.
+     */
+    explicit NoAllocScope(const char* where);
+    ~NoAllocScope();
+
+    NoAllocScope(const NoAllocScope&) = delete;
+    NoAllocScope& operator=(const NoAllocScope&) = delete;
+
+private:
+    const char* previous;   /**< Ámbito exterior */
+};
+
+#define ALLOC_TRACKER_CONCAT_(a, b) a##b
+#define ALLOC_TRACKER_CONCAT(a, b) ALLOC_TRACKER_CONCAT_(a, b)
+#define ALLOC_TRACKER_STRING_(x) #x
+#define ALLOC_TRACKER_STRING(x) ALLOC_TRACKER_STRING_(x)
+
+/// Etiqueta las reservas hechas hasta el final del bloque.
+#define ALLOC_SCOPE(tag) AllocScope ALLOC_TRACKER_CONCAT(allocScope, __LINE__)(tag)
+/// Declara que el bloque no reserva memoria en el heap.
+#define RENDER_NO_ALLOC() NoAllocScope ALLOC_TRACKER_CONCAT(noAllocScope, __LINE__)(__FILE__ ":" ALLOC_TRACKER_STRING(__LINE__))
+
+#else
+
+class AllocTracker {
+public:
+    static AllocCounters threadCounters() { return AllocCounters(); }
+    static AllocCounters globalCounters() { return AllocCounters(); }
+    static void beginFrame() {}
+    static void endFrame() {}
+    static void armNoAlloc(bool) {}
+    static uint64_t noAllocViolations() { return 0; }
+    static void report(std::ostream&) {}
+};
+
+#define ALLOC_SCOPE(tag) ((void)0)
+#define RENDER_NO_ALLOC() ((void)0)
+
+#endif // ALLOC_TRACKING
+
+#endif // ALLOC_TRACKER_H
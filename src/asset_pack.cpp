@@ -0,0 +1,445 @@
+// AssetPack.cpp
+
+#include "asset_pack.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+std::unique_ptr<AssetPack> AssetPack::mountedPack;
+
+namespace {
+
+constexpr char kMagic[4] = { 'L', 'H', 'P', 'K' };
+constexpr size_t kCookedAlignment = 16; // Alignment of sections inside cooked blobs
+
+size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// LZ block format (LZ4-compatible): token, literal length, literals, 16-bit offset, match length
+constexpr int kMinMatch = 4;
+constexpr int kHashBits = 14;
+constexpr size_t kLastLiterals = 5;   // The tail of a block is always emitted as literals
+constexpr size_t kMatchSafety = 12;   // No match starts this close to the end
+
+uint32_t read32(const unsigned char* p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t hashSequence(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - kHashBits);
+}
+
+void writeLength(std::vector<unsigned char>& out, size_t length)
+{
+    while (length >= 255)
+    {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<unsigned char>(length));
+}
+
+void emitSequence(std::vector<unsigned char>& out, const unsigned char* literals, size_t literalLength,
+                  size_t offset, size_t matchLength)
+{
+    size_t matchCode = matchLength ? matchLength - kMinMatch : 0;
+    unsigned char token = static_cast<unsigned char>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15));
+    out.push_back(token);
+    if (literalLength >= 15)
+        writeLength(out, literalLength - 15);
+    out.insert(out.end(), literals, literals + literalLength);
+    if (matchLength == 0)
+        return;
+    out.push_back(static_cast<unsigned char>(offset & 0xFF));
+    out.push_back(static_cast<unsigned char>(offset >> 8));
+    if (matchCode >= 15)
+        writeLength(out, matchCode - 15);
+}
+
+bool readLength(const unsigned char*& ip, const unsigned char* end, size_t& length)
+{
+    unsigned char byte;
+    do
+    {
+        if (ip >= end)
+            return false;
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+template <typename T>
+void appendPod(std::vector<unsigned char>& out, const T& value)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+} // namespace
+
+AssetPack::AssetPack(const std::string& path)
+    : file(path), header(nullptr), entries(nullptr), strings(nullptr)
+{
+    if (!file.isOpen())
+        return;
+
+    if (!validate())
+    {
+        std::cerr << "ERROR::ASSET_PACK::INVALID_FILE: " << path << std::endl;
+        close();
+    }
+}
+
+AssetPack::~AssetPack()
+{
+    close();
+}
+
+void AssetPack::close()
+{
+    file.close();
+    header = nullptr;
+    entries = nullptr;
+    strings = nullptr;
+}
+
+bool AssetPack::validate()
+{
+    const unsigned char* base = file.data();
+    const size_t mappedSize = file.size();
+    if (mappedSize < sizeof(AssetPackHeader))
+        return false;
+    header = reinterpret_cast<const AssetPackHeader*>(base);
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != AssetPackHeader::kVersion)
+        return false;
+
+    const uint64_t tableSize = static_cast<uint64_t>(header->entryCount) * sizeof(AssetPackEntry);
+    if (header->tableOffset > mappedSize || tableSize > mappedSize - header->tableOffset)
+        return false;
+    if (header->stringTableOffset > mappedSize || header->stringTableSize > mappedSize - header->stringTableOffset)
+        return false;
+
+    entries = reinterpret_cast<const AssetPackEntry*>(base + header->tableOffset);
+    strings = reinterpret_cast<const char*>(base + header->stringTableOffset);
+    for (uint32_t i = 0; i < header->entryCount; ++i)
+    {
+        const AssetPackEntry& entry = entries[i];
+        if (entry.offset > mappedSize || entry.storedSize > mappedSize - entry.offset)
+            return false;
+        if (static_cast<uint64_t>(entry.nameOffset) + entry.nameLength > header->stringTableSize)
+            return false;
+    }
+    return true;
+}
+
+bool AssetPack::find(const std::string& name, AssetBlob& blob) const
+{
+    if (!entries)
+        return false;
+
+    const uint64_t hash = hashName(name);
+    const AssetPackEntry* end = entries + header->entryCount;
+    const AssetPackEntry* it = std::lower_bound(entries, end, hash,
+        [](const AssetPackEntry& entry, uint64_t h) { return entry.nameHash < h; });
+
+    for (; it != end && it->nameHash == hash; ++it)
+    {
+        if (it->nameLength != name.size() || name.compare(0, name.size(), strings + it->nameOffset, it->nameLength) != 0)
+            continue;
+
+        blob.kind = it->kind;
+        blob.size = static_cast<size_t>(it->size);
+        if (it->compression == AssetCompression::None)
+        {
+            blob.storage.clear();
+            blob.data = file.data() + it->offset;
+            return true;
+        }
+
+        blob.storage.resize(blob.size);
+        if (!decompress(file.data() + it->offset, static_cast<size_t>(it->storedSize), blob.storage.data(), blob.size))
+        {
+            std::cerr << "ERROR::ASSET_PACK::CORRUPT_BLOB: " << name << std::endl;
+            blob.storage.clear();
+            return false;
+        }
+        blob.data = blob.storage.data();
+        return true;
+    }
+    return false;
+}
+
+bool AssetPack::mount(const std::string& path)
+{
+    auto pack = std::make_unique<AssetPack>(path);
+    if (!pack->isOpen())
+        return false;
+    std::cout << "Mounted asset pack: " << path << " (" << pack->entryCount() << " assets)" << std::endl;
+    mountedPack = std::move(pack);
+    return true;
+}
+
+void AssetPack::unmount()
+{
+    mountedPack.reset();
+}
+
+const AssetPack* AssetPack::mounted()
+{
+    return mountedPack.get();
+}
+
+uint64_t AssetPack::hashName(const std::string& name)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : name)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::vector<unsigned char> AssetPack::cookTexture(const TextureImage& image)
+{
+    std::vector<unsigned char> out;
+    PackedTextureHeader texHeader{ image.internalFormat, image.format, image.dataType,
+                                   static_cast<uint32_t>(image.levels.size()) };
+    appendPod(out, texHeader);
+
+    size_t dataOffset = alignUp(sizeof(PackedTextureHeader) + image.levels.size() * sizeof(PackedTextureLevel), kCookedAlignment);
+    for (const TextureImage::Level& level : image.levels)
+    {
+        PackedTextureLevel packed{ static_cast<uint32_t>(level.width), static_cast<uint32_t>(level.height),
+                                   dataOffset, level.size };
+        appendPod(out, packed);
+        dataOffset = alignUp(dataOffset + level.size, kCookedAlignment);
+    }
+    for (const TextureImage::Level& level : image.levels)
+    {
+        out.resize(alignUp(out.size(), kCookedAlignment), 0);
+        const unsigned char* texels = static_cast<const unsigned char*>(level.data);
+        out.insert(out.end(), texels, texels + level.size);
+    }
+    return out;
+}
+
+bool AssetPack::parseTexture(AssetBlob&& blob, TextureImage& image)
+{
+    if (blob.kind != AssetKind::Texture || blob.size < sizeof(PackedTextureHeader))
+        return false;
+
+    PackedTextureHeader texHeader;
+    std::memcpy(&texHeader, blob.data, sizeof(texHeader));
+    if (sizeof(PackedTextureHeader) + static_cast<uint64_t>(texHeader.levelCount) * sizeof(PackedTextureLevel) > blob.size)
+        return false;
+
+    image.internalFormat = texHeader.internalFormat;
+    image.format = texHeader.format;
+    image.dataType = texHeader.dataType;
+    image.levels.clear();
+    const PackedTextureLevel* levels = reinterpret_cast<const PackedTextureLevel*>(blob.data + sizeof(PackedTextureHeader));
+    for (uint32_t i = 0; i < texHeader.levelCount; ++i)
+    {
+        if (levels[i].offset > blob.size || levels[i].size > blob.size - levels[i].offset)
+            return false;
+        image.levels.push_back({ static_cast<GLsizei>(levels[i].width), static_cast<GLsizei>(levels[i].height),
+                                 blob.data + levels[i].offset, static_cast<size_t>(levels[i].size) });
+    }
+
+    // Level pointers reference the mapping, or the decompressed buffer that moves in here
+    image.blobStorage = std::move(blob.storage);
+    return true;
+}
+
+std::vector<unsigned char> AssetPack::cookMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+    PackedMeshHeader meshHeader{};
+    meshHeader.vertexCount = static_cast<uint32_t>(vertices.size());
+    meshHeader.indexCount = static_cast<uint32_t>(indices.size());
+    meshHeader.vertexStride = sizeof(Vertex);
+    meshHeader.vertexOffset = alignUp(sizeof(PackedMeshHeader), kCookedAlignment);
+    meshHeader.indexOffset = alignUp(meshHeader.vertexOffset + vertices.size() * sizeof(Vertex), kCookedAlignment);
+
+    std::vector<unsigned char> out(meshHeader.indexOffset + indices.size() * sizeof(unsigned int), 0);
+    std::memcpy(out.data(), &meshHeader, sizeof(meshHeader));
+    std::memcpy(out.data() + meshHeader.vertexOffset, vertices.data(), vertices.size() * sizeof(Vertex));
+    std::memcpy(out.data() + meshHeader.indexOffset, indices.data(), indices.size() * sizeof(unsigned int));
+    return out;
+}
+
+bool AssetPack::parseMesh(const AssetBlob& blob, MeshView& mesh)
+{
+    if (blob.kind != AssetKind::Mesh || blob.size < sizeof(PackedMeshHeader))
+        return false;
+
+    PackedMeshHeader meshHeader;
+    std::memcpy(&meshHeader, blob.data, sizeof(meshHeader));
+    if (meshHeader.vertexStride != sizeof(Vertex))
+        return false;
+    if (meshHeader.vertexOffset + static_cast<uint64_t>(meshHeader.vertexCount) * sizeof(Vertex) > blob.size ||
+        meshHeader.indexOffset + static_cast<uint64_t>(meshHeader.indexCount) * sizeof(unsigned int) > blob.size)
+        return false;
+
+    mesh.vertices = reinterpret_cast<const Vertex*>(blob.data + meshHeader.vertexOffset);
+    mesh.vertexCount = meshHeader.vertexCount;
+    mesh.indices = reinterpret_cast<const unsigned int*>(blob.data + meshHeader.indexOffset);
+    mesh.indexCount = meshHeader.indexCount;
+    return true;
+}
+
+std::vector<unsigned char> AssetPack::compress(const unsigned char* data, size_t size)
+{
+    std::vector<unsigned char> out;
+    out.reserve(size / 2 + 16);
+    std::vector<uint32_t> table(size_t(1) << kHashBits, 0xFFFFFFFFu);
+
+    size_t anchor = 0;
+    size_t ip = 0;
+    const size_t matchLimit = size > kMatchSafety ? size - kMatchSafety : 0;
+    while (ip < matchLimit)
+    {
+        uint32_t sequence = read32(data + ip);
+        uint32_t& slot = table[hashSequence(sequence)];
+        size_t candidate = slot;
+        slot = static_cast<uint32_t>(ip);
+
+        if (candidate == 0xFFFFFFFFu || ip - candidate > 0xFFFF || read32(data + candidate) != sequence)
+        {
+            ++ip;
+            continue;
+        }
+
+        size_t matchLength = kMinMatch;
+        const size_t maxLength = size - kLastLiterals - ip;
+        while (matchLength < maxLength && data[candidate + matchLength] == data[ip + matchLength])
+            ++matchLength;
+
+        emitSequence(out, data + anchor, ip - anchor, ip - candidate, matchLength);
+        ip += matchLength;
+        anchor = ip;
+    }
+    emitSequence(out, data + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+bool AssetPack::decompress(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize)
+{
+    const unsigned char* ip = src;
+    const unsigned char* ipEnd = src + srcSize;
+    size_t op = 0;
+
+    while (ip < ipEnd)
+    {
+        unsigned char token = *ip++;
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(ip, ipEnd, literalLength))
+            return false;
+        if (literalLength > static_cast<size_t>(ipEnd - ip) || literalLength > dstSize - op)
+            return false;
+        if (literalLength > 0)
+            std::memcpy(dst + op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        if (ip == ipEnd)
+            break; // Last sequence carries literals only
+
+        if (ipEnd - ip < 2)
+            return false;
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        size_t matchLength = token & 0x0F;
+        if (matchLength == 15 && !readLength(ip, ipEnd, matchLength))
+            return false;
+        matchLength += kMinMatch;
+        if (offset == 0 || offset > op || matchLength > dstSize - op)
+            return false;
+
+        // Byte-wise copy: overlapping matches replicate runs
+        for (size_t i = 0; i < matchLength; ++i, ++op)
+            dst[op] = dst[op - offset];
+    }
+    return op == dstSize;
+}
+
+void AssetPack::Writer::add(const std::string& name, AssetKind kind, std::vector<unsigned char> bytes, bool allowCompression)
+{
+    Pending blob{ name, kind, AssetCompression::None, bytes.size(), {} };
+    if (allowCompression && !bytes.empty())
+    {
+        std::vector<unsigned char> packed = compress(bytes.data(), bytes.size());
+        if (packed.size() < bytes.size() - bytes.size() / 10)
+        {
+            blob.compression = AssetCompression::LZ;
+            blob.stored = std::move(packed);
+        }
+    }
+    if (blob.compression == AssetCompression::None)
+        blob.stored = std::move(bytes);
+    pending.push_back(std::move(blob));
+}
+
+bool AssetPack::Writer::write(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "ERROR::ASSET_PACK::CANNOT_WRITE: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<AssetPackEntry> table;
+    std::string stringTable;
+    std::vector<unsigned char> padding(AssetPackHeader::kAlignment, 0);
+
+    AssetPackHeader packHeader{};
+    std::memcpy(packHeader.magic, kMagic, sizeof(kMagic));
+    packHeader.version = AssetPackHeader::kVersion;
+    packHeader.entryCount = static_cast<uint32_t>(pending.size());
+    file.write(reinterpret_cast<const char*>(&packHeader), sizeof(packHeader));
+
+    uint64_t offset = sizeof(packHeader);
+    for (const Pending& blob : pending)
+    {
+        uint64_t aligned = alignUp(offset, AssetPackHeader::kAlignment);
+        file.write(reinterpret_cast<const char*>(padding.data()), static_cast<std::streamsize>(aligned - offset));
+        file.write(reinterpret_cast<const char*>(blob.stored.data()), static_cast<std::streamsize>(blob.stored.size()));
+
+        AssetPackEntry entry{};
+        entry.nameHash = hashName(blob.name);
+        entry.nameOffset = static_cast<uint32_t>(stringTable.size());
+        entry.nameLength = static_cast<uint32_t>(blob.name.size());
+        entry.offset = aligned;
+        entry.storedSize = blob.stored.size();
+        entry.size = blob.size;
+        entry.kind = blob.kind;
+        entry.compression = blob.compression;
+        table.push_back(entry);
+        stringTable += blob.name;
+        offset = aligned + blob.stored.size();
+    }
+
+    std::sort(table.begin(), table.end(),
+        [](const AssetPackEntry& a, const AssetPackEntry& b) { return a.nameHash < b.nameHash; });
+
+    uint64_t tableOffset = alignUp(offset, alignof(AssetPackEntry));
+    file.write(reinterpret_cast<const char*>(padding.data()), static_cast<std::streamsize>(tableOffset - offset));
+    file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(AssetPackEntry)));
+    file.write(stringTable.data(), static_cast<std::streamsize>(stringTable.size()));
+
+    packHeader.tableOffset = tableOffset;
+    packHeader.stringTableOffset = tableOffset + table.size() * sizeof(AssetPackEntry);
+    packHeader.stringTableSize = stringTable.size();
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&packHeader), sizeof(packHeader));
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,260 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include "Mesh.h"
+#include "Texture.h"
+#include "mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @enum AssetKind
+ * @brief Tipo de contenido de un blob dentro del asset pack.
+ */
+enum class AssetKind : uint32_t {
+    Raw = 0,      /**< Bytes sin interpretar */
+    Texture = 1,  /**< Textura cocinada: formato de OpenGL + cadena de mipmaps lista para subir */
+    Shader = 2,   /**< Código fuente GLSL */
+    Mesh = 3      /**< Malla cocinada: arreglo de Vertex + arreglo de índices */
+};
+
+/**
+ * @enum AssetCompression
+ * @brief Compresión aplicada a un blob individual.
+ */
+enum class AssetCompression : uint32_t {
+    None = 0,  /**< Blob almacenado tal cual; se lee sin copia desde el mapeo */
+    LZ = 1     /**< Bloque LZ (formato de bloque LZ4); se descomprime a memoria propia */
+};
+
+/**
+ * @struct AssetPackHeader
+ * @brief Cabecera al inicio del archivo .pak.
+ *
+ * Disposición del archivo: cabecera, blobs alineados a @ref kAlignment, tabla de
+ * entradas ordenada por hash del nombre y tabla de cadenas con los nombres.
+ */
+struct AssetPackHeader {
+    char magic[4];              /**< "LHPK" */
+    uint32_t version;           /**< Versión del formato (@ref kVersion) */
+    uint32_t entryCount;        /**< Número de entradas en la tabla */
+    uint32_t flags;             /**< Reservado, 0 */
+    uint64_t tableOffset;       /**< Offset de la tabla de entradas */
+    uint64_t stringTableOffset; /**< Offset de la tabla de cadenas */
+    uint64_t stringTableSize;   /**< Tamaño de la tabla de cadenas */
+
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint64_t kAlignment = 4096; /**< Alineación de cada blob (una página) */
+};
+
+/**
+ * @struct AssetPackEntry
+ * @brief Entrada de la tabla de offsets: ubica un blob por nombre.
+ */
+struct AssetPackEntry {
+    uint64_t nameHash;     /**< FNV-1a de 64 bits del nombre */
+    uint32_t nameOffset;   /**< Offset del nombre dentro de la tabla de cadenas */
+    uint32_t nameLength;   /**< Longitud del nombre */
+    uint64_t offset;       /**< Offset del blob en el archivo */
+    uint64_t storedSize;   /**< Bytes almacenados (comprimidos o no) */
+    uint64_t size;         /**< Bytes tras descomprimir */
+    AssetKind kind;        /**< Tipo de contenido */
+    AssetCompression compression; /**< Compresión del blob */
+};
+
+static_assert(sizeof(AssetPackHeader) == 40, "AssetPackHeader layout is part of the file format");
+static_assert(sizeof(AssetPackEntry) == 48, "AssetPackEntry layout is part of the file format");
+
+/**
+ * @struct PackedTextureHeader
+ * @brief Cabecera de un blob de textura cocinada, seguida de @c levelCount @ref PackedTextureLevel.
+ */
+struct PackedTextureHeader {
+    uint32_t internalFormat; /**< Formato interno para glTexStorage2D */
+    uint32_t format;         /**< Formato de cliente para glTexSubImage2D */
+    uint32_t dataType;       /**< Tipo de dato de cliente (GL_UNSIGNED_BYTE, GL_FLOAT) */
+    uint32_t levelCount;     /**< Niveles de mipmap */
+};
+
+/**
+ * @struct PackedTextureLevel
+ * @brief Ubicación de un nivel de mipmap dentro del blob de textura.
+ */
+struct PackedTextureLevel {
+    uint32_t width;   /**< Ancho del nivel */
+    uint32_t height;  /**< Alto del nivel */
+    uint64_t offset;  /**< Offset de los texels relativo al inicio del blob */
+    uint64_t size;    /**< Bytes del nivel */
+};
+
+/**
+ * @struct PackedMeshHeader
+ * @brief Cabecera de un blob de malla cocinada.
+ */
+struct PackedMeshHeader {
+    uint32_t vertexCount;   /**< Número de vértices */
+    uint32_t indexCount;    /**< Número de índices */
+    uint32_t vertexStride;  /**< sizeof(Vertex) al cocinar; debe coincidir al cargar */
+    uint32_t reserved;      /**< Reservado, 0 */
+    uint64_t vertexOffset;  /**< Offset de los vértices relativo al inicio del blob */
+    uint64_t indexOffset;   /**< Offset de los índices relativo al inicio del blob */
+};
+
+/**
+ * @struct AssetBlob
+ * @brief Vista de solo lectura a un blob del pack.
+ *
+ * Si el blob no está comprimido, @ref data apunta directamente al archivo mapeado
+ * (sin copia). Si está comprimido, se descomprime en @ref storage.
+ */
+struct AssetBlob {
+    const unsigned char* data = nullptr;   /**< Inicio del contenido */
+    size_t size = 0;                       /**< Tamaño del contenido */
+    AssetKind kind = AssetKind::Raw;       /**< Tipo de contenido */
+    std::vector<unsigned char> storage;    /**< Memoria propia para blobs descomprimidos */
+};
+
+/**
+ * @struct MeshView
+ * @brief Vértices e índices de una malla cocinada, leídos en su lugar desde un @ref AssetBlob.
+ */
+struct MeshView {
+    const Vertex* vertices = nullptr;      /**< Arreglo de vértices */
+    size_t vertexCount = 0;                /**< Número de vértices */
+    const unsigned int* indices = nullptr; /**< Arreglo de índices */
+    size_t indexCount = 0;                 /**< Número de índices */
+};
+
+/**
+ * @class AssetPack
+ * @brief Archivo único de assets mapeado en memoria.
+ *
+ * El pack se abre con una sola llamada y se mapea completo; las texturas, shaders y
+ * mallas se leen directamente desde el mapeo hacia los buffers de subida. Un pack
+ * puede montarse globalmente con @ref mount; los cargadores lo consultan primero y
+ * recurren a los archivos sueltos si el asset no está empaquetado.
+ */
+class AssetPack {
+public:
+    /**
+     * @brief Abre y mapea un archivo .pak.
+     * @param path Ruta al archivo.
+     */
+    explicit AssetPack(const std::string& path);
+
+    /**
+     * @brief Destructor. Libera el mapeo.
+     */
+    ~AssetPack();
+
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    /**
+     * @brief Indica si el archivo se abrió y su cabecera es válida.
+     */
+    bool isOpen() const { return header != nullptr; }
+
+    /**
+     * @brief Busca un asset por nombre (ruta relativa, ej: "assets/shaders/phong_vertex_shader.glsl").
+     * @param name Nombre del asset.
+     * @param blob Vista de salida al contenido.
+     * @return true si el asset existe y pudo leerse.
+     */
+    bool find(const std::string& name, AssetBlob& blob) const;
+
+    /**
+     * @brief Número de assets en el pack.
+     */
+    size_t entryCount() const { return entries ? header->entryCount : 0; }
+
+    /**
+     * @brief Monta un pack global consultado por los cargadores de texturas, shaders y mallas.
+     * @param path Ruta al archivo .pak.
+     * @return true si el pack se montó.
+     */
+    static bool mount(const std::string& path);
+
+    /**
+     * @brief Desmonta el pack global.
+     */
+    static void unmount();
+
+    /**
+     * @brief Obtiene el pack global montado.
+     * @return Puntero al pack, o nullptr si no hay ninguno.
+     */
+    static const AssetPack* mounted();
+
+    /// Serialización de assets cocinados (compartida por el constructor y el runtime).
+    static std::vector<unsigned char> cookTexture(const TextureImage& image);
+    static bool parseTexture(AssetBlob&& blob, TextureImage& image);
+    static std::vector<unsigned char> cookMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+    static bool parseMesh(const AssetBlob& blob, MeshView& mesh);
+
+    /// Compresión LZ por blob. @c decompress devuelve false si los datos son inválidos.
+    static std::vector<unsigned char> compress(const unsigned char* data, size_t size);
+    static bool decompress(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize);
+
+    /**
+     * @brief Hash FNV-1a de 64 bits usado para indexar los nombres.
+     */
+    static uint64_t hashName(const std::string& name);
+
+    /**
+     * @class Writer
+     * @brief Construye un archivo .pak a partir de blobs en memoria.
+     */
+    class Writer {
+    public:
+        /**
+         * @brief Añade un blob.
+         * @param name Nombre del asset.
+         * @param kind Tipo de contenido.
+         * @param bytes Contenido sin comprimir.
+         * @param allowCompression Si es true, se comprime cuando ahorra al menos un 10%.
+         */
+        void add(const std::string& name, AssetKind kind, std::vector<unsigned char> bytes, bool allowCompression);
+
+        /**
+         * @brief Escribe el pack a disco.
+         * @param path Ruta del archivo de salida.
+         * @return true si se escribió correctamente.
+         */
+        bool write(const std::string& path) const;
+
+    private:
+        struct Pending {
+            std::string name;
+            AssetKind kind;
+            AssetCompression compression;
+            uint64_t size;
+            std::vector<unsigned char> stored;
+        };
+        std::vector<Pending> pending; /**< Blobs en el orden en que se añadieron */
+    };
+
+private:
+    MappedFile file;                 /**< Archivo mapeado */
+    const AssetPackHeader* header;   /**< Cabecera dentro del mapeo */
+    const AssetPackEntry* entries;   /**< Tabla de entradas dentro del mapeo */
+    const char* strings;             /**< Tabla de cadenas dentro del mapeo */
+
+    static std::unique_ptr<AssetPack> mountedPack; /**< Pack global */
+
+    /**
+     * @brief Valida la cabecera y la tabla tras mapear el archivo.
+     * @return true si el contenido es consistente con el tamaño del archivo.
+     */
+    bool validate();
+
+    /**
+     * @brief Libera el mapeo y los handles.
+     */
+    void close();
+};
+
+#endif // ASSET_PACK_H
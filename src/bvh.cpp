@@ -0,0 +1,187 @@
+// Bvh.cpp
+
+#include "bvh.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+constexpr int kBins = 16;
+
+struct Box {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+    void grow(const glm::vec3& lo, const glm::vec3& hi)
+    {
+        min = glm::min(min, lo);
+        max = glm::max(max, hi);
+    }
+
+    float area() const
+    {
+        if (min.x > max.x)
+            return 0.0f;
+        const glm::vec3 size = max - min;
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+};
+
+using Pending = BvhBuildScratch::Pending;
+using Primitive = BvhBuildScratch::Primitive;
+
+} // namespace
+
+namespace Bvh {
+
+uint32_t build(const glm::vec3* mins, const glm::vec3* maxs, size_t count, uint32_t maxLeafSize,
+               std::vector<BvhNode>& nodes, std::vector<uint32_t>& order)
+{
+    BvhBuildScratch scratch;
+    return build(mins, maxs, count, maxLeafSize, nodes, order, scratch);
+}
+
+uint32_t build(const glm::vec3* mins, const glm::vec3* maxs, size_t count, uint32_t maxLeafSize,
+               std::vector<BvhNode>& nodes, std::vector<uint32_t>& order, BvhBuildScratch& scratch)
+{
+    nodes.clear();
+    order.resize(count);
+    if (count == 0)
+        return 0;
+
+    std::vector<Primitive>& primitives = scratch.primitives;
+    primitives.resize(count);
+    for (size_t i = 0; i < count; ++i)
+        primitives[i] = Primitive{ mins[i], static_cast<uint32_t>(i), maxs[i], 0.0f };
+
+    nodes.reserve(2 * count / std::max(1u, maxLeafSize) + 1);
+    nodes.push_back(BvhNode{ glm::vec3(0.0f), 0, glm::vec3(0.0f), static_cast<uint32_t>(count) });
+
+    uint32_t depth = 0;
+    std::vector<Pending>& stack = scratch.stack;
+    stack.clear();
+    stack.push_back({ 0, 1 });
+    while (!stack.empty())
+    {
+        const Pending pending = stack.back();
+        stack.pop_back();
+        const uint32_t first = nodes[pending.node].first;
+        const uint32_t size = nodes[pending.node].count;
+        Primitive* begin = primitives.data() + first;
+        Primitive* end = begin + size;
+        depth = std::max(depth, pending.depth);
+
+        // Box centers (doubled: min + max) drive the splits
+        Box bounds, centerBounds;
+        for (const Primitive* p = begin; p != end; ++p)
+        {
+            bounds.grow(p->min, p->max);
+            const glm::vec3 center = p->min + p->max;
+            centerBounds.grow(center, center);
+        }
+        nodes[pending.node].min = bounds.min;
+        nodes[pending.node].max = bounds.max;
+        if (size <= maxLeafSize || pending.depth + 1 >= kMaxDepth)
+            continue;
+
+        // Bin the centers along the widest axis and pick the cheapest plane by surface area
+        const glm::vec3 extent = centerBounds.max - centerBounds.min;
+        const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        for (Primitive* p = begin; p != end; ++p)
+            p->center = p->min[axis] + p->max[axis];
+        Primitive* middle = nullptr;
+        if (extent[axis] > 0.0f)
+        {
+            const float scale = kBins / extent[axis];
+            const float origin = centerBounds.min[axis];
+            auto binOf = [scale, origin](const Primitive& p) {
+                return std::min(kBins - 1, static_cast<int>((p.center - origin) * scale));
+            };
+
+            Box binBounds[kBins];
+            uint32_t binCounts[kBins] = {};
+            for (const Primitive* p = begin; p != end; ++p)
+            {
+                const int bin = binOf(*p);
+                binBounds[bin].grow(p->min, p->max);
+                ++binCounts[bin];
+            }
+
+            // Sweep from the right for the cost of every right side, then from the left
+            float rightCost[kBins];
+            Box right;
+            uint32_t rightCount = 0;
+            for (int bin = kBins - 1; bin > 0; --bin)
+            {
+                right.grow(binBounds[bin].min, binBounds[bin].max);
+                rightCount += binCounts[bin];
+                rightCost[bin] = right.area() * rightCount;
+            }
+            Box left;
+            uint32_t leftCount = 0;
+            float bestCost = std::numeric_limits<float>::max();
+            int bestSplit = 0;
+            for (int bin = 1; bin < kBins; ++bin)
+            {
+                left.grow(binBounds[bin - 1].min, binBounds[bin - 1].max);
+                leftCount += binCounts[bin - 1];
+                const float cost = left.area() * leftCount + rightCost[bin];
+                if (leftCount > 0 && leftCount < size && cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestSplit = bin;
+                }
+            }
+            if (bestSplit > 0)
+                middle = std::partition(begin, end, [&](const Primitive& p) { return binOf(p) < bestSplit; });
+        }
+
+        // Every center in one bin (or in one point): split by count instead
+        if (middle == nullptr || middle == begin || middle == end)
+        {
+            middle = begin + size / 2;
+            std::nth_element(begin, middle, end, [](const Primitive& a, const Primitive& b) { return a.center < b.center; });
+        }
+
+        const uint32_t leftIndex = static_cast<uint32_t>(nodes.size());
+        const uint32_t leftSize = static_cast<uint32_t>(middle - begin);
+        nodes.push_back(BvhNode{ glm::vec3(0.0f), first, glm::vec3(0.0f), leftSize });
+        nodes.push_back(BvhNode{ glm::vec3(0.0f), first + leftSize, glm::vec3(0.0f), size - leftSize });
+        nodes[pending.node].first = leftIndex;
+        nodes[pending.node].count = 0;
+        stack.push_back({ leftIndex, pending.depth + 1 });
+        stack.push_back({ leftIndex + 1, pending.depth + 1 });
+    }
+
+    for (size_t i = 0; i < count; ++i)
+        order[i] = primitives[i].id;
+    return depth;
+}
+
+void refit(std::vector<BvhNode>& nodes, const glm::vec3* mins, const glm::vec3* maxs)
+{
+    // Children always follow their parent, so one backwards pass sees them first
+    for (size_t i = nodes.size(); i-- > 0;)
+    {
+        BvhNode& node = nodes[i];
+        if (node.count > 0)
+        {
+            node.min = mins[node.first];
+            node.max = maxs[node.first];
+            for (uint32_t p = node.first + 1; p < node.first + node.count; ++p)
+            {
+                node.min = glm::min(node.min, mins[p]);
+                node.max = glm::max(node.max, maxs[p]);
+            }
+        }
+        else
+        {
+            const BvhNode& left = nodes[node.first];
+            const BvhNode& right = nodes[node.first + 1];
+            node.min = glm::min(left.min, right.min);
+            node.max = glm::max(left.max, right.max);
+        }
+    }
+}
+
+} // namespace Bvh
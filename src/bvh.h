@@ -0,0 +1,121 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @struct BvhNode
+ * @brief Nodo de una jerarquía de cajas (BVH) plana: 32 bytes, dos por línea de caché.
+ *
+ * Un nodo interior (@ref count 0) tiene sus dos hijos en @c first y @c first + 1; una hoja
+ * cubre las primitivas [@c first, @c first + @ref count) del orden de hojas.
+ */
+struct BvhNode {
+    glm::vec3 min;      /**< Esquina mínima de la caja */
+    uint32_t first;     /**< Primer hijo (interior) o primera primitiva (hoja) */
+    glm::vec3 max;      /**< Esquina máxima de la caja */
+    uint32_t count;     /**< Primitivas de la hoja; 0 en los nodos interiores */
+};
+
+static_assert(sizeof(BvhNode) == 32, "BvhNode is meant to be two per cache line");
+
+/**
+ * @struct BvhBuildScratch
+ * @brief Memoria auxiliar de @ref Bvh::build; quien reconstruye a menudo la conserva para no reservar cada vez.
+ */
+struct BvhBuildScratch {
+    /// Primitiva en construcción: se reparten en su sitio, así cada pasada lee la memoria en orden.
+    struct Primitive {
+        glm::vec3 min;
+        uint32_t id;
+        glm::vec3 max;
+        float center;   /**< Sobre el eje que se divide */
+    };
+
+    /// Nodo pendiente de dividir.
+    struct Pending {
+        uint32_t node;
+        uint32_t depth;
+    };
+
+    std::vector<Primitive> primitives;  /**< Primitivas, en el orden de hojas al terminar */
+    std::vector<Pending> stack;         /**< Nodos por dividir */
+};
+
+/**
+ * @namespace Bvh
+ * @brief Construcción, reajuste y pruebas de caja compartidos por @ref SpatialIndex y @ref MeshCollision.
+ */
+namespace Bvh {
+
+/// Profundidad máxima que recorren las consultas (pila fija); la construcción no la supera.
+constexpr uint32_t kMaxDepth = 64;
+
+/**
+ * @brief Construye la jerarquía por SAH con cubos sobre los centros de las cajas de las primitivas.
+ *
+ * Los hijos se crean siempre después de su padre, lo que permite reajustar con un solo
+ * recorrido inverso (@ref refit).
+ *
+ * @param mins Esquina mínima de cada primitiva.
+ * @param maxs Esquina máxima de cada primitiva.
+ * @param count Número de primitivas.
+ * @param maxLeafSize Primitivas por debajo de las que un nodo queda como hoja.
+ * @param nodes Nodos de salida; el 0 es la raíz (vacío si no hay primitivas).
+ * @param order Orden de hojas de salida: la posición @c i es la primitiva @c order[i].
+ * @return uint32_t Profundidad de la jerarquía.
+ */
+uint32_t build(const glm::vec3* mins, const glm::vec3* maxs, size_t count, uint32_t maxLeafSize,
+               std::vector<BvhNode>& nodes, std::vector<uint32_t>& order);
+
+/**
+ * @brief Como @ref build, pero con memoria auxiliar reutilizable: con la capacidad ya alcanzada no reserva.
+ * @param scratch Memoria auxiliar (su contenido se descarta).
+ */
+uint32_t build(const glm::vec3* mins, const glm::vec3* maxs, size_t count, uint32_t maxLeafSize,
+               std::vector<BvhNode>& nodes, std::vector<uint32_t>& order, BvhBuildScratch& scratch);
+
+/**
+ * @brief Recalcula las cajas de todos los nodos sin cambiar la topología.
+ * @param nodes Nodos construidos con @ref build.
+ * @param mins Esquina mínima de cada primitiva, en el orden de hojas.
+ * @param maxs Esquina máxima de cada primitiva, en el orden de hojas.
+ */
+void refit(std::vector<BvhNode>& nodes, const glm::vec3* mins, const glm::vec3* maxs);
+
+/**
+ * @brief Prueba de rayo contra la caja de un nodo (método de las losas).
+ * @param node Nodo.
+ * @param origin Origen del rayo.
+ * @param inverseDirection Inverso de cada componente de la dirección.
+ * @param maxDistance Parámetro máximo del rayo.
+ * @param entry Parámetro de entrada en la caja (salida).
+ * @return true si el rayo toca la caja antes de @p maxDistance.
+ */
+inline bool intersectRay(const BvhNode& node, const glm::vec3& origin, const glm::vec3& inverseDirection,
+                         float maxDistance, float& entry)
+{
+    const glm::vec3 t0 = (node.min - origin) * inverseDirection;
+    const glm::vec3 t1 = (node.max - origin) * inverseDirection;
+    const glm::vec3 closest = glm::min(t0, t1);
+    const glm::vec3 farthest = glm::max(t0, t1);
+    entry = glm::max(glm::max(closest.x, closest.y), glm::max(closest.z, 0.0f));
+    const float leave = glm::min(glm::min(farthest.x, farthest.y), glm::min(farthest.z, maxDistance));
+    return entry <= leave;
+}
+
+/**
+ * @brief Indica si una esfera toca la caja de un nodo.
+ */
+inline bool overlapsSphere(const BvhNode& node, const glm::vec3& center, float radius)
+{
+    const glm::vec3 offset = center - glm::clamp(center, node.min, node.max);
+    return glm::dot(offset, offset) <= radius * radius;
+}
+
+} // namespace Bvh
+
+#endif // BVH_H
@@ -0,0 +1,412 @@
+// EntityRegistry.cpp
+
+#include "entity_registry.h"
+#include "job_system.h"
+#include "transform_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+uint32_t ComponentSet::insert(Entity entity)
+{
+    const uint32_t index = entity.index();
+    if (index >= sparse.size())
+        sparse.resize(index + 1, kNone);
+    sparse[index] = static_cast<uint32_t>(dense.size());
+    dense.push_back(entity);
+    return sparse[index];
+}
+
+void TransformComponents::add(Entity entity, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    uint32_t index = indexOf(entity);
+    if (index == kNone)
+    {
+        index = insert(entity);
+        positions.emplace_back();
+        rotations.emplace_back();
+        scales.emplace_back();
+        worlds.emplace_back(1.0f);
+        normals.emplace_back(1.0f);
+        parents.emplace_back();
+        parentIndices.push_back(kNone);
+        dirty.push_back(0);
+        changed.push_back(0);
+        orderDirty = true;
+    }
+    positions[index] = position;
+    rotations[index] = rotation;
+    scales[index] = scale;
+    dirty[index] = 1;
+}
+
+bool TransformComponents::setParent(Entity entity, Entity parent)
+{
+    const uint32_t index = indexOf(entity);
+    if (index == kNone)
+        return false;
+    if (parent.valid())
+    {
+        if (!contains(parent))
+        {
+            std::cerr << "Transform parent has no transform" << std::endl;
+            return false;
+        }
+        // Walk up from the new parent: meeting the child means the link would close a cycle
+        for (Entity ancestor = parent; ancestor.valid() && contains(ancestor); ancestor = parents[indexOf(ancestor)])
+        {
+            if (ancestor == entity)
+            {
+                std::cerr << "Transform parent would create a cycle" << std::endl;
+                return false;
+            }
+        }
+    }
+    parents[index] = parent;
+    dirty[index] = 1;
+    orderDirty = true;
+    return true;
+}
+
+void TransformComponents::setPosition(Entity entity, const glm::vec3& position)
+{
+    const uint32_t index = indexOf(entity);
+    if (index == kNone)
+        return;
+    positions[index] = position;
+    dirty[index] = 1;
+}
+
+void TransformComponents::setRotation(Entity entity, const glm::quat& rotation)
+{
+    const uint32_t index = indexOf(entity);
+    if (index == kNone)
+        return;
+    rotations[index] = rotation;
+    dirty[index] = 1;
+}
+
+void TransformComponents::setScale(Entity entity, const glm::vec3& scale)
+{
+    const uint32_t index = indexOf(entity);
+    if (index == kNone)
+        return;
+    scales[index] = scale;
+    dirty[index] = 1;
+}
+
+// Stable sort by depth keeps siblings in insertion order, so re-sorting an unchanged tree is a no-op
+void TransformComponents::sortTopologically()
+{
+    const uint32_t count = static_cast<uint32_t>(size());
+
+    // Children of a removed parent become roots
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (parents[i].valid() && !contains(parents[i]))
+        {
+            parents[i] = Entity();
+            dirty[i] = 1;
+        }
+    }
+
+    depths.assign(count, 0);
+    for (uint32_t i = 0; i < count; ++i)
+        for (Entity ancestor = parents[i]; ancestor.valid(); ancestor = parents[indexOf(ancestor)])
+            ++depths[i];
+
+    // Bulk loads append parents before children, level after level: then nothing has to move
+    const bool inOrder = std::is_sorted(depths.begin(), depths.end());
+    order.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+        order[i] = i;
+    if (!inOrder)
+        std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return depths[a] < depths[b]; });
+
+    levelEnds.clear();
+    for (uint32_t i = 1; i <= count; ++i)
+        if (i == count || depths[order[i]] != depths[order[i - 1]])
+            levelEnds.push_back(i);
+
+    if (!inOrder)
+        reorder(order, positions, rotations, scales, worlds, normals, parents, dirty, changed);
+    for (uint32_t i = 0; i < count; ++i)
+        parentIndices[i] = parents[i].valid() ? indexOf(parents[i]) : kNone;
+    orderDirty = false;
+}
+
+void BoundsComponents::add(Entity entity, const glm::vec3& center, float radius)
+{
+    uint32_t index = indexOf(entity);
+    if (index == kNone)
+    {
+        index = insert(entity);
+        localCenters.emplace_back();
+        localRadii.emplace_back();
+        worldCenters.emplace_back(center);
+        worldRadii.emplace_back(radius);
+        visible.emplace_back(1);
+        dirty.emplace_back();
+    }
+    localCenters[index] = center;
+    localRadii[index] = radius;
+    dirty[index] = 1;
+}
+
+void MeshComponents::add(Entity entity, const Mesh& mesh)
+{
+    uint32_t index = indexOf(entity);
+    if (index == kNone)
+    {
+        index = insert(entity);
+        meshes.emplace_back();
+    }
+    meshes[index] = &mesh;
+}
+
+void MaterialComponents::add(Entity entity, const VirtualTexture* virtualTexture, bool sided)
+{
+    uint32_t index = indexOf(entity);
+    if (index == kNone)
+    {
+        index = insert(entity);
+        virtualTextures.emplace_back();
+        doubleSided.emplace_back();
+    }
+    virtualTextures[index] = virtualTexture;
+    doubleSided[index] = sided ? 1 : 0;
+}
+
+void LightComponents::add(Entity entity, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular,
+                          float constant, float linear, float quadratic)
+{
+    uint32_t index = indexOf(entity);
+    if (index == kNone)
+    {
+        index = insert(entity);
+        ambients.emplace_back();
+        diffuses.emplace_back();
+        speculars.emplace_back();
+        constants.emplace_back();
+        linears.emplace_back();
+        quadratics.emplace_back();
+    }
+    ambients[index] = ambient;
+    diffuses[index] = diffuse;
+    speculars[index] = specular;
+    constants[index] = constant;
+    linears[index] = linear;
+    quadratics[index] = quadratic;
+}
+
+Entity EntityRegistry::create()
+{
+    Entity entity;
+    if (!freeIndices.empty())
+    {
+        const uint32_t index = freeIndices.back();
+        freeIndices.pop_back();
+        entity.id = (static_cast<uint32_t>(generations[index]) << 24) | index;
+    }
+    else
+    {
+        entity.id = static_cast<uint32_t>(generations.size());
+        generations.push_back(0);
+    }
+    return entity;
+}
+
+void EntityRegistry::destroy(Entity entity)
+{
+    if (!alive(entity))
+        return;
+    transforms.remove(entity);
+    bounds.remove(entity);
+    meshes.remove(entity);
+    materials.remove(entity);
+    lights.remove(entity);
+    ++generations[entity.index()];
+    freeIndices.push_back(entity.index());
+}
+
+Entity EntityRegistry::createRenderable(const Mesh& mesh, const glm::vec3& position, bool doubleSided,
+                                        const VirtualTexture* virtualTexture)
+{
+    const Entity entity = create();
+    transforms.add(entity, position);
+    makeRenderable(entity, mesh, doubleSided, virtualTexture);
+    return entity;
+}
+
+void EntityRegistry::makeRenderable(Entity entity, const Mesh& mesh, bool doubleSided, const VirtualTexture* virtualTexture)
+{
+    bounds.add(entity, mesh.getBoundsCenter(), mesh.getBoundsRadius());
+    meshes.add(entity, mesh);
+    materials.add(entity, virtualTexture, doubleSided);
+}
+
+Entity EntityRegistry::createNode(const glm::vec3& position, Entity parent, const glm::quat& rotation, const glm::vec3& scale)
+{
+    const Entity entity = create();
+    transforms.add(entity, position, rotation, scale);
+    if (parent.valid())
+        transforms.setParent(entity, parent);
+    return entity;
+}
+
+void EntityRegistry::reserve(size_t nodes, size_t renderables)
+{
+    generations.reserve(generations.size() + nodes);
+    transforms.reserve(nodes);
+    bounds.reserve(renderables);
+    meshes.reserve(renderables);
+    materials.reserve(renderables);
+}
+
+Entity EntityRegistry::createPointLight(const glm::vec3& position, const glm::vec3& ambient, const glm::vec3& diffuse,
+                                        const glm::vec3& specular, float constant, float linear, float quadratic)
+{
+    const Entity entity = create();
+    transforms.add(entity, position);
+    lights.add(entity, ambient, diffuse, specular, constant, linear, quadratic);
+    return entity;
+}
+
+void EntityRegistry::updateTransforms(size_t begin, size_t end)
+{
+    const TransformKernels::TransformBatch batch{transforms.positions.data(), transforms.rotations.data(),
+                                                 transforms.scales.data(), transforms.worlds.data(), transforms.normals.data()};
+    const uint32_t* parent = transforms.parentIndices.data();
+    uint8_t* dirty = transforms.dirty.data();
+    uint8_t* changed = transforms.changed.data();
+    glm::mat4* world = transforms.worlds.data();
+    glm::mat3* normal = transforms.normals.data();
+
+    // Nodes to recompute go through the batch kernel in fixed-size chunks (no allocation);
+    // children then compose with their parent, whose matrices are already this frame's
+    uint32_t pending[kKernelBatch];
+    size_t count = 0;
+    auto flush = [&]() {
+        TransformKernels::composeTRS(batch, pending, count);
+        for (size_t k = 0; k < count; ++k)
+        {
+            const uint32_t i = pending[k];
+            const uint32_t p = parent[i];
+            if (p == ComponentSet::kNone)
+                continue;
+            world[i] = world[p] * world[i];
+            normal[i] = normal[p] * normal[i];
+        }
+        count = 0;
+    };
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        // Parents sit in earlier levels, so their changed flag is already this frame's
+        const uint32_t p = parent[i];
+        if (!dirty[i] && (p == ComponentSet::kNone || !changed[p]))
+        {
+            changed[i] = 0;
+            continue;
+        }
+        dirty[i] = 0;
+        changed[i] = 1;
+        pending[count++] = static_cast<uint32_t>(i);
+        if (count == kKernelBatch)
+            flush();
+    }
+    if (count)
+        flush();
+}
+
+void EntityRegistry::updateBounds(size_t begin, size_t end)
+{
+    const TransformKernels::SphereBatch batch{transforms.worlds.data(), bounds.localCenters.data(), bounds.localRadii.data(),
+                                              bounds.worldCenters.data(), bounds.worldRadii.data()};
+    uint32_t spheres[kKernelBatch];
+    uint32_t matrices[kKernelBatch];
+    size_t count = 0;
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        const uint32_t t = transforms.indexOf(bounds.entity(static_cast<uint32_t>(i)), static_cast<uint32_t>(i));
+        if (t == ComponentSet::kNone)
+        {
+            bounds.worldCenters[i] = bounds.localCenters[i];
+            bounds.worldRadii[i] = bounds.localRadii[i];
+            continue;
+        }
+        if (!bounds.dirty[i] && !transforms.changed[t])
+            continue;
+        bounds.dirty[i] = 0;
+        spheres[count] = static_cast<uint32_t>(i);
+        matrices[count++] = t;
+        if (count == kKernelBatch)
+        {
+            TransformKernels::transformSpheres(batch, spheres, matrices, count);
+            count = 0;
+        }
+    }
+    if (count)
+        TransformKernels::transformSpheres(batch, spheres, matrices, count);
+}
+
+void EntityRegistry::cull(const Frustum& frustum, size_t begin, size_t end)
+{
+    const glm::vec3* center = bounds.worldCenters.data();
+    const float* radius = bounds.worldRadii.data();
+    uint8_t* visible = bounds.visible.data();
+    for (size_t i = begin; i < end; ++i)
+        visible[i] = frustum.intersectsSphere(center[i], radius[i]) ? 1 : 0;
+}
+
+void EntityRegistry::update(const Frustum& frustum)
+{
+    // Ranges large enough to amortize a job; small scenes run inline
+    constexpr size_t kGrain = 4096;
+    JobSystem* jobs = JobSystem::active();
+    auto run = [jobs](size_t begin, size_t end, auto&& system) {
+        if (jobs && end - begin > kGrain)
+            jobs->parallelFor(begin, end, kGrain, system);
+        else
+            system(begin, end);
+    };
+
+    // One pass per depth level: a level only reads the world matrices of the one before
+    if (transforms.needsSort())
+        transforms.sortTopologically();
+    size_t levelBegin = 0;
+    for (uint32_t levelEnd : transforms.levels())
+    {
+        run(levelBegin, levelEnd, [this](size_t begin, size_t end) { updateTransforms(begin, end); });
+        levelBegin = levelEnd;
+    }
+
+    run(0, bounds.size(), [this, &frustum](size_t begin, size_t end) {
+        updateBounds(begin, end);
+        cull(frustum, begin, end);
+    });
+}
+
+// The mesh's maps pick the variant; a ready virtual texture replaces its tiled diffuse map
+ShaderVariantKey EntityRegistry::materialKey(uint32_t meshIndex, ShaderVariantKey base,
+                                             const VirtualTexture*& virtualTexture, bool& doubleSided) const
+{
+    const Entity entity = meshes.entity(meshIndex);
+    ShaderVariantKey key = meshes.meshes[meshIndex]->materialKey(base);
+    virtualTexture = nullptr;
+    doubleSided = false;
+
+    const uint32_t m = materials.indexOf(entity, meshIndex);
+    if (m == ComponentSet::kNone)
+        return key;
+    doubleSided = materials.doubleSided[m] != 0;
+    const VirtualTexture* candidate = materials.virtualTextures[m];
+    if (candidate && candidate->isReady())
+    {
+        key.virtualTexture = true;
+        key.diffuseMap = false;
+        virtualTexture = candidate;
+    }
+    return key;
+}
@@ -0,0 +1,462 @@
+#ifndef ENTITY_REGISTRY_H
+#define ENTITY_REGISTRY_H
+
+#include "Mesh.h"
+#include "frustum.h"
+#include "shader_variants.h"
+#include "virtual_texture.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+/**
+ * @struct Entity
+ * @brief Identificador de una entidad: índice (24 bits) y generación (8 bits).
+ *
+ * La generación cambia al destruir la entidad, así que un identificador viejo deja de
+ * ser válido aunque su índice se reutilice.
+ */
+struct Entity {
+    static constexpr uint32_t kInvalidId = 0xFFFFFFFFu;
+
+    uint32_t id = kInvalidId;   /**< Índice y generación empaquetados */
+
+    uint32_t index() const { return id & 0x00FFFFFFu; }
+    uint32_t generation() const { return id >> 24; }
+    bool valid() const { return id != kInvalidId; }
+    bool operator==(const Entity& other) const { return id == other.id; }
+    bool operator!=(const Entity& other) const { return id != other.id; }
+};
+
+/**
+ * @class ComponentSet
+ * @brief Conjunto disperso de entidades: índice denso por entidad y entidad por índice denso.
+ *
+ * Cada pool de componentes hereda de aquí y guarda sus campos en arreglos paralelos
+ * (estructura de arreglos) indexados por el índice denso. Quitar una entidad mueve la
+ * última a su hueco, así que los arreglos siguen contiguos y sin agujeros.
+ */
+class ComponentSet {
+public:
+    static constexpr uint32_t kNone = 0xFFFFFFFFu;
+
+    /**
+     * @brief Indica si la entidad tiene este componente.
+     */
+    bool contains(Entity entity) const
+    {
+        const uint32_t index = entity.index();
+        return index < sparse.size() && sparse[index] != kNone && dense[sparse[index]] == entity;
+    }
+
+    /**
+     * @brief Índice denso del componente de una entidad.
+     * @return uint32_t Índice, o kNone si no lo tiene.
+     */
+    uint32_t indexOf(Entity entity) const { return contains(entity) ? sparse[entity.index()] : kNone; }
+
+    /**
+     * @brief Índice denso con una pista: pools rellenados en el mismo orden comparten índices.
+     * @param entity Entidad.
+     * @param hint Índice que probablemente tiene (ej: su índice en otro pool).
+     */
+    uint32_t indexOf(Entity entity, uint32_t hint) const
+    {
+        return hint < dense.size() && dense[hint] == entity ? hint : indexOf(entity);
+    }
+
+    /**
+     * @brief Entidad del índice denso @p index.
+     */
+    Entity entity(uint32_t index) const { return dense[index]; }
+
+    /**
+     * @brief Componentes en el pool.
+     */
+    size_t size() const { return dense.size(); }
+
+protected:
+    std::vector<Entity> dense;      /**< Entidad de cada índice denso */
+    std::vector<uint32_t> sparse;   /**< Índice denso de cada índice de entidad (kNone si no está) */
+
+    /**
+     * @brief Reserva el índice denso de una entidad nueva en el pool.
+     * @return uint32_t Índice donde escribir sus campos (al final de cada arreglo).
+     */
+    uint32_t insert(Entity entity);
+
+    /**
+     * @brief Quita una entidad moviendo la última a su hueco en el conjunto y en cada arreglo.
+     * @param entity Entidad (si no está no hace nada).
+     * @param columns Arreglos de campos del pool.
+     */
+    template <typename... Columns>
+    void erase(Entity entity, Columns&... columns)
+    {
+        const uint32_t index = indexOf(entity);
+        if (index == kNone)
+            return;
+        const uint32_t last = static_cast<uint32_t>(dense.size() - 1);
+        ((columns[index] = std::move(columns[last]), columns.pop_back()), ...);
+        dense[index] = dense[last];
+        sparse[dense[index].index()] = index;
+        dense.pop_back();
+        sparse[entity.index()] = kNone;
+    }
+
+    /**
+     * @brief Reserva sitio para @p count componentes más en el conjunto y en cada arreglo.
+     * @param count Componentes que se van a añadir.
+     * @param columns Arreglos de campos del pool.
+     */
+    template <typename... Columns>
+    void reserveMore(size_t count, Columns&... columns)
+    {
+        dense.reserve(dense.size() + count);
+        sparse.reserve(sparse.size() + count);
+        (columns.reserve(columns.size() + count), ...);
+    }
+
+    /**
+     * @brief Reordena el conjunto y cada arreglo: la posición @c i pasa a tener lo que había en @c order[i].
+     * @param order Permutación de los índices densos.
+     * @param columns Arreglos de campos del pool.
+     */
+    template <typename... Columns>
+    void reorder(const std::vector<uint32_t>& order, Columns&... columns)
+    {
+        permute(order, dense);
+        (permute(order, columns), ...);
+        for (uint32_t i = 0; i < dense.size(); ++i)
+            sparse[dense[i].index()] = i;
+    }
+
+private:
+    template <typename Column>
+    static void permute(const std::vector<uint32_t>& order, Column& column)
+    {
+        Column sorted;
+        sorted.reserve(column.size());
+        for (uint32_t from : order)
+            sorted.push_back(std::move(column[from]));
+        column.swap(sorted);
+    }
+};
+
+/**
+ * @struct TransformComponents
+ * @brief Jerarquía de transformaciones: posición, rotación y escala locales (relativas al padre) y la matriz de mundo.
+ *
+ * Los arreglos se guardan en orden topológico (cada padre antes que sus hijos), agrupados
+ * por profundidad, así que el sistema de transformaciones los recorre una sola vez en
+ * línea y los nodos de un mismo nivel pueden repartirse entre hilos. Solo se recalculan
+ * las matrices de nodos marcados como sucios y de sus descendientes: los objetos estáticos
+ * no cuestan nada por frame y mover un padre mueve todo su subárbol.
+ *
+ * Escribir directamente en @ref positions, @ref rotations o @ref scales no marca el nodo;
+ * use los setters o @ref markDirty. Añadir, quitar o cambiar de padre reordena los arreglos
+ * en el siguiente @ref EntityRegistry::update, por lo que los índices densos no son estables.
+ */
+struct TransformComponents : ComponentSet {
+    std::vector<glm::vec3> positions;       /**< Posición local */
+    std::vector<glm::quat> rotations;       /**< Rotación local */
+    std::vector<glm::vec3> scales;          /**< Escala local */
+    std::vector<glm::mat4> worlds;          /**< Matriz de modelo (salida de @ref EntityRegistry::updateTransforms) */
+    std::vector<glm::mat3> normals;         /**< Matriz de normales: inversa traspuesta de la parte 3x3 de @ref worlds */
+    std::vector<Entity> parents;            /**< Padre (inválido en las raíces) */
+    std::vector<uint32_t> parentIndices;    /**< Índice denso del padre (kNone en las raíces) */
+    std::vector<uint8_t> dirty;             /**< 1 si la transformación local cambió desde el último update */
+    std::vector<uint8_t> changed;           /**< 1 si la matriz de mundo se recalculó en el último update */
+
+    /**
+     * @brief Añade o sustituye la transformación local de una entidad (una entidad nueva es raíz).
+     */
+    void add(Entity entity, const glm::vec3& position, const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+             const glm::vec3& scale = glm::vec3(1.0f));
+
+    /**
+     * @brief Quita la transformación de una entidad. Sus hijos pasan a ser raíces con su transformación local.
+     */
+    void remove(Entity entity)
+    {
+        erase(entity, positions, rotations, scales, worlds, normals, parents, parentIndices, dirty, changed);
+        orderDirty = true;
+    }
+
+    /**
+     * @brief Reserva sitio para @p count transformaciones más (cargas masivas).
+     */
+    void reserve(size_t count)
+    {
+        reserveMore(count, positions, rotations, scales, worlds, normals, parents, parentIndices, dirty, changed);
+    }
+
+    /**
+     * @brief Cuelga una entidad de otra; su transformación local pasa a ser relativa al padre.
+     *
+     * @param entity Entidad con transformación.
+     * @param parent Nuevo padre con transformación, o una entidad inválida para hacerla raíz.
+     * @return true si se aplicó; false si falta alguna transformación o crearía un ciclo.
+     */
+    bool setParent(Entity entity, Entity parent);
+
+    /**
+     * @brief Cambia la posición local y marca el nodo.
+     */
+    void setPosition(Entity entity, const glm::vec3& position);
+
+    /**
+     * @brief Cambia la rotación local y marca el nodo.
+     */
+    void setRotation(Entity entity, const glm::quat& rotation);
+
+    /**
+     * @brief Cambia la escala local y marca el nodo.
+     */
+    void setScale(Entity entity, const glm::vec3& scale);
+
+    /**
+     * @brief Marca un nodo cuya transformación local se escribió directamente.
+     * @param index Índice denso.
+     */
+    void markDirty(uint32_t index) { dirty[index] = 1; }
+
+    /**
+     * @brief Indica si hay que reordenar los arreglos antes de recorrer la jerarquía.
+     */
+    bool needsSort() const { return orderDirty; }
+
+    /**
+     * @brief Reordena los arreglos por profundidad (padres antes que hijos) y recalcula @ref parentIndices.
+     */
+    void sortTopologically();
+
+    /**
+     * @brief Fin (exclusivo) de cada nivel de profundidad en los arreglos, tras @ref sortTopologically.
+     */
+    const std::vector<uint32_t>& levels() const { return levelEnds; }
+
+private:
+    std::vector<uint32_t> levelEnds;    /**< Fin de cada nivel, de las raíces a las hojas */
+    std::vector<uint32_t> depths;       /**< Profundidad de cada nodo (auxiliar de la ordenación) */
+    std::vector<uint32_t> order;        /**< Permutación de la ordenación */
+    bool orderDirty = false;            /**< La estructura cambió desde la última ordenación */
+};
+
+/**
+ * @struct BoundsComponents
+ * @brief Esfera envolvente local, su versión en el mundo y el resultado del culling.
+ */
+struct BoundsComponents : ComponentSet {
+    std::vector<glm::vec3> localCenters;  /**< Centro en espacio de la malla */
+    std::vector<float> localRadii;        /**< Radio en espacio de la malla */
+    std::vector<glm::vec3> worldCenters;  /**< Centro en el mundo (salida de @ref EntityRegistry::updateBounds) */
+    std::vector<float> worldRadii;        /**< Radio en el mundo */
+    std::vector<uint8_t> visible;         /**< 1 si pasó el último culling */
+    std::vector<uint8_t> dirty;           /**< 1 si la esfera local cambió desde el último update */
+
+    /**
+     * @brief Añade o sustituye la esfera local de una entidad.
+     */
+    void add(Entity entity, const glm::vec3& center, float radius);
+
+    /**
+     * @brief Quita la esfera de una entidad.
+     */
+    void remove(Entity entity) { erase(entity, localCenters, localRadii, worldCenters, worldRadii, visible, dirty); }
+    void reserve(size_t count) { reserveMore(count, localCenters, localRadii, worldCenters, worldRadii, visible, dirty); }
+};
+
+/**
+ * @struct MeshComponents
+ * @brief Malla que dibuja la entidad (no propia: la dueña debe vivir más que el componente).
+ */
+struct MeshComponents : ComponentSet {
+    std::vector<const Mesh*> meshes;    /**< Geometría y texturas */
+
+    void add(Entity entity, const Mesh& mesh);
+    void remove(Entity entity) { erase(entity, meshes); }
+    void reserve(size_t count) { reserveMore(count, meshes); }
+};
+
+/**
+ * @struct MaterialComponents
+ * @brief Estado de material que no está en las texturas de la malla.
+ */
+struct MaterialComponents : ComponentSet {
+    std::vector<const VirtualTexture*> virtualTextures; /**< Sustituye al mapa difuso cuando está lista (puede ser nula) */
+    std::vector<uint8_t> doubleSided;                   /**< Dibuja ambas caras */
+
+    void add(Entity entity, const VirtualTexture* virtualTexture, bool doubleSided);
+    void remove(Entity entity) { erase(entity, virtualTextures, doubleSided); }
+    void reserve(size_t count) { reserveMore(count, virtualTextures, doubleSided); }
+};
+
+/**
+ * @struct LightComponents
+ * @brief Luces puntuales; la posición sale de la transformación de la entidad.
+ */
+struct LightComponents : ComponentSet {
+    std::vector<glm::vec3> ambients;    /**< Componente ambiental */
+    std::vector<glm::vec3> diffuses;    /**< Componente difusa */
+    std::vector<glm::vec3> speculars;   /**< Componente especular */
+    std::vector<float> constants;       /**< Atenuación constante */
+    std::vector<float> linears;         /**< Atenuación lineal */
+    std::vector<float> quadratics;      /**< Atenuación cuadrática */
+
+    void add(Entity entity, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular,
+             float constant, float linear, float quadratic);
+    void remove(Entity entity) { erase(entity, ambients, diffuses, speculars, constants, linears, quadratics); }
+};
+
+/**
+ * @class EntityRegistry
+ * @brief Entidades de la escena y sus componentes en pools densos de estructura de arreglos.
+ *
+ * Cada pool guarda cada campo en su propio arreglo contiguo, de modo que un sistema solo
+ * recorre los datos que lee (ej: el culling lee centros y radios, no matrices ni mallas).
+ * Los sistemas trabajan sobre rangos de índices densos y se reparten entre los trabajadores
+ * del @ref JobSystem activo. Las entidades creadas con todos sus componentes a la vez
+ * ocupan el mismo índice en cada pool, y las uniones entre pools lo aprovechan antes de
+ * recurrir al índice disperso.
+ *
+ * Crear, destruir y añadir componentes se hace desde un solo hilo (el de OpenGL); los
+ * sistemas pueden correr en paralelo mientras nadie cambia la estructura.
+ */
+class EntityRegistry {
+public:
+    TransformComponents transforms; /**< Transformaciones */
+    BoundsComponents bounds;        /**< Esferas envolventes y visibilidad */
+    MeshComponents meshes;          /**< Mallas */
+    MaterialComponents materials;   /**< Estado de material */
+    LightComponents lights;         /**< Luces puntuales */
+
+    /**
+     * @brief Crea una entidad sin componentes.
+     */
+    Entity create();
+
+    /**
+     * @brief Quita todos los componentes de la entidad e invalida su identificador.
+     */
+    void destroy(Entity entity);
+
+    /**
+     * @brief Indica si el identificador corresponde a una entidad viva.
+     */
+    bool alive(Entity entity) const
+    {
+        return entity.valid() && entity.index() < generations.size() && generations[entity.index()] == entity.generation();
+    }
+
+    /**
+     * @brief Entidades vivas.
+     */
+    size_t size() const { return generations.size() - freeIndices.size(); }
+
+    /**
+     * @brief Crea una entidad dibujable: transformación, esfera de la malla, malla y material.
+     *
+     * @param mesh Malla (no propia).
+     * @param position Posición local (en el mundo mientras no tenga padre).
+     * @param doubleSided Dibuja ambas caras.
+     * @param virtualTexture Textura virtual del material (opcional).
+     * @return Entity Entidad creada.
+     */
+    Entity createRenderable(const Mesh& mesh, const glm::vec3& position, bool doubleSided = false,
+                            const VirtualTexture* virtualTexture = nullptr);
+
+    /**
+     * @brief Hace dibujable una entidad que ya tiene transformación: esfera de la malla, malla y material.
+     *
+     * @param entity Entidad con transformación (ej: un nodo creado con @ref createNode).
+     * @param mesh Malla (no propia).
+     * @param doubleSided Dibuja ambas caras.
+     * @param virtualTexture Textura virtual del material (opcional).
+     */
+    void makeRenderable(Entity entity, const Mesh& mesh, bool doubleSided = false,
+                        const VirtualTexture* virtualTexture = nullptr);
+
+    /**
+     * @brief Crea un nodo de la jerarquía: entidad con solo transformación, para agrupar otras.
+     * @param position Posición local.
+     * @param parent Padre (opcional).
+     * @param rotation Rotación local.
+     * @param scale Escala local.
+     */
+    Entity createNode(const glm::vec3& position, Entity parent = Entity(),
+                      const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), const glm::vec3& scale = glm::vec3(1.0f));
+
+    /**
+     * @brief Reserva sitio para una carga masiva, así crear entidades no realoja los pools a cada paso.
+     * @param nodes Entidades con transformación que se van a crear.
+     * @param renderables Cuántas de ellas serán dibujables.
+     */
+    void reserve(size_t nodes, size_t renderables);
+
+    /**
+     * @brief Crea una luz puntual en @p position.
+     */
+    Entity createPointLight(const glm::vec3& position, const glm::vec3& ambient, const glm::vec3& diffuse,
+                            const glm::vec3& specular, float constant, float linear, float quadratic);
+
+    /**
+     * @brief Sistema de transformaciones: matrices de mundo y de normales de los nodos sucios y de los hijos de nodos recalculados.
+     *
+     * La matriz de normales se compone como la de mundo, sin invertir nada: la de R * S es
+     * R * S^-1, así que la del hijo es la del padre por la suya local. Las matrices locales
+     * salen de @ref TransformKernels::composeTRS en lotes de @c kKernelBatch nodos.
+     *
+     * Los padres del rango deben estar ya calculados: se llama nivel a nivel (@ref TransformComponents::levels).
+     *
+     * @param begin Primer índice denso de @ref transforms.
+     * @param end Índice denso final (exclusivo).
+     */
+    void updateTransforms(size_t begin, size_t end);
+
+    /**
+     * @brief Sistema de esferas: pasa al mundo las esferas cuya transformación o esfera local cambió.
+     *
+     * Las esferas pendientes pasan por @ref TransformKernels::transformSpheres en lotes.
+     * @param begin Primer índice denso de @ref bounds.
+     * @param end Índice denso final (exclusivo).
+     */
+    void updateBounds(size_t begin, size_t end);
+
+    /**
+     * @brief Sistema de culling: marca @c visible en las esferas que tocan el frustum.
+     * @param frustum Frustum de la cámara.
+     * @param begin Primer índice denso de @ref bounds.
+     * @param end Índice denso final (exclusivo).
+     */
+    void cull(const Frustum& frustum, size_t begin, size_t end);
+
+    /**
+     * @brief Ejecuta transformaciones (nivel a nivel), esferas y culling sobre todos los pools, en paralelo si hay trabajadores.
+     * @param frustum Frustum de la cámara.
+     */
+    void update(const Frustum& frustum);
+
+    /**
+     * @brief Variante de shader del material de una malla.
+     *
+     * @param meshIndex Índice denso en @ref meshes.
+     * @param base Características comunes de la escena.
+     * @param virtualTexture Salida: textura virtual a aplicar, o nula.
+     * @param doubleSided Salida: dibuja ambas caras.
+     * @return ShaderVariantKey Variante.
+     */
+    ShaderVariantKey materialKey(uint32_t meshIndex, ShaderVariantKey base, const VirtualTexture*& virtualTexture,
+                                 bool& doubleSided) const;
+
+private:
+    static constexpr size_t kKernelBatch = 256; /**< Índices por llamada a los núcleos de @ref TransformKernels */
+
+    std::vector<uint8_t> generations;   /**< Generación actual de cada índice */
+    std::vector<uint32_t> freeIndices;  /**< Índices de entidades destruidas */
+};
+
+#endif // ENTITY_REGISTRY_H
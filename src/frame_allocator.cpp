@@ -0,0 +1,102 @@
+// FrameAllocator.cpp
+
+#include "frame_allocator.h"
+#include <algorithm>
+
+static thread_local FrameAllocator* tlsFrameAllocator = nullptr;
+
+LinearArena::LinearArena(size_t capacity)
+    : memory(static_cast<unsigned char*>(::operator new(capacity))), size(capacity), offset(0),
+      demand(0), peak(0), overflows(0), overflowList(nullptr)
+{
+}
+
+LinearArena::~LinearArena()
+{
+    reset();
+    ::operator delete(memory);
+}
+
+void* LinearArena::allocate(size_t bytes, size_t alignment)
+{
+    const uintptr_t base = reinterpret_cast<uintptr_t>(memory);
+    const size_t aligned = ((base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+    demand += bytes + (aligned - offset);
+    peak = std::max(peak, demand);
+    if (aligned + bytes <= size)
+    {
+        offset = aligned + bytes;
+        return memory + aligned;
+    }
+
+    // Does not fit: serve it from the heap until the next reset grows the block
+    const size_t header = (sizeof(Overflow) + alignment - 1) & ~(alignment - 1);
+    unsigned char* block = static_cast<unsigned char*>(::operator new(header + bytes + alignment));
+    Overflow* overflow = reinterpret_cast<Overflow*>(block);
+    overflow->next = overflowList;
+    overflowList = overflow;
+    ++overflows;
+    const uintptr_t start = reinterpret_cast<uintptr_t>(block) + header;
+    return reinterpret_cast<void*>((start + alignment - 1) & ~(uintptr_t)(alignment - 1));
+}
+
+void LinearArena::reset()
+{
+    while (overflowList)
+    {
+        Overflow* next = overflowList->next;
+        ::operator delete(overflowList);
+        overflowList = next;
+    }
+
+    // One reallocation after a frame that did not fit, none in steady state
+    if (overflows > 0 && demand > size)
+    {
+        size_t grown = size;
+        while (grown < demand)
+            grown *= 2;
+        ::operator delete(memory);
+        memory = static_cast<unsigned char*>(::operator new(grown));
+        size = grown;
+    }
+    offset = 0;
+    demand = 0;
+    overflows = 0;
+}
+
+FrameAllocator::FrameAllocator(size_t scratchBytes, size_t bufferedBytes)
+    : scratchArena(scratchBytes), bufferedArenas{LinearArena(bufferedBytes), LinearArena(bufferedBytes)},
+      current(0), frames(0)
+{
+}
+
+FrameAllocator::~FrameAllocator()
+{
+    if (tlsFrameAllocator == this)
+        tlsFrameAllocator = nullptr;
+}
+
+void FrameAllocator::beginFrame()
+{
+    scratchArena.reset();
+    // The other arena holds last frame's data, which stays valid during this one
+    current ^= 1;
+    bufferedArenas[current].reset();
+    ++frames;
+}
+
+void FrameAllocator::activate()
+{
+    tlsFrameAllocator = this;
+}
+
+FrameAllocator* FrameAllocator::active()
+{
+    return tlsFrameAllocator;
+}
+
+FrameString frameString(const char* text)
+{
+    FrameAllocator* frame = FrameAllocator::active();
+    return FrameString(text, ArenaAllocator<char>(frame ? &frame->scratch() : nullptr));
+}
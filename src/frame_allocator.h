@@ -0,0 +1,186 @@
+#ifndef FRAME_ALLOCATOR_H
+#define FRAME_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <vector>
+
+/**
+ * @class LinearArena
+ * @brief Arena lineal: reserva avanzando un puntero y libera todo de una vez con @ref reset.
+ *
+ * Pensada para temporales de vida conocida (un frame). Si una reserva no cabe, se atiende
+ * desde el heap y se libera en el siguiente @ref reset; ese reset agranda además el bloque
+ * hasta la demanda observada, de modo que en régimen estable no hay reservas en el heap.
+ * No es segura entre hilos: cada arena pertenece a un único hilo.
+ */
+class LinearArena {
+public:
+    /**
+     * @brief Constructor.
+     * @param capacity Bytes del bloque inicial.
+     */
+    explicit LinearArena(size_t capacity);
+    ~LinearArena();
+
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    /**
+     * @brief Reserva memoria sin inicializar.
+     * @param size Bytes.
+     * @param alignment Alineación (potencia de dos).
+     * @return void* Memoria válida hasta el siguiente @ref reset.
+     */
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    /**
+     * @brief Libera todas las reservas y, si hubo desbordes, agranda el bloque.
+     */
+    void reset();
+
+    size_t used() const { return offset; }           /**< Bytes reservados en el bloque desde el último reset */
+    size_t capacity() const { return size; }         /**< Bytes del bloque */
+    size_t highWater() const { return peak; }        /**< Mayor demanda (bloque + desbordes) entre dos resets */
+    size_t overflowCount() const { return overflows; } /**< Reservas desbordadas al heap desde el último reset */
+
+private:
+    /**
+     * @struct Overflow
+     * @brief Cabecera de una reserva desbordada al heap.
+     */
+    struct Overflow {
+        Overflow* next;     /**< Siguiente desborde */
+    };
+
+    unsigned char* memory;  /**< Bloque */
+    size_t size;            /**< Bytes del bloque */
+    size_t offset;          /**< Siguiente byte libre */
+    size_t demand;          /**< Bytes pedidos desde el último reset (bloque + desbordes) */
+    size_t peak;            /**< Máximo de @ref demand */
+    size_t overflows;       /**< Desbordes desde el último reset */
+    Overflow* overflowList; /**< Reservas desbordadas, liberadas en @ref reset */
+};
+
+/**
+ * @class ArenaAllocator
+ * @brief Asignador de la STL sobre una @ref LinearArena; sin arena usa el heap.
+ *
+ * @c deallocate no devuelve nada a la arena: la memoria se recupera entera en su reset.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator() noexcept : arena(nullptr) {}
+    explicit ArenaAllocator(LinearArena* arena) noexcept : arena(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(size_t n)
+    {
+        if (arena)
+            return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t) noexcept
+    {
+        if (!arena)
+            ::operator delete(pointer);
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept { return arena != other.arena; }
+
+    LinearArena* arena; /**< Arena de origen, o nullptr para el heap */
+};
+
+/// Cadena y vector cuyos datos viven en una arena de frame.
+using FrameString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+/**
+ * @class FrameAllocator
+ * @brief Memoria temporal del hilo de render: una arena por frame y un par de arenas alternas.
+ *
+ * - @ref scratch se vacía en cada @ref beginFrame: temporales del frame en curso (nombres
+ *   de uniforms, listas intermedias).
+ * - @ref buffered alterna entre dos arenas: lo reservado en el frame N sigue siendo válido
+ *   durante el frame N + 1 (datos que consume el frame siguiente).
+ *
+ * Cada hilo activa el suyo con @ref activate; @ref frameString y @ref frameVector usan el
+ * del hilo actual y, si no hay ninguno, el heap.
+ */
+class FrameAllocator {
+public:
+    /**
+     * @brief Constructor.
+     * @param scratchBytes Bytes iniciales de la arena del frame.
+     * @param bufferedBytes Bytes iniciales de cada arena alterna.
+     */
+    explicit FrameAllocator(size_t scratchBytes = 256 * 1024, size_t bufferedBytes = 64 * 1024);
+    ~FrameAllocator();
+
+    FrameAllocator(const FrameAllocator&) = delete;
+    FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+    /**
+     * @brief Empieza un frame: vacía @ref scratch y la arena alterna de hace dos frames.
+     */
+    void beginFrame();
+
+    /**
+     * @brief Arena de temporales válidos hasta el siguiente @ref beginFrame.
+     */
+    LinearArena& scratch() { return scratchArena; }
+
+    /**
+     * @brief Arena de datos válidos durante este frame y el siguiente.
+     */
+    LinearArena& buffered() { return bufferedArenas[current]; }
+
+    /**
+     * @brief Frames empezados desde la creación.
+     */
+    uint64_t frameIndex() const { return frames; }
+
+    /**
+     * @brief Hace de este el asignador de frame del hilo que llama.
+     */
+    void activate();
+
+    /**
+     * @brief Asignador de frame del hilo actual, o nullptr.
+     */
+    static FrameAllocator* active();
+
+private:
+    LinearArena scratchArena;       /**< Temporales del frame */
+    LinearArena bufferedArenas[2];  /**< Arenas alternas (frame par / impar) */
+    int current;                    /**< Arena alterna del frame en curso */
+    uint64_t frames;                /**< Contador de frames */
+};
+
+/**
+ * @brief Cadena vacía en la arena @ref FrameAllocator::scratch del hilo (o en el heap si no hay).
+ */
+FrameString frameString(const char* text = "");
+
+/**
+ * @brief Vector vacío en la arena @ref FrameAllocator::scratch del hilo (o en el heap si no hay).
+ */
+template <typename T>
+FrameVector<T> frameVector()
+{
+    FrameAllocator* frame = FrameAllocator::active();
+    return FrameVector<T>(ArenaAllocator<T>(frame ? &frame->scratch() : nullptr));
+}
+
+#endif // FRAME_ALLOCATOR_H
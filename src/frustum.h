@@ -0,0 +1,27 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+/**
+ * @struct Frustum
+ * @brief Los seis planos de una matriz view-projection, normalizados.
+ */
+struct Frustum {
+    glm::vec4 planes[6];    /**< Izquierdo, derecho, inferior, superior, cercano y lejano */
+
+    /**
+     * @brief Extrae los planos de una matriz view-projection.
+     * @param viewProjection Matriz proyección * vista.
+     */
+    static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+    /**
+     * @brief Indica si una esfera toca el volumen.
+     * @param center Centro en el mundo.
+     * @param radius Radio.
+     */
+    bool intersectsSphere(const glm::vec3& center, float radius) const;
+};
+
+#endif // FRUSTUM_H
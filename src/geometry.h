@@ -0,0 +1,90 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include "Mesh.h"
+#include <string>
+#include <vector>
+
+/**
+ * @namespace Geometry
+ * @brief Generadores de primitivas procedurales (cilindro, cono, esfera).
+ *
+ * Las funciones no tocan OpenGL, de modo que pueden usarse tanto en tiempo de
+ * ejecución como desde el constructor del asset pack para cocinar mallas.
+ */
+namespace Geometry {
+
+/**
+ * @brief Genera vértices para un cilindro.
+ *
+ * @param radius Radio del cilindro.
+ * @param height Altura del cilindro.
+ * @param sectorCount Número de sectores alrededor de la circunferencia.
+ * @return std::vector<Vertex> Vértices generados.
+ */
+std::vector<Vertex> generateCylinderVertices(float radius, float height, int sectorCount);
+
+/**
+ * @brief Genera índices para un cilindro.
+ *
+ * @param sectorCount Número de sectores alrededor de la circunferencia.
+ * @return std::vector<unsigned int> Índices generados.
+ */
+std::vector<unsigned int> generateCylinderIndices(int sectorCount);
+
+/**
+ * @brief Genera vértices para un cono.
+ *
+ * @param radius Radio base del cono.
+ * @param height Altura del cono.
+ * @param sectorCount Número de sectores alrededor de la circunferencia.
+ * @return std::vector<Vertex> Vértices generados.
+ */
+std::vector<Vertex> generateConeVertices(float radius, float height, int sectorCount);
+
+/**
+ * @brief Genera índices para un cono.
+ *
+ * @param sectorCount Número de sectores alrededor de la circunferencia.
+ * @return std::vector<unsigned int> Índices generados.
+ */
+std::vector<unsigned int> generateConeIndices(int sectorCount);
+
+/**
+ * @brief Genera vértices para una esfera.
+ *
+ * @param radius Radio de la esfera.
+ * @param sectorCount Número de sectores (cortes verticales).
+ * @param stackCount Número de stacks (cortes horizontales).
+ * @return std::vector<Vertex> Vértices generados.
+ */
+std::vector<Vertex> generateSphereVertices(float radius, int sectorCount, int stackCount);
+
+/**
+ * @brief Genera índices para una esfera.
+ *
+ * @param sectorCount Número de sectores (cortes verticales).
+ * @param stackCount Número de stacks (cortes horizontales).
+ * @return std::vector<unsigned int> Índices generados.
+ */
+std::vector<unsigned int> generateSphereIndices(int sectorCount, int stackCount);
+
+/**
+ * @brief Nombres de las mallas procedurales de la escena (las que cocina el asset pack).
+ * @return Lista de nombres, ej: "meshes/lighthouse/tower.mesh".
+ */
+const std::vector<std::string>& builtinMeshNames();
+
+/**
+ * @brief Genera una malla procedural de la escena a partir de su nombre.
+ *
+ * @param name Nombre de la malla (ver @ref builtinMeshNames).
+ * @param vertices Vértices generados.
+ * @param indices Índices generados.
+ * @return true si el nombre corresponde a una malla conocida.
+ */
+bool generateBuiltinMesh(const std::string& name, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+} // namespace Geometry
+
+#endif // GEOMETRY_H
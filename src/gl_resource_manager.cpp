@@ -0,0 +1,461 @@
+// GLResourceManager.cpp
+
+#include "gl_resource_manager.h"
+#include "texture_streamer.h"
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+GLResourceManager* GLResourceManager::activeManager = nullptr;
+
+GLResourceManager::GLResourceManager(size_t memoryBudgetBytes, size_t poolBudgetBytes)
+    : memoryBudget(memoryBudgetBytes), retiringBytes(0), poolBudget(poolBudgetBytes), pooledBytes(0),
+      frameIndex(0), deletedThisFrame(0)
+{
+    stats.budgetBytes = memoryBudget;
+}
+
+GLResourceManager::~GLResourceManager()
+{
+    if (activeManager == this)
+        activeManager = nullptr;
+}
+
+void GLResourceManager::activate()
+{
+    activeManager = this;
+}
+
+GLResourceManager* GLResourceManager::active()
+{
+    return activeManager;
+}
+
+size_t GLResourceManager::textureBytes(const GLTextureDesc& desc)
+{
+    size_t bytes = 0;
+    for (GLsizei level = 0; level < desc.levels; ++level)
+    {
+        const size_t w = static_cast<size_t>(std::max(1, desc.width >> level));
+        const size_t h = static_cast<size_t>(std::max(1, desc.height >> level));
+        bytes += w * h * Texture::bytesPerTexel(desc.internalFormat);
+    }
+    return desc.target == GL_TEXTURE_CUBE_MAP ? bytes * 6 : bytes;
+}
+
+size_t GLResourceManager::releaseBytes(const Release& release)
+{
+    switch (release.kind)
+    {
+        case Kind::Texture:     return textureBytes(release.texture);
+        case Kind::Buffer:      return static_cast<size_t>(release.size);
+        case Kind::VertexArray: return 0;
+    }
+    return 0;
+}
+
+void GLResourceManager::track(GLuint id, const GLTextureDesc& desc)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    liveTextures[id] = TextureAllocation{ desc, textureBytes(desc), frameIndex };
+}
+
+void GLResourceManager::track(GLuint id, GLenum target, GLsizeiptr size)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    liveBuffers[id] = BufferAllocation{ target, size };
+}
+
+size_t GLResourceManager::liveBytes() const
+{
+    size_t bytes = 0;
+    for (const auto& texture : liveTextures)
+        bytes += texture.second.bytes;
+    for (const auto& buffer : liveBuffers)
+        bytes += static_cast<size_t>(buffer.second.size);
+    return bytes;
+}
+
+size_t GLResourceManager::streamingBudget(size_t streamedStorageBytes) const
+{
+    size_t fixed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        fixed = liveBytes() + retiringBytes + pooledBytes;
+    }
+    fixed -= std::min(fixed, streamedStorageBytes);
+    return memoryBudget > fixed ? memoryBudget - fixed : 0;
+}
+
+uint64_t GLResourceManager::lastUsedFrame(GLuint id) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = liveTextures.find(id);
+    return it != liveTextures.end() ? it->second.lastUsedFrame : 0;
+}
+
+void GLResourceManager::touchTexture(GLuint id)
+{
+    if (activeManager && id != 0)
+        activeManager->touched.push_back(id);
+}
+
+void GLResourceManager::reportMemory(std::ostream& out) const
+{
+    // (kind, format, levels) -> (count, bytes); kind 0 = 2D texture, 1 = cubemap, 2 = buffer by target
+    std::map<std::tuple<int, GLenum, GLsizei>, std::pair<int, size_t>> groups;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& texture : liveTextures)
+        {
+            const GLTextureDesc& desc = texture.second.desc;
+            auto& group = groups[std::make_tuple(desc.target == GL_TEXTURE_CUBE_MAP ? 1 : 0, desc.internalFormat, desc.levels)];
+            ++group.first;
+            group.second += texture.second.bytes;
+        }
+        for (const auto& buffer : liveBuffers)
+        {
+            auto& group = groups[std::make_tuple(2, buffer.second.target, 0)];
+            ++group.first;
+            group.second += static_cast<size_t>(buffer.second.size);
+        }
+    }
+
+    out << "GPU memory: " << (stats.committedBytes >> 10) << " KB of " << (memoryBudget >> 10) << " KB budget ("
+        << (stats.pooledBytes >> 10) << " KB pooled, " << (stats.retiringBytes >> 10) << " KB retiring)" << std::endl;
+    for (const auto& group : groups)
+    {
+        const int kind = std::get<0>(group.first);
+        out << "  " << (kind == 0 ? "texture 2D" : kind == 1 ? "cubemap" : "buffer")
+            << std::hex << " 0x" << std::get<1>(group.first) << std::dec;
+        if (kind != 2)
+            out << ", " << std::get<2>(group.first) << " levels";
+        out << ": " << group.second.first << (group.second.first == 1 ? " object, " : " objects, ")
+            << (group.second.second >> 10) << " KB" << std::endl;
+    }
+}
+
+GLuint GLResourceManager::createTexture(const GLTextureDesc& desc)
+{
+    if (GLResourceManager* manager = activeManager)
+    {
+        // Most recently retired first: its memory is the most likely to still be warm
+        std::vector<PooledTexture>& pool = manager->texturePool;
+        for (size_t i = pool.size(); i-- > 0;)
+        {
+            if (!(pool[i].desc == desc))
+                continue;
+            const GLuint id = pool[i].id;
+            manager->pooledBytes -= pool[i].bytes;
+            pool.erase(pool.begin() + i);
+            ++manager->stats.textureReuses;
+            glBindTexture(desc.target, id);
+            glTexParameteri(desc.target, GL_TEXTURE_BASE_LEVEL, 0);
+            manager->track(id, desc);
+            return id;
+        }
+    }
+
+    GLuint id = 0;
+    glGenTextures(1, &id);
+    glBindTexture(desc.target, id);
+    glTexStorage2D(desc.target, desc.levels, desc.internalFormat, desc.width, desc.height);
+    if (activeManager)
+        activeManager->track(id, desc);
+    return id;
+}
+
+GLuint GLResourceManager::createBuffer(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+    if (GLResourceManager* manager = activeManager)
+    {
+        std::vector<PooledBuffer>& pool = manager->bufferPool;
+        for (size_t i = pool.size(); i-- > 0;)
+        {
+            if (pool[i].size != size || pool[i].usage != usage)
+                continue;
+            const GLuint id = pool[i].id;
+            manager->pooledBytes -= static_cast<size_t>(size);
+            pool.erase(pool.begin() + i);
+            ++manager->stats.bufferReuses;
+            glBindBuffer(target, id);
+            if (data)
+                glBufferSubData(target, 0, size, data);
+            manager->track(id, target, size);
+            return id;
+        }
+    }
+
+    GLuint id = 0;
+    glGenBuffers(1, &id);
+    glBindBuffer(target, id);
+    glBufferData(target, size, data, usage);
+    if (activeManager)
+        activeManager->track(id, target, size);
+    return id;
+}
+
+GLuint GLResourceManager::createStorageBuffer(GLenum target, GLsizeiptr size, GLbitfield flags)
+{
+    GLuint id = 0;
+    glGenBuffers(1, &id);
+    glBindBuffer(target, id);
+    glBufferStorage(target, size, nullptr, flags);
+    if (activeManager)
+        activeManager->track(id, target, size);
+    return id;
+}
+
+void GLResourceManager::deleteTexture(GLuint id, const GLTextureDesc& desc)
+{
+    if (id == 0)
+        return;
+    Release release = { Kind::Texture, id, desc, 0, 0 };
+    if (activeManager)
+        activeManager->defer(release);
+    else
+    {
+        if (TextureStreamer* streamer = TextureStreamer::active())
+            streamer->forget(id);
+        glDeleteTextures(1, &id);
+    }
+}
+
+void GLResourceManager::deleteBuffer(GLuint id, GLsizeiptr size, GLenum usage)
+{
+    if (id == 0)
+        return;
+    Release release = { Kind::Buffer, id, GLTextureDesc(), size, usage };
+    if (activeManager)
+        activeManager->defer(release);
+    else
+        glDeleteBuffers(1, &id);
+}
+
+void GLResourceManager::deleteVertexArray(GLuint id)
+{
+    if (id == 0)
+        return;
+    Release release = { Kind::VertexArray, id, GLTextureDesc(), 0, 0 };
+    if (activeManager)
+        activeManager->defer(release);
+    else
+        glDeleteVertexArrays(1, &id);
+}
+
+void GLResourceManager::defer(const Release& release)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (release.kind == Kind::Texture)
+        liveTextures.erase(release.id);
+    else if (release.kind == Kind::Buffer)
+        liveBuffers.erase(release.id);
+    retiringBytes += releaseBytes(release);
+    pending.push_back(release);
+}
+
+void GLResourceManager::endFrame()
+{
+    // This frame's releases wait for every command submitted so far
+    bool closed = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Draws of the frame that just ended
+        for (GLuint id : touched)
+        {
+            auto it = liveTextures.find(id);
+            if (it != liveTextures.end())
+                it->second.lastUsedFrame = frameIndex;
+        }
+        touched.clear();
+
+        if (!pending.empty())
+        {
+            RetireBatch batch;
+            batch.fence = nullptr;
+            if (!spareLists.empty())
+            {
+                batch.releases = std::move(spareLists.back());
+                spareLists.pop_back();
+            }
+            batch.releases.swap(pending);
+            inFlight.push_back(std::move(batch));
+            closed = true;
+        }
+    }
+    if (closed)
+        inFlight.back().fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ++frameIndex;
+
+    // Fences signal in submission order: stop at the first frame the GPU has not finished
+    size_t retired = 0;
+    while (retired < inFlight.size())
+    {
+        RetireBatch& batch = inFlight[retired];
+        const GLenum status = glClientWaitSync(batch.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        glDeleteSync(batch.fence);
+        retire(batch.releases);
+        batch.releases.clear();
+        spareLists.push_back(std::move(batch.releases));
+        ++retired;
+    }
+    inFlight.erase(inFlight.begin(), inFlight.begin() + retired);
+
+    trimPools();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.pendingReleases = static_cast<int>(pending.size());
+        stats.liveTextures = static_cast<int>(liveTextures.size());
+        stats.liveBuffers = static_cast<int>(liveBuffers.size());
+        stats.textureBytes = stats.cubemapBytes = 0;
+        for (const auto& texture : liveTextures)
+            (texture.second.desc.target == GL_TEXTURE_CUBE_MAP ? stats.cubemapBytes : stats.textureBytes) += texture.second.bytes;
+        stats.vertexBytes = stats.indexBytes = stats.otherBufferBytes = 0;
+        for (const auto& buffer : liveBuffers)
+        {
+            const size_t bytes = static_cast<size_t>(buffer.second.size);
+            if (buffer.second.target == GL_ARRAY_BUFFER)
+                stats.vertexBytes += bytes;
+            else if (buffer.second.target == GL_ELEMENT_ARRAY_BUFFER)
+                stats.indexBytes += bytes;
+            else
+                stats.otherBufferBytes += bytes;
+        }
+        stats.retiringBytes = retiringBytes;
+    }
+    stats.framesInFlight = static_cast<int>(inFlight.size());
+    stats.pooledTextures = static_cast<int>(texturePool.size());
+    stats.pooledBuffers = static_cast<int>(bufferPool.size());
+    stats.pooledBytes = pooledBytes;
+    stats.committedBytes = stats.textureBytes + stats.cubemapBytes + stats.vertexBytes + stats.indexBytes +
+                           stats.otherBufferBytes + stats.retiringBytes + stats.pooledBytes;
+    stats.budgetBytes = memoryBudget;
+    stats.deletedLastFrame = deletedThisFrame;
+    deletedThisFrame = 0;
+}
+
+void GLResourceManager::retire(std::vector<Release>& releases)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const Release& release : releases)
+            retiringBytes -= releaseBytes(release);
+    }
+    for (const Release& release : releases)
+    {
+        switch (release.kind)
+        {
+            case Kind::Texture:
+            {
+                // The streamer drops its entry before the ID can be handed out again
+                if (TextureStreamer* streamer = TextureStreamer::active())
+                    streamer->forget(release.id);
+                const size_t bytes = textureBytes(release.texture);
+                if (bytes <= poolBudget)
+                {
+                    texturePool.push_back(PooledTexture{ release.id, release.texture, bytes, frameIndex });
+                    pooledBytes += bytes;
+                }
+                else
+                    destroy(release);
+                break;
+            }
+            case Kind::Buffer:
+                if (release.usage != 0 && static_cast<size_t>(release.size) <= poolBudget)
+                {
+                    bufferPool.push_back(PooledBuffer{ release.id, release.size, release.usage, frameIndex });
+                    pooledBytes += static_cast<size_t>(release.size);
+                }
+                else
+                    destroy(release);
+                break;
+            case Kind::VertexArray:
+                destroy(release);
+                break;
+        }
+    }
+}
+
+void GLResourceManager::destroy(const Release& release)
+{
+    switch (release.kind)
+    {
+        case Kind::Texture:     glDeleteTextures(1, &release.id); break;
+        case Kind::Buffer:      glDeleteBuffers(1, &release.id); break;
+        case Kind::VertexArray: glDeleteVertexArrays(1, &release.id); break;
+    }
+    ++deletedThisFrame;
+}
+
+void GLResourceManager::trimPools()
+{
+    // Over the memory budget, pooled objects are the first thing to give back
+    size_t others;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        others = liveBytes() + retiringBytes;
+    }
+    const size_t budget = std::min(poolBudget, memoryBudget > others ? memoryBudget - others : 0);
+
+    // Both pools are ordered by retirement frame: evict from the front, oldest first
+    size_t textureFront = 0;
+    size_t bufferFront = 0;
+    while (textureFront < texturePool.size() || bufferFront < bufferPool.size())
+    {
+        const bool textureOlder = bufferFront == bufferPool.size() ||
+            (textureFront < texturePool.size() && texturePool[textureFront].frame <= bufferPool[bufferFront].frame);
+        const uint64_t frame = textureOlder ? texturePool[textureFront].frame : bufferPool[bufferFront].frame;
+        if (pooledBytes <= budget && frameIndex - frame < kPoolFrames)
+            break;
+
+        if (textureOlder)
+        {
+            const PooledTexture& texture = texturePool[textureFront++];
+            destroy(Release{ Kind::Texture, texture.id, texture.desc, 0, 0 });
+            pooledBytes -= texture.bytes;
+        }
+        else
+        {
+            const PooledBuffer& buffer = bufferPool[bufferFront++];
+            destroy(Release{ Kind::Buffer, buffer.id, GLTextureDesc(), buffer.size, buffer.usage });
+            pooledBytes -= static_cast<size_t>(buffer.size);
+        }
+    }
+    texturePool.erase(texturePool.begin(), texturePool.begin() + textureFront);
+    bufferPool.erase(bufferPool.begin(), bufferPool.begin() + bufferFront);
+}
+
+void GLResourceManager::shutdown()
+{
+    if (activeManager == this)
+        activeManager = nullptr;
+
+    // Nothing is in use once the GPU drains, so every fence can be skipped
+    glFinish();
+    for (RetireBatch& batch : inFlight)
+    {
+        glDeleteSync(batch.fence);
+        for (const Release& release : batch.releases)
+            destroy(release);
+    }
+    inFlight.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const Release& release : pending)
+            destroy(release);
+        pending.clear();
+        retiringBytes = 0;
+    }
+    for (const PooledTexture& texture : texturePool)
+        glDeleteTextures(1, &texture.id);
+    for (const PooledBuffer& buffer : bufferPool)
+        glDeleteBuffers(1, &buffer.id);
+    texturePool.clear();
+    bufferPool.clear();
+    spareLists.clear();
+    pooledBytes = 0;
+}
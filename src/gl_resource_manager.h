@@ -0,0 +1,322 @@
+#ifndef GL_RESOURCE_MANAGER_H
+#define GL_RESOURCE_MANAGER_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct GLTextureDesc
+ * @brief Forma del almacenamiento inmutable de una textura: dos texturas con la misma son intercambiables.
+ */
+struct GLTextureDesc {
+    GLenum target = GL_TEXTURE_2D;  /**< GL_TEXTURE_2D o GL_TEXTURE_CUBE_MAP */
+    GLsizei levels = 0;             /**< Niveles de mipmap */
+    GLenum internalFormat = 0;      /**< Formato interno */
+    GLsizei width = 0;              /**< Ancho del nivel 0 */
+    GLsizei height = 0;             /**< Alto del nivel 0 */
+
+    bool operator==(const GLTextureDesc& other) const
+    {
+        return target == other.target && levels == other.levels && internalFormat == other.internalFormat &&
+               width == other.width && height == other.height;
+    }
+};
+
+/**
+ * @struct GLResourceStats
+ * @brief Contadores del gestor, actualizados en cada @ref GLResourceManager::endFrame.
+ *
+ * Los bytes son estimaciones a partir de la forma de cada objeto (texels por formato y
+ * nivel, tamaño de buffer); el driver puede añadir relleno y alineación.
+ */
+struct GLResourceStats {
+    int pendingReleases = 0;        /**< Objetos liberados en el frame en curso */
+    int framesInFlight = 0;         /**< Frames con liberaciones esperando su fence */
+    int pooledTextures = 0;         /**< Texturas listas para reutilizarse */
+    int pooledBuffers = 0;          /**< Buffers listos para reutilizarse */
+    size_t pooledBytes = 0;         /**< Memoria de GPU retenida en los pools */
+    uint64_t textureReuses = 0;     /**< Texturas servidas desde el pool */
+    uint64_t bufferReuses = 0;      /**< Buffers servidos desde el pool */
+    int deletedLastFrame = 0;       /**< Objetos borrados de verdad en el último endFrame */
+
+    int liveTextures = 0;           /**< Texturas creadas y no liberadas */
+    int liveBuffers = 0;            /**< Buffers creados y no liberados */
+    size_t textureBytes = 0;        /**< Almacenamiento de texturas 2D vivas (todos sus niveles) */
+    size_t cubemapBytes = 0;        /**< Almacenamiento de cubemaps vivos */
+    size_t vertexBytes = 0;         /**< Buffers de vértices vivos */
+    size_t indexBytes = 0;          /**< Buffers de índices vivos */
+    size_t otherBufferBytes = 0;    /**< Otros buffers vivos */
+    size_t retiringBytes = 0;       /**< Objetos liberados que esperan su fence */
+    size_t committedBytes = 0;      /**< Total reservado: vivos, pools y en retirada */
+    size_t budgetBytes = 0;         /**< Presupuesto de memoria de GPU */
+};
+
+/**
+ * @class GLResourceManager
+ * @brief Vida de los objetos de OpenGL: borrado diferido tras la fence del frame y pools de reutilización.
+ *
+ * Los destructores de @c Mesh, @c Texture y la escena no llaman a @c glDelete* directamente:
+ * - Las liberaciones (desde cualquier hilo) se apuntan en el frame en curso. @ref endFrame
+ *   cierra el frame con una fence y las retira cuando la GPU la ha pasado, de modo que nunca
+ *   se borra un objeto que un comando en vuelo aún usa ni se llama a OpenGL fuera de su hilo.
+ * - Al retirarse, las texturas y buffers vuelven a un pool por forma exacta (almacenamiento
+ *   inmutable igual / mismo tamaño y uso); @ref createTexture y @ref createBuffer los
+ *   reutilizan antes de generar objetos nuevos. Los pools tienen un límite de bytes y sueltan
+ *   lo que lleva @ref kPoolFrames frames sin usarse.
+ * - Los VAOs no se reutilizan (guardan referencias a buffers concretos): solo se difieren.
+ *
+ * Además lleva la cuenta de la memoria de GPU de cada textura (forma, formato y niveles) y
+ * buffer vivos frente a un presupuesto. Los draws marcan las texturas que usan
+ * (@ref touchTexture); con ese uso por frame, el @c TextureStreamer baja a niveles más
+ * gruesos las texturas usadas hace más tiempo cuando el total supera el presupuesto
+ * (@ref streamingBudget) y las recupera cuando vuelven a pedirse. Por encima del presupuesto
+ * los pools se vacían antes que nada.
+ *
+ * Sin gestor activo (herramientas, apagado) las funciones estáticas crean y borran de inmediato.
+ */
+class GLResourceManager {
+public:
+    static constexpr uint64_t kPoolFrames = 600; /**< Frames que un objeto puede esperar en el pool */
+
+    /**
+     * @brief Constructor.
+     * @param memoryBudgetBytes Memoria de GPU que la aplicación intenta no superar.
+     * @param poolBudgetBytes Memoria de GPU máxima retenida entre los dos pools.
+     */
+    explicit GLResourceManager(size_t memoryBudgetBytes = 512u << 20, size_t poolBudgetBytes = 64u << 20);
+
+    /**
+     * @brief Destructor. Se desactiva; los objetos deben haberse liberado antes con @ref shutdown.
+     */
+    ~GLResourceManager();
+
+    GLResourceManager(const GLResourceManager&) = delete;
+    GLResourceManager& operator=(const GLResourceManager&) = delete;
+
+    /**
+     * @brief Hace de este gestor el que usan las funciones estáticas.
+     */
+    void activate();
+
+    /**
+     * @brief Obtiene el gestor activo.
+     * @return Puntero al gestor, o nullptr si los objetos se borran de inmediato.
+     */
+    static GLResourceManager* active();
+
+    /**
+     * @brief Cierra el frame: pone una fence tras sus liberaciones y retira las de frames ya terminados. Hilo de OpenGL.
+     */
+    void endFrame();
+
+    /**
+     * @brief Espera a la GPU, borra todo lo pendiente y vacía los pools. Hilo de OpenGL, antes de destruir el contexto.
+     *
+     * El gestor queda desactivado: lo que se libere después se borra de inmediato.
+     */
+    void shutdown();
+
+    /**
+     * @brief Devuelve los contadores del último @ref endFrame.
+     */
+    const GLResourceStats& getStats() const { return stats; }
+
+    /**
+     * @brief Cambia el presupuesto de memoria de GPU.
+     * @param bytes Bytes máximos.
+     */
+    void setMemoryBudget(size_t bytes) { memoryBudget = bytes; }
+
+    /**
+     * @brief Bytes que el streamer puede tener residentes sin superar el presupuesto.
+     *
+     * @param streamedStorageBytes Almacenamiento completo de las texturas del streamer
+     *        (se descuenta del total: de ellas solo cuenta lo residente).
+     * @return size_t Presupuesto menos todo lo que no es streaming (0 si ya no queda).
+     */
+    size_t streamingBudget(size_t streamedStorageBytes) const;
+
+    /**
+     * @brief Último frame en que un draw usó la textura. Hilo de OpenGL.
+     * @param id ID de la textura.
+     * @return uint64_t Frame (0 si nunca se usó o no es del gestor).
+     */
+    uint64_t lastUsedFrame(GLuint id) const;
+
+    /**
+     * @brief Frames cerrados con @ref endFrame.
+     */
+    uint64_t currentFrame() const { return frameIndex; }
+
+    /**
+     * @brief Escribe la memoria viva agrupada por tipo, formato y niveles.
+     * @param out Flujo de salida.
+     */
+    void reportMemory(std::ostream& out) const;
+
+    /**
+     * @brief Marca una textura como usada en el frame en curso. Hilo de OpenGL, durante los draws.
+     * @param id ID de la textura.
+     */
+    static void touchTexture(GLuint id);
+
+    /**
+     * @brief Crea (o reutiliza del pool) una textura con almacenamiento inmutable y la deja enlazada. Hilo de OpenGL.
+     *
+     * Una textura reutilizada conserva texels antiguos: quien la pide debe subir todos los
+     * niveles que vaya a muestrear. @c GL_TEXTURE_BASE_LEVEL vuelve a 0.
+     *
+     * @param desc Forma del almacenamiento.
+     * @return GLuint ID de la textura.
+     */
+    static GLuint createTexture(const GLTextureDesc& desc);
+
+    /**
+     * @brief Crea (o reutiliza del pool) un buffer, lo enlaza a @p target y copia @p data. Hilo de OpenGL.
+     *
+     * @param target Punto de enlace (ej: GL_ARRAY_BUFFER).
+     * @param size Bytes del buffer.
+     * @param data Contenido inicial (puede ser nullptr).
+     * @param usage Pista de uso (ej: GL_STATIC_DRAW).
+     * @return GLuint ID del buffer.
+     */
+    static GLuint createBuffer(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+
+    /**
+     * @brief Crea un buffer con almacenamiento inmutable (@c glBufferStorage). Hilo de OpenGL.
+     *
+     * No pasa por el pool: se libera con @ref deleteBuffer y uso 0 y se borra al retirarse.
+     *
+     * @param target Punto de enlace con el que se contabiliza.
+     * @param size Bytes del buffer.
+     * @param flags Flags de @c glBufferStorage (ej: GL_DYNAMIC_STORAGE_BIT).
+     * @return GLuint ID del buffer.
+     */
+    static GLuint createStorageBuffer(GLenum target, GLsizeiptr size, GLbitfield flags);
+
+    /**
+     * @brief Libera una textura; el streamer la olvida al retirarse. Cualquier hilo.
+     * @param id ID de la textura (0 no hace nada).
+     * @param desc Forma con la que se creó.
+     */
+    static void deleteTexture(GLuint id, const GLTextureDesc& desc);
+
+    /**
+     * @brief Libera un buffer. Cualquier hilo.
+     * @param id ID del buffer (0 no hace nada).
+     * @param size Bytes con los que se creó.
+     * @param usage Pista de uso con la que se creó (0: almacenamiento inmutable, no se reutiliza).
+     */
+    static void deleteBuffer(GLuint id, GLsizeiptr size, GLenum usage);
+
+    /**
+     * @brief Libera un VAO. Cualquier hilo.
+     * @param id ID del VAO (0 no hace nada).
+     */
+    static void deleteVertexArray(GLuint id);
+
+private:
+    /**
+     * @enum Kind
+     * @brief Tipo de objeto liberado.
+     */
+    enum class Kind { Texture, Buffer, VertexArray };
+
+    /**
+     * @struct Release
+     * @brief Objeto liberado a la espera de su fence.
+     */
+    struct Release {
+        Kind kind;              /**< Tipo de objeto */
+        GLuint id;              /**< ID de OpenGL */
+        GLTextureDesc texture;  /**< Forma (texturas) */
+        GLsizeiptr size;        /**< Bytes (buffers) */
+        GLenum usage;           /**< Uso (buffers) */
+    };
+
+    /**
+     * @struct TextureAllocation
+     * @brief Textura viva.
+     */
+    struct TextureAllocation {
+        GLTextureDesc desc;     /**< Forma del almacenamiento */
+        size_t bytes;           /**< Memoria estimada */
+        uint64_t lastUsedFrame; /**< Último frame en que un draw la usó */
+    };
+
+    /**
+     * @struct BufferAllocation
+     * @brief Buffer vivo.
+     */
+    struct BufferAllocation {
+        GLenum target;          /**< Punto de enlace con el que se creó */
+        GLsizeiptr size;        /**< Bytes */
+    };
+
+    /**
+     * @struct RetireBatch
+     * @brief Liberaciones de un frame y la fence que las protege.
+     */
+    struct RetireBatch {
+        GLsync fence;                   /**< Fence puesta al cerrar el frame */
+        std::vector<Release> releases;  /**< Objetos liberados durante el frame */
+    };
+
+    /**
+     * @struct PooledTexture
+     * @brief Textura retirada lista para reutilizarse.
+     */
+    struct PooledTexture {
+        GLuint id;              /**< ID de la textura */
+        GLTextureDesc desc;     /**< Forma del almacenamiento */
+        size_t bytes;           /**< Memoria estimada */
+        uint64_t frame;         /**< Frame en que entró al pool */
+    };
+
+    /**
+     * @struct PooledBuffer
+     * @brief Buffer retirado listo para reutilizarse.
+     */
+    struct PooledBuffer {
+        GLuint id;              /**< ID del buffer */
+        GLsizeiptr size;        /**< Bytes */
+        GLenum usage;           /**< Pista de uso */
+        uint64_t frame;         /**< Frame en que entró al pool */
+    };
+
+    mutable std::mutex mutex;                       /**< Protege las liberaciones y las cuentas (cualquier hilo libera) */
+    std::vector<Release> pending;                   /**< Liberaciones del frame en curso */
+    std::unordered_map<GLuint, TextureAllocation> liveTextures; /**< Texturas vivas */
+    std::unordered_map<GLuint, BufferAllocation> liveBuffers;   /**< Buffers vivos */
+    std::vector<GLuint> touched;                    /**< Texturas usadas por los draws de este frame (hilo de OpenGL) */
+    size_t memoryBudget;                            /**< Presupuesto de memoria de GPU */
+    size_t retiringBytes;                           /**< Bytes liberados a la espera de su fence */
+    std::vector<RetireBatch> inFlight;              /**< Frames cerrados, del más antiguo al más reciente */
+    std::vector<std::vector<Release>> spareLists;   /**< Listas vacías para reutilizar su capacidad */
+    std::vector<PooledTexture> texturePool;         /**< Texturas retiradas, de la más antigua a la más reciente */
+    std::vector<PooledBuffer> bufferPool;           /**< Buffers retirados, del más antiguo al más reciente */
+    size_t poolBudget;                              /**< Bytes máximos en los pools */
+    size_t pooledBytes;                             /**< Bytes actuales en los pools */
+    uint64_t frameIndex;                            /**< Frames cerrados */
+    GLResourceStats stats;                          /**< Contadores del último endFrame */
+    int deletedThisFrame;                           /**< Objetos borrados desde el último endFrame */
+
+    static GLResourceManager* activeManager;        /**< Gestor usado por las funciones estáticas */
+
+    void track(GLuint id, const GLTextureDesc& desc);
+    void track(GLuint id, GLenum target, GLsizeiptr size);
+    void defer(const Release& release);
+    void retire(std::vector<Release>& releases);
+    void destroy(const Release& release);
+    void trimPools();
+    size_t liveBytes() const;
+    static size_t textureBytes(const GLTextureDesc& desc);
+    static size_t releaseBytes(const Release& release);
+};
+
+#endif // GL_RESOURCE_MANAGER_H
@@ -0,0 +1,477 @@
+// GpuHeap.cpp
+
+#include "gpu_heap.h"
+#include "gl_resource_manager.h"
+#include <algorithm>
+
+// ---- OffsetAllocator ----
+
+OffsetAllocator::OffsetAllocator(uint32_t size, uint32_t maxAllocations)
+    : firstLevelMap(0), freeUnits(0), allocations(0)
+{
+    std::fill(std::begin(binHeads), std::end(binHeads), kNone);
+    std::fill(std::begin(secondLevelMaps), std::end(secondLevelMaps), 0u);
+
+    // Every allocation can leave a free block on each side: two nodes per allocation plus one
+    const uint32_t capacity = maxAllocations * 2 + 1;
+    nodes.resize(capacity);
+    spareNodes.reserve(capacity);
+    for (uint32_t i = capacity; i-- > 1;)
+        spareNodes.push_back(i);
+
+    nodes[0].size = size;
+    freeUnits = size;
+    insertFree(0);
+}
+
+// Two-level size class: the power of two, then 16 linear steps inside it (exact below 16)
+uint32_t OffsetAllocator::binIndex(uint32_t size)
+{
+    if (size < kSecondLevelCount)
+        return size;
+    const uint32_t msb = 31u - static_cast<uint32_t>(__builtin_clz(size));
+    const uint32_t firstLevel = msb - kSecondLevelBits + 1;
+    const uint32_t secondLevel = (size >> (msb - kSecondLevelBits)) & (kSecondLevelCount - 1);
+    return firstLevel * kSecondLevelCount + secondLevel;
+}
+
+void OffsetAllocator::insertFree(uint32_t index)
+{
+    Node& node = nodes[index];
+    const uint32_t bin = binIndex(node.size);
+    node.used = false;
+    node.prevFree = kNone;
+    node.nextFree = binHeads[bin];
+    if (node.nextFree != kNone)
+        nodes[node.nextFree].prevFree = index;
+    binHeads[bin] = index;
+    secondLevelMaps[bin / kSecondLevelCount] |= 1u << (bin % kSecondLevelCount);
+    firstLevelMap |= 1u << (bin / kSecondLevelCount);
+}
+
+void OffsetAllocator::removeFree(uint32_t index)
+{
+    Node& node = nodes[index];
+    const uint32_t bin = binIndex(node.size);
+    if (node.prevFree != kNone)
+        nodes[node.prevFree].nextFree = node.nextFree;
+    else
+        binHeads[bin] = node.nextFree;
+    if (node.nextFree != kNone)
+        nodes[node.nextFree].prevFree = node.prevFree;
+
+    if (binHeads[bin] == kNone)
+    {
+        secondLevelMaps[bin / kSecondLevelCount] &= ~(1u << (bin % kSecondLevelCount));
+        if (secondLevelMaps[bin / kSecondLevelCount] == 0)
+            firstLevelMap &= ~(1u << (bin / kSecondLevelCount));
+    }
+}
+
+OffsetAllocator::Allocation OffsetAllocator::allocate(uint32_t size)
+{
+    Allocation allocation;
+    size = std::max(size, 1u);
+    if (size > freeUnits)
+        return allocation;
+
+    // Round up to the next class boundary so any block of the class found is large enough
+    uint64_t rounded = size;
+    if (size >= kSecondLevelCount)
+    {
+        const uint32_t msb = 31u - static_cast<uint32_t>(__builtin_clz(size));
+        rounded += (1ull << (msb - kSecondLevelBits)) - 1;
+    }
+    uint32_t index = kNone;
+    if (rounded <= 0xFFFFFFFFull)
+    {
+        const uint32_t bin = binIndex(static_cast<uint32_t>(rounded));
+        uint32_t firstLevel = bin / kSecondLevelCount;
+        uint32_t secondMap = secondLevelMaps[firstLevel] & (~0u << (bin % kSecondLevelCount));
+        if (secondMap == 0)
+        {
+            const uint32_t firstMap = firstLevel + 1 < 32 ? firstLevelMap & (~0u << (firstLevel + 1)) : 0;
+            if (firstMap != 0)
+            {
+                firstLevel = static_cast<uint32_t>(__builtin_ctz(firstMap));
+                secondMap = secondLevelMaps[firstLevel];
+            }
+        }
+        if (secondMap != 0)
+            index = binHeads[firstLevel * kSecondLevelCount + static_cast<uint32_t>(__builtin_ctz(secondMap))];
+    }
+    // Nothing in a larger class: a block of the request's own class may still fit (e.g. an exact-size page)
+    if (index == kNone)
+    {
+        for (uint32_t i = binHeads[binIndex(size)]; i != kNone; i = nodes[i].nextFree)
+        {
+            if (nodes[i].size >= size)
+            {
+                index = i;
+                break;
+            }
+        }
+        if (index == kNone)
+            return allocation;
+    }
+    removeFree(index);
+
+    // Split the tail off as a new free block (kept whole when the node pool is exhausted)
+    Node& node = nodes[index];
+    if (node.size > size && !spareNodes.empty())
+    {
+        const uint32_t tail = spareNodes.back();
+        spareNodes.pop_back();
+        Node& rest = nodes[tail];
+        rest.offset = node.offset + size;
+        rest.size = node.size - size;
+        rest.prevPhysical = index;
+        rest.nextPhysical = node.nextPhysical;
+        if (rest.nextPhysical != kNone)
+            nodes[rest.nextPhysical].prevPhysical = tail;
+        node.nextPhysical = tail;
+        node.size = size;
+        insertFree(tail);
+    }
+    node.used = true;
+    freeUnits -= node.size;
+    ++allocations;
+
+    allocation.offset = node.offset;
+    allocation.node = index;
+    return allocation;
+}
+
+void OffsetAllocator::free(uint32_t index)
+{
+    Node& node = nodes[index];
+    freeUnits += node.size;
+    --allocations;
+
+    // Merge with the physical neighbours; node 0 always survives as the offset-0 block
+    if (node.prevPhysical != kNone && !nodes[node.prevPhysical].used)
+    {
+        const uint32_t prev = node.prevPhysical;
+        removeFree(prev);
+        nodes[prev].size += node.size;
+        nodes[prev].nextPhysical = node.nextPhysical;
+        if (node.nextPhysical != kNone)
+            nodes[node.nextPhysical].prevPhysical = prev;
+        nodes[index] = Node();
+        spareNodes.push_back(index);
+        index = prev;
+    }
+    Node& merged = nodes[index];
+    if (merged.nextPhysical != kNone && !nodes[merged.nextPhysical].used)
+    {
+        const uint32_t next = merged.nextPhysical;
+        removeFree(next);
+        merged.size += nodes[next].size;
+        merged.nextPhysical = nodes[next].nextPhysical;
+        if (merged.nextPhysical != kNone)
+            nodes[merged.nextPhysical].prevPhysical = index;
+        nodes[next] = Node();
+        spareNodes.push_back(next);
+    }
+    insertFree(index);
+}
+
+uint32_t OffsetAllocator::largestFree() const
+{
+    if (firstLevelMap == 0)
+        return 0;
+    const uint32_t firstLevel = 31u - static_cast<uint32_t>(__builtin_clz(firstLevelMap));
+    const uint32_t secondLevel = 31u - static_cast<uint32_t>(__builtin_clz(secondLevelMaps[firstLevel]));
+    uint32_t largest = 0;
+    for (uint32_t i = binHeads[firstLevel * kSecondLevelCount + secondLevel]; i != kNone; i = nodes[i].nextFree)
+        largest = std::max(largest, nodes[i].size);
+    return largest;
+}
+
+// ---- GpuHeap ----
+
+GpuHeap* GpuHeap::activeHeap = nullptr;
+
+GpuHeap::Page::Page(GLuint buffer, GLsizeiptr size, uint32_t maxAllocations)
+    : buffer(buffer), size(size), allocator(GpuHeap::units(size), maxAllocations),
+      owners(maxAllocations * 2 + 1, kInvalidHandle)
+{
+}
+
+GpuHeap::GpuHeap(GLsizeiptr pageBytes, size_t moveBytesPerFrame)
+    : pageBytes(pageBytes), moveBytesPerFrame(moveBytesPerFrame), firstFreeSlot(kInvalidHandle), evacuating(-1),
+      allocationsThisFrame(0)
+{
+}
+
+GpuHeap::~GpuHeap()
+{
+    if (activeHeap == this)
+        activeHeap = nullptr;
+}
+
+void GpuHeap::activate()
+{
+    activeHeap = this;
+}
+
+GpuHeap* GpuHeap::active()
+{
+    return activeHeap;
+}
+
+uint32_t GpuHeap::units(GLsizeiptr bytes)
+{
+    return static_cast<uint32_t>((bytes + kAlignment - 1) / kAlignment);
+}
+
+uint32_t GpuHeap::addPage(GLsizeiptr size)
+{
+    const GLuint buffer = GLResourceManager::createStorageBuffer(GL_ARRAY_BUFFER, size, GL_DYNAMIC_STORAGE_BIT);
+    const uint32_t maxAllocations = std::min<uint32_t>(units(size), 16384);
+    auto page = std::make_unique<Page>(buffer, size, maxAllocations);
+
+    for (uint32_t i = 0; i < pages.size(); ++i)
+    {
+        if (!pages[i])
+        {
+            pages[i] = std::move(page);
+            return i;
+        }
+    }
+    pages.push_back(std::move(page));
+    return static_cast<uint32_t>(pages.size() - 1);
+}
+
+void GpuHeap::releasePage(uint32_t pageIndex)
+{
+    Page& page = *pages[pageIndex];
+    GLResourceManager::deleteBuffer(page.buffer, page.size, 0);
+    pages[pageIndex].reset();
+    if (evacuating == static_cast<int>(pageIndex))
+        evacuating = -1;
+}
+
+// First page with room, oldest first so new pages only fill up once the rest are full
+bool GpuHeap::place(uint32_t count, int skipPage, uint32_t& pageIndex, OffsetAllocator::Allocation& allocation)
+{
+    for (uint32_t i = 0; i < pages.size(); ++i)
+    {
+        if (!pages[i] || static_cast<int>(i) == skipPage)
+            continue;
+        allocation = pages[i]->allocator.allocate(count);
+        if (allocation.offset != OffsetAllocator::kNone)
+        {
+            pageIndex = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+GpuHeap::Handle GpuHeap::allocate(GLsizeiptr size)
+{
+    GpuHeap& heap = *activeHeap;
+    const uint32_t count = units(size);
+
+    uint32_t pageIndex = 0;
+    OffsetAllocator::Allocation allocation;
+    if (!heap.place(count, heap.evacuating, pageIndex, allocation))
+    {
+        // Oversized requests get a page of their own
+        pageIndex = heap.addPage(std::max(heap.pageBytes, static_cast<GLsizeiptr>(count) * kAlignment));
+        allocation = heap.pages[pageIndex]->allocator.allocate(count);
+    }
+
+    Handle handle = heap.firstFreeSlot;
+    if (handle != kInvalidHandle)
+        heap.firstFreeSlot = heap.slots[handle].nextFree;
+    else
+    {
+        handle = static_cast<Handle>(heap.slots.size());
+        heap.slots.emplace_back();
+    }
+
+    Page& page = *heap.pages[pageIndex];
+    Slot& slot = heap.slots[handle];
+    slot.range.buffer = page.buffer;
+    slot.range.offset = static_cast<GLintptr>(allocation.offset) * kAlignment;
+    slot.range.size = size;
+    slot.page = pageIndex;
+    slot.node = allocation.node;
+    slot.nextFree = kInvalidHandle;
+    page.owners[allocation.node] = handle;
+    ++heap.allocationsThisFrame;
+    ++heap.stats.liveAllocations;
+    return handle;
+}
+
+void GpuHeap::upload(Handle handle, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    const Range& range = resolve(handle);
+    glNamedBufferSubData(range.buffer, range.offset + offset, size, data);
+}
+
+void GpuHeap::free(Handle handle)
+{
+    if (handle == kInvalidHandle || !activeHeap)
+        return;
+    std::lock_guard<std::mutex> lock(activeHeap->freeMutex);
+    activeHeap->freed.push_back(handle);
+}
+
+void GpuHeap::endFrame()
+{
+    // Freed handles go back now (nothing resolves them any more); their ranges wait for the fence
+    {
+        std::lock_guard<std::mutex> lock(freeMutex);
+        freeing.swap(freed);
+    }
+    for (Handle handle : freeing)
+    {
+        Slot& slot = slots[handle];
+        pages[slot.page]->owners[slot.node] = kInvalidHandle;
+        current.push_back(PendingRange{ slot.page, slot.node });
+        slot.range = Range();
+        slot.nextFree = firstFreeSlot;
+        firstFreeSlot = handle;
+    }
+    stats.freesLastFrame = static_cast<int>(freeing.size());
+    stats.liveAllocations -= stats.freesLastFrame;
+    freeing.clear();
+
+    // Copies are issued before the fence, so the old ranges are read before they can be reused
+    defragment();
+
+    if (!current.empty())
+    {
+        RetireBatch batch;
+        batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        batch.ranges.swap(current);
+        inFlight.push_back(std::move(batch));
+    }
+
+    // Fences signal in submission order: stop at the first frame the GPU has not finished
+    size_t retired = 0;
+    while (retired < inFlight.size())
+    {
+        RetireBatch& batch = inFlight[retired];
+        const GLenum status = glClientWaitSync(batch.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        glDeleteSync(batch.fence);
+        for (const PendingRange& range : batch.ranges)
+        {
+            pages[range.page]->allocator.free(range.node);
+            // Drained pages go back, keeping one so steady churn does not recreate it every frame
+            if (pages[range.page]->allocator.allocationCount() == 0 &&
+                (static_cast<int>(range.page) == evacuating ||
+                 std::count_if(pages.begin(), pages.end(), [](const std::unique_ptr<Page>& p) { return p != nullptr; }) > 1))
+                releasePage(range.page);
+        }
+        // Keep the capacity for the next frame's ranges
+        if (current.capacity() < batch.ranges.capacity())
+        {
+            batch.ranges.clear();
+            current.swap(batch.ranges);
+        }
+        ++retired;
+    }
+    inFlight.erase(inFlight.begin(), inFlight.begin() + retired);
+
+    stats.pages = 0;
+    stats.committedBytes = stats.usedBytes = stats.largestFreeBytes = 0;
+    for (const auto& page : pages)
+    {
+        if (!page)
+            continue;
+        ++stats.pages;
+        stats.committedBytes += static_cast<size_t>(page->size);
+        stats.usedBytes += static_cast<size_t>(page->size) - static_cast<size_t>(page->allocator.freeSize()) * kAlignment;
+        stats.largestFreeBytes = std::max(stats.largestFreeBytes, static_cast<size_t>(page->allocator.largestFree()) * kAlignment);
+    }
+    stats.allocationsLastFrame = allocationsThisFrame;
+    stats.evacuatingPage = evacuating;
+    allocationsThisFrame = 0;
+}
+
+void GpuHeap::defragment()
+{
+    stats.movedBytesLastFrame = 0;
+
+    // Pick the emptiest page once it falls under the threshold and the others can take its ranges
+    if (evacuating < 0)
+    {
+        int candidate = -1;
+        size_t candidateUsed = 0;
+        size_t freeElsewhere = 0;
+        for (uint32_t i = 0; i < pages.size(); ++i)
+        {
+            if (!pages[i])
+                continue;
+            const size_t used = static_cast<size_t>(pages[i]->size) - static_cast<size_t>(pages[i]->allocator.freeSize()) * kAlignment;
+            freeElsewhere += static_cast<size_t>(pages[i]->allocator.freeSize()) * kAlignment;
+            if (used > 0 && used < static_cast<size_t>(pages[i]->size * kEvacuateBelow) &&
+                (candidate < 0 || used < candidateUsed))
+            {
+                candidate = static_cast<int>(i);
+                candidateUsed = used;
+            }
+        }
+        if (candidate < 0)
+            return;
+        freeElsewhere -= static_cast<size_t>(pages[candidate]->allocator.freeSize()) * kAlignment;
+        if (freeElsewhere < candidateUsed * 2) // Leave slack: the free space elsewhere may be fragmented too
+            return;
+        evacuating = candidate;
+    }
+
+    // Move live ranges out of the evacuating page with GPU copies, a bounded amount per frame
+    Page& source = *pages[evacuating];
+    bool stuck = false;
+    source.allocator.forEachAllocation([&](uint32_t node, uint32_t offset, uint32_t count) {
+        const Handle handle = source.owners[node];
+        if (handle == kInvalidHandle || stuck || stats.movedBytesLastFrame >= moveBytesPerFrame)
+            return;
+        uint32_t pageIndex = 0;
+        OffsetAllocator::Allocation allocation;
+        if (!place(count, evacuating, pageIndex, allocation))
+        {
+            stuck = true;
+            return;
+        }
+
+        Page& target = *pages[pageIndex];
+        Slot& slot = slots[handle];
+        const GLintptr newOffset = static_cast<GLintptr>(allocation.offset) * kAlignment;
+        glCopyNamedBufferSubData(source.buffer, target.buffer, static_cast<GLintptr>(offset) * kAlignment, newOffset,
+                                 slot.range.size);
+        current.push_back(PendingRange{ slot.page, node });
+        source.owners[node] = kInvalidHandle;
+        target.owners[allocation.node] = handle;
+        slot.range.buffer = target.buffer;
+        slot.range.offset = newOffset;
+        slot.page = pageIndex;
+        slot.node = allocation.node;
+        stats.movedBytesLastFrame += static_cast<size_t>(count) * kAlignment;
+    });
+    if (stuck)
+        evacuating = -1;
+}
+
+void GpuHeap::shutdown()
+{
+    for (RetireBatch& batch : inFlight)
+        glDeleteSync(batch.fence);
+    inFlight.clear();
+    current.clear();
+    for (uint32_t i = 0; i < pages.size(); ++i)
+        if (pages[i])
+            releasePage(i);
+    pages.clear();
+    slots.clear();
+    stats = GpuHeapStats();
+    firstFreeSlot = kInvalidHandle;
+    if (activeHeap == this)
+        activeHeap = nullptr;
+}
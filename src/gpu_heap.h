@@ -0,0 +1,306 @@
+#ifndef GPU_HEAP_H
+#define GPU_HEAP_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @class OffsetAllocator
+ * @brief Asignador TLSF de rangos dentro de un bloque de tamaño fijo; solo guarda desplazamientos.
+ *
+ * Los bloques libres se reparten en listas segregadas de dos niveles (potencia de dos y 16
+ * subdivisiones) con un bitmap por nivel: buscar un bloque suficiente es un par de
+ * count-trailing-zeros y liberar fusiona con los vecinos físicos, todo en O(1). Los nodos
+ * salen de un arreglo de capacidad fija, así que asignar y liberar no reservan memoria.
+ */
+class OffsetAllocator {
+public:
+    static constexpr uint32_t kNone = 0xFFFFFFFFu; /**< Nodo u offset inválido */
+
+    /**
+     * @struct Allocation
+     * @brief Rango asignado.
+     */
+    struct Allocation {
+        uint32_t offset = kNone;  /**< Inicio del rango (kNone si no había sitio) */
+        uint32_t node = kNone;    /**< Nodo que hay que pasar a @ref free */
+    };
+
+    /**
+     * @brief Constructor.
+     * @param size Unidades gestionadas.
+     * @param maxAllocations Asignaciones vivas máximas.
+     */
+    OffsetAllocator(uint32_t size, uint32_t maxAllocations);
+
+    /**
+     * @brief Reserva un rango (el primero suficiente de la clase de tamaño más ajustada).
+     * @param size Unidades a reservar.
+     * @return Allocation Rango reservado, o uno con offset kNone si no cabe.
+     */
+    Allocation allocate(uint32_t size);
+
+    /**
+     * @brief Devuelve un rango y lo fusiona con sus vecinos libres.
+     * @param node Nodo devuelto por @ref allocate.
+     */
+    void free(uint32_t node);
+
+    /**
+     * @brief Unidades de un rango asignado.
+     * @param node Nodo devuelto por @ref allocate.
+     */
+    uint32_t allocationSize(uint32_t node) const { return nodes[node].size; }
+
+    /**
+     * @brief Unidades libres en total.
+     */
+    uint32_t freeSize() const { return freeUnits; }
+
+    /**
+     * @brief Bloque libre más grande (el mayor de la clase de tamaño más alta ocupada).
+     */
+    uint32_t largestFree() const;
+
+    /**
+     * @brief Rangos asignados actualmente.
+     */
+    uint32_t allocationCount() const { return allocations; }
+
+    /**
+     * @brief Recorre los rangos asignados en orden de offset.
+     * @param visit Llamada con (nodo, offset, unidades) por cada rango.
+     */
+    template <typename Visit>
+    void forEachAllocation(Visit&& visit) const
+    {
+        for (uint32_t i = 0; i != kNone; i = nodes[i].nextPhysical)
+            if (nodes[i].used)
+                visit(i, nodes[i].offset, nodes[i].size);
+    }
+
+private:
+    static constexpr uint32_t kSecondLevelBits = 4;
+    static constexpr uint32_t kSecondLevelCount = 1u << kSecondLevelBits;
+    static constexpr uint32_t kFirstLevelCount = 32 - kSecondLevelBits + 1;
+
+    /**
+     * @struct Node
+     * @brief Rango libre o asignado, enlazado con sus vecinos en memoria y en su lista libre.
+     */
+    struct Node {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+        uint32_t prevPhysical = kNone;
+        uint32_t nextPhysical = kNone;
+        uint32_t prevFree = kNone;
+        uint32_t nextFree = kNone;
+        bool used = false;
+    };
+
+    std::vector<Node> nodes;          /**< Nodos; el 0 es siempre el de offset 0 */
+    std::vector<uint32_t> spareNodes; /**< Pila de nodos sin usar */
+    uint32_t binHeads[kFirstLevelCount * kSecondLevelCount]; /**< Primera entrada de cada lista libre */
+    uint32_t secondLevelMaps[kFirstLevelCount];  /**< Listas no vacías de cada primer nivel */
+    uint32_t firstLevelMap;           /**< Primeros niveles con alguna lista no vacía */
+    uint32_t freeUnits;               /**< Unidades libres */
+    uint32_t allocations;             /**< Rangos asignados */
+
+    static uint32_t binIndex(uint32_t size);
+    void insertFree(uint32_t node);
+    void removeFree(uint32_t node);
+};
+
+/**
+ * @struct GpuHeapStats
+ * @brief Contadores del heap, actualizados en cada @ref GpuHeap::endFrame.
+ */
+struct GpuHeapStats {
+    int pages = 0;                    /**< Buffers grandes reservados */
+    size_t committedBytes = 0;        /**< Almacenamiento de todas las páginas */
+    size_t usedBytes = 0;             /**< Bytes en rangos vivos o esperando su fence */
+    size_t largestFreeBytes = 0;      /**< Mayor bloque libre de cualquier página */
+    int liveAllocations = 0;          /**< Rangos vivos */
+    int allocationsLastFrame = 0;     /**< Rangos pedidos desde el último endFrame */
+    int freesLastFrame = 0;           /**< Rangos devueltos desde el último endFrame */
+    size_t movedBytesLastFrame = 0;   /**< Bytes copiados por la desfragmentación en el último endFrame */
+    int evacuatingPage = -1;          /**< Página que se está vaciando (-1 ninguna) */
+};
+
+/**
+ * @class GpuHeap
+ * @brief Reparte rangos de unos pocos buffers inmutables grandes entre las mallas.
+ *
+ * En lugar de un VBO y un EBO por malla, cada malla pide un rango (@ref allocate) de una
+ * página de @c kPageBytes creada con @c glBufferStorage y guarda un @ref Handle estable:
+ * - Asignar y liberar son contabilidad de CPU en O(1) (@ref OffsetAllocator); no hay
+ *   @c glGenBuffers ni @c glBufferData por malla. Solo se crea una página cuando ninguna
+ *   tiene sitio (las asignaciones mayores que una página reciben una página propia).
+ * - Liberar (desde cualquier hilo) no devuelve el rango hasta que la GPU ha pasado la fence
+ *   del frame, como hace @ref GLResourceManager con los objetos.
+ * - Desfragmentación: cuando la página menos ocupada baja de @c kEvacuateBelow y lo que
+ *   contiene cabe en las demás, @ref endFrame copia sus rangos en la GPU
+ *   (@c glCopyNamedBufferSubData), hasta @c moveBytesPerFrame por frame, y la suelta al
+ *   quedar vacía. El @ref Handle no cambia; quien dibuja consulta @ref resolve y vuelve a
+ *   apuntar su VAO si el buffer o el offset han cambiado.
+ *
+ * Las páginas se crean y se devuelven a través de @ref GLResourceManager (cuentan para su
+ * presupuesto). Todo salvo @ref free se llama desde el hilo de OpenGL.
+ */
+class GpuHeap {
+public:
+    using Handle = uint32_t;                         /**< Rango estable ante la desfragmentación */
+    static constexpr Handle kInvalidHandle = 0xFFFFFFFFu;
+    static constexpr GLsizeiptr kAlignment = 16;     /**< Granularidad de los rangos, en bytes */
+    static constexpr float kEvacuateBelow = 0.25f;   /**< Ocupación por debajo de la cual se vacía una página */
+
+    /**
+     * @struct Range
+     * @brief Posición actual de un rango.
+     */
+    struct Range {
+        GLuint buffer = 0;        /**< Buffer de la página */
+        GLintptr offset = 0;      /**< Offset en bytes dentro de la página */
+        GLsizeiptr size = 0;      /**< Bytes pedidos */
+    };
+
+    /**
+     * @brief Constructor.
+     * @param pageBytes Tamaño de cada página.
+     * @param moveBytesPerFrame Bytes que la desfragmentación puede copiar por frame.
+     */
+    explicit GpuHeap(GLsizeiptr pageBytes = 16 << 20, size_t moveBytesPerFrame = 1u << 20);
+
+    /**
+     * @brief Destructor. Se desactiva; las páginas deben haberse soltado antes con @ref shutdown.
+     */
+    ~GpuHeap();
+
+    GpuHeap(const GpuHeap&) = delete;
+    GpuHeap& operator=(const GpuHeap&) = delete;
+
+    /**
+     * @brief Hace de este heap el que usan las funciones estáticas.
+     */
+    void activate();
+
+    /**
+     * @brief Obtiene el heap activo.
+     * @return Puntero al heap, o nullptr si las mallas usan buffers propios.
+     */
+    static GpuHeap* active();
+
+    /**
+     * @brief Cierra el frame: pone la fence de sus liberaciones, devuelve los rangos ya seguros y desfragmenta.
+     */
+    void endFrame();
+
+    /**
+     * @brief Suelta todas las páginas y se desactiva. Antes de @ref GLResourceManager::shutdown.
+     */
+    void shutdown();
+
+    /**
+     * @brief Devuelve los contadores del último @ref endFrame.
+     */
+    const GpuHeapStats& getStats() const { return stats; }
+
+    /**
+     * @brief Reserva un rango del heap activo.
+     * @param size Bytes.
+     * @return Handle Rango reservado.
+     */
+    static Handle allocate(GLsizeiptr size);
+
+    /**
+     * @brief Copia datos dentro de un rango.
+     * @param handle Rango.
+     * @param offset Offset en bytes dentro del rango.
+     * @param size Bytes a copiar.
+     * @param data Origen.
+     */
+    static void upload(Handle handle, GLintptr offset, GLsizeiptr size, const void* data);
+
+    /**
+     * @brief Libera un rango tras la fence del frame en curso. Cualquier hilo.
+     * @param handle Rango (kInvalidHandle no hace nada).
+     */
+    static void free(Handle handle);
+
+    /**
+     * @brief Posición actual de un rango.
+     * @param handle Rango vivo.
+     */
+    static const Range& resolve(Handle handle) { return activeHeap->slots[handle].range; }
+
+private:
+    /**
+     * @struct Page
+     * @brief Buffer inmutable y el asignador de sus rangos.
+     */
+    struct Page {
+        GLuint buffer;                  /**< Buffer con almacenamiento inmutable */
+        GLsizeiptr size;                /**< Bytes */
+        OffsetAllocator allocator;      /**< Rangos, en unidades de kAlignment */
+        std::vector<Handle> owners;     /**< Rango vivo de cada nodo del asignador */
+
+        Page(GLuint buffer, GLsizeiptr size, uint32_t maxAllocations);
+    };
+
+    /**
+     * @struct Slot
+     * @brief Entrada de la tabla de handles.
+     */
+    struct Slot {
+        Range range;                    /**< Posición actual */
+        uint32_t page;                  /**< Página */
+        uint32_t node;                  /**< Nodo en el asignador de la página */
+        Handle nextFree;                /**< Siguiente slot libre */
+    };
+
+    /**
+     * @struct PendingRange
+     * @brief Rango liberado o abandonado al moverse, a la espera de su fence.
+     */
+    struct PendingRange {
+        uint32_t page;
+        uint32_t node;
+    };
+
+    /**
+     * @struct RetireBatch
+     * @brief Rangos de un frame y la fence que los protege.
+     */
+    struct RetireBatch {
+        GLsync fence;
+        std::vector<PendingRange> ranges;
+    };
+
+    GLsizeiptr pageBytes;                       /**< Tamaño de página por defecto */
+    size_t moveBytesPerFrame;                   /**< Límite de copias de desfragmentación */
+    std::vector<std::unique_ptr<Page>> pages;   /**< Páginas (nullptr: hueco reutilizable) */
+    std::vector<Slot> slots;                    /**< Tabla de handles */
+    Handle firstFreeSlot;                       /**< Lista de slots libres */
+    std::mutex freeMutex;                       /**< Protege @c freed (se libera desde cualquier hilo) */
+    std::vector<Handle> freed;                  /**< Handles liberados en el frame en curso */
+    std::vector<Handle> freeing;                /**< Copia de trabajo de @c freed */
+    std::vector<PendingRange> current;          /**< Rangos del frame en curso */
+    std::vector<RetireBatch> inFlight;          /**< Frames cerrados, del más antiguo al más reciente */
+    int evacuating;                             /**< Página que se vacía (-1 ninguna) */
+    GpuHeapStats stats;                         /**< Contadores del último endFrame */
+    int allocationsThisFrame;                   /**< Rangos pedidos desde el último endFrame */
+
+    static GpuHeap* activeHeap;                 /**< Heap usado por las funciones estáticas */
+
+    bool place(uint32_t units, int skipPage, uint32_t& pageIndex, OffsetAllocator::Allocation& allocation);
+    uint32_t addPage(GLsizeiptr size);
+    void releasePage(uint32_t pageIndex);
+    void defragment();
+    static uint32_t units(GLsizeiptr bytes);
+};
+
+#endif // GPU_HEAP_H
@@ -0,0 +1,374 @@
+// JobSystem.cpp
+
+#include "job_system.h"
+#include <algorithm>
+
+JobSystem* JobSystem::activeSystem = nullptr;
+
+// Worker identity of the calling thread: which system it belongs to and its deque
+static thread_local const JobSystem* tlsSystem = nullptr;
+static thread_local unsigned tlsWorker = 0;
+
+JobSystem::JobSystem(int workerCount)
+    : running(true), queued(0), sleepers(0)
+{
+    unsigned count = workerCount >= 0
+        ? static_cast<unsigned>(workerCount)
+        : std::max(1u, std::thread::hardware_concurrency()) - 1;
+    if (workerCount < 0)
+        count = std::max(1u, count);
+
+    for (unsigned i = 0; i < count; ++i)
+        deques.push_back(std::make_unique<WorkStealingDeque<Job*>>());
+    workers.reserve(count);
+    for (unsigned i = 0; i < count; ++i)
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    if (activeSystem == this)
+        activeSystem = nullptr;
+
+    // Workers drain what is queued before they exit
+    running.store(false);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wake.notify_all();
+    }
+    for (std::thread& worker : workers)
+        worker.join();
+
+    // Without workers (or with jobs queued after they left) run the rest here
+    while (Job* job = takeJob())
+        execute(job);
+    runGLJobs();
+
+    for (Job* job : freeJobs)
+        delete job;
+}
+
+// Jobs are recycled: in steady state scheduling does not touch the heap
+JobSystem::Job* JobSystem::acquireJob(JobCounter* counter, bool glThread)
+{
+    Job* job = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (!freeJobs.empty())
+        {
+            job = freeJobs.back();
+            freeJobs.pop_back();
+        }
+    }
+    if (!job)
+    {
+        job = new Job();
+        // The free list keeps room for every job, so recycling never grows it
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (freeJobs.capacity() < ++ownedJobs)
+            freeJobs.reserve(ownedJobs * 2);
+    }
+    job->counter = counter;
+    job->glThread = glThread;
+    job->range = nullptr;
+    return job;
+}
+
+void JobSystem::reserveJobs(size_t count)
+{
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (freeJobs.capacity() < count)
+            freeJobs.reserve(count);
+        for (; ownedJobs < count; ++ownedJobs)
+            freeJobs.push_back(new Job());
+    }
+    std::lock_guard<std::mutex> lock(injectMutex);
+    if (injected.capacity() < count)
+        injected.reserve(count);
+}
+
+void JobSystem::recycleJob(Job* job)
+{
+    job->fn = nullptr;
+    std::lock_guard<std::mutex> lock(poolMutex);
+    freeJobs.push_back(job);
+}
+
+void JobSystem::activate()
+{
+    activeSystem = this;
+    setGLThread();
+}
+
+void JobSystem::setGLThread()
+{
+    glThread.store(std::this_thread::get_id());
+}
+
+JobSystem* JobSystem::active()
+{
+    return activeSystem;
+}
+
+void JobSystem::schedule(std::function<void()> job, JobCounter* counter, JobCounter* dependency)
+{
+    if (counter)
+        counter->value.fetch_add(1, std::memory_order_relaxed);
+
+    Job* entry = acquireJob(counter, false);
+    entry->fn = std::move(job);
+    if (dependency)
+    {
+        std::lock_guard<std::mutex> lock(dependency->mutex);
+        if (dependency->value.load(std::memory_order_acquire) != 0)
+        {
+            dependency->continuations.push_back(entry);
+            return;
+        }
+    }
+    release(entry);
+}
+
+void JobSystem::scheduleOnGLThread(std::function<void()> job, JobCounter* counter, JobCounter* dependency)
+{
+    if (counter)
+        counter->value.fetch_add(1, std::memory_order_relaxed);
+
+    Job* entry = acquireJob(counter, true);
+    entry->fn = std::move(job);
+    if (dependency)
+    {
+        std::lock_guard<std::mutex> lock(dependency->mutex);
+        if (dependency->value.load(std::memory_order_acquire) != 0)
+        {
+            dependency->continuations.push_back(entry);
+            return;
+        }
+    }
+    release(entry);
+}
+
+// Hands a job whose dependencies are met to the right queue
+void JobSystem::release(Job* job)
+{
+    if (job->glThread)
+    {
+        std::lock_guard<std::mutex> lock(glMutex);
+        glJobs.push_back(job);
+        return;
+    }
+    enqueue(job);
+}
+
+void JobSystem::enqueue(Job* job)
+{
+    queued.fetch_add(1);
+    if (tlsSystem != this || !deques[tlsWorker]->push(job))
+    {
+        std::lock_guard<std::mutex> lock(injectMutex);
+        injected.push_back(job);
+    }
+
+    // Pairs with the sleepers increment in workerLoop: either the worker sees the job or we see the sleeper
+    if (sleepers.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wake.notify_one();
+    }
+}
+
+JobSystem::Job* JobSystem::takeJob()
+{
+    Job* job = nullptr;
+    const bool isWorker = tlsSystem == this;
+    if (isWorker)
+        job = deques[tlsWorker]->pop();
+
+    if (!job)
+    {
+        std::lock_guard<std::mutex> lock(injectMutex);
+        if (injectedHead < injected.size())
+        {
+            job = injected[injectedHead++];
+            if (injectedHead == injected.size())
+            {
+                injected.clear();
+                injectedHead = 0;
+            }
+        }
+    }
+
+    // Steal the oldest (largest, for split ranges) job from another worker
+    const unsigned count = static_cast<unsigned>(deques.size());
+    const unsigned start = isWorker ? tlsWorker + 1 : 0;
+    for (unsigned i = 0; !job && i < count; ++i)
+    {
+        const unsigned victim = (start + i) % count;
+        if (isWorker && victim == tlsWorker)
+            continue;
+        job = deques[victim]->steal();
+    }
+
+    if (job)
+        queued.fetch_sub(1);
+    return job;
+}
+
+void JobSystem::execute(Job* job)
+{
+    if (job->range)
+        splitRange(job->begin, job->end, job->chunk, *job->range, *job->counter);
+    else
+        job->fn();
+    JobCounter* counter = job->counter;
+    recycleJob(job);
+    finish(counter);
+}
+
+void JobSystem::finish(JobCounter* counter)
+{
+    if (!counter)
+        return;
+
+    // Lock-free while other jobs are still pending
+    int value = counter->value.load(std::memory_order_relaxed);
+    while (value > 1)
+    {
+        if (counter->value.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+            return;
+    }
+
+    // The final decrement is made under the lock so a waiter never frees the counter under us
+    std::vector<Job*> ready;
+    {
+        std::lock_guard<std::mutex> lock(counter->mutex);
+        if (counter->value.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        ready.swap(counter->continuations);
+    }
+    for (Job* job : ready)
+        release(job);
+}
+
+int JobSystem::runGLJobs()
+{
+    // A GL job that waits on other work re-enters here; it takes its own batch
+    if (runningGLBatch)
+    {
+        std::vector<Job*> nested;
+        {
+            std::lock_guard<std::mutex> lock(glMutex);
+            nested.swap(glJobs);
+        }
+        for (Job* job : nested)
+            execute(job);
+        return static_cast<int>(nested.size());
+    }
+
+    // Both vectors keep their capacity, so polling from wait() never allocates
+    {
+        std::lock_guard<std::mutex> lock(glMutex);
+        if (glJobs.empty())
+            return 0;
+        glBatch.swap(glJobs);
+    }
+    runningGLBatch = true;
+    const int count = static_cast<int>(glBatch.size());
+    for (size_t i = 0; i < glBatch.size(); ++i)
+        execute(glBatch[i]);
+    glBatch.clear();
+    runningGLBatch = false;
+    return count;
+}
+
+void JobSystem::wait(JobCounter& counter, bool allowGLJobs)
+{
+    const bool glThreadWaiting = allowGLJobs && onGLThread();
+    while (!counter.done())
+    {
+        if (glThreadWaiting && runGLJobs() > 0)
+            continue;
+        if (Job* job = takeJob())
+            execute(job);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::parallelFor(size_t begin, size_t end, size_t minChunk, const std::function<void(size_t, size_t)>& fn)
+{
+    if (begin >= end)
+        return;
+
+    // Enough chunks for every thread to steal several, but never below minChunk
+    const size_t count = end - begin;
+    const size_t threads = workers.size() + 1;
+    const size_t chunk = std::max<size_t>({minChunk, 1, count / (threads * 8)});
+    if (count <= chunk || workers.empty())
+    {
+        fn(begin, end);
+        return;
+    }
+
+    // How many jobs end up in flight depends on stealing; have one per chunk ready up front
+    reserveJobs(count / chunk + 1);
+    JobCounter counter;
+    splitRange(begin, end, chunk, fn, counter);
+    // The chunks never depend on GL jobs, and those may mutate what the chunks read
+    // (a load task adding renderables while Render records them): leave them to the frame start
+    wait(counter, false);
+}
+
+// Keeps the lower half and schedules the upper one until the range fits a chunk; a thief
+// that takes an upper half splits it again, so work spreads as threads become free
+void JobSystem::splitRange(size_t begin, size_t end, size_t chunk, const std::function<void(size_t, size_t)>& fn,
+                           JobCounter& counter)
+{
+    while (end - begin > chunk)
+    {
+        const size_t mid = begin + (end - begin) / 2;
+        // A range job instead of a capturing std::function: no allocation per split
+        counter.value.fetch_add(1, std::memory_order_relaxed);
+        Job* job = acquireJob(&counter, false);
+        job->range = &fn;
+        job->begin = mid;
+        job->end = end;
+        job->chunk = chunk;
+        enqueue(job);
+        end = mid;
+    }
+    fn(begin, end);
+}
+
+void JobSystem::workerLoop(unsigned index)
+{
+    tlsSystem = this;
+    tlsWorker = index;
+
+    int idleSpins = 0;
+    while (true)
+    {
+        if (Job* job = takeJob())
+        {
+            execute(job);
+            idleSpins = 0;
+            continue;
+        }
+        if (!running.load())
+            break;
+        if (++idleSpins < 64)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepers.fetch_add(1);
+        wake.wait(lock, [this]() { return queued.load() > 0 || !running.load(); });
+        sleepers.fetch_sub(1);
+        idleSpins = 0;
+    }
+
+    tlsSystem = nullptr;
+}
@@ -0,0 +1,238 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include "work_stealing_deque.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class JobSystem;
+
+/**
+ * @class JobCounter
+ * @brief Contador de tareas pendientes: se puede esperar y usar como dependencia de otras tareas.
+ *
+ * Cada tarea programada con un contador lo incrementa y lo decrementa al terminar. Las
+ * tareas que dependen de él (@ref JobSystem::schedule con @c dependency) se lanzan cuando
+ * llega a cero.
+ */
+class JobCounter {
+public:
+    JobCounter() : value(0) {}
+
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    /**
+     * @brief Indica si no quedan tareas pendientes.
+     *
+     * Cuando devuelve true, la última tarea ya no toca el contador y este puede destruirse.
+     */
+    bool done() const
+    {
+        if (value.load(std::memory_order_acquire) != 0)
+            return false;
+        // The last decrement happens under the lock; taking it waits for that thread to let go
+        std::lock_guard<std::mutex> lock(mutex);
+        return value.load(std::memory_order_relaxed) == 0;
+    }
+
+private:
+    friend class JobSystem;
+    struct Job;
+
+    std::atomic<int> value;            /**< Tareas pendientes */
+    mutable std::mutex mutex;          /**< Protege @c continuations y el último decremento */
+    std::vector<Job*> continuations;   /**< Tareas que esperan a que el contador llegue a cero */
+};
+
+/**
+ * @class JobSystem
+ * @brief Planificador de tareas con robo de trabajo para repartir el trabajo de CPU entre todos los núcleos.
+ *
+ * Cada hilo trabajador tiene un deque de Chase-Lev: apila y desapila sus propias tareas
+ * (las más recientes, aún en caché) y, cuando se queda sin trabajo, roba las más antiguas
+ * de otro trabajador. Los hilos que no son trabajadores (principal, render, simulación)
+ * envían sus tareas a una cola compartida.
+ *
+ * - @ref wait ejecuta otras tareas mientras espera, así que se puede esperar desde una tarea.
+ * - @ref parallelFor divide un rango por mitades: cada mitad robada se vuelve a dividir, y
+ *   el reparto se adapta solo a los hilos libres y al coste desigual de los elementos.
+ * - Las tareas de OpenGL (@ref scheduleOnGLThread) solo se ejecutan en el hilo dueño del
+ *   contexto, cuando este llama a @ref runGLJobs.
+ */
+class JobSystem {
+public:
+    /**
+     * @brief Constructor. Arranca los hilos trabajadores.
+     * @param workerCount Hilos trabajadores; negativo usa un hilo por núcleo menos uno (mínimo uno).
+     *        Con 0 las tareas solo avanzan cuando alguien espera (útil para medir un solo núcleo).
+     */
+    explicit JobSystem(int workerCount = -1);
+
+    /**
+     * @brief Destructor. Termina las tareas encoladas y detiene los trabajadores.
+     */
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /**
+     * @brief Programa una tarea.
+     *
+     * @param job Función a ejecutar en cualquier trabajador.
+     * @param counter Contador que se incrementa ahora y se decrementa al terminar (opcional).
+     * @param dependency La tarea no empieza hasta que este contador llegue a cero (opcional).
+     */
+    void schedule(std::function<void()> job, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+
+    /**
+     * @brief Programa una tarea que debe ejecutarse en el hilo dueño del contexto OpenGL.
+     *
+     * @param job Función a ejecutar en la próxima llamada a @ref runGLJobs.
+     * @param counter Contador que se decrementa al terminar (opcional).
+     * @param dependency La tarea no se encola hasta que este contador llegue a cero (opcional).
+     */
+    void scheduleOnGLThread(std::function<void()> job, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+
+    /**
+     * @brief Ejecuta las tareas de OpenGL encoladas. Solo desde el hilo con el contexto.
+     * @return Número de tareas ejecutadas.
+     */
+    int runGLJobs();
+
+    /**
+     * @brief Espera a que un contador llegue a cero ejecutando otras tareas mientras tanto.
+     *
+     * Desde el hilo de OpenGL también ejecuta tareas de OpenGL, para que una espera sobre
+     * tareas que dependen de ellas no se bloquee. Las esperas que no dependen de ellas (como
+     * la de @ref parallelFor) pasan @p allowGLJobs a false: una tarea de OpenGL ejecutada a
+     * mitad de frame podría modificar datos que los trozos aún están leyendo.
+     *
+     * @param counter Contador a esperar.
+     * @param allowGLJobs Ejecuta tareas de OpenGL mientras espera (solo desde el hilo de OpenGL).
+     */
+    void wait(JobCounter& counter, bool allowGLJobs = true);
+
+    /**
+     * @brief Ejecuta @p fn sobre [begin, end) en trozos repartidos entre los trabajadores y espera.
+     *
+     * La espera no ejecuta tareas de OpenGL, así que es segura a mitad de frame: esas tareas
+     * solo avanzan en las llamadas a @ref runGLJobs del bucle de render.
+     *
+     * @param begin Primer índice.
+     * @param end Índice final (excluido).
+     * @param minChunk Elementos mínimos por trozo (por debajo no compensa una tarea).
+     * @param fn Función (chunkBegin, chunkEnd) sobre un trozo del rango.
+     */
+    void parallelFor(size_t begin, size_t end, size_t minChunk, const std::function<void(size_t, size_t)>& fn);
+
+    /**
+     * @brief Ejecuta una función en un trabajador y devuelve su resultado como @c std::future.
+     *
+     * Sin sistema activo (o sin trabajadores) recurre a @c std::async. A diferencia de @c std::async, destruir el
+     * future no espera a la tarea: quien use datos externos debe esperarla antes de liberarlos.
+     *
+     * @param fn Función sin argumentos.
+     * @return Future con el resultado.
+     */
+    template <typename Fn>
+    static auto async(Fn&& fn) -> std::future<std::invoke_result_t<std::decay_t<Fn>>>;
+
+    /**
+     * @brief Número de hilos trabajadores.
+     */
+    unsigned workerCount() const { return static_cast<unsigned>(workers.size()); }
+
+    /**
+     * @brief Hace de este sistema el que usan @ref async y los módulos del motor.
+     *
+     * El hilo que llama queda como dueño del contexto OpenGL (ver @ref setGLThread).
+     */
+    void activate();
+
+    /**
+     * @brief Marca el hilo que llama como dueño del contexto OpenGL (al pasar el contexto a otro hilo).
+     */
+    void setGLThread();
+
+    /**
+     * @brief Obtiene el sistema activo.
+     * @return Puntero al sistema, o nullptr si el trabajo se hace en el hilo que llama.
+     */
+    static JobSystem* active();
+
+private:
+    using Job = JobCounter::Job;
+
+    std::vector<std::thread> workers;                              /**< Hilos trabajadores */
+    std::vector<std::unique_ptr<WorkStealingDeque<Job*>>> deques;  /**< Un deque por trabajador */
+    std::mutex injectMutex;                                        /**< Protege @c injected */
+    std::vector<Job*> injected;                                    /**< Tareas de hilos que no son trabajadores (FIFO) */
+    size_t injectedHead = 0;                                       /**< Siguiente tarea de @c injected */
+    std::mutex glMutex;                                            /**< Protege @c glJobs */
+    std::vector<Job*> glJobs;                                      /**< Tareas para el hilo de OpenGL */
+    std::vector<Job*> glBatch;                                     /**< Lote en ejecución (solo el hilo de OpenGL) */
+    bool runningGLBatch = false;                                   /**< @c glBatch se está ejecutando */
+    std::mutex poolMutex;                                          /**< Protege @c freeJobs */
+    std::vector<Job*> freeJobs;                                    /**< Tareas terminadas para reutilizar sin reservar */
+    size_t ownedJobs = 0;                                          /**< Tareas creadas, libres o en uso */
+    std::atomic<std::thread::id> glThread;                         /**< Hilo dueño del contexto */
+
+    std::atomic<bool> running;       /**< Los trabajadores deben seguir */
+    std::atomic<int> queued;         /**< Tareas encoladas y aún no tomadas */
+    std::atomic<int> sleepers;       /**< Trabajadores dormidos */
+    std::mutex sleepMutex;           /**< Para dormir a los trabajadores sin perder avisos */
+    std::condition_variable wake;    /**< Despierta a los trabajadores dormidos */
+
+    static JobSystem* activeSystem;  /**< Sistema usado por @ref async */
+
+    bool onGLThread() const { return glThread.load(std::memory_order_relaxed) == std::this_thread::get_id(); }
+    void workerLoop(unsigned index);
+    Job* acquireJob(JobCounter* counter, bool glThread);
+    void reserveJobs(size_t count);
+    void recycleJob(Job* job);
+    void enqueue(Job* job);
+    Job* takeJob();
+    void execute(Job* job);
+    void release(Job* job);
+    void finish(JobCounter* counter);
+    void splitRange(size_t begin, size_t end, size_t chunk, const std::function<void(size_t, size_t)>& fn,
+                    JobCounter& counter);
+};
+
+/**
+ * @struct JobCounter::Job
+ * @brief Tarea programada.
+ */
+struct JobCounter::Job {
+    std::function<void()> fn;    /**< Trabajo */
+    JobCounter* counter;         /**< Contador a decrementar al terminar */
+    bool glThread;               /**< Solo en el hilo de OpenGL */
+    const std::function<void(size_t, size_t)>* range; /**< Rango de @ref JobSystem::parallelFor (en lugar de @c fn) */
+    size_t begin, end, chunk;    /**< Subrango a repartir y tamaño mínimo de trozo */
+};
+
+template <typename Fn>
+auto JobSystem::async(Fn&& fn) -> std::future<std::invoke_result_t<std::decay_t<Fn>>>
+{
+    using Result = std::invoke_result_t<std::decay_t<Fn>>;
+    JobSystem* system = active();
+    if (!system || system->workerCount() == 0)
+        return std::async(std::launch::async, std::forward<Fn>(fn));
+
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(fn));
+    std::future<Result> result = task->get_future();
+    system->schedule([task]() { (*task)(); });
+    return result;
+}
+
+#endif // JOB_SYSTEM_H
@@ -4,6 +4,12 @@
 #include "Shader.h"
 #include "Mesh.h"
 #include "Texture.h"
+#include "Camera.h"
+#include "texture_streamer.h"
+#include "shader_variants.h"
+#include "mesh_source.h"
+#include "task_graph.h"
+#include "entity_registry.h"
 #include <glm/glm.hpp>
 #include <vector>
 #include <memory>
@@ -30,88 +36,90 @@ public:
 
     /**
      * @brief Configura el faro cargando texturas y generando geometría.
+     * @param registry Registro donde crear las entidades de sus partes.
      */
-    void Setup();
+    void Setup(EntityRegistry& registry);
 
     /**
-     * @brief Renderiza el faro con iluminación y texturas aplicadas.
+     * @brief Añade al grafo las tareas de carga del faro.
      *
-     * @param shader El shader a utilizar para renderizar.
-     * @param time El tiempo actual para animar la dirección del spotlight.
-     */
-    void Render(const Shader& shader, float time);
-
-private:
-    std::unique_ptr<Mesh> tower;    /**< Malla que representa la torre del faro. */
-    std::unique_ptr<Mesh> roof;     /**< Malla que representa el techo del faro. */
-    std::unique_ptr<Mesh> beacon;   /**< Malla que representa el beacon del faro. */
-
-    std::vector<Texture> towerTextures; /**< Texturas aplicadas a la torre. */
-    std::vector<Texture> roofTextures;  /**< Texturas aplicadas al techo. */
-
-    /**
-     * @brief Genera vértices para un cilindro.
+     * La lectura y decodificación de texturas y mallas van a los trabajadores; la subida de
+     * cada textura y la creación de cada malla quedan fijadas al hilo de OpenGL. Cada parte
+     * se añade al registro como entidad dibujable en cuanto su malla existe.
      *
-     * @param radius Radio del cilindro.
-     * @param height Altura del cilindro.
-     * @param sectorCount Número de sectores alrededor de la circunferencia.
-     * @return std::vector<Vertex> Vértices generados.
+     * @param graph Grafo de carga de la escena.
+     * @param registry Registro de la escena; debe vivir hasta el fin de la carga.
+     * @param parent Nodo del que cuelga la base del faro (opcional; sin él queda en el origen).
+     * @return TaskGraph::TaskId Tarea que termina cuando las tres mallas están creadas.
      */
-    std::vector<Vertex> generateCylinderVertices(float radius, float height, int sectorCount) const;
+    TaskGraph::TaskId AddSetupTasks(TaskGraph& graph, EntityRegistry& registry, Entity parent = Entity());
 
     /**
-     * @brief Genera índices para un cilindro.
+     * @brief Coloca el faro: una sola escritura en el nodo raíz del que cuelgan sus partes.
      *
-     * @param sectorCount Número de sectores alrededor de la circunferencia.
-     * @return std::vector<unsigned int> Índices generados.
+     * @param registry Registro de la escena.
+     * @param position Posición de la base en el mundo.
      */
-    std::vector<unsigned int> generateCylinderIndices(int sectorCount) const;
+    void SetPosition(EntityRegistry& registry, const glm::vec3& position);
 
     /**
-     * @brief Genera vértices para un cono.
-     *
-     * @param radius Radio base del cono.
-     * @param height Altura del cono.
-     * @param sectorCount Número de sectores alrededor de la circunferencia.
-     * @return std::vector<Vertex> Vértices generados.
+     * @brief Indica si alguna parte del faro pasó el último culling del registro.
+     * @param registry Registro de la escena.
      */
-    std::vector<Vertex> generateConeVertices(float radius, float height, int sectorCount) const;
+    bool IsVisible(const EntityRegistry& registry) const;
 
     /**
-     * @brief Genera índices para un cono.
+     * @brief Fija en todas las variantes el spotlight giratorio del beacon.
      *
-     * @param sectorCount Número de sectores alrededor de la circunferencia.
-     * @return std::vector<unsigned int> Índices generados.
+     * @param shaders Variantes del shader de iluminación.
+     * @param registry Registro de la escena, con las transformaciones del frame ya calculadas.
+     * @param time El tiempo actual para animar la dirección del spotlight.
      */
-    std::vector<unsigned int> generateConeIndices(int sectorCount) const;
+    void UpdateSpotlight(ShaderVariants& shaders, const EntityRegistry& registry, float time) const;
 
     /**
-     * @brief Genera vértices para una esfera.
+     * @brief Solicita el detalle de textura necesario según la distancia a la cámara.
      *
-     * @param radius Radio de la esfera.
-     * @param sectorCount Número de sectores (cortes verticales).
-     * @param stackCount Número de stacks (cortes horizontales).
-     * @return std::vector<Vertex> Vértices generados.
+     * @param streamer Streamer de texturas.
+     * @param camera Cámara activa.
+     * @param registry Registro de la escena.
      */
-    std::vector<Vertex> generateSphereVertices(float radius, int sectorCount, int stackCount) const;
+    void RequestTextureDetail(TextureStreamer& streamer, const Camera& camera, const EntityRegistry& registry) const;
+
+private:
+    std::unique_ptr<Mesh> tower;    /**< Malla que representa la torre del faro. */
+    std::unique_ptr<Mesh> roof;     /**< Malla que representa el techo del faro. */
+    std::unique_ptr<Mesh> beacon;   /**< Malla que representa el beacon del faro. */
+
+    Entity rootEntity;              /**< Nodo de la base del que cuelgan las partes. */
+    Entity towerEntity;             /**< Entidad de la torre. */
+    Entity roofEntity;              /**< Entidad del techo. */
+    Entity beaconEntity;            /**< Entidad del beacon. */
+
+    std::vector<Texture> towerTextures; /**< Texturas aplicadas a la torre. */
+    std::vector<Texture> roofTextures;  /**< Texturas aplicadas al techo. */
+
+    MeshSource towerSource;  /**< Geometría de la torre durante la carga. */
+    MeshSource roofSource;   /**< Geometría del techo durante la carga. */
+    MeshSource beaconSource; /**< Geometría del beacon durante la carga. */
 
     /**
-     * @brief Genera índices para una esfera.
+     * @brief Posición en el mundo de una parte según la última actualización de transformaciones.
      *
-     * @param sectorCount Número de sectores (cortes verticales).
-     * @param stackCount Número de stacks (cortes horizontales).
-     * @return std::vector<unsigned int> Índices generados.
+     * @param registry Registro de la escena.
+     * @param entity Parte del faro.
+     * @param fallback Posición si la parte aún no existe.
      */
-    std::vector<unsigned int> generateSphereIndices(int sectorCount, int stackCount) const;
+    static glm::vec3 partPosition(const EntityRegistry& registry, Entity entity, const glm::vec3& fallback);
 
     /**
-     * @brief Carga una textura desde un archivo.
+     * @brief Añade las tareas de carga de una textura: decodificación y subida.
      *
-     * @param path Ruta al archivo de textura.
-     * @param type Tipo de textura (por ejemplo, "texture_diffuse").
-     * @return Texture Textura cargada.
+     * @param graph Grafo de carga.
+     * @param texture Textura a cargar; debe seguir en la misma dirección hasta que termine.
+     * @return TaskGraph::TaskId Tarea de subida.
      */
-    Texture loadTexture(const std::string& path, const std::string& type) const;
+    static TaskGraph::TaskId addTextureTasks(TaskGraph& graph, Texture& texture);
 };
 
 #endif // LIGHTHOUSE_H
@@ -5,8 +5,26 @@
 #include "Scene.h"
 #include "Texture.h"
 #include "Constants.h"
+#include "sampler_cache.h"
+#include "asset_pack.h"
+#include "program_cache.h"
+#include "shader_variants.h"
+#include "shader_manager.h"
+#include "simulation.h"
+#include "job_system.h"
+#include "frame_allocator.h"
+#include "alloc_tracker.h"
+#include "gl_resource_manager.h"
+#include "gpu_heap.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <string>
+#include <thread>
 
 // Debug Callback
 void APIENTRY glDebugOutput(GLenum source, GLenum type, GLuint id, GLenum severity,
@@ -52,61 +70,43 @@ void APIENTRY glDebugOutput(GLenum source, GLenum type, GLuint id, GLenum severi
 }
 
 // Callbacks
+// Framebuffer size packed as (width << 32 | height); the render thread applies it to the viewport
+static std::atomic<uint64_t> framebufferSize{0};
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
+    framebufferSize.store((uint64_t)(uint32_t)width << 32 | (uint32_t)height);
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 {
-    Camera* camera = static_cast<Camera*>(glfwGetWindowUserPointer(window));
-    if (camera)
+    Simulation* simulation = static_cast<Simulation*>(glfwGetWindowUserPointer(window));
+    if (simulation)
     {
-        static float lastX = WINDOW_WIDTH / 2.0f;
-        static float lastY = WINDOW_HEIGHT / 2.0f;
-        static bool firstMouse = true;
-
-        if (firstMouse)
-        {
-            lastX = (float)xpos;
-            lastY = (float)ypos;
-            firstMouse = false;
-        }
-
-        float xoffset = (float)xpos - lastX;
-        float yoffset = lastY - (float)ypos; 
-        lastX = (float)xpos;
-        lastY = (float)ypos;
-
-        camera->ProcessMouseMovement(xoffset, yoffset);
+        InputEvent event;
+        event.type = InputEvent::Type::CursorPos;
+        event.x = xpos;
+        event.y = ypos;
+        simulation->pushEvent(event);
     }
 }
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
-    Camera* camera = static_cast<Camera*>(glfwGetWindowUserPointer(window));
-    if (camera)
+    Simulation* simulation = static_cast<Simulation*>(glfwGetWindowUserPointer(window));
+    if (simulation)
     {
-        camera->ProcessMouseScroll((float)yoffset);
+        InputEvent event;
+        event.type = InputEvent::Type::Scroll;
+        event.y = yoffset;
+        simulation->pushEvent(event);
     }
 }
 
-void processInput(GLFWwindow *window, Camera &camera, float deltaTime)
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
-    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-        glfwSetWindowShouldClose(window, true);
-
-    if(glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        camera.ProcessKeyboard(CameraMovement::FORWARD, deltaTime);
-    if(glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        camera.ProcessKeyboard(CameraMovement::BACKWARD, deltaTime);
-    if(glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        camera.ProcessKeyboard(CameraMovement::LEFT, deltaTime);
-    if(glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);
-
-    static bool cKeyPressed = false;
-    if(glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS && !cKeyPressed)
+    // The cursor mode belongs to the window, so it is toggled here on the main thread
+    if (key == GLFW_KEY_C && action == GLFW_PRESS)
     {
         static bool cursorDisabled = true;
         cursorDisabled = !cursorDisabled;
@@ -114,16 +114,142 @@ void processInput(GLFWwindow *window, Camera &camera, float deltaTime)
             glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
         else
             glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-        cKeyPressed = true;
+        return;
     }
-    if(glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE)
+
+    Simulation* simulation = static_cast<Simulation*>(glfwGetWindowUserPointer(window));
+    if (simulation && action != GLFW_REPEAT)
+    {
+        InputEvent event;
+        event.type = InputEvent::Type::Key;
+        event.key = key;
+        event.action = action;
+        simulation->pushEvent(event);
+    }
+}
+
+// Milliseconds elapsed since a point in time
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Warms up every program created during loading and reports where they came from
+static void warmUpShaders(ShaderManager& shaderManager)
+{
+    shaderManager.warmUp();
+    std::cout << "Shader programs: " << ProgramCache::hits << " from cache, "
+              << ProgramCache::misses << " compiled." << std::endl;
+}
+
+// Render thread: owns the GL context and draws the latest simulation snapshot at its own pace
+void renderLoop(GLFWwindow* window, Scene& scene, ShaderVariants& phongShaders, Shader& skyboxShader,
+                Simulation& simulation, const std::atomic<bool>& rendering,
+                std::chrono::steady_clock::time_point launchTime)
+{
+    glfwMakeContextCurrent(window);
+    JobSystem* jobs = JobSystem::active();
+    if (jobs)
+        jobs->setGLThread();
+    uint64_t appliedSize = 0;
+    bool firstFrame = true;
+
+    // Render-path temporaries come from per-frame arenas instead of the heap
+    FrameAllocator frameAllocator;
+    frameAllocator.activate();
+
+    // Scene::Render is held to zero allocations once loading, warm-up and arena growth have settled
+    const int framesBeforeNoAlloc = 120;
+    int settledFrames = 0;
+
+    while(rendering.load())
     {
-        cKeyPressed = false;
+        AllocTracker::beginFrame();
+        frameAllocator.beginFrame();
+
+        const uint64_t size = framebufferSize.load();
+        if (size != appliedSize && size != 0)
+        {
+            glViewport(0, 0, (GLsizei)(size >> 32), (GLsizei)(size & 0xFFFFFFFFu));
+            appliedSize = size;
+        }
+
+        // GL work handed over by background jobs (uploads, resource creation). This is the only
+        // place it runs: waits inside Render leave it alone while workers read the registry
+        if (jobs)
+            jobs->runGLJobs();
+
+        // Objects appear as their loading tasks finish; programs are warmed up once everything is in
+        if (!scene.IsLoaded() && scene.UpdateLoading())
+            std::cout << "Scene fully loaded " << millisecondsSince(launchTime) << " ms after launch" << std::endl;
+        if (ShaderManager* shaderManager = ShaderManager::active())
+        {
+            if (scene.IsLoaded() && shaderManager->poll())
+                warmUpShaders(*shaderManager);
+        }
+
+        const FrameSnapshot& snapshot = simulation.acquire();
+        const SimulationState state = simulation.interpolate(snapshot, std::chrono::steady_clock::now());
+        const Camera camera = Simulation::makeCamera(state);
+
+        glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // The scene sets camera and light uniforms on every variant it draws with
+        scene.Render(phongShaders, camera, skyboxShader, (float)state.time);
+
+        // Spatial queries see the spheres Render just computed; a static frame only compares them
+        scene.UpdateSpatialIndex();
+
+        glfwSwapBuffers(window);
+        if (GLResourceManager* resources = GLResourceManager::active())
+            resources->endFrame();
+        if (GpuHeap* heap = GpuHeap::active())
+            heap->endFrame();
+        AllocTracker::endFrame();
+
+        if (firstFrame)
+        {
+            std::cout << "First interactive frame " << millisecondsSince(launchTime) << " ms after launch" << std::endl;
+            firstFrame = false;
+        }
+        if (scene.IsLoaded() && !ShaderManager::active() && ++settledFrames == framesBeforeNoAlloc)
+        {
+            // Streaming has settled by now: log what the GPU holds before allocations get fenced off
+            if (GLResourceManager* resources = GLResourceManager::active())
+                resources->reportMemory(std::cout);
+            AllocTracker::armNoAlloc(true);
+        }
     }
+    AllocTracker::armNoAlloc(false);
+
+    glfwMakeContextCurrent(nullptr);
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    const std::chrono::steady_clock::time_point launchTime = std::chrono::steady_clock::now();
+
+    // By default the window is interactive while assets load; --blocking-load waits for everything first.
+    // --gpu-budget-mb caps tracked GPU memory; streamed textures drop to coarser mips to stay under it.
+    // --scene picks the compiled scene (see scene_compiler); without one the built-in scene loads.
+    // --world-budget-mb caps the GPU memory of streamed world cells (scenes compiled with `world`)
+    bool blockingLoad = false;
+    size_t gpuBudgetBytes = 512u << 20;
+    std::string scenePath = "assets/scenes/lighthouse.bscene";
+    size_t worldBudgetBytes = 128u << 20;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--blocking-load")
+            blockingLoad = true;
+        else if (std::string(argv[i]) == "--gpu-budget-mb" && i + 1 < argc)
+            gpuBudgetBytes = static_cast<size_t>(std::max(1, std::atoi(argv[++i]))) << 20;
+        else if (std::string(argv[i]) == "--scene" && i + 1 < argc)
+            scenePath = argv[++i];
+        else if (std::string(argv[i]) == "--world-budget-mb" && i + 1 < argc)
+            worldBudgetBytes = static_cast<size_t>(std::max(1, std::atoi(argv[++i]))) << 20;
+    }
+
     if(!glfwInit())
     {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -133,6 +259,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,6);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_SRGB_CAPABLE, GLFW_TRUE);
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
@@ -165,52 +292,105 @@ int main()
     glCullFace(GL_BACK);
     glFrontFace(GL_CCW);
 
-    Shader phongShader("assets/shaders/phong_vertex_shader.glsl", 
-                       "assets/shaders/phong_fragment_shader.glsl");
-    Shader skyboxShader("assets/shaders/skybox_vertex_shader.glsl", 
-                        "assets/shaders/skybox_fragment_shader.glsl");
+    // Diffuse and skybox textures are sRGB, so lighting happens in linear space and
+    // the default framebuffer re-encodes on write
+    glEnable(GL_FRAMEBUFFER_SRGB);
+
+    // Worker threads for decoding, mip generation and other parallel CPU work
+    auto jobSystem = std::make_unique<JobSystem>();
+    jobSystem->activate();
+
+    // GL objects released by meshes and textures are deleted after the GPU is done with them,
+    // or handed to the next object of the same size
+    GLResourceManager glResources(gpuBudgetBytes);
+    glResources.activate();
+
+    // Mesh vertices and indices are sub-allocated from a few large buffers instead of two each
+    GpuHeap gpuHeap;
+    gpuHeap.activate();
+
+    // One mapped archive replaces the loose shader, texture and mesh files when it is present
+    if(!AssetPack::mount("assets.pak"))
+        std::cout << "No asset pack found, loading loose asset files." << std::endl;
+
+    // Programs created during loading compile in parallel and are warmed up before the first frame
+    ShaderManager shaderManager;
+    shaderManager.init((GLADloadproc)glfwGetProcAddress);
+    shaderManager.activate();
+
+    // One specialized program per material/light permutation
+    ShaderVariants phongShaders("assets/shaders/phong_vertex_shader.glsl", 
+                                "assets/shaders/phong_fragment_shader.glsl");
+    std::unique_ptr<Shader> skyboxShader = ShaderManager::create("assets/shaders/skybox_vertex_shader.glsl", 
+                                                                 "assets/shaders/skybox_fragment_shader.glsl");
 
     Camera camera(glm::vec3(0.0f, 15.0f, 30.0f));
 
     auto scene = std::make_unique<Scene>();
-    scene->Setup();
+    scene->GetWorldStreamer().setBudget(worldBudgetBytes);
+    if (blockingLoad)
+    {
+        scene->Setup(phongShaders, scenePath);
+
+        // Keep the window responsive while the driver compiles, then warm every program up
+        while(!shaderManager.poll() && !glfwWindowShouldClose(window))
+        {
+            glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        warmUpShaders(shaderManager);
+    }
+    else
+    {
+        // The render thread starts right away with placeholders and finishes the load frame by frame
+        scene->BeginSetup(phongShaders, scenePath);
+    }
 
-    glfwSetWindowUserPointer(window, &camera);
+    // Input and camera run on a fixed-rate simulation thread; GLFW events reach it through a queue
+    Simulation simulation(camera);
+    glfwSetWindowUserPointer(window, &simulation);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetKeyCallback(window, key_callback);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    simulation.start();
 
-    float deltaTime = 0.0f; 
-    float lastFrame = 0.0f;
+    // The GL context moves to the render thread; this thread only pumps window events
+    glfwMakeContextCurrent(nullptr);
+    std::atomic<bool> rendering{true};
+    std::thread renderThread(renderLoop, window, std::ref(*scene), std::ref(phongShaders),
+                             std::ref(*skyboxShader), std::ref(simulation), std::cref(rendering), launchTime);
 
     while(!glfwWindowShouldClose(window))
     {
-        float currentFrameTime = (float)glfwGetTime();
-        deltaTime = currentFrameTime - lastFrame;
-        lastFrame = currentFrameTime;
-
-        processInput(window, camera, deltaTime);
+        glfwWaitEvents();
+        if (simulation.quitRequested())
+            glfwSetWindowShouldClose(window, true);
+    }
 
-        glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    rendering.store(false);
+    renderThread.join();
+    simulation.stop();
+    glfwSetWindowUserPointer(window, nullptr);
+    glfwMakeContextCurrent(window);
+    jobSystem->setGLThread();
 
-        // Use shader
-        phongShader.use();
-        if(phongShader.ID != 0) {
-            glm::mat4 view = camera.GetViewMatrix();
-            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), 
-                                                    (float)WINDOW_WIDTH/(float)WINDOW_HEIGHT, 
-                                                    0.1f, 100.0f);
-            phongShader.setMat4("view", view);
-            phongShader.setMat4("projection", projection);
-        }
+    if (scene->GetWorldStreamer().isOpen())
+        scene->GetWorldStreamer().report(std::cout);
 
-        scene->Render(phongShader, camera, skyboxShader);
+    scene->GetSpatialIndex().report(std::cout);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-    }
+    // Scene GL objects and background loads must go before the context and the pack
+    scene.reset();
+    jobSystem.reset();
+    gpuHeap.shutdown();
+    glResources.shutdown();
+    SamplerCache::release();
+    AssetPack::unmount();
 
     glfwTerminate();
+    AllocTracker::report(std::cout);
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,61 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @class MappedFile
+ * @brief Archivo completo mapeado en memoria de solo lectura.
+ *
+ * Los formatos binarios (@ref AssetPack, @ref SceneFile) se leen en su lugar desde el
+ * mapeo: el sistema operativo trae las páginas bajo demanda y no hay copia intermedia.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    /**
+     * @brief Abre y mapea un archivo.
+     * @param path Ruta al archivo.
+     */
+    explicit MappedFile(const std::string& path);
+
+    /**
+     * @brief Destructor. Libera el mapeo.
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Indica si el archivo está mapeado (un archivo vacío no se mapea).
+     */
+    bool isOpen() const { return base != nullptr; }
+
+    /**
+     * @brief Inicio del mapeo.
+     */
+    const unsigned char* data() const { return base; }
+
+    /**
+     * @brief Tamaño del archivo mapeado.
+     */
+    size_t size() const { return mappedSize; }
+
+    /**
+     * @brief Libera el mapeo y los handles.
+     */
+    void close();
+
+private:
+    const unsigned char* base = nullptr; /**< Inicio del archivo mapeado */
+    size_t mappedSize = 0;               /**< Tamaño del mapeo */
+#ifdef _WIN32
+    void* fileHandle = nullptr;          /**< HANDLE del archivo */
+    void* mappingHandle = nullptr;       /**< HANDLE del mapeo */
+#endif
+};
+
+#endif // MAPPED_FILE_H
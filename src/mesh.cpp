@@ -1,23 +1,40 @@
 // Mesh.cpp
 
 #include "Mesh.h"
+#include "sampler_cache.h"
+#include "frame_allocator.h"
+#include "gl_resource_manager.h"
 #include <glad/glad.h>
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 
 // Constructor
 Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, std::vector<Texture>&& textures)
-    : VAO(0), VBO(0), EBO(0), indexCount(static_cast<GLsizei>(indices.size())), textures(std::move(textures))
+    : Mesh(vertices.data(), vertices.size(), indices.data(), indices.size(), std::move(textures))
 {
-    setupMesh(vertices, indices);
+}
+
+Mesh::Mesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+           std::vector<Texture>&& textures)
+    : VAO(0), geometry(GpuHeap::kInvalidHandle), buffer(0), vertexBytes(0), indexBytes(0),
+      indexCount(static_cast<GLsizei>(indexCount)), boundsCenter(0.0f), boundsRadius(0.0f), textures(std::move(textures))
+{
+    setupMesh(vertices, vertexCount, indices, indexCount);
 }
 
 // Move constructor
 Mesh::Mesh(Mesh&& other) noexcept
-    : VAO(other.VAO), VBO(other.VBO), EBO(other.EBO), indexCount(other.indexCount), textures(std::move(other.textures))
+    : VAO(other.VAO), geometry(other.geometry), buffer(other.buffer), vertexBytes(other.vertexBytes),
+      indexBytes(other.indexBytes), bound(other.bound), indexCount(other.indexCount), boundsCenter(other.boundsCenter),
+      boundsRadius(other.boundsRadius), textures(std::move(other.textures)), collision(std::move(other.collision))
 {
     other.VAO = 0;
-    other.VBO = 0;
-    other.EBO = 0;
+    other.geometry = GpuHeap::kInvalidHandle;
+    other.buffer = 0;
+    other.vertexBytes = 0;
+    other.indexBytes = 0;
+    other.bound = GpuHeap::Range();
     other.indexCount = 0;
 }
 
@@ -26,22 +43,29 @@ Mesh& Mesh::operator=(Mesh&& other) noexcept
 {
     if(this != &other)
     {
-        // Delete existing resources
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
+        // Release existing resources (deleted once the GPU is done with them)
+        release();
 
         // Transfer ownership
         VAO = other.VAO;
-        VBO = other.VBO;
-        EBO = other.EBO;
+        geometry = other.geometry;
+        buffer = other.buffer;
+        vertexBytes = other.vertexBytes;
+        indexBytes = other.indexBytes;
+        bound = other.bound;
         indexCount = other.indexCount;
+        boundsCenter = other.boundsCenter;
+        boundsRadius = other.boundsRadius;
         textures = std::move(other.textures);
+        collision = std::move(other.collision);
 
         // Reset other's resources
         other.VAO = 0;
-        other.VBO = 0;
-        other.EBO = 0;
+        other.geometry = GpuHeap::kInvalidHandle;
+        other.buffer = 0;
+        other.vertexBytes = 0;
+        other.indexBytes = 0;
+        other.bound = GpuHeap::Range();
         other.indexCount = 0;
     }
     return *this;
@@ -50,50 +74,94 @@ Mesh& Mesh::operator=(Mesh&& other) noexcept
 // Destructor
 Mesh::~Mesh()
 {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
+    release();
 }
 
-// Initialize buffers
-void Mesh::setupMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+void Mesh::release()
 {
-    // Generate buffers and arrays
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    GLResourceManager::deleteVertexArray(VAO);
+    GpuHeap::free(geometry);
+    GLResourceManager::deleteBuffer(buffer, vertexBytes + indexBytes, GL_STATIC_DRAW);
+    VAO = buffer = 0;
+    geometry = GpuHeap::kInvalidHandle;
+}
 
-    glBindVertexArray(VAO);
+// Initialize buffers
+void Mesh::setupMesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount)
+{
+    // Bounding sphere around the box center, for culling
+    if (vertexCount > 0)
+    {
+        glm::vec3 minimum = vertices[0].Position;
+        glm::vec3 maximum = vertices[0].Position;
+        for (size_t i = 1; i < vertexCount; ++i)
+        {
+            minimum = glm::min(minimum, vertices[i].Position);
+            maximum = glm::max(maximum, vertices[i].Position);
+        }
+        boundsCenter = (minimum + maximum) * 0.5f;
+        for (size_t i = 0; i < vertexCount; ++i)
+            boundsRadius = std::max(boundsRadius, glm::length(vertices[i].Position - boundsCenter));
+    }
 
-    // Load vertex data
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+    // Vertices and indices share one range: a sub-allocation of the GPU heap, or a buffer of its own
+    vertexBytes = static_cast<GLsizeiptr>(vertexCount * sizeof(Vertex));
+    indexBytes = static_cast<GLsizeiptr>(indexCount * sizeof(unsigned int));
+    if (GpuHeap::active())
+    {
+        geometry = GpuHeap::allocate(vertexBytes + indexBytes);
+        GpuHeap::upload(geometry, 0, vertexBytes, vertices);
+        GpuHeap::upload(geometry, vertexBytes, indexBytes, indices);
+        bound = GpuHeap::resolve(geometry);
+    }
+    else
+    {
+        buffer = GLResourceManager::createBuffer(GL_ARRAY_BUFFER, vertexBytes + indexBytes, nullptr, GL_STATIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, vertexBytes, vertices);
+        glBufferSubData(GL_ARRAY_BUFFER, vertexBytes, indexBytes, indices);
+        bound.buffer = buffer;
+        bound.offset = 0;
+        bound.size = vertexBytes + indexBytes;
+    }
 
-    // Load index data
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    // Attribute formats are fixed; only the buffer binding follows the range when it moves
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+    glBindVertexBuffer(0, bound.buffer, bound.offset, sizeof(Vertex));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bound.buffer);
 
     // Vertex Positions
-    glEnableVertexAttribArray(0);	
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexAttribBinding(0, 0);
 
     // Vertex Normals
-    glEnableVertexAttribArray(1);	
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Normal));
+    glVertexAttribBinding(1, 0);
 
     // Vertex Colors
-    glEnableVertexAttribArray(2);	
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Color));
+    glEnableVertexAttribArray(2);
+    glVertexAttribFormat(2, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Color));
+    glVertexAttribBinding(2, 0);
 
     // Texture Coordinates
     glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+    glVertexAttribFormat(3, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, TexCoords));
+    glVertexAttribBinding(3, 0);
 
     glBindVertexArray(0);
 }
 
 // Render the mesh
 void Mesh::Draw(const Shader& shader) const
+{
+    BindMaterial(shader);
+    DrawGeometry();
+    glBindVertexArray(0);
+}
+
+void Mesh::BindMaterial(const Shader& shader) const
 {
     // Bind appropriate textures
     unsigned int diffuseNr  = 1;
@@ -103,29 +171,69 @@ void Mesh::Draw(const Shader& shader) const
     {
         glActiveTexture(GL_TEXTURE0 + i); // Activate proper texture unit before binding
 
-        // Retrieve texture number (e.g., diffuse1, normal1)
-        std::string number;
-        std::string name = textures[i].getType();
-        if(name == "texture_diffuse")
-            number = std::to_string(diffuseNr++);
-        else if(name == "texture_normal")
-            number = std::to_string(normalNr++);
-        else if(name == "texture_roughness")
-            number = std::to_string(roughnessNr++);
-        else
-            number = "1"; // Default number
+        // Retrieve texture number (e.g., diffuse1, normal1); the name lives in the frame arena
+        const std::string& type = textures[i].getType();
+        unsigned int number = 1; // Default number
+        if(type == "texture_diffuse")
+            number = diffuseNr++;
+        else if(type == "texture_normal")
+            number = normalNr++;
+        else if(type == "texture_roughness")
+            number = roughnessNr++;
+
+        char digits[12];
+        std::snprintf(digits, sizeof(digits), "%u", number);
+        FrameString name = frameString(type.c_str());
+        name.append(digits);
 
         // Now set the sampler to the correct texture unit
-        shader.setInt((name + number).c_str(), i);
-        // Bind the texture
+        shader.setInt(name.c_str(), i);
+        // Bind the texture together with its shared sampler state
         glBindTexture(GL_TEXTURE_2D, textures[i].getID());
+        glBindSampler(i, SamplerCache::forTexture(type));
+        GLResourceManager::touchTexture(textures[i].getID());
     }
 
-    // Draw mesh
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
-
     // Reset active texture
     glActiveTexture(GL_TEXTURE0);
 }
+
+// Replayed command buffers bind the VAO back to back and unbind once at the end
+void Mesh::DrawGeometry() const
+{
+    // Defragmentation may have moved the range since the last draw
+    if (geometry != GpuHeap::kInvalidHandle)
+    {
+        const GpuHeap::Range& range = GpuHeap::resolve(geometry);
+        if (range.buffer != bound.buffer || range.offset != bound.offset)
+        {
+            glVertexArrayVertexBuffer(VAO, 0, range.buffer, range.offset, sizeof(Vertex));
+            glVertexArrayElementBuffer(VAO, range.buffer);
+            bound = range;
+        }
+    }
+    glBindVertexArray(VAO);
+    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, reinterpret_cast<const void*>(bound.offset + vertexBytes));
+}
+
+// Reports the on-screen size of this mesh's textures so the streamer can prioritize their mips
+void Mesh::requestTextureDetail(TextureStreamer& streamer, float screenPixels) const
+{
+    for (const Texture& texture : textures)
+        streamer.requestDetail(texture.getID(), screenPixels);
+}
+
+// Picks the tightest shader variant: only maps that actually loaded are sampled
+ShaderVariantKey Mesh::materialKey(ShaderVariantKey base) const
+{
+    for (const Texture& texture : textures)
+    {
+        if (texture.getID() == 0)
+            continue;
+        if (texture.getType() == "texture_diffuse")
+            base.diffuseMap = true;
+        else if (texture.getType() == "texture_normal")
+            base.normalMap = true;
+    }
+    return base;
+}
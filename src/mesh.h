@@ -3,10 +3,16 @@
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <memory>
 #include <vector>
 #include <string>
 #include "Shader.h"
 #include "Texture.h"
+#include "texture_streamer.h"
+#include "shader_variants.h"
+#include "gpu_heap.h"
+
+class MeshCollision;
 
 /**
  * @struct Vertex
@@ -23,8 +29,11 @@ struct Vertex {
  * @class Mesh
  * @brief Representa una malla con vértices, índices y texturas.
  *
- * La clase @c Mesh encapsula la creación de buffers de OpenGL (VBO, VAO, EBO)
+ * La clase @c Mesh encapsula la creación de la geometría en la GPU (VAO, vértices e índices)
  * y ofrece una función @c Draw para renderizar la geometría con un shader dado.
+ * Vértices e índices comparten un rango de @ref GpuHeap (los índices van tras los vértices);
+ * si la desfragmentación mueve el rango, el VAO se vuelve a apuntar en el siguiente draw.
+ * Sin heap activo usa un buffer propio de @ref GLResourceManager.
  */
 class Mesh {
 public:
@@ -36,6 +45,17 @@ public:
      */
     Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, std::vector<Texture>&& textures);
 
+    /**
+     * @brief Constructor desde arreglos crudos (ej: una malla cocinada leída del asset pack sin copia).
+     * @param vertices Puntero al primer vértice.
+     * @param vertexCount Número de vértices.
+     * @param indices Puntero al primer índice.
+     * @param indexCount Número de índices.
+     * @param textures Vector de texturas asociadas a la malla.
+     */
+    Mesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+         std::vector<Texture>&& textures);
+
     // Delete copy constructor and assignment to prevent copying
     Mesh(const Mesh&) = delete;
     Mesh& operator=(const Mesh&) = delete;
@@ -45,7 +65,7 @@ public:
     Mesh& operator=(Mesh&& other) noexcept;
 
     /**
-     * @brief Destructor. Libera los recursos de OpenGL.
+     * @brief Destructor. Devuelve los recursos de OpenGL al gestor de recursos.
      */
     ~Mesh();
 
@@ -55,17 +75,78 @@ public:
      */
     void Draw(const Shader& shader) const;
 
+    /**
+     * @brief Enlaza las texturas de la malla y asigna sus unidades a los samplers del shader.
+     * @param shader Shader activo.
+     */
+    void BindMaterial(const Shader& shader) const;
+
+    /**
+     * @brief Dibuja solo la geometría (deja el VAO enlazado). Requiere material y shader ya fijados.
+     */
+    void DrawGeometry() const;
+
+    /**
+     * @brief Solicita al streamer el detalle de todas las texturas de la malla.
+     * @param streamer Streamer de texturas.
+     * @param screenPixels Píxeles de pantalla que ocupa una repetición de las texturas.
+     */
+    void requestTextureDetail(TextureStreamer& streamer, float screenPixels) const;
+
+    /**
+     * @brief Completa una clave de variante con los mapas que la malla realmente tiene cargados.
+     * @param base Clave con las características de la escena (luces, niebla...).
+     * @return ShaderVariantKey Variante más ajustada para esta malla.
+     */
+    ShaderVariantKey materialKey(ShaderVariantKey base) const;
+
+    /**
+     * @brief Centro de la esfera envolvente, en espacio de la malla.
+     */
+    const glm::vec3& getBoundsCenter() const { return boundsCenter; }
+
+    /**
+     * @brief Radio de la esfera envolvente.
+     */
+    float getBoundsRadius() const { return boundsRadius; }
+
+    /**
+     * @brief Conserva la geometría en CPU para consultas de rayo (ver @ref SpatialIndex).
+     * @param geometry Geometría con la que se creó la malla.
+     */
+    void setCollision(std::shared_ptr<const MeshCollision> geometry) { collision = std::move(geometry); }
+
+    /**
+     * @brief Geometría en CPU de la malla (vacía si no se conservó); compartida para que sobreviva a la malla.
+     */
+    const std::shared_ptr<const MeshCollision>& getCollision() const { return collision; }
+
 private:
-    GLuint VAO, VBO, EBO;   /**< Identificadores de buffers OpenGL */
+    GLuint VAO;                 /**< Vertex array */
+    GpuHeap::Handle geometry;   /**< Rango en el heap (kInvalidHandle con buffer propio) */
+    GLuint buffer;              /**< Buffer propio cuando no hay heap activo */
+    GLsizeiptr vertexBytes;     /**< Bytes de vértices (offset de los índices dentro del rango) */
+    GLsizeiptr indexBytes;      /**< Bytes de índices */
+    mutable GpuHeap::Range bound; /**< Rango al que apunta el VAO */
     GLsizei indexCount;     /**< Cantidad de índices de la malla */
+    glm::vec3 boundsCenter; /**< Centro de la esfera envolvente (centro de la caja) */
+    float boundsRadius;     /**< Radio de la esfera envolvente */
     std::vector<Texture> textures; /**< Texturas asociadas a la malla */
+    std::shared_ptr<const MeshCollision> collision; /**< Geometría en CPU y su BVH de triángulos (opcional) */
+
+    /**
+     * @brief Sube vértices e índices a un rango del heap y configura el VAO.
+     * @param vertices Puntero a los vértices.
+     * @param vertexCount Número de vértices.
+     * @param indices Puntero a los índices.
+     * @param indexCount Número de índices.
+     */
+    void setupMesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount);
 
     /**
-     * @brief Inicializa los buffers (VAO, VBO, EBO) y configura las entradas de vértice.
-     * @param vertices Lista de vértices.
-     * @param indices Lista de índices.
+     * @brief Devuelve el VAO y la geometría (al heap o al gestor de recursos).
      */
-    void setupMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+    void release();
 };
 
 #endif // MESH_H
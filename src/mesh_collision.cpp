@@ -0,0 +1,148 @@
+// MeshCollision.cpp
+
+#include "mesh_collision.h"
+
+namespace {
+
+// Möller-Trumbore; returns the ray parameter of the hit or a negative value on a miss
+inline float intersectTriangle(const glm::vec3& origin, const glm::vec3& direction,
+                               const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    const glm::vec3 edge1 = b - a;
+    const glm::vec3 edge2 = c - a;
+    const glm::vec3 p = glm::cross(direction, edge2);
+    const float determinant = glm::dot(edge1, p);
+    if (determinant > -1e-12f && determinant < 1e-12f)
+        return -1.0f;
+    const float inverse = 1.0f / determinant;
+    const glm::vec3 s = origin - a;
+    const float u = glm::dot(s, p) * inverse;
+    if (u < 0.0f || u > 1.0f)
+        return -1.0f;
+    const glm::vec3 q = glm::cross(s, edge1);
+    const float v = glm::dot(direction, q) * inverse;
+    if (v < 0.0f || u + v > 1.0f)
+        return -1.0f;
+    return glm::dot(edge2, q) * inverse;
+}
+
+} // namespace
+
+MeshCollision::MeshCollision(MeshSource&& geometry)
+    : source(std::move(geometry))
+{
+    // Vectors and pack views both survive the move, so the pointers are taken afterwards
+    if (source.view.vertices)
+    {
+        vertices = source.view.vertices;
+        indices = source.view.indices;
+        indexCount = source.view.indexCount;
+    }
+    else
+    {
+        vertices = source.vertices.data();
+        indices = source.indices.data();
+        indexCount = source.indices.size();
+    }
+}
+
+void MeshCollision::ensureBuilt() const
+{
+    if (built.load(std::memory_order_acquire))
+        return;
+    std::lock_guard<std::mutex> lock(buildMutex);
+    if (built.load(std::memory_order_relaxed))
+        return;
+
+    const size_t count = indexCount / 3;
+    std::vector<glm::vec3> mins(count), maxs(count);
+    for (size_t t = 0; t < count; ++t)
+    {
+        const glm::vec3& a = vertices[indices[3 * t]].Position;
+        const glm::vec3& b = vertices[indices[3 * t + 1]].Position;
+        const glm::vec3& c = vertices[indices[3 * t + 2]].Position;
+        mins[t] = glm::min(a, glm::min(b, c));
+        maxs[t] = glm::max(a, glm::max(b, c));
+    }
+    Bvh::build(mins.data(), maxs.data(), count, 4, nodes, triangles);
+
+    // Corners in leaf order: a leaf reads its triangles from one contiguous run
+    corners.resize(3 * count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const size_t t = triangles[i];
+        corners[3 * i] = vertices[indices[3 * t]].Position;
+        corners[3 * i + 1] = vertices[indices[3 * t + 1]].Position;
+        corners[3 * i + 2] = vertices[indices[3 * t + 2]].Position;
+    }
+    built.store(true, std::memory_order_release);
+}
+
+bool MeshCollision::isBuilt() const
+{
+    return built.load(std::memory_order_acquire);
+}
+
+size_t MeshCollision::treeBytes() const
+{
+    if (!isBuilt())
+        return 0;
+    return nodes.size() * sizeof(BvhNode) + corners.size() * sizeof(glm::vec3) + triangles.size() * sizeof(uint32_t);
+}
+
+bool MeshCollision::raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance, uint32_t& triangle) const
+{
+    ensureBuilt();
+    if (nodes.empty())
+        return false;
+
+    const glm::vec3 inverseDirection = 1.0f / direction;
+    bool hit = false;
+    uint32_t stack[Bvh::kMaxDepth];
+    float entries[Bvh::kMaxDepth];
+    uint32_t size = 0;
+    if (!Bvh::intersectRay(nodes[0], origin, inverseDirection, distance, entries[0]))
+        return false;
+    stack[size++] = 0;
+    while (size > 0)
+    {
+        // Nodes pushed before a closer hit was found may no longer be worth visiting
+        --size;
+        if (entries[size] > distance)
+            continue;
+        const BvhNode& node = nodes[stack[size]];
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i)
+            {
+                const float t = intersectTriangle(origin, direction, corners[3 * i], corners[3 * i + 1], corners[3 * i + 2]);
+                if (t >= 0.0f && t < distance)
+                {
+                    distance = t;
+                    triangle = triangles[i];
+                    hit = true;
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first so its hits prune the farther one
+        float leftEntry, rightEntry;
+        const bool left = Bvh::intersectRay(nodes[node.first], origin, inverseDirection, distance, leftEntry);
+        const bool right = Bvh::intersectRay(nodes[node.first + 1], origin, inverseDirection, distance, rightEntry);
+        if (left && right)
+        {
+            const bool leftFirst = leftEntry <= rightEntry;
+            stack[size] = leftFirst ? node.first + 1 : node.first;
+            entries[size++] = leftFirst ? rightEntry : leftEntry;
+            stack[size] = leftFirst ? node.first : node.first + 1;
+            entries[size++] = leftFirst ? leftEntry : rightEntry;
+        }
+        else if (left || right)
+        {
+            stack[size] = left ? node.first : node.first + 1;
+            entries[size++] = left ? leftEntry : rightEntry;
+        }
+    }
+    return hit;
+}
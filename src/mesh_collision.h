@@ -0,0 +1,79 @@
+#ifndef MESH_COLLISION_H
+#define MESH_COLLISION_H
+
+#include "bvh.h"
+#include "mesh_source.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @class MeshCollision
+ * @brief Copia en CPU de la geometría de una malla y su BVH de triángulos, construido al primer uso.
+ *
+ * @ref MeshSource::upload la deja en la @ref Mesh que crea en lugar de liberar la geometría:
+ * las mallas cocinadas siguen apuntando al pack mapeado sin copia y las generadas conservan
+ * sus vectores. El BVH se construye la primera vez que se consulta, desde cualquier hilo;
+ * las consultas simultáneas sobre una malla aún sin BVH esperan a esa única construcción.
+ */
+class MeshCollision {
+public:
+    /**
+     * @brief Toma la geometría leída de una malla.
+     * @param source Geometría (del pack o generada).
+     */
+    explicit MeshCollision(MeshSource&& source);
+
+    MeshCollision(const MeshCollision&) = delete;
+    MeshCollision& operator=(const MeshCollision&) = delete;
+
+    /**
+     * @brief Triángulo más cercano que corta un rayo en espacio de la malla. Seguro entre hilos.
+     *
+     * La dirección no necesita estar normalizada: la distancia se mide en su parámetro, así
+     * que un rayo del mundo llevado a la malla con la inversa de su matriz conserva la escala.
+     *
+     * @param origin Origen del rayo.
+     * @param direction Dirección del rayo.
+     * @param distance Parámetro máximo a la entrada; el del corte a la salida si lo hay.
+     * @param triangle Índice del triángulo cortado (salida).
+     * @return true si hay corte antes de @p distance.
+     */
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance, uint32_t& triangle) const;
+
+    /**
+     * @brief Triángulos de la malla.
+     */
+    size_t triangleCount() const { return indexCount / 3; }
+
+    /**
+     * @brief Indica si el BVH ya se construyó.
+     */
+    bool isBuilt() const;
+
+    /**
+     * @brief Bytes del BVH construido (nodos y vértices de los triángulos), 0 si aún no lo está.
+     */
+    size_t treeBytes() const;
+
+private:
+    MeshSource source;                  /**< Dueña de los datos (blob del pack o vectores) */
+    const Vertex* vertices;             /**< Vértices de la malla */
+    const unsigned int* indices;        /**< Índices de la malla */
+    size_t indexCount;                  /**< Número de índices */
+
+    mutable std::mutex buildMutex;      /**< Serializa la construcción del BVH */
+    mutable std::atomic<bool> built{false}; /**< El BVH está completo y es de solo lectura */
+    mutable std::vector<BvhNode> nodes; /**< BVH de triángulos */
+    mutable std::vector<glm::vec3> corners;   /**< Tres vértices por triángulo, en el orden de hojas */
+    mutable std::vector<uint32_t> triangles;  /**< Triángulo original de cada posición del orden de hojas */
+
+    /**
+     * @brief Construye el BVH si aún no existe; solo el primer hilo que llega lo construye.
+     */
+    void ensureBuilt() const;
+};
+
+#endif // MESH_COLLISION_H
@@ -0,0 +1,44 @@
+// MeshSource.cpp
+
+#include "mesh_source.h"
+#include "geometry.h"
+#include "mesh_collision.h"
+#include <iostream>
+
+// Points at a cooked mesh in the mounted asset pack, or generates it procedurally.
+bool MeshSource::read(const std::string& name)
+{
+    if (const AssetPack* pack = AssetPack::mounted())
+    {
+        if (pack->find(name, blob) && AssetPack::parseMesh(blob, view))
+            return true;
+        view = MeshView();
+    }
+
+    if (!Geometry::generateBuiltinMesh(name, vertices, indices))
+    {
+        std::cerr << "Unknown builtin mesh: " << name << std::endl;
+        return false;
+    }
+    return true;
+}
+
+size_t MeshSource::geometryBytes() const
+{
+    if (view.vertices)
+        return view.vertexCount * sizeof(Vertex) + view.indexCount * sizeof(unsigned int);
+    return vertices.size() * sizeof(Vertex) + indices.size() * sizeof(unsigned int);
+}
+
+// Uploads the geometry, straight from the pack when it was cooked, and hands it to the mesh for picking.
+std::unique_ptr<Mesh> MeshSource::upload(std::vector<Texture>&& textures)
+{
+    std::unique_ptr<Mesh> mesh;
+    if (view.vertices)
+        mesh = std::make_unique<Mesh>(view.vertices, view.vertexCount, view.indices, view.indexCount, std::move(textures));
+    else
+        mesh = std::make_unique<Mesh>(vertices, indices, std::move(textures));
+    mesh->setCollision(std::make_shared<MeshCollision>(std::move(*this)));
+    *this = MeshSource();
+    return mesh;
+}
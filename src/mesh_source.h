@@ -0,0 +1,43 @@
+#ifndef MESH_SOURCE_H
+#define MESH_SOURCE_H
+
+#include "Mesh.h"
+#include "Texture.h"
+#include "asset_pack.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @struct MeshSource
+ * @brief Geometría leída en un trabajador y pendiente de subirse a OpenGL.
+ *
+ * @ref read va en un trabajador (no usa OpenGL); @ref upload en el hilo de OpenGL.
+ */
+struct MeshSource {
+    AssetBlob blob;                     /**< Blob del pack (mantiene vivos los datos de @ref view) */
+    MeshView view;                      /**< Malla cocinada en el pack, si la hay */
+    std::vector<Vertex> vertices;       /**< Vértices generados si la malla no está en el pack */
+    std::vector<unsigned int> indices;  /**< Índices generados si la malla no está en el pack */
+
+    /**
+     * @brief Lee una malla del asset pack montado o, si no está cocinada, la genera.
+     * @param name Nombre de la malla (ver @ref Geometry::generateBuiltinMesh).
+     * @return true si la malla existe.
+     */
+    bool read(const std::string& name);
+
+    /**
+     * @brief Bytes de vértices e índices que ocupará la malla en la GPU.
+     */
+    size_t geometryBytes() const;
+
+    /**
+     * @brief Sube la geometría leída, directamente desde el pack si estaba cocinada, y la pasa a la malla como @ref MeshCollision.
+     * @param textures Texturas asociadas a la malla (ya cargadas).
+     * @return std::unique_ptr<Mesh> Malla subida a OpenGL.
+     */
+    std::unique_ptr<Mesh> upload(std::vector<Texture>&& textures);
+};
+
+#endif // MESH_SOURCE_H
@@ -0,0 +1,408 @@
+// MipBuilder.cpp
+
+#include "mip_builder.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIP_BUILDER_SSE2 1
+#endif
+
+namespace {
+
+constexpr int kMinRowsPerBand = 32; // Below this a band is not worth a thread
+
+// Runs fn(begin, end) over [0, rows) split into contiguous row bands, one per thread.
+// With an active job system the bands are its parallelFor chunks instead of fresh threads.
+template <typename Fn>
+void forEachRowBand(int rows, Fn&& fn)
+{
+    if (JobSystem* jobs = JobSystem::active())
+    {
+        jobs->parallelFor(0, static_cast<size_t>(rows), kMinRowsPerBand, [&fn](size_t begin, size_t end) {
+            fn(static_cast<int>(begin), static_cast<int>(end));
+        });
+        return;
+    }
+
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    unsigned bands = std::min<unsigned>(hw, static_cast<unsigned>(std::max(1, rows / kMinRowsPerBand)));
+    if (bands <= 1)
+    {
+        fn(0, rows);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(bands - 1);
+    int bandRows = (rows + static_cast<int>(bands) - 1) / static_cast<int>(bands);
+    for (unsigned b = 1; b < bands; ++b)
+    {
+        int begin = static_cast<int>(b) * bandRows;
+        int end = std::min(rows, begin + bandRows);
+        if (begin < end)
+            workers.emplace_back([&fn, begin, end]() { fn(begin, end); });
+    }
+    fn(0, std::min(rows, bandRows));
+    for (auto& worker : workers)
+        worker.join();
+}
+
+// sRGB decode curve at every 8-bit code, and at the midpoints between consecutive codes.
+// Computed offline in 60-digit decimal and rounded to the nearest float, so neither table
+// depends on the platform's pow.
+constexpr float kSrgbToLinear[256] = {
+    0.0f, 0.000303526991f, 0.000607053982f, 0.000910580973f, 0.00121410796f, 0.00151763496f,
+    0.00182116195f, 0.00212468882f, 0.00242821593f, 0.0027317428f, 0.00303526991f, 0.00334653584f,
+    0.00367650739f, 0.00402471703f, 0.00439144205f, 0.00477695325f, 0.00518151652f, 0.00560539169f,
+    0.00604883302f, 0.00651209056f, 0.00699541019f, 0.00749903219f, 0.00802319311f, 0.00856812578f,
+    0.00913405884f, 0.00972121768f, 0.010329823f, 0.0109600937f, 0.0116122449f, 0.012286488f,
+    0.0129830325f, 0.0137020834f, 0.0144438436f, 0.0152085144f, 0.0159962941f, 0.0168073755f,
+    0.0176419541f, 0.01850022f, 0.0193823613f, 0.0202885624f, 0.0212190095f, 0.0221738853f,
+    0.0231533665f, 0.0241576321f, 0.0251868591f, 0.0262412224f, 0.0273208916f, 0.02842604f,
+    0.0295568351f, 0.0307134446f, 0.0318960324f, 0.0331047662f, 0.0343398079f, 0.0356013142f,
+    0.0368894488f, 0.0382043719f, 0.0395462364f, 0.0409151986f, 0.0423114114f, 0.043735031f,
+    0.045186203f, 0.0466650873f, 0.0481718257f, 0.0497065671f, 0.0512694567f, 0.0528606474f,
+    0.054480277f, 0.0561284907f, 0.0578054301f, 0.0595112368f, 0.0612460524f, 0.0630100146f,
+    0.064803265f, 0.0666259378f, 0.0684781671f, 0.0703600943f, 0.0722718537f, 0.0742135718f,
+    0.0761853829f, 0.078187421f, 0.0802198201f, 0.0822827071f, 0.0843762085f, 0.0865004584f,
+    0.0886555836f, 0.0908417106f, 0.0930589661f, 0.0953074694f, 0.097587347f, 0.0998987257f,
+    0.102241732f, 0.104616486f, 0.107023105f, 0.10946171f, 0.111932427f, 0.114435375f,
+    0.116970666f, 0.119538426f, 0.122138776f, 0.124771819f, 0.127437681f, 0.130136475f,
+    0.13286832f, 0.135633335f, 0.138431609f, 0.141263291f, 0.144128472f, 0.147027269f,
+    0.149959788f, 0.152926147f, 0.155926466f, 0.158960834f, 0.162029371f, 0.165132195f,
+    0.168269396f, 0.171441108f, 0.174647406f, 0.177888423f, 0.18116425f, 0.18447499f,
+    0.187820777f, 0.191201687f, 0.194617838f, 0.198069319f, 0.20155625f, 0.205078736f,
+    0.208636865f, 0.212230757f, 0.215860501f, 0.219526201f, 0.223227963f, 0.226965874f,
+    0.230740055f, 0.23455058f, 0.238397568f, 0.242281124f, 0.246201321f, 0.25015828f,
+    0.254152089f, 0.258182853f, 0.262250662f, 0.266355604f, 0.270497799f, 0.274677306f,
+    0.278894275f, 0.283148736f, 0.287440836f, 0.291770637f, 0.296138257f, 0.300543785f,
+    0.304987311f, 0.309468925f, 0.313988715f, 0.318546772f, 0.323143214f, 0.327778101f,
+    0.332451522f, 0.337163627f, 0.341914415f, 0.346704066f, 0.351532608f, 0.356400132f,
+    0.361306787f, 0.366252601f, 0.371237695f, 0.376262128f, 0.38132602f, 0.386429429f,
+    0.391572475f, 0.396755219f, 0.401977777f, 0.407240212f, 0.412542611f, 0.417885065f,
+    0.423267663f, 0.428690493f, 0.434153646f, 0.439657182f, 0.445201188f, 0.450785786f,
+    0.456411034f, 0.462076992f, 0.467783809f, 0.473531485f, 0.479320168f, 0.48514995f,
+    0.491020858f, 0.496932983f, 0.502886474f, 0.50888133f, 0.514917672f, 0.520995557f,
+    0.527115107f, 0.533276379f, 0.539479494f, 0.545724452f, 0.55201143f, 0.558340371f,
+    0.564711511f, 0.571124852f, 0.577580452f, 0.584078431f, 0.590618849f, 0.597201765f,
+    0.603827357f, 0.610495567f, 0.617206573f, 0.623960376f, 0.630757153f, 0.637596846f,
+    0.644479692f, 0.651405632f, 0.658374846f, 0.665387273f, 0.672443151f, 0.679542482f,
+    0.686685324f, 0.693871737f, 0.701101899f, 0.708375752f, 0.715693474f, 0.723055124f,
+    0.730460763f, 0.73791039f, 0.745404184f, 0.752942204f, 0.760524511f, 0.768151164f,
+    0.775822222f, 0.783537805f, 0.791297913f, 0.799102724f, 0.806952238f, 0.814846575f,
+    0.822785735f, 0.830769897f, 0.838799f, 0.846873224f, 0.854992628f, 0.863157213f,
+    0.871367097f, 0.8796224f, 0.887923121f, 0.896269381f, 0.904661179f, 0.913098633f,
+    0.921581864f, 0.930110872f, 0.938685715f, 0.947306514f, 0.955973327f, 0.964686275f,
+    0.973445296f, 0.982250571f, 0.991102099f, 1.0f,
+};
+
+constexpr float kSrgbMidpoints[255] = {
+    0.000151763496f, 0.000455290487f, 0.000758817478f, 0.00106234441f, 0.0013658714f, 0.00166939839f,
+    0.00197292538f, 0.00227645249f, 0.00257997937f, 0.00288350624f, 0.00318830088f, 0.00350925932f,
+    0.00384831498f, 0.00420574797f, 0.00458183279f, 0.00497683743f, 0.00539102405f, 0.00582465064f,
+    0.00627796957f, 0.00675122766f, 0.00724466844f, 0.00775853032f, 0.00829304848f, 0.00884845294f,
+    0.00942497049f, 0.0100228256f, 0.010642237f, 0.011283421f, 0.0119465925f, 0.0126319602f,
+    0.0133397318f, 0.0140701123f, 0.0148233026f, 0.0155995032f, 0.0163989104f, 0.0172217153f,
+    0.0180681143f, 0.0189382937f, 0.0198324434f, 0.0207507443f, 0.0216933824f, 0.0226605386f,
+    0.0236523896f, 0.0246691145f, 0.0257108882f, 0.0267778821f, 0.0278702695f, 0.0289882198f,
+    0.0301319025f, 0.0313014798f, 0.0324971229f, 0.0337189883f, 0.0349672437f, 0.0362420455f,
+    0.0375435539f, 0.0388719253f, 0.04022732f, 0.041609887f, 0.0430197865f, 0.0444571637f,
+    0.0459221713f, 0.0474149622f, 0.0489356853f, 0.0504844859f, 0.0520615056f, 0.0536668971f,
+    0.055300802f, 0.0569633618f, 0.0586547181f, 0.0603750125f, 0.0621243827f, 0.0639029741f,
+    0.0657109171f, 0.0675483495f, 0.0694154128f, 0.0713122338f, 0.0732389539f, 0.0751957074f,
+    0.0771826133f, 0.0791998208f, 0.0812474415f, 0.0833256245f, 0.085434489f, 0.0875741541f,
+    0.089744769f, 0.091946438f, 0.0941793025f, 0.0964434743f, 0.098739095f, 0.101066269f,
+    0.10342513f, 0.105815805f, 0.108238399f, 0.110693045f, 0.113179862f, 0.115698971f,
+    0.118250482f, 0.120834522f, 0.123451203f, 0.126100644f, 0.128782958f, 0.131498262f,
+    0.134246677f, 0.137028307f, 0.13984327f, 0.142691687f, 0.145573661f, 0.148489311f,
+    0.151438728f, 0.15442206f, 0.157439381f, 0.160490826f, 0.163576499f, 0.166696489f,
+    0.169850931f, 0.173039913f, 0.176263571f, 0.179521978f, 0.182815254f, 0.186143503f,
+    0.189506829f, 0.192905352f, 0.196339145f, 0.199808344f, 0.203313038f, 0.206853345f,
+    0.210429341f, 0.214041144f, 0.217688844f, 0.22137256f, 0.225092396f, 0.228848428f,
+    0.232640758f, 0.236469507f, 0.240334779f, 0.244236633f, 0.248175204f, 0.252150565f,
+    0.256162852f, 0.260212123f, 0.264298469f, 0.268422037f, 0.272582889f, 0.276781112f,
+    0.281016797f, 0.285290092f, 0.289601028f, 0.293949723f, 0.298336297f, 0.30276081f,
+    0.30722335f, 0.311724037f, 0.31626296f, 0.32084018f, 0.325455844f, 0.330109984f,
+    0.334802747f, 0.339534163f, 0.344304383f, 0.349113464f, 0.353961498f, 0.358848572f,
+    0.363774776f, 0.368740231f, 0.373744965f, 0.378789127f, 0.383872777f, 0.388996005f,
+    0.3941589f, 0.399361521f, 0.404604018f, 0.40988642f, 0.415208817f, 0.420571357f,
+    0.425974041f, 0.431417018f, 0.436900347f, 0.442424119f, 0.447988421f, 0.453593314f,
+    0.459238917f, 0.464925289f, 0.470652521f, 0.476420701f, 0.482229918f, 0.488080233f,
+    0.493971765f, 0.499904543f, 0.505878687f, 0.511894286f, 0.517951429f, 0.524050117f,
+    0.530190527f, 0.536372721f, 0.542596757f, 0.548862696f, 0.555170655f, 0.561520696f,
+    0.567912877f, 0.574347317f, 0.580824137f, 0.587343335f, 0.593904972f, 0.600509226f,
+    0.607156098f, 0.613845706f, 0.62057811f, 0.62735337f, 0.634171605f, 0.641032875f,
+    0.647937238f, 0.654884815f, 0.661875665f, 0.668909788f, 0.675987363f, 0.683108449f,
+    0.690273106f, 0.697481334f, 0.704733372f, 0.712029159f, 0.719368815f, 0.72675246f,
+    0.734180033f, 0.741651773f, 0.749167681f, 0.756727815f, 0.764332294f, 0.77198112f,
+    0.779674411f, 0.787412286f, 0.795194745f, 0.803021908f, 0.810893834f, 0.818810523f,
+    0.826772213f, 0.834778786f, 0.842830479f, 0.850927293f, 0.859069228f, 0.867256522f,
+    0.875489056f, 0.883767068f, 0.892090559f, 0.900459588f, 0.908874214f, 0.917334557f,
+    0.925840616f, 0.934392571f, 0.942990363f, 0.951634169f, 0.960324049f, 0.969060004f,
+    0.977842152f, 0.986670554f, 0.995545268f,
+};
+
+// Number of leading channels that carry sRGB color (the rest is linear alpha).
+int colorChannels(int channels)
+{
+    return (channels == 2 || channels == 4) ? channels - 1 : channels;
+}
+
+// Vertical 2:1 average of two source rows into tmp, then horizontal 2:1 average into dst.
+// An odd-sized level has no partner for its last row or column: r2 (the row after r1, or
+// null) and the column after the last pair are folded in with 1/4, 1/2, 1/4 weights, so no
+// texel is dropped. SIMD and scalar paths perform the same IEEE operations in the same
+// order, so the output is bit-identical whichever path runs.
+void downsampleRow(const float* r0, const float* r1, const float* r2, int srcW, float* dst, int dstW, int channels,
+                   float* tmp)
+{
+    const int n = srcW * channels;
+    int i = 0;
+#ifdef MIP_BUILDER_SSE2
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    if (r2)
+    {
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m128 middle = _mm_loadu_ps(r1 + i);
+            const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(r0 + i), _mm_add_ps(middle, middle)), _mm_loadu_ps(r2 + i));
+            _mm_storeu_ps(tmp + i, _mm_mul_ps(sum, quarter));
+        }
+    }
+    else
+    {
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(tmp + i, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(r0 + i), _mm_loadu_ps(r1 + i)), half));
+    }
+#endif
+    if (r2)
+    {
+        for (; i < n; ++i)
+            tmp[i] = (r0[i] + (r1[i] + r1[i]) + r2[i]) * 0.25f;
+    }
+    else
+    {
+        for (; i < n; ++i)
+            tmp[i] = (r0[i] + r1[i]) * 0.5f;
+    }
+
+    if (srcW == 1)
+    {
+        std::memcpy(dst, tmp, sizeof(float) * channels);
+        return;
+    }
+
+    // Columns averaged in pairs; with an odd width the last one takes three
+    const int pairs = (srcW & 1) ? dstW - 1 : dstW;
+    int x = 0;
+#ifdef MIP_BUILDER_SSE2
+    if (channels == 4)
+    {
+        for (; x < pairs; ++x)
+        {
+            __m128 a = _mm_loadu_ps(tmp + x * 8);
+            __m128 b = _mm_loadu_ps(tmp + x * 8 + 4);
+            _mm_storeu_ps(dst + x * 4, _mm_mul_ps(_mm_add_ps(a, b), half));
+        }
+    }
+    else if (channels == 2)
+    {
+        // [x0 y0 x1 y1][x2 y2 x3 y3] -> [x0 y0 x2 y2] + [x1 y1 x3 y3]
+        for (; x + 2 <= pairs; x += 2)
+        {
+            __m128 a = _mm_loadu_ps(tmp + x * 4);
+            __m128 b = _mm_loadu_ps(tmp + x * 4 + 4);
+            __m128 even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 1, 0));
+            __m128 odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 2, 3, 2));
+            _mm_storeu_ps(dst + x * 2, _mm_mul_ps(_mm_add_ps(even, odd), half));
+        }
+    }
+    else if (channels == 1)
+    {
+        for (; x + 4 <= pairs; x += 4)
+        {
+            __m128 a = _mm_loadu_ps(tmp + x * 2);
+            __m128 b = _mm_loadu_ps(tmp + x * 2 + 4);
+            __m128 even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(dst + x, _mm_mul_ps(_mm_add_ps(even, odd), half));
+        }
+    }
+#endif
+    for (; x < pairs; ++x)
+    {
+        for (int c = 0; c < channels; ++c)
+            dst[x * channels + c] = (tmp[(2 * x) * channels + c] + tmp[(2 * x + 1) * channels + c]) * 0.5f;
+    }
+    if (pairs < dstW)
+    {
+        const float* edge = tmp + (2 * pairs) * channels;
+        for (int c = 0; c < channels; ++c)
+            dst[pairs * channels + c] = (edge[c] + (edge[channels + c] + edge[channels + c]) + edge[2 * channels + c]) * 0.25f;
+    }
+}
+
+// Re-projects averaged normals (encoded in [0,1]) back onto the unit sphere.
+void renormalizeRow(float* row, int width, int channels)
+{
+    if (channels < 3)
+        return;
+    for (int x = 0; x < width; ++x)
+    {
+        float* p = row + x * channels;
+        float nx = p[0] * 2.0f - 1.0f;
+        float ny = p[1] * 2.0f - 1.0f;
+        float nz = p[2] * 2.0f - 1.0f;
+        float len = std::sqrt(nx * nx + ny * ny + nz * nz);
+        if (len > 0.0f)
+        {
+            nx /= len;
+            ny /= len;
+            nz /= len;
+        }
+        p[0] = nx * 0.5f + 0.5f;
+        p[1] = ny * 0.5f + 0.5f;
+        p[2] = nz * 0.5f + 0.5f;
+    }
+}
+
+std::vector<float> decodeBase(const void* pixels, int width, int height, int channels, bool isFloat, MipFilterMode mode)
+{
+    const size_t count = static_cast<size_t>(width) * height * channels;
+    std::vector<float> out(count);
+    if (isFloat)
+    {
+        std::memcpy(out.data(), pixels, count * sizeof(float));
+        return out;
+    }
+
+    const unsigned char* src = static_cast<const unsigned char*>(pixels);
+    const int srgbChannels = mode == MipFilterMode::SRGB ? colorChannels(channels) : 0;
+    for (size_t i = 0; i < count; i += channels)
+    {
+        for (int c = 0; c < channels; ++c)
+            out[i + c] = c < srgbChannels ? kSrgbToLinear[src[i + c]] : src[i + c] / 255.0f;
+    }
+    return out;
+}
+
+void encodeLevel(const std::vector<float>& texels, int channels, bool isFloat, MipFilterMode mode,
+                 std::vector<unsigned char>& out)
+{
+    if (isFloat)
+    {
+        out.resize(texels.size() * sizeof(float));
+        std::memcpy(out.data(), texels.data(), out.size());
+        return;
+    }
+
+    out.resize(texels.size());
+    const int srgbChannels = mode == MipFilterMode::SRGB ? colorChannels(channels) : 0;
+    for (size_t i = 0; i < texels.size(); i += channels)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            float v = std::min(std::max(texels[i + c], 0.0f), 1.0f);
+            out[i + c] = c < srgbChannels ? MipBuilder::linearToSrgb8(v)
+                                          : static_cast<unsigned char>(v * 255.0f + 0.5f);
+        }
+    }
+}
+
+} // namespace
+
+float MipBuilder::srgbToLinear(float c)
+{
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+unsigned char MipBuilder::linearToSrgb8(float linear)
+{
+    // A binary search over the linear-space midpoints between consecutive codes rounds to
+    // the nearest code in encoded space without calling pow per texel
+    return static_cast<unsigned char>(std::upper_bound(std::begin(kSrgbMidpoints), std::end(kSrgbMidpoints), linear)
+                                      - std::begin(kSrgbMidpoints));
+}
+
+MipChain MipBuilder::build(const void* pixels, int width, int height, int channels,
+                           bool isFloat, MipFilterMode mode)
+{
+    MipChain chain;
+    chain.channels = channels;
+    chain.isFloat = isFloat;
+    if (!pixels || width <= 0 || height <= 0 || channels <= 0)
+        return chain;
+
+    int levelCount = 1;
+    for (int size = std::max(width, height); size > 1; size >>= 1)
+        ++levelCount;
+    chain.levels.resize(levelCount);
+
+    // Level 0 is the source image untouched
+    const size_t texelSize = isFloat ? sizeof(float) : 1;
+    chain.levels[0].width = width;
+    chain.levels[0].height = height;
+    chain.levels[0].bytes.assign(static_cast<const unsigned char*>(pixels),
+                                 static_cast<const unsigned char*>(pixels) + static_cast<size_t>(width) * height * channels * texelSize);
+
+    auto current = std::make_shared<const std::vector<float>>(decodeBase(pixels, width, height, channels, isFloat, mode));
+    // Builds usually run inside a decode job: wait on a counter (which helps) rather than block on futures
+    JobSystem* jobs = JobSystem::active();
+    JobCounter encodeJobs;
+    std::vector<std::future<void>> encoders;
+    int srcW = width, srcH = height;
+
+    for (int level = 1; level < levelCount; ++level)
+    {
+        const int dstW = std::max(1, srcW / 2);
+        const int dstH = std::max(1, srcH / 2);
+        auto next = std::make_shared<std::vector<float>>(static_cast<size_t>(dstW) * dstH * channels);
+
+        forEachRowBand(dstH, [&](int yBegin, int yEnd) {
+            std::vector<float> tmp(static_cast<size_t>(srcW) * channels);
+            for (int y = yBegin; y < yEnd; ++y)
+            {
+                const float* r0 = current->data() + static_cast<size_t>(std::min(2 * y, srcH - 1)) * srcW * channels;
+                const float* r1 = current->data() + static_cast<size_t>(std::min(2 * y + 1, srcH - 1)) * srcW * channels;
+                // The last row of an odd height (above one) also takes the row left over
+                const bool oddEdge = (srcH & 1) && srcH > 1 && y == dstH - 1;
+                const float* r2 = oddEdge ? r1 + static_cast<size_t>(srcW) * channels : nullptr;
+                float* dst = next->data() + static_cast<size_t>(y) * dstW * channels;
+                downsampleRow(r0, r1, r2, srcW, dst, dstW, channels, tmp.data());
+                if (mode == MipFilterMode::NormalMap)
+                    renormalizeRow(dst, dstW, channels);
+            }
+        });
+
+        // Encode this level in the background while the next iteration reads it as its source
+        MipChain::Level& out = chain.levels[level];
+        out.width = dstW;
+        out.height = dstH;
+        auto encode = [next, channels, isFloat, mode, &out]() {
+            encodeLevel(*next, channels, isFloat, mode, out.bytes);
+        };
+        if (jobs)
+            jobs->schedule(encode, &encodeJobs);
+        else
+            encoders.push_back(std::async(std::launch::async, encode));
+
+        current = next;
+        srcW = dstW;
+        srcH = dstH;
+    }
+
+    if (jobs)
+        jobs->wait(encodeJobs);
+    for (auto& encoder : encoders)
+        encoder.get();
+    return chain;
+}
@@ -0,0 +1,85 @@
+#ifndef MIP_BUILDER_H
+#define MIP_BUILDER_H
+
+#include <vector>
+
+/**
+ * @enum MipFilterMode
+ * @brief Espacio de color en el que se filtra la cadena de mipmaps.
+ */
+enum class MipFilterMode {
+    Linear,     /**< Datos lineales (roughness, máscaras): se promedian tal cual */
+    SRGB,       /**< Color sRGB: se promedia en espacio lineal y se re-codifica (alfa lineal) */
+    NormalMap   /**< Normales codificadas en [0,1]: se promedian y se renormalizan por nivel */
+};
+
+/**
+ * @struct MipChain
+ * @brief Cadena completa de mipmaps generada en CPU, lista para subir a OpenGL o guardar en disco.
+ *
+ * Cada nivel conserva el mismo formato de cliente que la imagen de entrada
+ * (mismo número de canales y mismo tipo: @c unsigned @c char o @c float).
+ */
+struct MipChain {
+    /**
+     * @struct Level
+     * @brief Un nivel de la cadena con sus texels empaquetados sin padding.
+     */
+    struct Level {
+        int width;                        /**< Ancho del nivel */
+        int height;                       /**< Alto del nivel */
+        std::vector<unsigned char> bytes; /**< Texels (reinterpretar como float si @ref isFloat) */
+    };
+
+    int channels = 0;          /**< Canales por texel */
+    bool isFloat = false;      /**< true si los texels son float de 32 bits */
+    std::vector<Level> levels; /**< Niveles, del 0 (base) al 1x1 */
+};
+
+/**
+ * @class MipBuilder
+ * @brief Genera cadenas de mipmaps en CPU con filtro box 2x2 vectorizado (SSE2).
+ *
+ * En los niveles de tamaño impar la última fila y la última columna promedian tres texels
+ * (pesos 1/4, 1/2, 1/4) en lugar de dos, así que ningún texel de la fuente se pierde.
+ *
+ * A diferencia de @c glGenerateMipmap, el resultado no depende del driver: todas las
+ * operaciones se hacen en float con un orden fijo y la conversión sRGB usa tablas
+ * constantes, así que los mips son idénticos entre máquinas. Cada nivel se reparte en bandas de filas entre hilos y la codificación de
+ * salida de cada nivel (sRGB, cuantización) corre en paralelo con el siguiente nivel.
+ */
+class MipBuilder {
+public:
+    /**
+     * @brief Construye la cadena completa de mipmaps de una imagen.
+     *
+     * El nivel 0 es una copia exacta de la entrada.
+     *
+     * @param pixels Texels de entrada, empaquetados sin padding.
+     * @param width Ancho de la imagen.
+     * @param height Alto de la imagen.
+     * @param channels Canales por texel (1 a 4).
+     * @param isFloat true si @p pixels son float, false si son bytes.
+     * @param mode Espacio de filtrado (ver @ref MipFilterMode).
+     * @return MipChain Cadena de niveles hasta 1x1.
+     */
+    static MipChain build(const void* pixels, int width, int height, int channels,
+                          bool isFloat, MipFilterMode mode);
+
+    /**
+     * @brief Convierte un valor sRGB codificado en [0,1] a lineal.
+     *
+     * Usa @c std::pow, cuyo redondeo depende de la plataforma; @ref build no la llama y
+     * decodifica los bytes con una tabla constante.
+     */
+    static float srgbToLinear(float c);
+
+    /**
+     * @brief Convierte un valor lineal a un byte sRGB, redondeando al más cercano en espacio sRGB.
+     *
+     * Busca en una tabla constante de puntos medios entre códigos: no depende de @c std::pow.
+     */
+    static unsigned char linearToSrgb8(float linear);
+};
+
+#endif // MIP_BUILDER_H
@@ -3,6 +3,8 @@
 #include "Plane.h"
 #include <glad/glad.h>
 #include "stb_image.h"
+#include "Constants.h"
+#include <cmath>
 #include <iostream>
 
 // Constructor
@@ -15,41 +17,51 @@ Plane::Plane()
 Plane::~Plane() = default;
 
 // Setup method
-void Plane::Setup()
+void Plane::Setup(EntityRegistry &registry)
 {
-    // Load textures
-    textures.clear(); // Ensure no residual textures
+    TaskGraph graph;
+    addSetupTasks(graph, registry);
+    graph.run();
+}
 
-    // Load Diffuse Texture with Absolute Path
-    Texture diffuseTexture("C:/Users/yumar/OneDrive/Desktop/COMP 4046/OpenGL/main7/assets/textures/plane/coast_sand_rocks_02_diff_2k.jpg", "texture_diffuse");
-    if (!diffuseTexture.load())
-    {
-        std::cerr << "Failed to load plane diffuse texture." << std::endl;
-    }
-    textures.push_back(std::move(diffuseTexture));
+// Adds texture decode/upload and mesh tasks to the scene graph
+TaskGraph::TaskId Plane::addSetupTasks(TaskGraph &graph, EntityRegistry &registry, Entity parent)
+{
+    // Textures keep their addresses until the mesh takes them
+    textures.clear(); // Ensure no residual textures
+    textures.emplace_back("assets/textures/plane/coast_sand_rocks_02_diff_2k.jpg", "texture_diffuse");
+    textures.emplace_back("assets/textures/plane/coast_sand_rocks_02_nor_gl_2k.exr", "texture_normal");
+    textures.emplace_back("assets/textures/plane/coast_sand_rocks_02_rough_2k.exr", "texture_roughness");
 
-    // Load Normal Map with Absolute Path
-    Texture normalTexture("C:/Users/yumar/OneDrive/Desktop/COMP 4046/OpenGL/main7/assets/textures/plane/coast_sand_rocks_02_nor_gl_2k.exr", "texture_normal");
-    if (!normalTexture.load())
-    {
-        std::cerr << "Failed to load plane normal texture." << std::endl;
-    }
-    textures.push_back(std::move(normalTexture));
+    // Generate vertices and indices
+    TaskGraph::TaskId generate = graph.add("generate plane", [this]() {
+        pendingGeometry.vertices = generatePlaneVertices();
+        pendingGeometry.indices = generatePlaneIndices();
+    });
 
-    // Load Roughness Map with Absolute Path
-    Texture roughnessTexture("C:/Users/yumar/OneDrive/Desktop/COMP 4046/OpenGL/main7/assets/textures/plane/coast_sand_rocks_02_rough_2k.exr", "texture_roughness");
-    if (!roughnessTexture.load())
+    std::vector<TaskGraph::TaskId> uploads;
+    for (Texture &texture : textures)
     {
-        std::cerr << "Failed to load plane roughness texture." << std::endl;
+        TaskGraph::TaskId decode = graph.add("decode " + texture.getPath(), [&texture]() { texture.prepare(); });
+        uploads.push_back(graph.add("upload " + texture.getPath(), [&texture]() {
+            if (!texture.load())
+            {
+                std::cerr << "Failed to load plane texture: " << texture.getPath() << std::endl;
+            }
+        }, TaskAffinity::GLThread, {decode}));
     }
-    textures.push_back(std::move(roughnessTexture));
 
-    // Generate vertices and indices
-    std::vector<Vertex> planeVertices = generatePlaneVertices();
-    std::vector<unsigned int> planeIndices = generatePlaneIndices();
-
-    // Initialize the Mesh with vertices, indices, and textures
-    planeMesh = std::make_unique<Mesh>(planeVertices, planeIndices, std::move(textures));
+    // Initialize the Mesh with vertices, indices, and textures once they are all uploaded;
+    // both sides of the ground are visible
+    TaskGraph::TaskId create = graph.add("create plane", [this, &registry, parent]() {
+        planeMesh = pendingGeometry.upload(std::move(textures));
+        entity = registry.createRenderable(*planeMesh, glm::vec3(0.0f), true);
+        if (parent.valid())
+            registry.transforms.setParent(entity, parent);
+    }, TaskAffinity::GLThread, {generate});
+    for (TaskGraph::TaskId upload : uploads)
+        graph.addDependency(create, upload);
+    return create;
 }
 
 // Generates vertices for a large ground plane
@@ -57,26 +69,27 @@ std::vector<Vertex> Plane::generatePlaneVertices() const
 {
     std::vector<Vertex> vertices(4);
 
-    // Define four corners of the plane
-    vertices[0].Position = glm::vec3(-50.0f, 0.0f, -50.0f);
+    // Define four corners of the plane, centered on its node; the textures repeat every 2 units
+    const float half = size * 0.5f;
+    vertices[0].Position = glm::vec3(-half, 0.0f, -half);
     vertices[0].Normal = glm::vec3(0.0f, 1.0f, 0.0f);
     vertices[0].Color = glm::vec3(0.3f, 0.5f, 0.3f); // Greenish
     vertices[0].TexCoords = glm::vec2(0.0f, 0.0f);
 
-    vertices[1].Position = glm::vec3(50.0f, 0.0f, -50.0f);
+    vertices[1].Position = glm::vec3(half, 0.0f, -half);
     vertices[1].Normal = glm::vec3(0.0f, 1.0f, 0.0f);
     vertices[1].Color = glm::vec3(0.3f, 0.5f, 0.3f); // Greenish
-    vertices[1].TexCoords = glm::vec2(50.0f, 0.0f);
+    vertices[1].TexCoords = glm::vec2(half, 0.0f);
 
-    vertices[2].Position = glm::vec3(50.0f, 0.0f, 50.0f);
+    vertices[2].Position = glm::vec3(half, 0.0f, half);
     vertices[2].Normal = glm::vec3(0.0f, 1.0f, 0.0f);
     vertices[2].Color = glm::vec3(0.3f, 0.5f, 0.3f); // Greenish
-    vertices[2].TexCoords = glm::vec2(50.0f, 50.0f);
+    vertices[2].TexCoords = glm::vec2(half, half);
 
-    vertices[3].Position = glm::vec3(-50.0f, 0.0f, 50.0f);
+    vertices[3].Position = glm::vec3(-half, 0.0f, half);
     vertices[3].Normal = glm::vec3(0.0f, 1.0f, 0.0f);
     vertices[3].Color = glm::vec3(0.3f, 0.5f, 0.3f); // Greenish
-    vertices[3].TexCoords = glm::vec2(0.0f, 50.0f);
+    vertices[3].TexCoords = glm::vec2(0.0f, half);
 
     return vertices;
 }
@@ -90,6 +103,18 @@ std::vector<unsigned int> Plane::generatePlaneIndices() const
     };
 }
 
+// Requests texture mips for the ground from the size of one texture repeat right below the camera
+void Plane::requestTextureDetail(TextureStreamer &streamer, const Camera &camera) const
+{
+    if (!planeMesh)
+        return;
+
+    // The plane repeats its textures every 2 world units whatever its size
+    float distance = std::abs(camera.Position.y);
+    float pixels = TextureStreamer::projectedPixels(2.0f, distance, camera.Zoom, (float)WINDOW_HEIGHT);
+    planeMesh->requestTextureDetail(streamer, pixels);
+}
+
 // Renders the ground plane
 void Plane::draw(const Shader &shader) const
 {
@@ -4,6 +4,13 @@
 #include "Shader.h"
 #include "Mesh.h"
 #include "Texture.h"
+#include "Camera.h"
+#include "texture_streamer.h"
+#include "virtual_texture.h"
+#include "shader_variants.h"
+#include "task_graph.h"
+#include "entity_registry.h"
+#include "mesh_source.h"
 #include <memory>
 #include <vector>
 
@@ -28,8 +35,33 @@ public:
 
     /**
      * @brief Configura el plano cargando texturas y generando la geometría.
+     * @param registry Registro donde crear la entidad del plano.
      */
-    void Setup();
+    void Setup(EntityRegistry &registry);
+
+    /**
+     * @brief Añade al grafo las tareas de carga del plano: decodificación de texturas y
+     *        geometría en trabajadores, subidas en el hilo de OpenGL.
+     *
+     * Al crear la malla añade el plano al registro como entidad de dos caras.
+     *
+     * @param graph Grafo de carga de la escena.
+     * @param registry Registro de la escena; debe vivir hasta el fin de la carga.
+     * @param parent Nodo del que cuelga el plano (opcional; sin él queda en el origen).
+     * @return TaskGraph::TaskId Tarea que crea la malla (la última del plano).
+     */
+    TaskGraph::TaskId addSetupTasks(TaskGraph &graph, EntityRegistry &registry, Entity parent = Entity());
+
+    /**
+     * @brief Fija el lado del plano (centrado en su nodo). Antes de @ref addSetupTasks.
+     * @param side Lado en unidades del mundo; la textura se repite cada 2 unidades.
+     */
+    void setSize(float side) { size = side; }
+
+    /**
+     * @brief Lado del plano.
+     */
+    float getSize() const { return size; }
 
     /**
      * @brief Renderiza el plano.
@@ -38,9 +70,25 @@ public:
      */
     void draw(const Shader &shader) const;
 
+    /**
+     * @brief Solicita el detalle de textura necesario según la altura de la cámara.
+     *
+     * @param streamer Streamer de texturas.
+     * @param camera Cámara activa.
+     */
+    void requestTextureDetail(TextureStreamer &streamer, const Camera &camera) const;
+
+    /**
+     * @brief Entidad del plano en el registro (inválida hasta que se crea la malla).
+     */
+    Entity getEntity() const { return entity; }
+
 private:
     std::unique_ptr<Mesh> planeMesh; /**< Malla que representa el plano. */
     std::vector<Texture> textures;  /**< Texturas aplicadas al plano. */
+    MeshSource pendingGeometry;     /**< Vértices e índices generados, pendientes de subir. */
+    Entity entity;                  /**< Entidad del plano. */
+    float size = 100.0f;            /**< Lado del plano. */
 
     /**
      * @brief Genera vértices para el plano.
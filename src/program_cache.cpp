@@ -0,0 +1,170 @@
+// ProgramCache.cpp
+
+#include "program_cache.h"
+#include "asset_pack.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+std::string ProgramCache::directory = "shader_cache";
+int ProgramCache::hits = 0;
+int ProgramCache::misses = 0;
+
+namespace {
+
+/**
+ * @brief Cabecera de cada archivo de la caché.
+ */
+struct ProgramBinaryHeader {
+    char magic[4];     /**< "LHPB" */
+    uint32_t version;  /**< Versión del formato del archivo */
+    uint32_t format;   /**< Formato devuelto por glGetProgramBinary */
+    uint32_t length;   /**< Bytes del binario que siguen a la cabecera */
+    uint64_t key;      /**< Clave del programa (protege contra archivos renombrados) */
+};
+
+constexpr uint32_t kCacheVersion = 1;
+
+const char* glString(GLenum name)
+{
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+} // namespace
+
+bool ProgramCache::isSupported()
+{
+    static int formats = -1;
+    if (formats < 0)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+        formats = count;
+    }
+    return formats > 0;
+}
+
+uint64_t ProgramCache::key(const std::string& vertexSource, const std::string& fragmentSource, const std::string& defines)
+{
+    // Binaries are only valid for the exact driver that produced them
+    static const std::string driver = std::string(glString(GL_VENDOR)) + '\n' + glString(GL_RENDERER) + '\n' + glString(GL_VERSION);
+
+    std::string identity;
+    identity.reserve(driver.size() + defines.size() + vertexSource.size() + fragmentSource.size() + 3);
+    identity += driver;
+    identity += '\0';
+    identity += defines;
+    identity += '\0';
+    identity += vertexSource;
+    identity += '\0';
+    identity += fragmentSource;
+    return AssetPack::hashName(identity);
+}
+
+std::string ProgramCache::pathFor(uint64_t key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return directory + "/" + name;
+}
+
+void ProgramCache::prepare(GLuint program)
+{
+    if (isSupported())
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool ProgramCache::load(uint64_t key, GLuint program)
+{
+    if (!isSupported())
+        return false;
+
+    const std::string path = pathFor(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    ProgramBinaryHeader header;
+    std::vector<char> binary;
+    bool valid = static_cast<bool>(file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+                 && std::memcmp(header.magic, "LHPB", 4) == 0 && header.version == kCacheVersion && header.key == key;
+    if (valid)
+    {
+        binary.resize(header.length);
+        valid = static_cast<bool>(file.read(binary.data(), static_cast<std::streamsize>(binary.size())));
+    }
+    file.close();
+
+    GLint linked = GL_FALSE;
+    if (valid)
+    {
+        glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    }
+
+    if (!linked)
+    {
+        // Stale or corrupt (e.g. after a driver update); the caller recompiles and stores a fresh one
+        std::error_code ignored;
+        std::filesystem::remove(path, ignored);
+        return false;
+    }
+
+    ++hits;
+    return true;
+}
+
+void ProgramCache::store(uint64_t key, GLuint program)
+{
+    ++misses;
+    if (!isSupported())
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0)
+        return;
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+    {
+        std::cerr << "Failed to create shader cache directory " << directory << ": " << error.message() << std::endl;
+        return;
+    }
+
+    ProgramBinaryHeader header;
+    std::memcpy(header.magic, "LHPB", 4);
+    header.version = kCacheVersion;
+    header.format = format;
+    header.length = static_cast<uint32_t>(written);
+    header.key = key;
+
+    // Written under a temporary name so a crash never leaves a truncated binary behind
+    const std::string path = pathFor(key);
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), written);
+        if (!file)
+        {
+            std::cerr << "Failed to write shader cache entry " << temporary << std::endl;
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+        std::filesystem::remove(temporary, error);
+}
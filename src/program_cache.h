@@ -0,0 +1,73 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <glad/glad.h>
+
+/**
+ * @class ProgramCache
+ * @brief Caché en disco de binarios de programas enlazados (@c glGetProgramBinary / @c glProgramBinary).
+ *
+ * Cada programa se guarda en @c <directorio>/<clave>.bin, donde la clave es un hash del
+ * código fuente, los defines y la identidad del driver (vendor, renderer y versión de GL):
+ * un cambio de driver o de shader produce otra clave y el binario viejo simplemente no se usa.
+ * Si el driver rechaza un binario, este se borra y el llamador compila desde GLSL.
+ */
+class ProgramCache {
+public:
+    /**
+     * @brief Calcula la clave de caché de un programa. Requiere un contexto OpenGL activo.
+     *
+     * @param vertexSource Código del shader de vértices.
+     * @param fragmentSource Código del shader de fragmentos.
+     * @param defines Defines inyectados (vacío si no hay).
+     * @return uint64_t Clave del programa.
+     */
+    static uint64_t key(const std::string& vertexSource, const std::string& fragmentSource, const std::string& defines);
+
+    /**
+     * @brief Intenta cargar un programa desde la caché.
+     *
+     * @param key Clave del programa (ver @ref key).
+     * @param program Programa recién creado con @c glCreateProgram, sin shaders adjuntos.
+     * @return true si el binario existía y el driver lo aceptó (el programa queda enlazado).
+     */
+    static bool load(uint64_t key, GLuint program);
+
+    /**
+     * @brief Guarda el binario de un programa enlazado.
+     *
+     * El programa debe haberse enlazado con @c GL_PROGRAM_BINARY_RETRIEVABLE_HINT (ver @ref prepare).
+     *
+     * @param key Clave del programa.
+     * @param program Programa enlazado correctamente.
+     */
+    static void store(uint64_t key, GLuint program);
+
+    /**
+     * @brief Marca un programa para que su binario pueda recuperarse tras enlazarlo.
+     * @param program Programa aún sin enlazar.
+     */
+    static void prepare(GLuint program);
+
+    /**
+     * @brief Indica si el driver soporta al menos un formato de binario de programa.
+     */
+    static bool isSupported();
+
+    /**
+     * @brief Cambia el directorio de la caché (por defecto @c shader_cache).
+     */
+    static void setDirectory(const std::string& path) { directory = path; }
+
+    static int hits;    /**< Programas cargados desde la caché */
+    static int misses;  /**< Programas compilados desde GLSL */
+
+private:
+    static std::string directory; /**< Directorio de los binarios */
+
+    static std::string pathFor(uint64_t key);
+};
+
+#endif // PROGRAM_CACHE_H
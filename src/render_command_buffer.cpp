@@ -0,0 +1,127 @@
+// RenderCommandBuffer.cpp
+
+#include "render_command_buffer.h"
+#include "shader_manager.h"
+#include <glad/glad.h>
+
+void RenderCommandBuffer::clear()
+{
+    commands.clear();
+    pipelines.clear();
+    materials.clear();
+    drawData.clear();
+    geometry.clear();
+    boundPipeline = kNone;
+    boundMaterial = kNone;
+}
+
+void RenderCommandBuffer::bindPipeline(const RenderPipeline& pipeline)
+{
+    if (boundPipeline != kNone)
+    {
+        const RenderPipeline& bound = pipelines[boundPipeline];
+        if (bound.key.packed() == pipeline.key.packed() && bound.doubleSided == pipeline.doubleSided)
+            return;
+    }
+    boundPipeline = static_cast<uint32_t>(pipelines.size());
+    pipelines.push_back(pipeline);
+    commands.push_back({RenderCommandType::BindPipeline, boundPipeline});
+
+    // Sampler uniforms belong to the program, so a new program needs its material again
+    boundMaterial = kNone;
+}
+
+void RenderCommandBuffer::bindMaterial(const RenderMaterial& material)
+{
+    if (boundMaterial != kNone)
+    {
+        const RenderMaterial& bound = materials[boundMaterial];
+        if (bound.textures == material.textures && bound.virtualTexture == material.virtualTexture)
+            return;
+    }
+    boundMaterial = static_cast<uint32_t>(materials.size());
+    materials.push_back(material);
+    commands.push_back({RenderCommandType::BindMaterial, boundMaterial});
+}
+
+void RenderCommandBuffer::setDrawData(const glm::mat4& model, const glm::mat3& normal)
+{
+    commands.push_back({RenderCommandType::SetDrawData, static_cast<uint32_t>(drawData.size())});
+    drawData.push_back({model, normal});
+}
+
+void RenderCommandBuffer::draw(const Mesh& mesh)
+{
+    commands.push_back({RenderCommandType::Draw, static_cast<uint32_t>(geometry.size())});
+    geometry.push_back(&mesh);
+}
+
+void RenderCommandBuffer::drawMesh(const Mesh& mesh, const RenderPipeline& pipeline, const glm::mat4& model,
+                                   const glm::mat3& normal, const VirtualTexture* virtualTexture)
+{
+    bindPipeline(pipeline);
+    bindMaterial(RenderMaterial{&mesh, virtualTexture});
+    setDrawData(model, normal);
+    draw(mesh);
+}
+
+void RenderCommandBuffer::execute(ShaderVariants& shaders) const
+{
+    const Shader* shader = nullptr;
+    bool cullDisabled = false;
+
+    for (const RenderCommand& command : commands)
+    {
+        switch (command.type)
+        {
+            case RenderCommandType::BindPipeline:
+            {
+                const RenderPipeline& pipeline = pipelines[command.index];
+                // A variant still compiling in the background skips its draws instead of stalling the frame
+                if (ShaderManager::isCompiling(shaders.get(pipeline.key)))
+                {
+                    shader = nullptr;
+                    break;
+                }
+                shader = &shaders.use(pipeline.key);
+                if (pipeline.doubleSided != cullDisabled)
+                {
+                    if (pipeline.doubleSided)
+                        glDisable(GL_CULL_FACE);
+                    else
+                        glEnable(GL_CULL_FACE);
+                    cullDisabled = pipeline.doubleSided;
+                }
+                break;
+            }
+            case RenderCommandType::BindMaterial:
+            {
+                const RenderMaterial& material = materials[command.index];
+                if (!shader)
+                    break;
+                if (material.textures)
+                    material.textures->BindMaterial(*shader);
+                if (material.virtualTexture)
+                    material.virtualTexture->apply(*shader);
+                break;
+            }
+            case RenderCommandType::SetDrawData:
+                if (shader)
+                {
+                    shader->setMat4("model", drawData[command.index].model);
+                    shader->setMat3("normalMatrix", drawData[command.index].normal);
+                }
+                break;
+            case RenderCommandType::Draw:
+                if (shader)
+                    geometry[command.index]->DrawGeometry();
+                break;
+        }
+    }
+
+    // Leave the default state behind for immediate-mode passes
+    if (cullDisabled)
+        glEnable(GL_CULL_FACE);
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,137 @@
+#ifndef RENDER_COMMAND_BUFFER_H
+#define RENDER_COMMAND_BUFFER_H
+
+#include "Mesh.h"
+#include "shader_variants.h"
+#include "virtual_texture.h"
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @enum RenderCommandType
+ * @brief Operaciones del buffer de comandos, en el orden habitual de un draw.
+ */
+enum class RenderCommandType : uint8_t {
+    BindPipeline,   /**< Variante de shader y estado de rasterizado */
+    BindMaterial,   /**< Texturas de la malla y textura virtual */
+    SetDrawData,    /**< Datos propios del draw (matrices de modelo y de normales) */
+    Draw            /**< Geometría de una malla */
+};
+
+/**
+ * @struct RenderCommand
+ * @brief Comando compacto (8 bytes): tipo e índice en la tabla correspondiente del buffer.
+ */
+struct RenderCommand {
+    RenderCommandType type;   /**< Operación */
+    uint32_t index;           /**< Índice en la tabla de pipelines, materiales, datos o geometría */
+};
+
+/**
+ * @struct RenderPipeline
+ * @brief Estado que fija @ref RenderCommandType::BindPipeline.
+ */
+struct RenderPipeline {
+    ShaderVariantKey key;       /**< Variante del shader de iluminación */
+    bool doubleSided = false;   /**< Desactiva el descarte de caras traseras */
+};
+
+/**
+ * @struct RenderDrawData
+ * @brief Datos que fija @ref RenderCommandType::SetDrawData.
+ */
+struct RenderDrawData {
+    glm::mat4 model;        /**< Matriz de modelo */
+    glm::mat3 normal;       /**< Inversa traspuesta de la parte 3x3 del modelo */
+};
+
+/**
+ * @struct RenderMaterial
+ * @brief Recursos que fija @ref RenderCommandType::BindMaterial.
+ */
+struct RenderMaterial {
+    const Mesh* textures = nullptr;                  /**< Malla cuyas texturas se enlazan (puede ser nula) */
+    const VirtualTexture* virtualTexture = nullptr;  /**< Textura virtual a aplicar (puede ser nula) */
+};
+
+/**
+ * @class RenderCommandBuffer
+ * @brief Lista de draws grabada en cualquier hilo y reproducida después en el hilo de OpenGL.
+ *
+ * Grabar no toca OpenGL: solo apunta comandos de 8 bytes y sus datos en tablas propias
+ * del buffer, así que varios trabajadores pueden grabar a la vez en buffers distintos
+ * (por vista o por rango de objetos). Los cambios de pipeline y material redundantes se
+ * descartan al grabar. @ref execute recorre los comandos en un bucle cerrado con el
+ * contexto actual; las mallas y texturas referenciadas deben seguir vivas hasta entonces.
+ *
+ * @c clear conserva la memoria, de modo que reutilizar el buffer cada frame no reserva.
+ */
+class RenderCommandBuffer {
+public:
+    /**
+     * @brief Vacía el buffer conservando su capacidad.
+     */
+    void clear();
+
+    /**
+     * @brief Graba el cambio a una variante de shader y estado de rasterizado.
+     */
+    void bindPipeline(const RenderPipeline& pipeline);
+
+    /**
+     * @brief Graba el enlace de las texturas de un material.
+     */
+    void bindMaterial(const RenderMaterial& material);
+
+    /**
+     * @brief Graba las matrices de modelo y de normales del siguiente draw.
+     */
+    void setDrawData(const glm::mat4& model, const glm::mat3& normal);
+
+    /**
+     * @brief Graba el draw de la geometría de una malla.
+     */
+    void draw(const Mesh& mesh);
+
+    /**
+     * @brief Graba una malla completa: pipeline, material con sus texturas, matrices y draw.
+     *
+     * @param mesh Malla a dibujar.
+     * @param pipeline Variante y estado de rasterizado.
+     * @param model Matriz de modelo.
+     * @param normal Matriz de normales de @p model (ver @ref TransformComponents::normals).
+     * @param virtualTexture Textura virtual del material (opcional).
+     */
+    void drawMesh(const Mesh& mesh, const RenderPipeline& pipeline, const glm::mat4& model, const glm::mat3& normal,
+                  const VirtualTexture* virtualTexture = nullptr);
+
+    /**
+     * @brief Reproduce los comandos. Solo en el hilo con el contexto OpenGL.
+     * @param shaders Variantes del shader de iluminación (con los uniforms compartidos ya fijados).
+     */
+    void execute(ShaderVariants& shaders) const;
+
+    /**
+     * @brief Número de comandos grabados.
+     */
+    size_t size() const { return commands.size(); }
+
+    /**
+     * @brief Indica si no hay comandos grabados.
+     */
+    bool empty() const { return commands.empty(); }
+
+private:
+    static constexpr uint32_t kNone = 0xFFFFFFFFu; /**< Sin pipeline o material fijado */
+
+    std::vector<RenderCommand> commands;     /**< Comandos en orden */
+    std::vector<RenderPipeline> pipelines;   /**< Tabla de BindPipeline */
+    std::vector<RenderMaterial> materials;   /**< Tabla de BindMaterial */
+    std::vector<RenderDrawData> drawData;    /**< Tabla de SetDrawData */
+    std::vector<const Mesh*> geometry;       /**< Tabla de Draw */
+    uint32_t boundPipeline = kNone;          /**< Último pipeline grabado */
+    uint32_t boundMaterial = kNone;          /**< Último material grabado */
+};
+
+#endif // RENDER_COMMAND_BUFFER_H
@@ -0,0 +1,55 @@
+// SamplerCache.cpp
+
+#include "sampler_cache.h"
+#include <algorithm>
+
+GLuint SamplerCache::samplers[static_cast<int>(SamplerType::Count)] = {};
+
+GLuint SamplerCache::get(SamplerType type)
+{
+    GLuint& sampler = samplers[static_cast<int>(type)];
+    if (sampler != 0)
+        return sampler;
+
+    glGenSamplers(1, &sampler);
+    glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    if (type == SamplerType::RepeatTrilinear)
+    {
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        // Anisotropic filtering is core since GL 4.6; keeps the tiled ground sharp at grazing angles
+        GLfloat maxAnisotropy = 1.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+        glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY, std::min(8.0f, maxAnisotropy));
+    }
+    else
+    {
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+
+    return sampler;
+}
+
+GLuint SamplerCache::forTexture(const std::string& textureType)
+{
+    if (textureType == "texture_cubemap")
+        return get(SamplerType::ClampTrilinear);
+    return get(SamplerType::RepeatTrilinear);
+}
+
+void SamplerCache::release()
+{
+    for (GLuint& sampler : samplers)
+    {
+        if (sampler != 0)
+        {
+            glDeleteSamplers(1, &sampler);
+            sampler = 0;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef SAMPLER_CACHE_H
+#define SAMPLER_CACHE_H
+
+#include <string>
+#include <glad/glad.h>
+
+/**
+ * @enum SamplerType
+ * @brief Configuraciones de muestreo compartidas por todas las texturas.
+ */
+enum class SamplerType {
+    RepeatTrilinear,   /**< Wrap GL_REPEAT con filtrado trilineal y anisotrópico (materiales) */
+    ClampTrilinear,    /**< Wrap GL_CLAMP_TO_EDGE con filtrado trilineal (cubemaps) */
+    Count              /**< Número de configuraciones disponibles */
+};
+
+/**
+ * @class SamplerCache
+ * @brief Mantiene un único sampler object de OpenGL por configuración.
+ *
+ * El estado de wrap y filtrado se define una sola vez al crear cada sampler, en lugar
+ * de repetir @c glTexParameteri por cada textura. Los samplers se crean perezosamente
+ * y requieren un contexto OpenGL activo.
+ */
+class SamplerCache {
+public:
+    /**
+     * @brief Obtiene (creándolo si hace falta) el sampler de una configuración.
+     * @param type Configuración deseada.
+     * @return GLuint ID del sampler object.
+     */
+    static GLuint get(SamplerType type);
+
+    /**
+     * @brief Obtiene el sampler apropiado para un tipo de textura.
+     * @param textureType Tipo de textura (ej: "texture_diffuse", "texture_cubemap").
+     * @return GLuint ID del sampler object.
+     */
+    static GLuint forTexture(const std::string& textureType);
+
+    /**
+     * @brief Elimina todos los samplers creados. Debe llamarse antes de destruir el contexto.
+     */
+    static void release();
+
+private:
+    static GLuint samplers[static_cast<int>(SamplerType::Count)]; /**< IDs por configuración (0 = no creado) */
+};
+
+#endif // SAMPLER_CACHE_H
@@ -1,27 +1,65 @@
 #include "Scene.h"
-#include "stb_image.h"
+#include "sampler_cache.h"
+#include "job_system.h"
+#include "task_graph.h"
+#include "shader_manager.h"
+#include "frame_allocator.h"
+#include "alloc_tracker.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <GLFW/glfw3.h>
 #include <iostream>
 #include <algorithm>
+#include <cstdio>
+#include <filesystem>
 
 Scene::Scene() 
-    : spotlight(glm::vec3(0.0f, 12.0f, 0.0f), glm::vec3(1.0f), glm::vec3(0.0f,-1.0f,0.0f)),
-      skyboxVAO(0), skyboxVBO(0)
+    : worldStreamer(registry), spotlight(glm::vec3(0.0f, 12.0f, 0.0f), glm::vec3(1.0f), glm::vec3(0.0f,-1.0f,0.0f)),
+      skyboxTexture(0), skyboxVAO(0), skyboxVBO(0), shaderVariants(nullptr)
 {
 }
 
 Scene::~Scene()
 {
-    glDeleteVertexArrays(1, &skyboxVAO);
-    glDeleteBuffers(1, &skyboxVBO);
+    // Loading tasks still in flight write into the scene
+    if (loadGraph)
+        loadGraph->finish();
+    GLResourceManager::deleteTexture(skyboxTexture, skyboxDesc);
+    GLResourceManager::deleteVertexArray(skyboxVAO);
+    GLResourceManager::deleteBuffer(skyboxVBO, kSkyboxVertexBytes, GL_STATIC_DRAW);
 }
 
-void Scene::Setup()
+void Scene::Setup(ShaderVariants &shaders, const std::string &scenePath)
 {
-    // Setup skybox
-    std::vector<std::string> faces = {
+    BeginSetup(shaders, scenePath);
+    loadGraph->finish();
+    UpdateLoading();
+}
+
+void Scene::BeginSetup(ShaderVariants &shaders, const std::string &scenePath)
+{
+    loadStart = std::chrono::steady_clock::now();
+    shaderVariants = &shaders;
+
+    // Textures loaded from here on start with their low mips and refine in the background
+    textureStreamer.activate();
+
+    // Directional Light (like the sun); a compiled scene may replace it
+    dirLight.direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+    dirLight.ambient = glm::vec3(0.1f,0.1f,0.1f);
+    dirLight.diffuse = glm::vec3(0.5f,0.5f,0.5f);
+    dirLight.specular = glm::vec3(1.0f,1.0f,1.0f);
+
+    // A one-texel-per-face sky and the cube geometry are ready before the first frame
+    skyboxTexture = createPlaceholderCubemap(skyboxDesc);
+    createSkybox();
+
+    // Loading runs as a task graph: reads and decodes on the workers, GL work pinned to the
+    // GL thread, each step starting as soon as its inputs are ready
+    loadGraph = std::make_unique<TaskGraph>();
+    TaskGraph &graph = *loadGraph;
+
+    // Setup skybox: the six faces decode in parallel, then upload together
+    skyboxFaces = {
         "assets/textures/skybox/right.jpg",
         "assets/textures/skybox/left.jpg",
         "assets/textures/skybox/top.jpg",
@@ -29,114 +67,310 @@ void Scene::Setup()
         "assets/textures/skybox/front.jpg",
         "assets/textures/skybox/back.jpg"
     };
-    skyboxTexture = loadCubemap(faces);
-    createSkybox();
+    skyboxImages.assign(skyboxFaces.size(), TextureImage());
+    std::vector<TaskGraph::TaskId> faceDecodes;
+    for (size_t i = 0; i < skyboxFaces.size(); ++i)
+    {
+        faceDecodes.push_back(graph.add("decode " + skyboxFaces[i], [this, i]() {
+            // Cooked faces come straight from the asset pack; loose files are decoded and mipmapped on the CPU
+            if (!Texture::readImage(skyboxFaces[i], "texture_cubemap", skyboxImages[i]))
+                skyboxImages[i].levels.clear();
+        }));
+    }
+    TaskGraph::TaskId skyboxUpload = graph.add("upload skybox", [this]() {
+        // The placeholder may still be in flight for the previous frame: it is retired after its fence
+        GLTextureDesc desc;
+        if (const unsigned int loaded = loadCubemap(skyboxFaces, skyboxImages, desc))
+        {
+            GLResourceManager::deleteTexture(skyboxTexture, skyboxDesc);
+            skyboxTexture = loaded;
+            skyboxDesc = desc;
+        }
+        skyboxImages.clear();
+    }, TaskAffinity::GLThread);
+    for (TaskGraph::TaskId decode : faceDecodes)
+        graph.addDependency(skyboxUpload, decode);
 
-    // Initialize lighthouse
-    lighthouse = std::make_unique<Lighthouse>();
-    lighthouse->Setup();
+    // Scene content: lights, lighthouse, ground and instances from the compiled scene when
+    // there is one, the built-in lighthouse scene otherwise
+    if (!scenePath.empty())
+    {
+        sceneFile = std::make_unique<SceneFile>(scenePath);
+        if (!sceneFile->isOpen())
+        {
+            std::cout << "No compiled scene at " << scenePath << ", loading the built-in scene." << std::endl;
+            sceneFile.reset();
+        }
+    }
+    const std::vector<TaskGraph::TaskId> contentReady = sceneFile ? addSceneFileContent(graph) : addBuiltinContent(graph);
 
-    // Initialize ground plane
-    groundPlane.Setup();
+    // A streamed world keeps its cells next to the scene; they load around the camera from the first frame
+    if (sceneFile)
+    {
+        const std::string worldPath = std::filesystem::path(scenePath).replace_extension(".world").string();
+        if (worldStreamer.open(worldPath))
+            std::cout << "Streaming world cells from " << worldPath << std::endl;
+    }
 
-    // Setup lights
-    // Directional Light (like the sun)
-    dirLight.direction = glm::vec3(-0.2f, -1.0f, -0.3f);
-    dirLight.ambient = glm::vec3(0.1f,0.1f,0.1f);
-    dirLight.diffuse = glm::vec3(0.5f,0.5f,0.5f);
-    dirLight.specular = glm::vec3(1.0f,1.0f,1.0f);
+    // Variants depend on the loaded materials; submitting them as soon as those exist overlaps
+    // driver compilation with the rest of the loading
+    TaskGraph::TaskId submit = graph.add("submit shaders", [this]() { PrepareShaders(*shaderVariants); },
+                                         TaskAffinity::GLThread);
+    for (TaskGraph::TaskId ready : contentReady)
+        graph.addDependency(submit, ready);
+
+    loadGraph->start();
+}
 
+std::vector<TaskGraph::TaskId> Scene::addBuiltinContent(TaskGraph &graph)
+{
     // Point Lights
-    pointLights.push_back(PointLightData{
-        glm::vec3(10.0f,5.0f,10.0f),
-        glm::vec3(0.05f),
-        glm::vec3(0.8f,0.8f,0.7f),
-        glm::vec3(1.0f),
-        1.0f,0.09f,0.032f
-    });
+    registry.createPointLight(glm::vec3(10.0f,5.0f,10.0f), glm::vec3(0.05f), glm::vec3(0.8f,0.8f,0.7f), glm::vec3(1.0f),
+                              1.0f,0.09f,0.032f);
+    registry.createPointLight(glm::vec3(-10.0f,10.0f,-10.0f), glm::vec3(0.05f), glm::vec3(0.7f,0.3f,0.3f), glm::vec3(1.0f),
+                              1.0f,0.09f,0.032f);
+    registry.createPointLight(glm::vec3(0.0f,20.0f,0.0f), glm::vec3(0.05f), glm::vec3(0.3f,0.7f,0.9f), glm::vec3(1.0f),
+                              1.0f,0.09f,0.032f);
 
-    pointLights.push_back(PointLightData{
-        glm::vec3(-10.0f,10.0f,-10.0f),
-        glm::vec3(0.05f),
-        glm::vec3(0.7f,0.3f,0.3f),
-        glm::vec3(1.0f),
-        1.0f,0.09f,0.032f
-    });
+    // Initialize lighthouse
+    lighthouse = std::make_unique<Lighthouse>();
+    TaskGraph::TaskId lighthouseReady = lighthouse->AddSetupTasks(graph, registry);
 
-    pointLights.push_back(PointLightData{
-        glm::vec3(0.0f,20.0f,0.0f),
-        glm::vec3(0.05f),
-        glm::vec3(0.3f,0.7f,0.9f),
-        glm::vec3(1.0f),
-        1.0f,0.09f,0.032f
-    });
+    // Initialize ground plane
+    TaskGraph::TaskId planeReady = groundPlane.addSetupTasks(graph, registry);
+    return {lighthouseReady, addTerrainTask(graph, planeReady, glm::vec2(0.0f))};
 }
 
-bool Scene::isSphereInFrustum(const glm::vec3 &center, float radius, const glm::mat4 &vpMatrix) const
+std::vector<TaskGraph::TaskId> Scene::addSceneFileContent(TaskGraph &graph)
 {
-    glm::vec4 planes[6];
-    // Extract frustum planes
-    planes[0] = vpMatrix[0] + vpMatrix[3]; // Left
-    planes[1] = vpMatrix[3] - vpMatrix[0]; // Right
-    planes[2] = vpMatrix[1] + vpMatrix[3]; // Bottom
-    planes[3] = vpMatrix[3] - vpMatrix[1]; // Top
-    planes[4] = vpMatrix[2] + vpMatrix[3]; // Near
-    planes[5] = vpMatrix[3] - vpMatrix[2]; // Far
-
-    // Normalize
-    for(auto &plane : planes)
+    const SceneFile &file = *sceneFile;
+    std::vector<TaskGraph::TaskId> ready;
+    size_t invalidReferences = 0;
+
+    if (file.directionalLightCount() > 0)
     {
-        float length = glm::length(glm::vec3(plane));
-        plane /= length;
+        const SceneDirectionalLight &sun = file.directionalLights()[0];
+        dirLight.direction = sceneVec3(sun.direction);
+        dirLight.ambient = sceneVec3(sun.ambient);
+        dirLight.diffuse = sceneVec3(sun.diffuse);
+        dirLight.specular = sceneVec3(sun.specular);
     }
 
-    // Test sphere against planes
-    for(const auto& plane : planes)
+    // Nodes become entities in one pass straight over the mapped array; parents come first,
+    // so every parent entity exists by the time its children reference it
+    const SceneNode *nodes = file.nodes();
+    const size_t nodeCount = file.nodeCount();
+    registry.reserve(nodeCount, file.instanceCount());
+    sceneNodes.resize(nodeCount);
+    for (size_t i = 0; i < nodeCount; ++i)
     {
-        float distance = glm::dot(glm::vec3(plane), center) + plane.w;
-        if(distance < -radius)
-            return false;
+        const SceneNode &node = nodes[i];
+        Entity parent;
+        if (node.parent < i)
+            parent = sceneNodes[node.parent];
+        else if (node.parent != SceneNode::kNoParent)
+            ++invalidReferences;
+        sceneNodes[i] = registry.createNode(sceneVec3(node.position), parent, sceneQuat(node.rotation), sceneVec3(node.scale));
     }
-    return true;
+
+    const ScenePointLight *lights = file.pointLights();
+    for (size_t i = 0; i < file.pointLightCount(); ++i)
+    {
+        const ScenePointLight &light = lights[i];
+        if (light.node >= nodeCount)
+        {
+            ++invalidReferences;
+            continue;
+        }
+        registry.lights.add(sceneNodes[light.node], sceneVec3(light.ambient), sceneVec3(light.diffuse), sceneVec3(light.specular),
+                            light.constant, light.linear, light.quadratic);
+    }
+
+    // Meshes are read and uploaded once per asset; the lighthouse and the ground hang from the node of their instance
+    const SceneAsset *assets = file.assets();
+    const SceneInstance *instances = file.instances();
+    sceneMeshSources.resize(file.assetCount());
+    sceneMeshTextures.resize(file.assetCount());
+    sceneMeshes.resize(file.assetCount());
+    for (uint32_t a = 0; a < file.assetCount(); ++a)
+    {
+        const SceneAsset &asset = assets[a];
+        if (asset.instanceCount == 0)
+            continue;
+        if (asset.kind == SceneAssetKind::Mesh)
+        {
+            ready.push_back(addSceneMeshTasks(graph, a));
+            continue;
+        }
+
+        const uint32_t nodeIndex = instances[asset.firstInstance].node;
+        if (nodeIndex >= nodeCount)
+        {
+            ++invalidReferences;
+            continue;
+        }
+        if (asset.instanceCount > 1)
+            std::cerr << "Scene asset " << file.assetName(asset) << " is placed once; extra instances are ignored" << std::endl;
+
+        if (asset.kind == SceneAssetKind::Lighthouse && !lighthouse)
+        {
+            lighthouse = std::make_unique<Lighthouse>();
+            ready.push_back(lighthouse->AddSetupTasks(graph, registry, sceneNodes[nodeIndex]));
+        }
+        else if (asset.kind == SceneAssetKind::Ground && !groundPlane.getEntity().valid() && asset.param > 0.0f)
+        {
+            // The terrain texture maps world XZ, so it follows the translations of the ground's ancestors
+            glm::vec3 center(0.0f);
+            for (uint32_t n = nodeIndex; ; n = nodes[n].parent)
+            {
+                center += sceneVec3(nodes[n].position);
+                if (nodes[n].parent >= n)
+                    break;
+            }
+            groundPlane.setSize(asset.param);
+            TaskGraph::TaskId planeReady = groundPlane.addSetupTasks(graph, registry, sceneNodes[nodeIndex]);
+            ready.push_back(addTerrainTask(graph, planeReady, glm::vec2(center.x, center.z)));
+        }
+        else
+        {
+            std::cerr << "Unsupported scene asset: " << file.assetName(asset) << std::endl;
+        }
+    }
+
+    if (invalidReferences > 0)
+        std::cerr << "Scene file has " << invalidReferences << " references to missing nodes" << std::endl;
+    std::cout << "Scene file: " << nodeCount << " nodes, " << file.instanceCount() << " instances, "
+              << file.pointLightCount() << " point lights, " << file.assetCount() << " assets" << std::endl;
+    return ready;
 }
 
-unsigned int Scene::loadCubemap(const std::vector<std::string>& faces)
+TaskGraph::TaskId Scene::addSceneMeshTasks(TaskGraph &graph, uint32_t assetIndex)
 {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    const SceneAsset &sceneAsset = sceneFile->assets()[assetIndex];
+    const std::string name = sceneFile->assetName(sceneAsset);
+    const std::string texture = sceneFile->assetTexture(sceneAsset);
+    TaskGraph::TaskId read = graph.add("read " + name, [this, assetIndex, name, texture]() {
+        sceneMeshSources[assetIndex].read(name);
+        if (!texture.empty())
+        {
+            sceneMeshTextures[assetIndex].emplace_back(texture, "texture_diffuse");
+            sceneMeshTextures[assetIndex].back().prepare();
+        }
+    });
+
+    // Without a texture (like the beacon) instances shade with the vertex color
+    return graph.add("create " + name, [this, assetIndex]() {
+        std::vector<Texture> &textures = sceneMeshTextures[assetIndex];
+        for (Texture &texture : textures)
+        {
+            if (!texture.load())
+                std::cerr << "Failed to load texture: " << texture.getPath() << std::endl;
+        }
+        sceneMeshes[assetIndex] = sceneMeshSources[assetIndex].upload(std::move(textures));
+        const Mesh &mesh = *sceneMeshes[assetIndex];
 
-    int width,height,nrChannels;
-    stbi_set_flip_vertically_on_load(false);
+        // Every instance of the asset is one contiguous run of the mapped instance array
+        const SceneAsset &asset = sceneFile->assets()[assetIndex];
+        const SceneInstance *instances = sceneFile->instances() + asset.firstInstance;
+        for (uint32_t i = 0; i < asset.instanceCount; ++i)
+        {
+            if (instances[i].node < sceneNodes.size())
+                registry.makeRenderable(sceneNodes[instances[i].node], mesh, (instances[i].flags & SceneInstance::kDoubleSided) != 0);
+        }
+    }, TaskAffinity::GLThread, {read});
+}
+
+TaskGraph::TaskId Scene::addTerrainTask(TaskGraph &graph, TaskGraph::TaskId planeReady, const glm::vec2 &center)
+{
+    // Unique terrain texturing from page tiles when they have been built (see vt_tile_builder);
+    // the texture covers the ground plane
+    return graph.add("open terrain texture", [this, center]() {
+        const float size = groundPlane.getSize();
+        if (terrainTexture.open("assets/terrain/terrain.vt", center - glm::vec2(size * 0.5f), glm::vec2(size)))
+            registry.materials.add(groundPlane.getEntity(), &terrainTexture, true);
+    }, TaskAffinity::GLThread, {planeReady});
+}
+
+bool Scene::UpdateLoading()
+{
+    if (!loadGraph)
+        return true;
+
+    loadProgress.completedTasks = loadGraph->completedCount();
+    loadProgress.totalTasks = loadGraph->size();
+    if (!loadGraph->isFinished())
+        return false;
+
+    const TaskGraphStats &stats = loadGraph->finish();
+    loadProgress.loaded = true;
+    loadProgress.loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    loadProgress.criticalPathMs = stats.criticalPathMs;
+    loadGraph.reset();
+
+    // Everything the compiled scene described is in the registry now
+    sceneFile.reset();
+    sceneNodes = std::vector<Entity>();
+    sceneMeshSources = std::vector<MeshSource>();
+    sceneMeshTextures = std::vector<std::vector<Texture>>();
+
+    std::cout << "Scene setup: " << stats.wallMs << " ms for " << stats.tasks << " tasks (critical path "
+              << stats.criticalPathMs << " ms, " << stats.totalTaskMs << " ms of work)" << std::endl;
+    return true;
+}
+
+unsigned int Scene::loadCubemap(const std::vector<std::string>& faces, const std::vector<TextureImage>& images,
+                                GLTextureDesc& desc)
+{
+    unsigned int textureID = 0;
     for (unsigned int i = 0; i < faces.size(); i++)
     {
-        unsigned char *data = stbi_load(faces[i].c_str(), &width,&height,&nrChannels,0);
-        if(data)
+        const TextureImage& image = images[i];
+        if(!image.levels.empty())
         {
-            GLenum format = GL_RGB;
-            if (nrChannels == 1) format = GL_RED;
-            else if(nrChannels==3) format=GL_RGB;
-            else if(nrChannels==4) format=GL_RGBA;
-
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X+i,0,format,width,height,0,format,GL_UNSIGNED_BYTE,data);
-            stbi_image_free(data);
+            // Immutable sRGB storage for every face and mip, allocated (or recycled) with the first face
+            if(textureID == 0)
+            {
+                desc.target = GL_TEXTURE_CUBE_MAP;
+                desc.levels = (GLsizei)image.levels.size();
+                desc.internalFormat = image.internalFormat;
+                desc.width = image.levels[0].width;
+                desc.height = image.levels[0].height;
+                textureID = GLResourceManager::createTexture(desc);
+            }
+            for (GLsizei level=0; level<(GLsizei)image.levels.size(); level++)
+            {
+                const TextureImage::Level& mip = image.levels[level];
+                glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X+i,level,0,0,mip.width,mip.height,image.format,image.dataType,mip.data);
+            }
         }
         else
         {
             std::cerr<<"Cubemap texture failed to load at path: "<<faces[i]<<std::endl;
-            stbi_image_free(data);
         }
     }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_WRAP_R,GL_CLAMP_TO_EDGE);
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
     return textureID;
 }
 
+unsigned int Scene::createPlaceholderCubemap(GLTextureDesc& desc)
+{
+    // Horizon haze on the sides, sky above, sea below (sRGB)
+    const unsigned char side[4] = { 170, 190, 210, 255 };
+    const unsigned char top[4] = { 90, 130, 190, 255 };
+    const unsigned char bottom[4] = { 40, 60, 80, 255 };
+    const unsigned char* faces[6] = { side, side, top, bottom, side, side };
+
+    desc.target = GL_TEXTURE_CUBE_MAP;
+    desc.levels = 1;
+    desc.internalFormat = GL_SRGB8_ALPHA8;
+    desc.width = 1;
+    desc.height = 1;
+    unsigned int textureID = GLResourceManager::createTexture(desc);
+    for (unsigned int i = 0; i < 6; i++)
+        glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X+i,0,0,0,1,1,GL_RGBA,GL_UNSIGNED_BYTE,faces[i]);
+    return textureID;
+}
+
 void Scene::createSkybox()
 {
     float skyboxVertices[] = {
@@ -184,81 +418,172 @@ void Scene::createSkybox()
          1.0f, -1.0f,  1.0f
     };
 
+    static_assert(sizeof(skyboxVertices) == kSkyboxVertexBytes, "skybox cube is 36 positions");
     glGenVertexArrays(1, &skyboxVAO);
-    glGenBuffers(1, &skyboxVBO);
     glBindVertexArray(skyboxVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices),skyboxVertices,GL_STATIC_DRAW);
+    skyboxVBO = GLResourceManager::createBuffer(GL_ARRAY_BUFFER, sizeof(skyboxVertices), skyboxVertices, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,3*sizeof(float),(void*)0);
     glBindVertexArray(0);
 }
 
-void Scene::Render(Shader &shader, const Camera &camera, Shader &skyboxShader)
+ShaderVariantKey Scene::baseShaderKey() const
+{
+    ShaderVariantKey key;
+    key.pointLights = std::min((int)registry.lights.size(), ShaderVariantKey::kMaxPointLights);
+    return key;
+}
+
+void Scene::PrepareShaders(ShaderVariants &shaders) const
 {
+    const ShaderVariantKey baseKey = baseShaderKey();
+    const VirtualTexture *virtualTexture;
+    bool doubleSided;
+    for (uint32_t i = 0; i < registry.meshes.size(); ++i)
+        shaders.get(registry.materialKey(i, baseKey, virtualTexture, doubleSided));
+}
+
+void Scene::Render(ShaderVariants &shaders, const Camera &camera, Shader &skyboxShader, float time)
+{
+    // Integrate finished decodes and stream in the mips requested last frame
+    textureStreamer.update();
+    terrainTexture.update();
+
+    // World cells around the camera; the ones that just arrived may need shader variants
+    if (worldStreamer.update(camera, time) && shaderVariants)
+        PrepareShaders(*shaderVariants);
+
+    // Streaming may allocate as pages arrive; drawing must not (checked in ALLOC_TRACKING builds)
+    RENDER_NO_ALLOC();
+
     // === Render Skybox First ===
-    glDepthFunc(GL_LEQUAL);
-    skyboxShader.use();
-    glm::mat4 skyboxView = glm::mat4(glm::mat3(camera.GetViewMatrix()));
+    // (skipped while its program is still compiling in the background)
     glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)WINDOW_WIDTH/(float)WINDOW_HEIGHT, 0.1f, 1000.0f);
-    skyboxShader.setMat4("view", skyboxView);
-    skyboxShader.setMat4("projection", projection);
-    glBindVertexArray(skyboxVAO);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTexture);
-    skyboxShader.setInt("skybox",0);
-    glDrawArrays(GL_TRIANGLES,0,36);
-    glBindVertexArray(0);
-    glDepthFunc(GL_LESS);
-
-    // === Set Up Lighting and Material Uniforms for main scene shader ===
-    shader.use();
-    shader.setMat4("view", camera.GetViewMatrix());
-    shader.setMat4("projection", projection);
-    shader.setVec3("viewPos", camera.Position);
-
-    // SpotLight parameters (from the lighthouse):
-    shader.setVec3("spotLight.position", spotlight.getPosition());
-    shader.setVec3("spotLight.direction", spotlight.getDirection());
-    shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-    shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
-    shader.setVec3("spotLight.ambient", glm::vec3(0.1f));
-    shader.setVec3("spotLight.diffuse", glm::vec3(0.8f));
-    shader.setVec3("spotLight.specular", glm::vec3(1.0f));
-    shader.setFloat("spotLight.constant",1.0f);
-    shader.setFloat("spotLight.linear",0.09f);
-    shader.setFloat("spotLight.quadratic",0.032f);
+    if (!ShaderManager::isCompiling(skyboxShader))
+    {
+        glDepthFunc(GL_LEQUAL);
+        skyboxShader.use();
+        glm::mat4 skyboxView = glm::mat4(glm::mat3(camera.GetViewMatrix()));
+        skyboxShader.setMat4("view", skyboxView);
+        skyboxShader.setMat4("projection", projection);
+        glBindVertexArray(skyboxVAO);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTexture);
+        glBindSampler(0, SamplerCache::get(SamplerType::ClampTrilinear));
+        skyboxShader.setInt("skybox",0);
+        glDrawArrays(GL_TRIANGLES,0,36);
+        glBindVertexArray(0);
+        glDepthFunc(GL_LESS);
+    }
+
+    // === Set Up Lighting Uniforms shared by every shader variant ===
+    shaders.setMat4("view", camera.GetViewMatrix());
+    shaders.setMat4("projection", projection);
+    shaders.setVec3("viewPos", camera.Position);
+
+    // SpotLight parameters (from the lighthouse); the beacon animates the direction below
+    shaders.setVec3("spotLight.position", spotlight.getPosition());
+    shaders.setVec3("spotLight.direction", spotlight.getDirection());
+    shaders.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+    shaders.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+    shaders.setVec3("spotLight.ambient", glm::vec3(0.1f));
+    shaders.setVec3("spotLight.diffuse", glm::vec3(0.8f));
+    shaders.setVec3("spotLight.specular", glm::vec3(1.0f));
+    shaders.setFloat("spotLight.constant",1.0f);
+    shaders.setFloat("spotLight.linear",0.09f);
+    shaders.setFloat("spotLight.quadratic",0.032f);
 
     // Directional Light parameters
-    shader.setVec3("dirLight.direction", dirLight.direction);
-    shader.setVec3("dirLight.ambient", dirLight.ambient);
-    shader.setVec3("dirLight.diffuse", dirLight.diffuse);
-    shader.setVec3("dirLight.specular", dirLight.specular);
+    shaders.setVec3("dirLight.direction", dirLight.direction);
+    shaders.setVec3("dirLight.ambient", dirLight.ambient);
+    shaders.setVec3("dirLight.diffuse", dirLight.diffuse);
+    shaders.setVec3("dirLight.specular", dirLight.specular);
 
     // Point Lights
-    shader.setInt("numPointLights",(int)pointLights.size());
-    for (int i=0; i<(int)pointLights.size(); i++){
-        std::string base="pointLights["+std::to_string(i)+"]";
-        shader.setVec3((base+".position").c_str(), pointLights[i].position);
-        shader.setVec3((base+".ambient").c_str(), pointLights[i].ambient);
-        shader.setVec3((base+".diffuse").c_str(), pointLights[i].diffuse);
-        shader.setVec3((base+".specular").c_str(), pointLights[i].specular);
-        shader.setFloat((base+".constant").c_str(), pointLights[i].constant);
-        shader.setFloat((base+".linear").c_str(), pointLights[i].linear);
-        shader.setFloat((base+".quadratic").c_str(), pointLights[i].quadratic);
+    // Uniform names are built in the frame arena: no heap allocation per light per frame
+    FrameString name = frameString();
+    auto member = [&name](int light, const char* field) -> const char* {
+        name.assign("pointLights[");
+        char digits[12];
+        std::snprintf(digits, sizeof(digits), "%d", light);
+        name.append(digits).append("].").append(field);
+        return name.c_str();
+    };
+    // Positions come from the light entities' transforms, resolved below after the transform system
+    const LightComponents &lights = registry.lights;
+    const int lightCount = std::min((int)lights.size(), ShaderVariantKey::kMaxPointLights);
+    for (int i=0; i<lightCount; i++){
+        shaders.setVec3(member(i, "ambient"), lights.ambients[i]);
+        shaders.setVec3(member(i, "diffuse"), lights.diffuses[i]);
+        shaders.setVec3(member(i, "specular"), lights.speculars[i]);
+        shaders.setFloat(member(i, "constant"), lights.constants[i]);
+        shaders.setFloat(member(i, "linear"), lights.linears[i]);
+        shaders.setFloat(member(i, "quadratic"), lights.quadratics[i]);
+    }
+
+    // === Entity systems: dirty world transforms, world bounds and frustum culling over the dense pools ===
+    registry.update(Frustum::fromMatrix(projection * camera.GetViewMatrix()));
+    if (lighthouse)
+        lighthouse->UpdateSpotlight(shaders, registry, time);
+    for (int i=0; i<lightCount; i++){
+        const uint32_t t = registry.transforms.indexOf(lights.entity(i));
+        if (t != ComponentSet::kNone)
+            shaders.setVec3(member(i, "position"), glm::vec3(registry.transforms.worlds[t][3]));
     }
 
-    float currentTime = (float)glfwGetTime();
-    glm::mat4 vpMatrix = projection * camera.GetViewMatrix();
-    glm::vec3 lighthouseCenter = glm::vec3(0.0f,5.0f,0.0f);
-    float lighthouseRadius=10.0f;
-    if (isSphereInFrustum(lighthouseCenter,lighthouseRadius,vpMatrix)){
-        lighthouse->Render(shader, currentTime);
+    // Scene-wide features; each object adds its material maps to pick the tightest variant
+    const ShaderVariantKey baseKey = baseShaderKey();
+
+    // === Record visible entities in parallel, one command buffer per range of the mesh pool ===
+    const MeshComponents &meshes = registry.meshes;
+    const size_t ranges = (meshes.size() + kEntitiesPerCommandBuffer - 1) / kEntitiesPerCommandBuffer;
+    commandBuffers.resize(ranges);
+
+    auto recordBuffer = [&](size_t index) {
+        RenderCommandBuffer &commands = commandBuffers[index];
+        commands.clear();
+        const uint32_t begin = static_cast<uint32_t>(index * kEntitiesPerCommandBuffer);
+        const uint32_t end = static_cast<uint32_t>(std::min(meshes.size(), (index + 1) * kEntitiesPerCommandBuffer));
+        RenderPipeline pipeline;
+        for (uint32_t i = begin; i < end; ++i) {
+            const Entity entity = meshes.entity(i);
+            const uint32_t b = registry.bounds.indexOf(entity, i);
+            if (b != ComponentSet::kNone && !registry.bounds.visible[b])
+                continue;
+            const uint32_t t = registry.transforms.indexOf(entity, i);
+            const VirtualTexture *virtualTexture;
+            bool doubleSided;
+            pipeline.key = registry.materialKey(i, baseKey, virtualTexture, doubleSided);
+            pipeline.doubleSided = doubleSided;
+            if (t != ComponentSet::kNone)
+                commands.drawMesh(*meshes.meshes[i], pipeline, registry.transforms.worlds[t], registry.transforms.normals[t],
+                                  virtualTexture);
+            else
+                commands.drawMesh(*meshes.meshes[i], pipeline, glm::mat4(1.0f), glm::mat3(1.0f), virtualTexture);
+        }
+    };
+
+    if (JobSystem *jobs = JobSystem::active()) {
+        jobs->parallelFor(0, commandBuffers.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                recordBuffer(i);
+        });
+    } else {
+        for (size_t i = 0; i < commandBuffers.size(); ++i)
+            recordBuffer(i);
     }
 
-    groundPlane.draw(shader);
+    // === Replay on this (GL) thread, in order ===
+    for (const RenderCommandBuffer &commands : commandBuffers)
+        commands.execute(shaders);
+
+    if (lighthouse && lighthouse->IsVisible(registry))
+        lighthouse->RequestTextureDetail(textureStreamer, camera, registry);
+    groundPlane.requestTextureDetail(textureStreamer, camera);
 
-    for (const auto &mesh : meshes){
-        mesh->Draw(shader);
+    // Low-resolution page feedback for the terrain, read back a few frames later
+    if (const Shader* feedbackShader = terrainTexture.beginFeedback(camera.GetViewMatrix(), projection)) {
+        groundPlane.draw(*feedbackShader);
+        terrainTexture.endFeedback();
     }
 }
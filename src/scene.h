@@ -9,27 +9,23 @@
 #include "Lighthouse.h"
 #include "Texture.h"
 #include "Constants.h"
+#include "texture_streamer.h"
+#include "virtual_texture.h"
+#include "shader_variants.h"
+#include "render_command_buffer.h"
+#include "task_graph.h"
+#include "gl_resource_manager.h"
+#include "entity_registry.h"
+#include "scene_file.h"
+#include "mesh_source.h"
+#include "world_streamer.h"
+#include "spatial_index.h"
+#include <chrono>
 #include <vector>
 #include <string>
 #include <memory>
 #include <glm/glm.hpp>
 
-/**
- * @struct PointLightData
- * @brief Contiene los datos necesarios para describir una luz puntual.
- *
- * Incluye posición, componentes ambiental, difusa, especular y parámetros de atenuación.
- */
-struct PointLightData {
-    glm::vec3 position;   /**< Posición de la luz puntual en el mundo */
-    glm::vec3 ambient;    /**< Componente ambiental de la luz */
-    glm::vec3 diffuse;    /**< Componente difusa de la luz */
-    glm::vec3 specular;   /**< Componente especular de la luz */
-    float constant;       /**< Factor constante de atenuación */
-    float linear;         /**< Factor lineal de atenuación */
-    float quadratic;      /**< Factor cuadrático de atenuación */
-};
-
 /**
  * @struct DirectionalLightData
  * @brief Contiene los datos necesarios para describir una luz direccional.
@@ -43,12 +39,26 @@ struct DirectionalLightData {
     glm::vec3 specular;   /**< Componente especular */
 };
 
+/**
+ * @struct SceneLoadProgress
+ * @brief Progreso de la carga asíncrona de la escena (ver @ref Scene::BeginSetup).
+ */
+struct SceneLoadProgress {
+    size_t completedTasks = 0;    /**< Tareas de carga terminadas */
+    size_t totalTasks = 0;        /**< Tareas de carga en total */
+    bool loaded = false;          /**< Todos los recursos están cargados */
+    double loadMs = 0.0;          /**< Desde @ref Scene::BeginSetup hasta el fin de la carga */
+    double criticalPathMs = 0.0;  /**< Camino crítico del grafo de carga */
+};
+
 /**
  * @class Scene
  * @brief Representa toda la escena a renderizar.
  *
  * La escena contiene un skybox, un faro (lighthouse), un plano (terreno),
  * múltiples luces (direccional, puntuales y spotlight) y facilita su configuración y renderizado.
+ * Lo que se dibuja y las luces puntuales son entidades de un @ref EntityRegistry: el faro y
+ * el plano son dueños de sus mallas y las añaden al registro al cargarlas.
  */
 class Scene {
 public:
@@ -58,49 +68,203 @@ public:
     Scene();
 
     /**
-     * @brief Destructor. Limpia VAOs y VBOs del skybox.
+     * @brief Destructor. Devuelve la textura, el VAO y el VBO del skybox al gestor de recursos.
      */
     ~Scene();
 
     /**
      * @brief Configura la escena: carga skybox, configura luces, crea el faro y el plano.
+     *
+     * La carga se ejecuta como un @ref TaskGraph: lectura y decodificación en los trabajadores,
+     * subidas y creación de objetos de OpenGL en el hilo que llama, que debe tener el contexto.
+     * Al final envía a compilar las variantes de shader (ver @ref PrepareShaders).
+     *
+     * @param shaders Variantes del shader de iluminación.
+     * @param scenePath Escena compilada a cargar (ver @ref SceneFile); si está vacía o no se
+     *        puede abrir se carga la escena del faro incorporada.
+     */
+    void Setup(ShaderVariants &shaders, const std::string &scenePath = std::string());
+
+    /**
+     * @brief Lanza la carga de la escena sin esperarla.
+     *
+     * Crea de inmediato un skybox de marcador (un texel por cara) y lanza el mismo grafo que
+     * @ref Setup. La escena puede renderizarse enseguida: cada objeto aparece cuando sus
+     * recursos terminan y las texturas muestran sus marcadores del streamer hasta entonces.
+     * Las tareas de OpenGL avanzan cuando el hilo de render llama a @ref JobSystem::runGLJobs.
+     *
+     * Con una escena compilada, sus nodos y luces pasan al registro en una sola pasada sobre
+     * los arreglos mapeados antes de volver; cada malla referenciada se lee y sube una vez y
+     * todas sus instancias se vuelven dibujables juntas en cuanto existe.
+     * Si junto a la escena hay un manifiesto de mundo (misma ruta con extensión .world, ver
+     * tools/scene_compiler.cpp), sus celdas se cargan y descargan alrededor de la cámara en
+     * cada @ref Render.
+     *
+     * @param shaders Variantes del shader de iluminación; deben vivir hasta el fin de la carga.
+     * @param scenePath Escena compilada a cargar (ver @ref Setup).
+     */
+    void BeginSetup(ShaderVariants &shaders, const std::string &scenePath = std::string());
+
+    /**
+     * @brief Actualiza el progreso de la carga lanzada con @ref BeginSetup. Hilo de OpenGL, una vez por frame.
+     * @return true si la escena ya está completamente cargada.
      */
-    void Setup();
+    bool UpdateLoading();
+
+    /**
+     * @brief Indica si la carga terminó.
+     */
+    bool IsLoaded() const { return !loadGraph; }
+
+    /**
+     * @brief Progreso y tiempos de la carga (actualizados por @ref UpdateLoading).
+     */
+    const SceneLoadProgress& GetLoadProgress() const { return loadProgress; }
 
     /**
      * @brief Renderiza la escena completa, incluyendo skybox, lighthouse, plano y objetos adicionales.
-     * @param shader Shader principal de la escena (iluminación).
+     *
+     * Los sistemas del registro calculan transformaciones, esferas y culling; después las
+     * entidades visibles se graban en buffers de comandos por rangos de su pool de mallas en
+     * paralelo (si hay un @ref JobSystem activo) y se reproducen en orden en el hilo de OpenGL.
+     *
+     * @param shaders Variantes del shader de iluminación; cada objeto usa la de su material.
      * @param camera Cámara activa desde la que se ve la escena.
      * @param skyboxShader Shader para el skybox.
+     * @param time Tiempo de simulación (anima el spotlight del faro).
+     */
+    void Render(ShaderVariants &shaders, const Camera &camera, Shader &skyboxShader, float time);
+
+    /**
+     * @brief Envía a compilar todas las variantes de shader que usará la escena.
+     *
+     * @ref Setup la llama en cuanto los materiales están cargados; con un @ref ShaderManager
+     * activo las variantes se compilan en paralelo y ningún objeto compila la suya en mitad de un frame.
+     *
+     * @param shaders Variantes del shader de iluminación.
+     */
+    void PrepareShaders(ShaderVariants &shaders) const;
+
+    /**
+     * @brief Obtiene el streamer de texturas de la escena (contadores de residencia y subida).
+     */
+    const TextureStreamer& GetTextureStreamer() const { return textureStreamer; }
+
+    /**
+     * @brief Obtiene la textura virtual del terreno (contadores de la caché de páginas).
      */
-    void Render(Shader &shader, const Camera &camera, Shader &skyboxShader);
+    const VirtualTexture& GetTerrainTexture() const { return terrainTexture; }
+
+    /**
+     * @brief Obtiene el streamer de celdas del mundo (techo de memoria, residencia y esperas).
+     */
+    WorldStreamer& GetWorldStreamer() { return worldStreamer; }
+
+    /**
+     * @brief Obtiene el registro de entidades de la escena. Hilo de OpenGL, fuera de @ref Render.
+     */
+    EntityRegistry& GetRegistry() { return registry; }
+
+    /**
+     * @brief Lleva el índice espacial a las entidades y esferas del último @ref Render. Hilo de OpenGL, fuera de @ref Render.
+     *
+     * El bucle de render la llama tras cada @ref Render; sin cambios solo compara las esferas.
+     * Si cambian las entidades, el índice se reconstruye en una tarea y mientras tanto sigue
+     * respondiendo con la instantánea anterior.
+     */
+    void UpdateSpatialIndex() { spatialIndex.update(registry); }
+
+    /**
+     * @brief Obtiene el índice espacial para consultas de rayo, esfera y frustum.
+     *
+     * Las consultas no pueden solaparse con @ref UpdateSpatialIndex (sí con la reconstrucción
+     * en segundo plano): valen desde el hilo de OpenGL entre frames o desde tareas que terminan
+     * antes de la siguiente llamada.
+     */
+    const SpatialIndex& GetSpatialIndex() const { return spatialIndex; }
 
 private:
-    std::vector<std::unique_ptr<Mesh>> meshes;   /**< Lista de mallas adicionales en la escena */
+    TextureStreamer textureStreamer;             /**< Streaming de mipmaps; se destruye después de las texturas */
+    EntityRegistry registry;                     /**< Entidades: mallas dibujables y luces puntuales */
+    WorldStreamer worldStreamer;                 /**< Celdas del mundo alrededor de la cámara (si la escena tiene manifiesto) */
+    SpatialIndex spatialIndex;                   /**< Instantánea de los objetos dibujables para consultas espaciales */
     Light spotlight;                             /**< Spotlight principal (faro) */
     unsigned int skyboxTexture;                  /**< Textura cubemap del skybox */
+    GLTextureDesc skyboxDesc;                    /**< Forma del cubemap actual (para devolverlo al gestor) */
     unsigned int skyboxVAO, skyboxVBO;           /**< VAO y VBO para el skybox */
+    VirtualTexture terrainTexture;               /**< Textura virtual del terreno (si hay tiles) */
     Plane groundPlane;                           /**< Plano del terreno */
     std::unique_ptr<Lighthouse> lighthouse;      /**< Faro principal en la escena */
 
     DirectionalLightData dirLight;               /**< Luz direccional (ej: sol) */
-    std::vector<PointLightData> pointLights;     /**< Luces puntuales en la escena */
+
+    std::unique_ptr<TaskGraph> loadGraph;        /**< Carga en curso; nulo cuando la escena está cargada */
+    SceneLoadProgress loadProgress;              /**< Progreso de la carga */
+    std::chrono::steady_clock::time_point loadStart; /**< Inicio de la carga */
+    ShaderVariants *shaderVariants;              /**< Variantes a compilar al final de la carga */
+    std::vector<std::string> skyboxFaces;        /**< Rutas de las caras del skybox */
+    std::vector<TextureImage> skyboxImages;      /**< Caras decodificadas pendientes de subir */
+    std::unique_ptr<SceneFile> sceneFile;        /**< Escena compilada mapeada durante la carga */
+    std::vector<Entity> sceneNodes;              /**< Entidad de cada nodo de la escena compilada */
+    std::vector<MeshSource> sceneMeshSources;    /**< Geometría leída de cada asset de malla, pendiente de subir */
+    std::vector<std::vector<Texture>> sceneMeshTextures; /**< Textura difusa preparada de cada asset de malla, pendiente de subir */
+    std::vector<std::unique_ptr<Mesh>> sceneMeshes; /**< Mallas de los assets de la escena compilada */
+
+    static constexpr size_t kEntitiesPerCommandBuffer = 1024; /**< Entidades dibujables grabadas por tarea */
+    static constexpr GLsizeiptr kSkyboxVertexBytes = 36 * 3 * sizeof(float); /**< Tamaño del VBO del skybox */
+    std::vector<RenderCommandBuffer> commandBuffers;       /**< Draws del frame: un buffer por rango de entidades */
+
+    /**
+     * @brief Características de la escena comunes a todas las variantes (número de luces...).
+     */
+    ShaderVariantKey baseShaderKey() const;
+
+    /**
+     * @brief Crea el contenido de la escena del faro incorporada: luces, faro y plano.
+     * @param graph Grafo de carga.
+     * @return Tareas tras las que los materiales de la escena están cargados.
+     */
+    std::vector<TaskGraph::TaskId> addBuiltinContent(TaskGraph &graph);
+
+    /**
+     * @brief Crea el contenido de @ref sceneFile: nodos y luces en el acto, mallas, faro y plano como tareas.
+     * @param graph Grafo de carga.
+     * @return Tareas tras las que los materiales de la escena están cargados.
+     */
+    std::vector<TaskGraph::TaskId> addSceneFileContent(TaskGraph &graph);
+
+    /**
+     * @brief Añade las tareas de un asset de malla de @ref sceneFile: lectura, subida y sus instancias.
+     * @param graph Grafo de carga.
+     * @param assetIndex Índice del asset.
+     * @return TaskGraph::TaskId Tarea que hace dibujables sus instancias.
+     */
+    TaskGraph::TaskId addSceneMeshTasks(TaskGraph &graph, uint32_t assetIndex);
+
+    /**
+     * @brief Añade la tarea que abre la textura virtual del terreno sobre el plano.
+     * @param graph Grafo de carga.
+     * @param planeReady Tarea que crea el plano.
+     * @param center Centro del plano en XZ (el plano debe ser raíz o colgar de nodos sin rotación).
+     */
+    TaskGraph::TaskId addTerrainTask(TaskGraph &graph, TaskGraph::TaskId planeReady, const glm::vec2 &center);
 
     /**
-     * @brief Verifica si una esfera está dentro del frustum de la cámara.
-     * @param center Centro de la esfera.
-     * @param radius Radio de la esfera.
-     * @param vpMatrix Matriz View-Projection actual.
-     * @return true si la esfera está dentro, false si no.
+     * @brief Sube un cubemap a partir de sus caras ya decodificadas.
+     * @param faces Vector con las rutas de las texturas para cada cara del cubemap (para diagnóstico).
+     * @param images Caras decodificadas, en el mismo orden; una cara sin niveles se considera fallida.
+     * @param desc Forma del almacenamiento creado.
+     * @return ID de textura OpenGL, o 0 si ninguna cara se pudo leer.
      */
-    bool isSphereInFrustum(const glm::vec3 &center, float radius, const glm::mat4 &vpMatrix) const;
+    unsigned int loadCubemap(const std::vector<std::string>& faces, const std::vector<TextureImage>& images,
+                             GLTextureDesc& desc);
 
     /**
-     * @brief Carga un cubemap a partir de una lista de rutas de textura.
-     * @param faces Vector con las rutas de las texturas para cada cara del cubemap.
+     * @brief Crea un cubemap de 1x1 por cara (cielo, horizonte y mar) mientras carga el real.
+     * @param desc Forma del almacenamiento creado.
      * @return ID de textura OpenGL.
      */
-    unsigned int loadCubemap(const std::vector<std::string>& faces);
+    unsigned int createPlaceholderCubemap(GLTextureDesc& desc);
 
     /**
      * @brief Crea el VAO y VBO para el skybox.
@@ -0,0 +1,227 @@
+// SceneFile.cpp
+
+#include "scene_file.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+constexpr char kMagic[4] = { 'L', 'H', 'S', 'C' };
+
+uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+void copyVec3(float (&out)[3], const glm::vec3& v)
+{
+    out[0] = v.x;
+    out[1] = v.y;
+    out[2] = v.z;
+}
+
+// Size of one record of each section, in SceneSection order
+constexpr uint64_t kRecordSizes[SceneFileHeader::kSectionCount] = {
+    sizeof(SceneNode), sizeof(SceneInstance), sizeof(ScenePointLight),
+    sizeof(SceneDirectionalLight), sizeof(SceneAsset), sizeof(char)
+};
+
+} // namespace
+
+SceneFile::SceneFile(const std::string& path)
+    : file(path), header(nullptr)
+{
+    if (!file.isOpen())
+        return;
+
+    if (!validate())
+    {
+        std::cerr << "ERROR::SCENE_FILE::INVALID_FILE: " << path << std::endl;
+        header = nullptr;
+        file.close();
+    }
+}
+
+bool SceneFile::validate()
+{
+    const size_t mappedSize = file.size();
+    if (mappedSize < sizeof(SceneFileHeader))
+        return false;
+    const SceneFileHeader* candidate = reinterpret_cast<const SceneFileHeader*>(file.data());
+    if (std::memcmp(candidate->magic, kMagic, sizeof(kMagic)) != 0 || candidate->version != SceneFileHeader::kVersion)
+        return false;
+    if (candidate->sectionCount != SceneFileHeader::kSectionCount || candidate->fileSize != mappedSize)
+        return false;
+
+    // Every section fits in the file and starts aligned for its records
+    for (uint32_t i = 0; i < SceneFileHeader::kSectionCount; ++i)
+    {
+        const SceneFileSection& section = candidate->sections[i];
+        if (section.offset % SceneFileHeader::kAlignment != 0 || section.offset > mappedSize)
+            return false;
+        if (section.count > (mappedSize - section.offset) / kRecordSizes[i])
+            return false;
+    }
+    if (candidate->sections[static_cast<uint32_t>(SceneSection::DirectionalLights)].count > 1)
+        return false;
+    header = candidate;
+
+    // Assets are few; their names, textures and instance ranges are checked once here
+    const uint64_t stringsSize = count(SceneSection::Strings);
+    const uint64_t instanceTotal = instanceCount();
+    const SceneAsset* assetList = assets();
+    for (size_t i = 0; i < assetCount(); ++i)
+    {
+        const SceneAsset& asset = assetList[i];
+        if (static_cast<uint64_t>(asset.nameOffset) + asset.nameLength > stringsSize)
+            return false;
+        if (static_cast<uint64_t>(asset.textureOffset) + asset.textureLength > stringsSize)
+            return false;
+        if (static_cast<uint64_t>(asset.firstInstance) + asset.instanceCount > instanceTotal)
+            return false;
+    }
+    return true;
+}
+
+std::string SceneFile::assetName(const SceneAsset& asset) const
+{
+    const char* strings = section<char>(SceneSection::Strings);
+    return strings ? std::string(strings + asset.nameOffset, asset.nameLength) : std::string();
+}
+
+std::string SceneFile::assetTexture(const SceneAsset& asset) const
+{
+    const char* strings = section<char>(SceneSection::Strings);
+    return strings ? std::string(strings + asset.textureOffset, asset.textureLength) : std::string();
+}
+
+uint32_t SceneFile::Writer::addNode(const glm::vec3& position, uint32_t parent, const glm::quat& rotation, const glm::vec3& scale)
+{
+    if (parent != SceneNode::kNoParent && parent >= nodes.size())
+    {
+        std::cerr << "ERROR::SCENE_FILE::PARENT_NOT_ADDED: " << parent << std::endl;
+        parent = SceneNode::kNoParent;
+    }
+
+    SceneNode node{};
+    copyVec3(node.position, position);
+    node.parent = parent;
+    node.rotation[0] = rotation.x;
+    node.rotation[1] = rotation.y;
+    node.rotation[2] = rotation.z;
+    node.rotation[3] = rotation.w;
+    copyVec3(node.scale, scale);
+    nodes.push_back(node);
+    return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+uint32_t SceneFile::Writer::addAsset(SceneAssetKind kind, const std::string& name, const std::string& texture, float param)
+{
+    SceneAsset asset{};
+    asset.kind = kind;
+    asset.nameOffset = static_cast<uint32_t>(strings.size());
+    asset.nameLength = static_cast<uint32_t>(name.size());
+    strings += name;
+    asset.textureOffset = static_cast<uint32_t>(strings.size());
+    asset.textureLength = static_cast<uint32_t>(texture.size());
+    asset.param = param;
+    strings += texture;
+    assets.push_back(asset);
+    return static_cast<uint32_t>(assets.size() - 1);
+}
+
+void SceneFile::Writer::addInstance(uint32_t asset, uint32_t node, uint32_t flags)
+{
+    instances.push_back({ asset, { node, flags } });
+}
+
+void SceneFile::Writer::addPointLight(uint32_t node, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular,
+                                      float constant, float linear, float quadratic)
+{
+    ScenePointLight light{};
+    copyVec3(light.ambient, ambient);
+    copyVec3(light.diffuse, diffuse);
+    copyVec3(light.specular, specular);
+    light.constant = constant;
+    light.linear = linear;
+    light.quadratic = quadratic;
+    light.node = node;
+    pointLights.push_back(light);
+}
+
+void SceneFile::Writer::setDirectionalLight(const glm::vec3& direction, const glm::vec3& ambient, const glm::vec3& diffuse,
+                                            const glm::vec3& specular)
+{
+    SceneDirectionalLight light{};
+    copyVec3(light.direction, direction);
+    copyVec3(light.ambient, ambient);
+    copyVec3(light.diffuse, diffuse);
+    copyVec3(light.specular, specular);
+    directionalLights.assign(1, light);
+}
+
+bool SceneFile::Writer::write(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        std::cerr << "ERROR::SCENE_FILE::CANNOT_WRITE: " << path << std::endl;
+        return false;
+    }
+
+    // Instances grouped by asset (stable), so each asset owns one contiguous range
+    std::vector<SceneAsset> assetTable = assets;
+    for (const PendingInstance& pending : instances)
+    {
+        if (pending.asset >= assetTable.size())
+        {
+            std::cerr << "ERROR::SCENE_FILE::UNKNOWN_ASSET: " << pending.asset << std::endl;
+            return false;
+        }
+        ++assetTable[pending.asset].instanceCount;
+    }
+    uint32_t first = 0;
+    for (SceneAsset& asset : assetTable)
+    {
+        asset.firstInstance = first;
+        first += asset.instanceCount;
+        asset.instanceCount = 0;
+    }
+    std::vector<SceneInstance> instanceTable(instances.size());
+    for (const PendingInstance& pending : instances)
+    {
+        SceneAsset& asset = assetTable[pending.asset];
+        instanceTable[asset.firstInstance + asset.instanceCount++] = pending.instance;
+    }
+
+    SceneFileHeader fileHeader{};
+    std::memcpy(fileHeader.magic, kMagic, sizeof(kMagic));
+    fileHeader.version = SceneFileHeader::kVersion;
+    fileHeader.sectionCount = SceneFileHeader::kSectionCount;
+    out.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+
+    const char padding[SceneFileHeader::kAlignment] = {};
+    uint64_t offset = sizeof(fileHeader);
+    auto writeSection = [&](SceneSection id, const void* data, uint64_t count) {
+        const uint64_t aligned = alignUp(offset, SceneFileHeader::kAlignment);
+        out.write(padding, static_cast<std::streamsize>(aligned - offset));
+        const uint64_t bytes = count * kRecordSizes[static_cast<uint32_t>(id)];
+        if (bytes)
+            out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        fileHeader.sections[static_cast<uint32_t>(id)] = { aligned, count };
+        offset = aligned + bytes;
+    };
+    writeSection(SceneSection::Nodes, nodes.data(), nodes.size());
+    writeSection(SceneSection::Instances, instanceTable.data(), instanceTable.size());
+    writeSection(SceneSection::PointLights, pointLights.data(), pointLights.size());
+    writeSection(SceneSection::DirectionalLights, directionalLights.data(), directionalLights.size());
+    writeSection(SceneSection::Assets, assetTable.data(), assetTable.size());
+    writeSection(SceneSection::Strings, strings.data(), strings.size());
+
+    fileHeader.fileSize = offset;
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+    return static_cast<bool>(out);
+}
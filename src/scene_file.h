@@ -0,0 +1,292 @@
+#ifndef SCENE_FILE_H
+#define SCENE_FILE_H
+
+#include "mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+/**
+ * @enum SceneSection
+ * @brief Secciones del archivo de escena, en el orden de @ref SceneFileHeader::sections.
+ */
+enum class SceneSection : uint32_t {
+    Nodes = 0,             /**< @ref SceneNode: una entidad con transformación por registro */
+    Instances = 1,         /**< @ref SceneInstance, agrupadas por asset */
+    PointLights = 2,       /**< @ref ScenePointLight */
+    DirectionalLights = 3, /**< @ref SceneDirectionalLight (cero o una) */
+    Assets = 4,            /**< @ref SceneAsset */
+    Strings = 5            /**< Nombres de los assets (la cuenta es en bytes) */
+};
+
+/**
+ * @enum SceneAssetKind
+ * @brief Qué crea la escena para cada instancia de un asset.
+ */
+enum class SceneAssetKind : uint32_t {
+    Mesh = 0,       /**< Malla por nombre: cocinada en el asset pack o generada (ver @ref Geometry::generateBuiltinMesh) */
+    Lighthouse = 1, /**< El faro completo, colgado del nodo de la instancia */
+    Ground = 2      /**< Plano del terreno; @c param es el lado */
+};
+
+/**
+ * @struct SceneFileSection
+ * @brief Ubicación de un arreglo plano dentro del archivo.
+ */
+struct SceneFileSection {
+    uint64_t offset;    /**< Offset desde el inicio del archivo, alineado a @ref SceneFileHeader::kAlignment */
+    uint64_t count;     /**< Número de registros */
+};
+
+/**
+ * @struct SceneFileHeader
+ * @brief Cabecera al inicio del archivo de escena compilado.
+ *
+ * Detrás de la cabecera van los arreglos de cada sección, sin punteros: las referencias
+ * entre registros son índices y los nombres offsets en la tabla de cadenas, así que el
+ * archivo es reubicable y se usa tal cual desde el mapeo. Little-endian.
+ */
+struct SceneFileHeader {
+    char magic[4];              /**< "LHSC" */
+    uint32_t version;           /**< Versión del formato (@ref kVersion) */
+    uint32_t flags;             /**< Reservado, 0 */
+    uint32_t sectionCount;      /**< Secciones en @ref sections (@ref kSectionCount) */
+    uint64_t fileSize;          /**< Tamaño total del archivo */
+    uint64_t reserved;          /**< Reservado, 0 */
+    SceneFileSection sections[6]; /**< Una por @ref SceneSection */
+
+    static constexpr uint32_t kVersion = 2;
+    static constexpr uint32_t kSectionCount = 6;
+    static constexpr uint64_t kAlignment = 16; /**< Alineación de cada sección */
+};
+
+/**
+ * @struct SceneNode
+ * @brief Transformación local de una entidad. Los padres van antes que sus hijos.
+ */
+struct SceneNode {
+    float position[3];      /**< Posición local */
+    uint32_t parent;        /**< Índice del nodo padre (menor que el propio), o @ref kNoParent */
+    float rotation[4];      /**< Rotación local como cuaternión x, y, z, w */
+    float scale[3];         /**< Escala local */
+    uint32_t flags;         /**< Reservado, 0 */
+
+    static constexpr uint32_t kNoParent = 0xFFFFFFFFu;
+};
+
+/**
+ * @struct SceneInstance
+ * @brief Un uso de un asset en un nodo. Las instancias de cada asset son contiguas.
+ */
+struct SceneInstance {
+    uint32_t node;          /**< Índice del nodo */
+    uint32_t flags;         /**< Combinación de @ref kDoubleSided */
+
+    static constexpr uint32_t kDoubleSided = 1u << 0; /**< Dibuja ambas caras */
+};
+
+/**
+ * @struct ScenePointLight
+ * @brief Luz puntual; la posición sale del nodo.
+ */
+struct ScenePointLight {
+    float ambient[3];       /**< Componente ambiental */
+    float constant;         /**< Atenuación constante */
+    float diffuse[3];       /**< Componente difusa */
+    float linear;           /**< Atenuación lineal */
+    float specular[3];      /**< Componente especular */
+    float quadratic;        /**< Atenuación cuadrática */
+    uint32_t node;          /**< Índice del nodo */
+    uint32_t reserved[3];   /**< Reservado, 0 */
+};
+
+/**
+ * @struct SceneDirectionalLight
+ * @brief Luz direccional (sol).
+ */
+struct SceneDirectionalLight {
+    float direction[3];     /**< Dirección de la luz */
+    float reserved0;        /**< Reservado, 0 */
+    float ambient[3];       /**< Componente ambiental */
+    float reserved1;        /**< Reservado, 0 */
+    float diffuse[3];       /**< Componente difusa */
+    float reserved2;        /**< Reservado, 0 */
+    float specular[3];      /**< Componente especular */
+    float reserved3;        /**< Reservado, 0 */
+};
+
+/**
+ * @struct SceneAsset
+ * @brief Referencia a un asset y el rango de sus instancias.
+ */
+struct SceneAsset {
+    SceneAssetKind kind;    /**< Qué crea cada instancia */
+    uint32_t nameOffset;    /**< Offset del nombre en la tabla de cadenas */
+    uint32_t nameLength;    /**< Longitud del nombre */
+    uint32_t firstInstance; /**< Primera instancia en la sección de instancias */
+    uint32_t instanceCount; /**< Instancias consecutivas */
+    uint32_t textureOffset; /**< Offset de la textura difusa en la tabla de cadenas (@ref SceneAssetKind::Mesh) */
+    uint32_t textureLength; /**< Longitud de la ruta de la textura; 0 si la malla no tiene textura */
+    float param;            /**< Parámetro según @ref kind */
+};
+
+static_assert(sizeof(SceneFileHeader) == 128, "SceneFileHeader layout is part of the file format");
+static_assert(sizeof(SceneNode) == 48, "SceneNode layout is part of the file format");
+static_assert(sizeof(SceneInstance) == 8, "SceneInstance layout is part of the file format");
+static_assert(sizeof(ScenePointLight) == 64, "ScenePointLight layout is part of the file format");
+static_assert(sizeof(SceneDirectionalLight) == 64, "SceneDirectionalLight layout is part of the file format");
+static_assert(sizeof(SceneAsset) == 32, "SceneAsset layout is part of the file format");
+
+/// Conversión entre los arreglos de floats del archivo y glm.
+inline glm::vec3 sceneVec3(const float (&v)[3]) { return glm::vec3(v[0], v[1], v[2]); }
+inline glm::quat sceneQuat(const float (&q)[4]) { return glm::quat(q[3], q[0], q[1], q[2]); }
+
+/**
+ * @class SceneFile
+ * @brief Escena compilada (ver tools/scene_compiler.cpp) mapeada en memoria.
+ *
+ * Abrir el archivo solo comprueba la cabecera, que cada sección cabe en el archivo y que
+ * los nombres, texturas y rangos de instancias de los assets son válidos; no hay pasada de lectura
+ * por registro. Los arreglos se leen en su lugar desde el mapeo, así que una escena con
+ * millones de instancias abre en lo que tarda el mmap. Las referencias de cada registro
+ * a nodos se comprueban al usarlas: quien las lee trata un índice fuera de rango como ausente.
+ */
+class SceneFile {
+public:
+    /**
+     * @brief Abre y mapea un archivo de escena compilado.
+     * @param path Ruta al archivo.
+     */
+    explicit SceneFile(const std::string& path);
+
+    SceneFile(const SceneFile&) = delete;
+    SceneFile& operator=(const SceneFile&) = delete;
+
+    /**
+     * @brief Indica si el archivo se abrió y su contenido es consistente.
+     */
+    bool isOpen() const { return header != nullptr; }
+
+    const SceneNode* nodes() const { return section<SceneNode>(SceneSection::Nodes); }
+    size_t nodeCount() const { return count(SceneSection::Nodes); }
+
+    const SceneInstance* instances() const { return section<SceneInstance>(SceneSection::Instances); }
+    size_t instanceCount() const { return count(SceneSection::Instances); }
+
+    const ScenePointLight* pointLights() const { return section<ScenePointLight>(SceneSection::PointLights); }
+    size_t pointLightCount() const { return count(SceneSection::PointLights); }
+
+    const SceneDirectionalLight* directionalLights() const { return section<SceneDirectionalLight>(SceneSection::DirectionalLights); }
+    size_t directionalLightCount() const { return count(SceneSection::DirectionalLights); }
+
+    const SceneAsset* assets() const { return section<SceneAsset>(SceneSection::Assets); }
+    size_t assetCount() const { return count(SceneSection::Assets); }
+
+    /**
+     * @brief Nombre de un asset (ej: "meshes/lighthouse/beacon.mesh").
+     */
+    std::string assetName(const SceneAsset& asset) const;
+
+    /**
+     * @brief Ruta de la textura difusa de un asset de malla, o vacía si no tiene.
+     */
+    std::string assetTexture(const SceneAsset& asset) const;
+
+    /**
+     * @class Writer
+     * @brief Construye un archivo de escena a partir de registros en memoria.
+     */
+    class Writer {
+    public:
+        /**
+         * @brief Añade un nodo.
+         * @param position Posición local.
+         * @param parent Índice de un nodo ya añadido, o @ref SceneNode::kNoParent.
+         * @param rotation Rotación local.
+         * @param scale Escala local.
+         * @return uint32_t Índice del nodo.
+         */
+        uint32_t addNode(const glm::vec3& position, uint32_t parent = SceneNode::kNoParent,
+                         const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                         const glm::vec3& scale = glm::vec3(1.0f));
+
+        /**
+         * @brief Añade un asset.
+         * @param kind Tipo de asset.
+         * @param name Nombre (ruta de la malla para @ref SceneAssetKind::Mesh).
+         * @param texture Textura difusa de la malla (opcional).
+         * @param param Parámetro según el tipo.
+         * @return uint32_t Índice del asset.
+         */
+        uint32_t addAsset(SceneAssetKind kind, const std::string& name, const std::string& texture = std::string(),
+                          float param = 0.0f);
+
+        /**
+         * @brief Añade una instancia de un asset en un nodo.
+         * @param asset Índice del asset.
+         * @param node Índice del nodo.
+         * @param flags Combinación de @ref SceneInstance::kDoubleSided.
+         */
+        void addInstance(uint32_t asset, uint32_t node, uint32_t flags = 0);
+
+        /**
+         * @brief Añade una luz puntual en un nodo.
+         */
+        void addPointLight(uint32_t node, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular,
+                           float constant, float linear, float quadratic);
+
+        /**
+         * @brief Fija la luz direccional de la escena.
+         */
+        void setDirectionalLight(const glm::vec3& direction, const glm::vec3& ambient, const glm::vec3& diffuse,
+                                 const glm::vec3& specular);
+
+        size_t nodeCount() const { return nodes.size(); }
+        size_t instanceCount() const { return instances.size(); }
+
+        /**
+         * @brief Escribe la escena a disco, con las instancias agrupadas por asset.
+         * @param path Ruta del archivo de salida.
+         * @return true si se escribió correctamente.
+         */
+        bool write(const std::string& path) const;
+
+    private:
+        struct PendingInstance {
+            uint32_t asset;
+            SceneInstance instance;
+        };
+        std::vector<SceneNode> nodes;                   /**< Nodos en orden de índice */
+        std::vector<PendingInstance> instances;         /**< Instancias en el orden en que se añadieron */
+        std::vector<ScenePointLight> pointLights;       /**< Luces puntuales */
+        std::vector<SceneDirectionalLight> directionalLights; /**< Cero o una */
+        std::vector<SceneAsset> assets;                 /**< Assets (sin rango de instancias hasta escribir) */
+        std::string strings;                            /**< Tabla de cadenas */
+    };
+
+private:
+    MappedFile file;                    /**< Archivo mapeado */
+    const SceneFileHeader* header;      /**< Cabecera dentro del mapeo (nula si no es válido) */
+
+    template <typename T>
+    const T* section(SceneSection id) const
+    {
+        return header ? reinterpret_cast<const T*>(file.data() + header->sections[static_cast<uint32_t>(id)].offset) : nullptr;
+    }
+
+    size_t count(SceneSection id) const
+    {
+        return header ? static_cast<size_t>(header->sections[static_cast<uint32_t>(id)].count) : 0;
+    }
+
+    /**
+     * @brief Valida la cabecera, las secciones y los assets tras mapear el archivo.
+     * @return true si el contenido es consistente con el tamaño del archivo.
+     */
+    bool validate();
+};
+
+#endif // SCENE_FILE_H
@@ -1,55 +1,57 @@
 #include "Shader.h"
+#include "asset_pack.h"
+#include "program_cache.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath)
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines)
+    : Shader(vertexPath, fragmentPath, defines, Build::Immediate)
 {
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
+}
 
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    try {
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();		
-        vShaderFile.close();
-        fShaderFile.close();
-        vertexCode   = vShaderStream.str();
-        fragmentCode = fShaderStream.str();		
-    } catch(std::ifstream::failure& e) {
-        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
-    }
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines, Build build)
+{
+    std::string vertexCode = injectDefines(readSource(vertexPath), defines);
+    std::string fragmentCode = injectDefines(readSource(fragmentPath), defines);
+
+    // Warm launches link straight from the driver binary and skip GLSL compilation
+    ID = glCreateProgram();
+    cacheKey = ProgramCache::key(vertexCode, fragmentCode, defines);
+    if (ProgramCache::load(cacheKey, ID))
+        return;
 
     const char* vShaderCode = vertexCode.c_str();
     const char* fShaderCode = fragmentCode.c_str();
 
-    GLuint vertex, fragment;
-    GLint success;
-    GLchar infoLog[1024];
+    // Compile and link are only submitted here; querying their status is what blocks
+    pendingVertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(pendingVertex, 1, &vShaderCode, NULL);
+    glCompileShader(pendingVertex);
 
-    // Vertex Shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
+    pendingFragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(pendingFragment, 1, &fShaderCode, NULL);
+    glCompileShader(pendingFragment);
 
-    // Fragment Shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
-
-    // Shader Program
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
+    glAttachShader(ID, pendingVertex);
+    glAttachShader(ID, pendingFragment);
+    ProgramCache::prepare(ID);
     glLinkProgram(ID);
+
+    if (build == Build::Immediate)
+        finish();
+}
+
+bool Shader::finish()
+{
+    if (!isPending())
+        return ID != 0;
+
+    checkCompileErrors(pendingVertex, "VERTEX");
+    checkCompileErrors(pendingFragment, "FRAGMENT");
+
+    GLint success;
+    GLchar infoLog[1024];
     // Check link errors
     glGetProgramiv(ID, GL_LINK_STATUS, &success);
     if(!success) {
@@ -59,14 +61,27 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
         glDeleteProgram(ID);
         ID = 0;
     }
+    else {
+        ProgramCache::store(cacheKey, ID);
+    }
 
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    glDeleteShader(pendingVertex);
+    glDeleteShader(pendingFragment);
+    pendingVertex = pendingFragment = 0;
+    return ID != 0;
+}
+
+bool Shader::linked() const
+{
+    // A deferred program used before the loader collected it is finished on the spot
+    if (isPending())
+        return const_cast<Shader*>(this)->finish();
+    return ID != 0;
 }
 
 void Shader::use() const
 {
-    if(ID != 0) glUseProgram(ID);
+    if(linked()) glUseProgram(ID);
     else {
         // If invalid program, print a warning (only once)
         static bool warned = false;
@@ -77,38 +92,52 @@ void Shader::use() const
     }
 }
 
-void Shader::setBool(const std::string &name, bool value) const
+void Shader::setBool(const char *name, bool value) const
 {
-    if(ID == 0) return; // Skip if invalid
-    GLint loc = glGetUniformLocation(ID, name.c_str());
+    if(!linked()) return; // Skip if invalid
+    GLint loc = glGetUniformLocation(ID, name);
     if(loc >= 0) glUniform1i(loc, (int)value);
 }
 
-void Shader::setInt(const std::string &name, int value) const
+void Shader::setInt(const char *name, int value) const
 {
-    if(ID == 0) return; // Skip if invalid
-    GLint loc = glGetUniformLocation(ID, name.c_str());
+    if(!linked()) return; // Skip if invalid
+    GLint loc = glGetUniformLocation(ID, name);
     if(loc >= 0) glUniform1i(loc, value);
 }
 
-void Shader::setFloat(const std::string &name, float value) const
+void Shader::setFloat(const char *name, float value) const
 {
-    if(ID == 0) return;
-    GLint loc = glGetUniformLocation(ID, name.c_str());
+    if(!linked()) return;
+    GLint loc = glGetUniformLocation(ID, name);
     if(loc >= 0) glUniform1f(loc, value);
 }
 
-void Shader::setVec3(const std::string &name, const glm::vec3 &value) const
+void Shader::setVec3(const char *name, const glm::vec3 &value) const
 {
-    if(ID == 0) return;
-    GLint loc = glGetUniformLocation(ID, name.c_str());
+    if(!linked()) return;
+    GLint loc = glGetUniformLocation(ID, name);
     if(loc >= 0) glUniform3fv(loc, 1, &value[0]);
 }
 
-void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const
+void Shader::setVec4(const char *name, const glm::vec4 &value) const
+{
+    if(!linked()) return;
+    GLint loc = glGetUniformLocation(ID, name);
+    if(loc >= 0) glUniform4fv(loc, 1, &value[0]);
+}
+
+void Shader::setMat3(const char *name, const glm::mat3 &mat) const
 {
-    if(ID == 0) return;
-    GLint loc = glGetUniformLocation(ID, name.c_str());
+    if(!linked()) return;
+    GLint loc = glGetUniformLocation(ID, name);
+    if(loc >= 0) glUniformMatrix3fv(loc, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setMat4(const char *name, const glm::mat4 &mat) const
+{
+    if(!linked()) return;
+    GLint loc = glGetUniformLocation(ID, name);
     if(loc >= 0) glUniformMatrix4fv(loc, 1, GL_FALSE, &mat[0][0]);
 }
 
@@ -131,3 +160,42 @@ void Shader::checkCompileErrors(GLuint shader, std::string type) const
         // Linking handled outside
     }
 }
+
+std::string Shader::readSource(const char* path)
+{
+    // Packed sources are read straight out of the mapped archive
+    if (const AssetPack* pack = AssetPack::mounted())
+    {
+        AssetBlob blob;
+        if (pack->find(path, blob) && blob.kind == AssetKind::Shader)
+            return std::string(reinterpret_cast<const char*>(blob.data), blob.size);
+    }
+
+    std::ifstream shaderFile;
+    shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    try {
+        shaderFile.open(path);
+        std::stringstream shaderStream;
+        shaderStream << shaderFile.rdbuf();
+        shaderFile.close();
+        return shaderStream.str();
+    } catch(std::ifstream::failure& e) {
+        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path << std::endl;
+    }
+    return std::string();
+}
+
+std::string Shader::injectDefines(const std::string& source, const std::string& defines)
+{
+    if (defines.empty())
+        return source;
+
+    // #version must stay the first directive, so the defines go right after its line
+    size_t version = source.find("#version");
+    if (version == std::string::npos)
+        return defines + source;
+    size_t lineEnd = source.find('\n', version);
+    if (lineEnd == std::string::npos)
+        return source + "\n" + defines;
+    return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
@@ -1,6 +1,7 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include <cstdint>
 #include <string>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -16,25 +17,67 @@ class Shader {
 public:
     GLuint ID; /**< ID del programa shader. */
 
+    /**
+     * @enum Build
+     * @brief Cuándo se espera al resultado de la compilación.
+     */
+    enum class Build {
+        Immediate,  /**< Compila, enlaza y comprueba errores en el constructor */
+        Deferred    /**< Solo envía compilación y enlace al driver; se comprueba en @ref finish */
+    };
+
     /**
      * @brief Constructor que carga y compila shaders desde archivos.
      *
+     * Si la caché de binarios (@ref ProgramCache) tiene el programa para estas fuentes y
+     * este driver, se carga directamente sin compilar GLSL.
+     *
+     * @param vertexPath Ruta al archivo del shader de vértices.
+     * @param fragmentPath Ruta al archivo del shader de fragmentos.
+     * @param defines Líneas @c #define que se insertan tras @c #version en ambos shaders.
+     */
+    Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines = std::string());
+
+    /**
+     * @brief Constructor que permite diferir la espera a la compilación.
+     *
+     * Con @ref Build::Deferred el driver puede compilar en segundo plano (ver @ref ShaderManager);
+     * el primer uso del programa, o @ref finish, recoge el resultado.
+     *
      * @param vertexPath Ruta al archivo del shader de vértices.
      * @param fragmentPath Ruta al archivo del shader de fragmentos.
+     * @param defines Líneas @c #define que se insertan tras @c #version en ambos shaders.
+     * @param build Momento en que se comprueba el resultado.
+     */
+    Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines, Build build);
+
+    /**
+     * @brief Indica si la compilación se envió pero su resultado aún no se ha recogido.
      */
-    Shader(const char* vertexPath, const char* fragmentPath);
+    bool isPending() const { return pendingVertex != 0; }
+
+    /**
+     * @brief Recoge el resultado de una compilación diferida (bloquea si el driver no terminó).
+     *
+     * Comprueba errores, guarda el binario en la caché y libera los shader objects.
+     *
+     * @return true si el programa es válido.
+     */
+    bool finish();
 
     /**
      * @brief Activa el programa shader.
      */
     void use() const;
 
-    /// Funciones para establecer uniformes.
-    void setBool(const std::string &name, bool value) const;
-    void setInt(const std::string &name, int value) const;
-    void setFloat(const std::string &name, float value) const;
-    void setVec3(const std::string &name, const glm::vec3 &value) const;
-    void setMat4(const std::string &name, const glm::mat4 &mat) const;
+    /// Funciones para establecer uniformes (nombres C: un literal no construye un std::string por llamada).
+    void setBool(const char *name, bool value) const;
+    void setInt(const char *name, int value) const;
+    void setFloat(const char *name, float value) const;
+    void setVec3(const char *name, const glm::vec3 &value) const;
+    void setVec4(const char *name, const glm::vec4 &value) const;
+    void setMat3(const char *name, const glm::mat3 &mat) const;
+    void setMat4(const char *name, const glm::mat4 &mat) const;
 
 private:
     /**
@@ -44,6 +87,32 @@ private:
      * @param type Tipo de operación (compilación o enlace).
      */
     void checkCompileErrors(GLuint shader, std::string type) const;
+
+    /**
+     * @brief Lee el código fuente de un shader desde el asset pack montado o, si no está, desde disco.
+     *
+     * @param path Ruta relativa del archivo GLSL.
+     * @return std::string Código fuente (vacío si no pudo leerse).
+     */
+    static std::string readSource(const char* path);
+
+    GLuint pendingVertex = 0;     /**< Shader de vértices de una compilación sin recoger */
+    GLuint pendingFragment = 0;   /**< Shader de fragmentos de una compilación sin recoger */
+    uint64_t cacheKey = 0;        /**< Clave en @ref ProgramCache del programa */
+
+    /**
+     * @brief Recoge una compilación pendiente si la hay y dice si el programa es usable.
+     */
+    bool linked() const;
+
+    /**
+     * @brief Inserta defines en el código fuente justo después de la directiva @c #version.
+     *
+     * @param source Código GLSL.
+     * @param defines Líneas @c #define (pueden estar vacías).
+     * @return std::string Código con los defines insertados.
+     */
+    static std::string injectDefines(const std::string& source, const std::string& defines);
 };
 
 #endif // SHADER_H
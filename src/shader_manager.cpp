@@ -0,0 +1,222 @@
+// ShaderManager.cpp
+
+#include "shader_manager.h"
+#include "Mesh.h"
+#include <cstring>
+#include <iostream>
+
+// GL_KHR_parallel_shader_compile is not part of the generated loader
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+ShaderManager* ShaderManager::activeManager = nullptr;
+
+ShaderManager::ShaderManager()
+    : parallelCompile(false)
+{
+}
+
+ShaderManager::~ShaderManager()
+{
+    if (activeManager == this)
+        activeManager = nullptr;
+}
+
+void ShaderManager::init(GLADloadproc loader)
+{
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount && !parallelCompile; ++i)
+    {
+        const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        parallelCompile = name && (std::strcmp(name, "GL_KHR_parallel_shader_compile") == 0
+                                   || std::strcmp(name, "GL_ARB_parallel_shader_compile") == 0);
+    }
+
+    if (parallelCompile)
+    {
+        // 0xFFFFFFFF lets the driver use as many compiler threads as it sees fit
+        auto maxThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(loader("glMaxShaderCompilerThreadsKHR"));
+        if (!maxThreads)
+            maxThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(loader("glMaxShaderCompilerThreadsARB"));
+        if (maxThreads)
+            maxThreads(0xFFFFFFFFu);
+    }
+}
+
+void ShaderManager::activate()
+{
+    activeManager = this;
+}
+
+ShaderManager* ShaderManager::active()
+{
+    return activeManager;
+}
+
+bool ShaderManager::isCompiling(const Shader& shader)
+{
+    if (!shader.isPending() || !activeManager || !activeManager->parallelCompile)
+        return false;
+    GLint done = GL_FALSE;
+    glGetProgramiv(shader.ID, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_FALSE;
+}
+
+std::unique_ptr<Shader> ShaderManager::create(const char* vertexPath, const char* fragmentPath,
+                                              const std::string& defines, WarmUpTarget target)
+{
+    if (!activeManager)
+        return std::make_unique<Shader>(vertexPath, fragmentPath, defines);
+
+    auto shader = std::make_unique<Shader>(vertexPath, fragmentPath, defines, Shader::Build::Deferred);
+    activeManager->entries.push_back(Entry{shader.get(), target});
+    return shader;
+}
+
+int ShaderManager::pendingCount() const
+{
+    int pending = 0;
+    for (const Entry& entry : entries)
+        pending += entry.shader->isPending() ? 1 : 0;
+    return pending;
+}
+
+bool ShaderManager::poll()
+{
+    bool collectedBlocking = false;
+    for (Entry& entry : entries)
+    {
+        if (!entry.shader->isPending())
+            continue;
+
+        if (parallelCompile)
+        {
+            GLint done = GL_FALSE;
+            glGetProgramiv(entry.shader->ID, GL_COMPLETION_STATUS_KHR, &done);
+            if (done)
+                entry.shader->finish();
+        }
+        else if (!collectedBlocking)
+        {
+            // Without the completion query, collecting blocks: one program per poll
+            entry.shader->finish();
+            collectedBlocking = true;
+        }
+    }
+    return pendingCount() == 0;
+}
+
+// Gives every sampler its own unit so that samplers of different types never alias unit 0
+void ShaderManager::assignSamplerUnits(GLuint program)
+{
+    GLint uniformCount = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+    GLint unit = 0;
+    for (GLint i = 0; i < uniformCount; ++i)
+    {
+        GLchar name[256];
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, static_cast<GLuint>(i), sizeof(name), nullptr, &size, &type, name);
+        switch (type)
+        {
+            case GL_SAMPLER_2D:
+            case GL_SAMPLER_3D:
+            case GL_SAMPLER_CUBE:
+            case GL_SAMPLER_2D_SHADOW:
+            case GL_SAMPLER_2D_ARRAY:
+            case GL_INT_SAMPLER_2D:
+            case GL_UNSIGNED_INT_SAMPLER_2D:
+                glProgramUniform1i(program, glGetUniformLocation(program, name), unit++);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void ShaderManager::warmUp()
+{
+    for (Entry& entry : entries)
+        entry.shader->finish();
+
+    GLint savedViewport[4];
+    GLint savedFramebuffer = 0;
+    glGetIntegerv(GL_VIEWPORT, savedViewport);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &savedFramebuffer);
+
+    // Representative targets: the sRGB back buffer and the integer feedback buffer, both with depth
+    const GLsizei size = 4;
+    GLuint renderbuffers[3];
+    glGenRenderbuffers(3, renderbuffers);
+    const GLenum formats[3] = {GL_SRGB8_ALPHA8, GL_RGBA16UI, GL_DEPTH_COMPONENT24};
+    for (int i = 0; i < 3; ++i)
+    {
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[i]);
+        glRenderbufferStorage(GL_RENDERBUFFER, formats[i], size, size);
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    GLuint framebuffers[2];
+    glGenFramebuffers(2, framebuffers);
+    for (int i = 0; i < 2; ++i)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[i]);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[i]);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[2]);
+    }
+
+    // One triangle in the Mesh vertex layout
+    Vertex triangle[3] = {};
+    triangle[1].Position = glm::vec3(1.0f, 0.0f, 0.0f);
+    triangle[2].Position = glm::vec3(0.0f, 1.0f, 0.0f);
+    GLuint vao, vbo;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(triangle), triangle, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Color));
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+
+    glViewport(0, 0, size, size);
+    int warmed = 0;
+    for (const Entry& entry : entries)
+    {
+        if (entry.shader->ID == 0)
+            continue;
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[entry.target == WarmUpTarget::Color ? 0 : 1]);
+        assignSamplerUnits(entry.shader->ID);
+        entry.shader->use();
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        ++warmed;
+    }
+    glFlush();
+
+    glUseProgram(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &vbo);
+    glDeleteVertexArrays(1, &vao);
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(savedFramebuffer));
+    glDeleteFramebuffers(2, framebuffers);
+    glDeleteRenderbuffers(3, renderbuffers);
+    glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+
+    std::cout << "Warmed up " << warmed << " shader programs"
+              << (parallelCompile ? " (parallel compile)." : ".") << std::endl;
+
+    // Programs created from now on compile synchronously
+    entries.clear();
+    if (activeManager == this)
+        activeManager = nullptr;
+}
@@ -0,0 +1,120 @@
+#ifndef SHADER_MANAGER_H
+#define SHADER_MANAGER_H
+
+#include "Shader.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+/**
+ * @enum WarmUpTarget
+ * @brief Tipo de framebuffer contra el que se precalienta un programa.
+ */
+enum class WarmUpTarget {
+    Color,              /**< Color sRGB + profundidad, como el framebuffer por defecto */
+    UnsignedFeedback    /**< Color entero sin signo + profundidad (feedback de la textura virtual) */
+};
+
+/**
+ * @class ShaderManager
+ * @brief Compila todos los programas en paralelo durante la carga y los precalienta antes del primer frame.
+ *
+ * Mientras el gestor está activo (@ref activate), @ref create envía compilación y enlace al
+ * driver sin esperar el resultado. @ref poll recoge los programas terminados sin bloquear
+ * cuando el driver expone @c GL_KHR_parallel_shader_compile (o la variante ARB); sin la
+ * extensión recoge un programa por llamada, de modo que el bucle de carga siga respondiendo.
+ *
+ * @ref warmUp hace un draw de prueba con cada programa contra un VAO con el formato de
+ * vértice de @c Mesh y un FBO del tipo de destino, para que el driver genere sus variantes
+ * dependientes del estado antes del primer frame. Después el gestor se desactiva y los
+ * programas nuevos vuelven a compilarse de forma síncrona.
+ */
+class ShaderManager {
+public:
+    ShaderManager();
+    ~ShaderManager();
+
+    ShaderManager(const ShaderManager&) = delete;
+    ShaderManager& operator=(const ShaderManager&) = delete;
+
+    /**
+     * @brief Detecta la compilación paralela y pide al driver todos sus hilos de compilación.
+     * @param loader Función para obtener punteros de OpenGL (p. ej. @c glfwGetProcAddress).
+     */
+    void init(GLADloadproc loader);
+
+    /**
+     * @brief Hace de este gestor el que recibe los programas creados con @ref create.
+     */
+    void activate();
+
+    /**
+     * @brief Crea un programa: diferido y registrado si hay un gestor activo, síncrono si no.
+     *
+     * @param vertexPath Ruta del shader de vértices.
+     * @param fragmentPath Ruta del shader de fragmentos.
+     * @param defines Líneas @c #define de la variante.
+     * @param target Framebuffer contra el que precalentarlo.
+     * @return std::unique_ptr<Shader> Programa (el gestor solo guarda una referencia hasta @ref warmUp).
+     */
+    static std::unique_ptr<Shader> create(const char* vertexPath, const char* fragmentPath,
+                                          const std::string& defines = std::string(),
+                                          WarmUpTarget target = WarmUpTarget::Color);
+
+    /**
+     * @brief Gestor activo, o nullptr si no hay ninguno (o ya se precalentó).
+     */
+    static ShaderManager* active();
+
+    /**
+     * @brief Indica si el driver sigue compilando un programa diferido.
+     *
+     * Solo puede saberse sin bloquear con la compilación paralela; sin ella devuelve false y
+     * el primer uso del programa espera a que termine.
+     *
+     * @param shader Programa a consultar.
+     * @return true si usarlo ahora bloquearía el hilo de OpenGL.
+     */
+    static bool isCompiling(const Shader& shader);
+
+    /**
+     * @brief Recoge los programas que el driver terminó de compilar.
+     * @return true si no queda ninguno pendiente.
+     */
+    bool poll();
+
+    /**
+     * @brief Precalienta todos los programas registrados (esperando a los pendientes) y desactiva el gestor.
+     */
+    void warmUp();
+
+    /**
+     * @brief Programas registrados cuya compilación aún no se ha recogido.
+     */
+    int pendingCount() const;
+
+    /**
+     * @brief Indica si el driver compila en paralelo (@c GL_KHR_parallel_shader_compile o ARB).
+     */
+    bool hasParallelCompile() const { return parallelCompile; }
+
+private:
+    /**
+     * @struct Entry
+     * @brief Programa registrado durante la carga.
+     */
+    struct Entry {
+        Shader* shader;         /**< Programa (propiedad de quien lo creó) */
+        WarmUpTarget target;    /**< Framebuffer del draw de prueba */
+    };
+
+    std::vector<Entry> entries;   /**< Programas creados mientras el gestor estaba activo */
+    bool parallelCompile;         /**< El driver expone la consulta de finalización */
+
+    static ShaderManager* activeManager; /**< Gestor que recibe los programas nuevos */
+
+    static void assignSamplerUnits(GLuint program);
+};
+
+#endif // SHADER_MANAGER_H
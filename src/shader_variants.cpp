@@ -0,0 +1,133 @@
+// ShaderVariants.cpp
+
+#include "shader_variants.h"
+#include "shader_manager.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+uint32_t ShaderVariantKey::packed() const
+{
+    uint32_t lights = static_cast<uint32_t>(std::min(std::max(pointLights, 0), kMaxPointLights));
+    return lights
+         | (diffuseMap     ? 1u << 8  : 0u)
+         | (normalMap      ? 1u << 9  : 0u)
+         | (virtualTexture ? 1u << 10 : 0u)
+         | (fog            ? 1u << 11 : 0u)
+         | (shadows        ? 1u << 12 : 0u);
+}
+
+std::string ShaderVariantKey::defines() const
+{
+    std::string text = "#define NUM_POINT_LIGHTS " + std::to_string(std::min(std::max(pointLights, 0), kMaxPointLights)) + "\n";
+    if (diffuseMap)     text += "#define HAS_DIFFUSE_MAP\n";
+    if (normalMap)      text += "#define HAS_NORMAL_MAP\n";
+    if (virtualTexture) text += "#define VIRTUAL_TEXTURE\n";
+    if (fog)            text += "#define FOG\n";
+    if (shadows)        text += "#define SHADOWS\n";
+    return text;
+}
+
+ShaderVariants::ShaderVariants(const char* vertexPath, const char* fragmentPath)
+    : vertexPath(vertexPath), fragmentPath(fragmentPath)
+{
+}
+
+const Shader& ShaderVariants::get(const ShaderVariantKey& key)
+{
+    const uint32_t id = key.packed();
+    auto it = programs.find(id);
+    if (it != programs.end())
+    {
+        // Variants submitted during loading receive the frame state once they have linked
+        if (unsynced.count(id) && !it->second->isPending())
+        {
+            unsynced.erase(id);
+            for (const auto& [name, value] : shared)
+                applyShared(*it->second, name.c_str(), value);
+        }
+        return *it->second;
+    }
+
+    auto program = ShaderManager::create(vertexPath.c_str(), fragmentPath.c_str(), key.defines());
+    if (program->isPending())
+    {
+        // Querying uniform locations now would wait for the driver; sync on first use instead
+        unsynced.insert(id);
+        return *programs.emplace(id, std::move(program)).first->second;
+    }
+    if (program->ID == 0)
+        std::cerr << "Failed to build shader variant 0x" << std::hex << id << std::dec << ":\n" << key.defines() << std::endl;
+
+    // New variants start with the current frame state
+    for (const auto& [name, value] : shared)
+        applyShared(*program, name.c_str(), value);
+
+    return *programs.emplace(id, std::move(program)).first->second;
+}
+
+const Shader& ShaderVariants::use(const ShaderVariantKey& key)
+{
+    const Shader& program = get(key);
+    program.use();
+    return program;
+}
+
+void ShaderVariants::setInt(const char* name, int value)
+{
+    SharedUniform uniform{GL_INT, value, {}};
+    setShared(name, uniform);
+}
+
+void ShaderVariants::setFloat(const char* name, float value)
+{
+    SharedUniform uniform{GL_FLOAT, 0, {value}};
+    setShared(name, uniform);
+}
+
+void ShaderVariants::setVec3(const char* name, const glm::vec3& value)
+{
+    SharedUniform uniform{GL_FLOAT_VEC3, 0, {value.x, value.y, value.z}};
+    setShared(name, uniform);
+}
+
+void ShaderVariants::setMat4(const char* name, const glm::mat4& value)
+{
+    SharedUniform uniform{GL_FLOAT_MAT4, 0, {}};
+    std::memcpy(uniform.values, &value[0][0], sizeof(uniform.values));
+    setShared(name, uniform);
+}
+
+void ShaderVariants::setShared(const char* name, const SharedUniform& value)
+{
+    // Names are set every frame; only the first set of a name stores a copy
+    auto it = std::find_if(shared.begin(), shared.end(),
+                           [name](const auto& entry) { return entry.first == name; });
+    if (it != shared.end())
+        it->second = value;
+    else
+        shared.emplace_back(name, value);
+
+    for (const auto& entry : programs)
+        if (!unsynced.count(entry.first))
+            applyShared(*entry.second, name, value);
+}
+
+// glProgramUniform writes without binding, so every variant is updated in place
+void ShaderVariants::applyShared(const Shader& shader, const char* name, const SharedUniform& value)
+{
+    if (shader.ID == 0)
+        return;
+    GLint loc = glGetUniformLocation(shader.ID, name);
+    if (loc < 0)
+        return;
+
+    switch (value.type)
+    {
+        case GL_INT:        glProgramUniform1i(shader.ID, loc, value.intValue); break;
+        case GL_FLOAT:      glProgramUniform1f(shader.ID, loc, value.values[0]); break;
+        case GL_FLOAT_VEC3: glProgramUniform3fv(shader.ID, loc, 1, value.values); break;
+        case GL_FLOAT_MAT4: glProgramUniformMatrix4fv(shader.ID, loc, 1, GL_FALSE, value.values); break;
+        default: break;
+    }
+}
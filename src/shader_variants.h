@@ -0,0 +1,113 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "Shader.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+/**
+ * @struct ShaderVariantKey
+ * @brief Conjunto de características que especializa un programa en tiempo de compilación.
+ *
+ * Cada combinación se traduce a @c #define inyectados tras @c #version, de modo que el
+ * shader no ramifica en tiempo de ejecución ni declara samplers que el material no usa.
+ */
+struct ShaderVariantKey {
+    static constexpr int kMaxPointLights = 10; /**< Tope de luces puntuales por variante */
+
+    int pointLights = 0;          /**< Luces puntuales declaradas (NUM_POINT_LIGHTS); solo la primera ilumina */
+    bool diffuseMap = false;      /**< Muestrea texture_diffuse1 (HAS_DIFFUSE_MAP); si no, usa el color del vértice */
+    bool normalMap = false;       /**< Declara texture_normal1 (HAS_NORMAL_MAP); el shader aún no perturba la normal */
+    bool virtualTexture = false;  /**< Color desde la textura virtual del terreno (VIRTUAL_TEXTURE) */
+    bool fog = false;             /**< Niebla exponencial (FOG) */
+    bool shadows = false;         /**< Reservada para un pase de sombras (SHADOWS); el shader aún no la usa */
+
+    /**
+     * @brief Empaqueta la clave en un entero (identificador de la variante).
+     */
+    uint32_t packed() const;
+
+    /**
+     * @brief Genera las líneas @c #define de la variante.
+     */
+    std::string defines() const;
+};
+
+/**
+ * @class ShaderVariants
+ * @brief Familia de programas compilados a partir de los mismos archivos GLSL, uno por permutación.
+ *
+ * Las variantes se compilan la primera vez que se piden (o al precargarlas) y se reutilizan.
+ * Los uniforms comunes a todo el frame (cámara, luces) se fijan una sola vez con los
+ * setters de esta clase: se aplican a todas las variantes existentes con
+ * @c glProgramUniform y se guardan para aplicarlos también a las que se creen después.
+ *
+ * Durante la carga las variantes se crean con @ref ShaderManager::create sin esperar al
+ * driver; las que siguen compilando reciben los uniforms compartidos en su primer uso.
+ */
+class ShaderVariants {
+public:
+    /**
+     * @brief Constructor.
+     * @param vertexPath Ruta del shader de vértices.
+     * @param fragmentPath Ruta del shader de fragmentos.
+     */
+    ShaderVariants(const char* vertexPath, const char* fragmentPath);
+
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    /**
+     * @brief Obtiene (compilándola si hace falta) la variante de una clave.
+     * @param key Características de la variante.
+     * @return const Shader& Programa especializado.
+     */
+    const Shader& get(const ShaderVariantKey& key);
+
+    /**
+     * @brief Obtiene la variante de una clave y la activa.
+     * @param key Características de la variante.
+     * @return const Shader& Programa activo, para fijar los uniforms propios del objeto.
+     */
+    const Shader& use(const ShaderVariantKey& key);
+
+    /**
+     * @brief Número de variantes compiladas.
+     */
+    size_t size() const { return programs.size(); }
+
+    /// Uniforms compartidos por todas las variantes.
+    void setInt(const char* name, int value);
+    void setFloat(const char* name, float value);
+    void setVec3(const char* name, const glm::vec3& value);
+    void setMat4(const char* name, const glm::mat4& value);
+
+private:
+    /**
+     * @struct SharedUniform
+     * @brief Último valor fijado de un uniform compartido.
+     */
+    struct SharedUniform {
+        GLenum type;          /**< GL_INT, GL_FLOAT, GL_FLOAT_VEC3 o GL_FLOAT_MAT4 */
+        GLint intValue;       /**< Valor si es entero */
+        float values[16];     /**< Valor si es flotante (escalar, vec3 o mat4) */
+    };
+
+    std::string vertexPath;                                        /**< Ruta del shader de vértices */
+    std::string fragmentPath;                                      /**< Ruta del shader de fragmentos */
+    std::unordered_map<uint32_t, std::unique_ptr<Shader>> programs; /**< Variantes por clave empaquetada */
+    std::vector<std::pair<std::string, SharedUniform>> shared;      /**< Uniforms compartidos (pocos: búsqueda lineal sin reservas) */
+    std::unordered_set<uint32_t> unsynced;                          /**< Variantes creadas en compilación, sin uniforms compartidos */
+
+    void setShared(const char* name, const SharedUniform& value);
+    static void applyShared(const Shader& shader, const char* name, const SharedUniform& value);
+};
+
+#endif // SHADER_VARIANTS_H
@@ -0,0 +1,185 @@
+// Simulation.cpp
+
+#include "simulation.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+
+using Clock = std::chrono::steady_clock;
+
+static SimulationState stateOf(const Camera& camera, double time)
+{
+    SimulationState state;
+    state.time = time;
+    state.cameraPosition = camera.Position;
+    state.cameraYaw = camera.Yaw;
+    state.cameraPitch = camera.Pitch;
+    state.cameraZoom = camera.Zoom;
+    return state;
+}
+
+// The renderer has a valid snapshot before the first tick
+static FrameSnapshot initialSnapshot(const Camera& camera)
+{
+    FrameSnapshot snapshot;
+    snapshot.publishTime = Clock::now();
+    snapshot.previous = stateOf(camera, 0.0);
+    snapshot.current = snapshot.previous;
+    return snapshot;
+}
+
+Simulation::Simulation(const Camera& camera, double tickRate)
+    : camera(camera),
+      tickDuration(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / tickRate))),
+      running(false),
+      quit(false),
+      snapshots(initialSnapshot(camera)),
+      keyForward(false), keyBackward(false), keyLeft(false), keyRight(false),
+      firstMouse(true),
+      lastX(0.0), lastY(0.0),
+      tickIndex(0),
+      previousState(stateOf(camera, 0.0)),
+      state(previousState)
+{
+}
+
+Simulation::~Simulation()
+{
+    stop();
+}
+
+void Simulation::start()
+{
+    if (running.exchange(true))
+        return;
+    thread = std::thread(&Simulation::run, this);
+}
+
+void Simulation::stop()
+{
+    running.store(false);
+    if (thread.joinable())
+        thread.join();
+}
+
+bool Simulation::pushEvent(const InputEvent& event)
+{
+    return events.push(event);
+}
+
+const FrameSnapshot& Simulation::acquire()
+{
+    snapshots.update();
+    return snapshots.front();
+}
+
+SimulationState Simulation::interpolate(const FrameSnapshot& snapshot, Clock::time_point now) const
+{
+    // Past the end of the step the last tick is held until the simulation publishes again
+    const double elapsed = std::chrono::duration<double>(now - snapshot.publishTime).count();
+    const double step = std::chrono::duration<double>(tickDuration).count();
+    const float alpha = static_cast<float>(std::clamp(elapsed / step, 0.0, 1.0));
+
+    const SimulationState& a = snapshot.previous;
+    const SimulationState& b = snapshot.current;
+    SimulationState result;
+    result.time = a.time + (b.time - a.time) * alpha;
+    result.cameraPosition = a.cameraPosition + (b.cameraPosition - a.cameraPosition) * alpha;
+    result.cameraYaw = a.cameraYaw + (b.cameraYaw - a.cameraYaw) * alpha;
+    result.cameraPitch = a.cameraPitch + (b.cameraPitch - a.cameraPitch) * alpha;
+    result.cameraZoom = a.cameraZoom + (b.cameraZoom - a.cameraZoom) * alpha;
+    return result;
+}
+
+Camera Simulation::makeCamera(const SimulationState& state)
+{
+    Camera view(state.cameraPosition, glm::vec3(0.0f, 1.0f, 0.0f), state.cameraYaw, state.cameraPitch);
+    view.Zoom = state.cameraZoom;
+    return view;
+}
+
+void Simulation::run()
+{
+    const float deltaTime = std::chrono::duration<float>(tickDuration).count();
+    Clock::time_point nextTick = Clock::now();
+
+    while (running.load(std::memory_order_relaxed))
+    {
+        InputEvent event;
+        while (events.pop(event))
+            handleEvent(event);
+
+        tick(deltaTime);
+        publish();
+
+        // After a long hitch skip the missed ticks instead of replaying them in a burst
+        nextTick += tickDuration;
+        const Clock::time_point now = Clock::now();
+        if (now - nextTick > tickDuration * 5)
+            nextTick = now;
+        std::this_thread::sleep_until(nextTick);
+    }
+}
+
+void Simulation::handleEvent(const InputEvent& event)
+{
+    switch (event.type)
+    {
+        case InputEvent::Type::Key:
+        {
+            const bool down = event.action != GLFW_RELEASE;
+            switch (event.key)
+            {
+                case GLFW_KEY_W: keyForward = down; break;
+                case GLFW_KEY_S: keyBackward = down; break;
+                case GLFW_KEY_A: keyLeft = down; break;
+                case GLFW_KEY_D: keyRight = down; break;
+                case GLFW_KEY_ESCAPE:
+                    if (down && !quit.exchange(true))
+                        glfwPostEmptyEvent(); // wake the main thread so it closes the window
+                    break;
+                default: break;
+            }
+            break;
+        }
+        case InputEvent::Type::CursorPos:
+        {
+            if (firstMouse)
+            {
+                lastX = event.x;
+                lastY = event.y;
+                firstMouse = false;
+            }
+            float xoffset = static_cast<float>(event.x - lastX);
+            float yoffset = static_cast<float>(lastY - event.y);
+            lastX = event.x;
+            lastY = event.y;
+            camera.ProcessMouseMovement(xoffset, yoffset);
+            break;
+        }
+        case InputEvent::Type::Scroll:
+            camera.ProcessMouseScroll(static_cast<float>(event.y));
+            break;
+    }
+}
+
+void Simulation::tick(float deltaTime)
+{
+    if (keyForward)  camera.ProcessKeyboard(CameraMovement::FORWARD, deltaTime);
+    if (keyBackward) camera.ProcessKeyboard(CameraMovement::BACKWARD, deltaTime);
+    if (keyLeft)     camera.ProcessKeyboard(CameraMovement::LEFT, deltaTime);
+    if (keyRight)    camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);
+
+    ++tickIndex;
+    previousState = state;
+    state = stateOf(camera, tickIndex * static_cast<double>(deltaTime));
+}
+
+void Simulation::publish()
+{
+    FrameSnapshot& snapshot = snapshots.back();
+    snapshot.previous = previousState;
+    snapshot.tick = tickIndex;
+    snapshot.publishTime = Clock::now();
+    snapshot.current = state;
+    snapshots.publish();
+}
@@ -0,0 +1,158 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "Camera.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <glm/glm.hpp>
+
+/**
+ * @struct InputEvent
+ * @brief Evento de GLFW reenviado desde el hilo principal a la simulación.
+ */
+struct InputEvent {
+    /**
+     * @enum Type
+     * @brief Origen del evento.
+     */
+    enum class Type {
+        Key,        /**< Tecla: @c key y @c action de GLFW */
+        CursorPos,  /**< Posición del cursor: @c x, @c y */
+        Scroll      /**< Rueda del ratón: desplazamiento en @c y */
+    };
+
+    Type type = Type::Key;  /**< Origen del evento */
+    int key = 0;            /**< Código de tecla de GLFW */
+    int action = 0;         /**< GLFW_PRESS, GLFW_RELEASE o GLFW_REPEAT */
+    double x = 0.0;         /**< Cursor X */
+    double y = 0.0;         /**< Cursor Y o desplazamiento de la rueda */
+};
+
+/**
+ * @struct SimulationState
+ * @brief Estado de un tick de la simulación que necesita el render.
+ *
+ * El spotlight del faro y la animación dependen solo de @c time, así que interpolar el
+ * tiempo interpola también las luces.
+ */
+struct SimulationState {
+    double time = 0.0;                  /**< Tiempo de simulación en segundos */
+    glm::vec3 cameraPosition{0.0f};     /**< Posición de la cámara */
+    float cameraYaw = -90.0f;           /**< Yaw de la cámara (grados) */
+    float cameraPitch = 0.0f;           /**< Pitch de la cámara (grados) */
+    float cameraZoom = 45.0f;           /**< Campo de visión de la cámara (grados) */
+};
+
+/**
+ * @struct FrameSnapshot
+ * @brief Instantánea inmutable publicada por la simulación en cada tick.
+ *
+ * Lleva también el tick anterior para que el render interpole aunque se haya saltado
+ * publicaciones intermedias.
+ */
+struct FrameSnapshot {
+    uint64_t tick = 0;                                  /**< Número de tick */
+    std::chrono::steady_clock::time_point publishTime;  /**< Momento de la publicación */
+    SimulationState previous;                           /**< Estado del tick anterior */
+    SimulationState current;                            /**< Estado de este tick */
+};
+
+/**
+ * @class Simulation
+ * @brief Hilo de simulación a paso fijo, desacoplado del hilo de render y de los eventos de la ventana.
+ *
+ * El hilo principal reenvía los eventos de GLFW con @ref pushEvent a una cola sin bloqueos.
+ * La simulación los consume al inicio de cada tick, mueve la cámara y publica una
+ * @ref FrameSnapshot en un triple buffer. El render toma la última con @ref acquire y, con
+ * @ref interpolate, dibuja entre los dos últimos ticks: si la simulación se retrasa, el
+ * render sigue dibujando a su ritmo con el último estado.
+ */
+class Simulation {
+public:
+    /**
+     * @brief Constructor.
+     * @param camera Cámara inicial (la simulación se queda con una copia).
+     * @param tickRate Ticks por segundo.
+     */
+    explicit Simulation(const Camera& camera, double tickRate = 60.0);
+
+    /**
+     * @brief Destructor. Detiene el hilo si sigue en marcha.
+     */
+    ~Simulation();
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    /**
+     * @brief Arranca el hilo de simulación.
+     */
+    void start();
+
+    /**
+     * @brief Detiene el hilo de simulación y espera a que termine.
+     */
+    void stop();
+
+    /**
+     * @brief Reenvía un evento de entrada. Solo desde el hilo principal.
+     * @return false si la cola estaba llena y el evento se descartó.
+     */
+    bool pushEvent(const InputEvent& event);
+
+    /**
+     * @brief Indica si la simulación pidió cerrar la ventana (tecla Escape).
+     */
+    bool quitRequested() const { return quit.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Toma la instantánea más reciente. Solo desde el hilo de render.
+     * @return const FrameSnapshot& Instantánea en uso hasta la siguiente llamada.
+     */
+    const FrameSnapshot& acquire();
+
+    /**
+     * @brief Estado entre los dos ticks de una instantánea en un momento dado.
+     *
+     * El render dibuja un tick por detrás de la simulación: al publicarse la instantánea
+     * muestra el tick anterior y llega al actual un paso después.
+     *
+     * @param snapshot Instantánea tomada con @ref acquire.
+     * @param now Momento que se va a dibujar.
+     * @return SimulationState Estado interpolado.
+     */
+    SimulationState interpolate(const FrameSnapshot& snapshot, std::chrono::steady_clock::time_point now) const;
+
+    /**
+     * @brief Construye una cámara de render a partir de un estado.
+     */
+    static Camera makeCamera(const SimulationState& state);
+
+private:
+    Camera camera;                                   /**< Cámara simulada (solo hilo de simulación) */
+    std::chrono::steady_clock::duration tickDuration; /**< Duración de un tick */
+    std::thread thread;                              /**< Hilo de simulación */
+    std::atomic<bool> running;                       /**< El hilo debe seguir */
+    std::atomic<bool> quit;                          /**< Se pidió cerrar la ventana */
+    SpscQueue<InputEvent, 1024> events;              /**< Eventos del hilo principal */
+    TripleBuffer<FrameSnapshot> snapshots;           /**< Instantáneas hacia el render */
+
+    // Estado de entrada, solo del hilo de simulación
+    bool keyForward, keyBackward, keyLeft, keyRight;
+    bool firstMouse;
+    double lastX, lastY;
+    uint64_t tickIndex;
+    SimulationState previousState;   /**< Estado del tick anterior */
+    SimulationState state;           /**< Estado del último tick */
+
+    void run();
+    void handleEvent(const InputEvent& event);
+    void tick(float deltaTime);
+    void publish();
+};
+
+#endif // SIMULATION_H
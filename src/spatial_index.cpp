@@ -0,0 +1,484 @@
+// SpatialIndex.cpp
+
+#include "spatial_index.h"
+#include "job_system.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+
+namespace {
+
+constexpr uint32_t kMaxLeafSize = 4;
+
+// Queries per job in the batched calls: each one costs microseconds
+constexpr size_t kQueryGrain = 64;
+
+// A refit that grows the root box this much has smeared the tree; rebuild instead
+constexpr float kRefitDegradation = 2.0f;
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+float surfaceArea(const BvhNode& node)
+{
+    const glm::vec3 size = node.max - node.min;
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+// Splits a batch across the active job system, or runs it here without one
+void runBatch(size_t count, const std::function<void(size_t, size_t)>& fn)
+{
+    if (JobSystem* jobs = JobSystem::active())
+        jobs->parallelFor(0, count, kQueryGrain, fn);
+    else
+        fn(0, count);
+}
+
+// Ray parameter where a ray enters a sphere (0 from inside), or a negative value on a miss
+inline float intersectSphere(const Ray& ray, const glm::vec3& center, float radius)
+{
+    const glm::vec3 offset = ray.origin - center;
+    const float b = glm::dot(offset, ray.direction);
+    const float c = glm::dot(offset, offset) - radius * radius;
+    if (c <= 0.0f)
+        return 0.0f;
+    const float discriminant = b * b - c;
+    if (b > 0.0f || discriminant < 0.0f)
+        return -1.0f;
+    return -b - std::sqrt(discriminant);
+}
+
+enum class Containment { Outside, Partial, Inside };
+
+// Positive/negative vertex test of a box against every plane
+inline Containment classify(const Frustum& frustum, const BvhNode& node)
+{
+    Containment result = Containment::Inside;
+    for (const glm::vec4& plane : frustum.planes)
+    {
+        const glm::vec3 normal(plane);
+        const glm::vec3 farthest(normal.x >= 0.0f ? node.max.x : node.min.x, normal.y >= 0.0f ? node.max.y : node.min.y,
+                                 normal.z >= 0.0f ? node.max.z : node.min.z);
+        if (glm::dot(normal, farthest) + plane.w < 0.0f)
+            return Containment::Outside;
+        const glm::vec3 nearest(normal.x >= 0.0f ? node.min.x : node.max.x, normal.y >= 0.0f ? node.min.y : node.max.y,
+                                normal.z >= 0.0f ? node.min.z : node.max.z);
+        if (glm::dot(normal, nearest) + plane.w < 0.0f)
+            result = Containment::Partial;
+    }
+    return result;
+}
+
+} // namespace
+
+SpatialIndex::~SpatialIndex()
+{
+    waitRebuild();
+}
+
+void SpatialIndex::update(const EntityRegistry& registry)
+{
+    // A rebuild that finished since the last frame replaces what the queries read
+    if (rebuildSystem && rebuildJob.done())
+    {
+        rebuildSystem = nullptr;
+        publish();
+    }
+
+    // Renderables are the entities with a mesh and a bounding sphere
+    gatheredEntities.clear();
+    gatheredMeshes.clear();
+    boundsIndices.clear();
+    transformIndices.clear();
+    const MeshComponents& meshes = registry.meshes;
+    for (uint32_t i = 0; i < meshes.size(); ++i)
+    {
+        const Entity entity = meshes.entity(i);
+        const uint32_t b = registry.bounds.indexOf(entity, i);
+        if (b == ComponentSet::kNone)
+            continue;
+        gatheredEntities.push_back(entity);
+        gatheredMeshes.push_back(meshes.meshes[i]);
+        boundsIndices.push_back(b);
+        transformIndices.push_back(registry.transforms.indexOf(entity, i));
+    }
+
+    if (gatheredEntities == front->sourceEntities && gatheredMeshes == front->sourceMeshes && refit(registry))
+        return;
+
+    // One rebuild at a time; until it lands the published snapshot keeps answering
+    if (rebuildSystem)
+        return;
+    startRebuild(registry);
+}
+
+void SpatialIndex::startRebuild(const EntityRegistry& registry)
+{
+    // Everything the build needs is copied here, on the GL thread: the job never reads the
+    // registry or a Mesh, which may change or go away while it runs
+    Snapshot& next = *back;
+    const size_t count = gatheredEntities.size();
+    next.sourceEntities.assign(gatheredEntities.begin(), gatheredEntities.end());
+    next.sourceMeshes.assign(gatheredMeshes.begin(), gatheredMeshes.end());
+    next.sourceSpheres.resize(count);
+    next.worlds.resize(count);
+    next.sourceGeometry.resize(count);
+    next.sharedGeometry.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        next.sourceSpheres[i] = glm::vec4(registry.bounds.worldCenters[boundsIndices[i]], registry.bounds.worldRadii[boundsIndices[i]]);
+        next.worlds[i] = transformIndices[i] != ComponentSet::kNone ? registry.transforms.worlds[transformIndices[i]]
+                                                                    : glm::mat4(1.0f);
+        const Mesh* mesh = gatheredMeshes[i];
+        next.sourceGeometry[i] = mesh ? mesh->getCollision().get() : nullptr;
+        // Runs of one mesh are common; the job drops the remaining duplicates
+        if (next.sourceGeometry[i] && (next.sharedGeometry.empty() || next.sharedGeometry.back().get() != next.sourceGeometry[i]))
+            next.sharedGeometry.push_back(mesh->getCollision());
+    }
+
+    JobSystem* jobs = JobSystem::active();
+    if (!jobs || jobs->workerCount() == 0)
+    {
+        rebuild(next);
+        publish();
+        return;
+    }
+    // Scheduled after Render, while the workers are idle, so one of them takes it rather
+    // than a parallelFor wait on this thread in the next frame
+    rebuildSystem = jobs;
+    jobs->schedule([&next]() { rebuild(next); }, &rebuildJob);
+}
+
+void SpatialIndex::waitRebuild()
+{
+    if (!rebuildSystem)
+        return;
+    rebuildSystem->wait(rebuildJob, false);
+    rebuildSystem = nullptr;
+}
+
+void SpatialIndex::build(const Entity* objects, const glm::vec4* spheres, size_t count)
+{
+    // No meshes: the next update() from a registry never matches and rebuilds
+    waitRebuild();
+    Snapshot& next = *back;
+    next.sourceEntities.assign(objects, objects + count);
+    next.sourceMeshes.assign(count, nullptr);
+    next.sourceSpheres.assign(spheres, spheres + count);
+    next.worlds.assign(count, glm::mat4(1.0f));
+    next.sourceGeometry.assign(count, nullptr);
+    next.sharedGeometry.clear();
+    rebuild(next);
+    publish();
+}
+
+void SpatialIndex::publish()
+{
+    std::swap(front, back);
+    stats.objects = front->entities.size();
+    stats.nodes = front->nodes.size();
+    stats.depth = front->depth;
+    stats.meshes = front->sharedGeometry.size();
+    stats.buildMs = front->buildMs;
+    ++stats.builds;
+}
+
+void SpatialIndex::rebuild(Snapshot& snapshot)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const size_t count = snapshot.sourceEntities.size();
+
+    // Boxes around the world spheres, in pool order, drive the build
+    snapshot.boxMins.resize(count);
+    snapshot.boxMaxs.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const glm::vec4& sphere = snapshot.sourceSpheres[i];
+        snapshot.boxMins[i] = glm::vec3(sphere) - glm::vec3(sphere.w);
+        snapshot.boxMaxs[i] = glm::vec3(sphere) + glm::vec3(sphere.w);
+    }
+    snapshot.depth = Bvh::build(snapshot.boxMins.data(), snapshot.boxMaxs.data(), count, kMaxLeafSize, snapshot.nodes,
+                                snapshot.order, snapshot.bvhScratch);
+
+    // Snapshot in leaf order, so a leaf reads its objects from one contiguous run
+    snapshot.mins.resize(count);
+    snapshot.maxs.resize(count);
+    snapshot.centers.resize(count);
+    snapshot.radii.resize(count);
+    snapshot.entities.resize(count);
+    snapshot.geometry.resize(count);
+    snapshot.sources.swap(snapshot.order);
+    snapshot.slots.resize(count);
+    for (size_t slot = 0; slot < count; ++slot)
+    {
+        const uint32_t i = snapshot.sources[slot];
+        snapshot.mins[slot] = snapshot.boxMins[i];
+        snapshot.maxs[slot] = snapshot.boxMaxs[i];
+        snapshot.centers[slot] = glm::vec3(snapshot.sourceSpheres[i]);
+        snapshot.radii[slot] = snapshot.sourceSpheres[i].w;
+        snapshot.entities[slot] = snapshot.sourceEntities[i];
+        snapshot.geometry[slot] = snapshot.sourceGeometry[i];
+        // What refit compares against stays in pool order
+        snapshot.slots[i] = static_cast<uint32_t>(slot);
+    }
+
+    // One reference per distinct mesh keeps its geometry alive
+    std::vector<std::shared_ptr<const MeshCollision>>& shared = snapshot.sharedGeometry;
+    std::sort(shared.begin(), shared.end());
+    shared.erase(std::unique(shared.begin(), shared.end()), shared.end());
+
+    snapshot.builtArea = snapshot.nodes.empty() ? 0.0f : surfaceArea(snapshot.nodes[0]);
+    snapshot.buildMs = millisecondsSince(start);
+}
+
+bool SpatialIndex::refit(const EntityRegistry& registry)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Snapshot& snapshot = *front;
+
+    // Static scenes cost one in-order comparison per object; a spin in place changes only the matrix
+    const glm::mat4 identity(1.0f);
+    bool moved = false;
+    for (size_t i = 0; i < snapshot.sourceEntities.size(); ++i)
+    {
+        const glm::vec4 sphere(registry.bounds.worldCenters[boundsIndices[i]], registry.bounds.worldRadii[boundsIndices[i]]);
+        const glm::mat4& world = transformIndices[i] != ComponentSet::kNone ? registry.transforms.worlds[transformIndices[i]]
+                                                                            : identity;
+        if (sphere == snapshot.sourceSpheres[i] && world == snapshot.worlds[i])
+            continue;
+        snapshot.sourceSpheres[i] = sphere;
+        snapshot.worlds[i] = world;
+        const uint32_t slot = snapshot.slots[i];
+        snapshot.centers[slot] = glm::vec3(sphere);
+        snapshot.radii[slot] = sphere.w;
+        snapshot.mins[slot] = glm::vec3(sphere) - glm::vec3(sphere.w);
+        snapshot.maxs[slot] = glm::vec3(sphere) + glm::vec3(sphere.w);
+        moved = true;
+    }
+    if (!moved)
+        return true;
+
+    Bvh::refit(snapshot.nodes, snapshot.mins.data(), snapshot.maxs.data());
+    ++stats.refits;
+    stats.refitMs = millisecondsSince(start);
+    return snapshot.nodes.empty() || surfaceArea(snapshot.nodes[0]) <= snapshot.builtArea * kRefitDegradation;
+}
+
+bool SpatialIndex::raycast(const Ray& ray, RayHit& hit, bool exact) const
+{
+    hit = RayHit();
+    const Snapshot& snapshot = *front;
+    const std::vector<BvhNode>& nodes = snapshot.nodes;
+    if (nodes.empty())
+        return false;
+
+    float closest = ray.maxDistance;
+    const glm::vec3 inverseDirection = 1.0f / ray.direction;
+    uint32_t stack[Bvh::kMaxDepth];
+    float entries[Bvh::kMaxDepth];
+    uint32_t size = 0;
+    if (!Bvh::intersectRay(nodes[0], ray.origin, inverseDirection, closest, entries[0]))
+        return false;
+    stack[size++] = 0;
+    while (size > 0)
+    {
+        --size;
+        if (entries[size] > closest)
+            continue;
+        const BvhNode& node = nodes[stack[size]];
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i)
+            {
+                const float entry = intersectSphere(ray, snapshot.centers[i], snapshot.radii[i]);
+                if (entry < 0.0f || entry >= closest)
+                    continue;
+                if (!exact || !snapshot.geometry[i])
+                {
+                    closest = entry;
+                    hit.entity = snapshot.entities[i];
+                    hit.distance = entry;
+                    hit.triangle = RayHit::kNoTriangle;
+                    continue;
+                }
+
+                // Into mesh space: the unnormalized direction keeps distances in world units
+                const glm::mat4 inverse = glm::inverse(snapshot.worlds[snapshot.sources[i]]);
+                const glm::vec3 origin(inverse * glm::vec4(ray.origin, 1.0f));
+                const glm::vec3 direction(inverse * glm::vec4(ray.direction, 0.0f));
+                float distance = closest;
+                uint32_t triangle;
+                if (snapshot.geometry[i]->raycast(origin, direction, distance, triangle))
+                {
+                    closest = distance;
+                    hit.entity = snapshot.entities[i];
+                    hit.distance = distance;
+                    hit.triangle = triangle;
+                }
+            }
+            continue;
+        }
+
+        float leftEntry, rightEntry;
+        const bool left = Bvh::intersectRay(nodes[node.first], ray.origin, inverseDirection, closest, leftEntry);
+        const bool right = Bvh::intersectRay(nodes[node.first + 1], ray.origin, inverseDirection, closest, rightEntry);
+        if (left && right)
+        {
+            const bool leftFirst = leftEntry <= rightEntry;
+            stack[size] = leftFirst ? node.first + 1 : node.first;
+            entries[size++] = leftFirst ? rightEntry : leftEntry;
+            stack[size] = leftFirst ? node.first : node.first + 1;
+            entries[size++] = leftFirst ? leftEntry : rightEntry;
+        }
+        else if (left || right)
+        {
+            stack[size] = left ? node.first : node.first + 1;
+            entries[size++] = left ? leftEntry : rightEntry;
+        }
+    }
+    return hit.hit();
+}
+
+void SpatialIndex::raycast(const Ray* rays, size_t count, RayHit* hits, bool exact) const
+{
+    runBatch(count, [this, rays, hits, exact](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            raycast(rays[i], hits[i], exact);
+    });
+}
+
+void SpatialIndex::overlapSphere(const glm::vec3& center, float radius, std::vector<Entity>& out) const
+{
+    const Snapshot& snapshot = *front;
+    const std::vector<BvhNode>& nodes = snapshot.nodes;
+    if (nodes.empty())
+        return;
+
+    uint32_t stack[Bvh::kMaxDepth];
+    uint32_t size = 0;
+    stack[size++] = 0;
+    while (size > 0)
+    {
+        const BvhNode& node = nodes[stack[--size]];
+        if (!Bvh::overlapsSphere(node, center, radius))
+            continue;
+        if (node.count == 0)
+        {
+            stack[size++] = node.first;
+            stack[size++] = node.first + 1;
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; ++i)
+        {
+            const glm::vec3 offset = snapshot.centers[i] - center;
+            const float reach = snapshot.radii[i] + radius;
+            if (glm::dot(offset, offset) <= reach * reach)
+                out.push_back(snapshot.entities[i]);
+        }
+    }
+}
+
+void SpatialIndex::overlapSpheres(const glm::vec3* queryCenters, const float* queryRadii, size_t count,
+                                  std::vector<std::vector<Entity>>& results) const
+{
+    results.resize(count);
+    runBatch(count, [this, queryCenters, queryRadii, &results](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            results[i].clear();
+            overlapSphere(queryCenters[i], queryRadii[i], results[i]);
+        }
+    });
+}
+
+void SpatialIndex::overlapFrustum(const Frustum& frustum, std::vector<Entity>& out) const
+{
+    const Snapshot& snapshot = *front;
+    const std::vector<BvhNode>& nodes = snapshot.nodes;
+    if (nodes.empty())
+        return;
+
+    uint32_t stack[Bvh::kMaxDepth];
+    uint32_t size = 0;
+    stack[size++] = 0;
+    while (size > 0)
+    {
+        const uint32_t index = stack[--size];
+        const BvhNode& node = nodes[index];
+        const Containment containment = classify(frustum, node);
+        if (containment == Containment::Outside)
+            continue;
+        if (containment == Containment::Inside)
+        {
+            uint32_t first, end;
+            subtreeRange(nodes, index, first, end);
+            out.insert(out.end(), snapshot.entities.begin() + first, snapshot.entities.begin() + end);
+            continue;
+        }
+        if (node.count == 0)
+        {
+            stack[size++] = node.first;
+            stack[size++] = node.first + 1;
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; ++i)
+        {
+            if (frustum.intersectsSphere(snapshot.centers[i], snapshot.radii[i]))
+                out.push_back(snapshot.entities[i]);
+        }
+    }
+}
+
+void SpatialIndex::overlapFrusta(const Frustum* frusta, size_t count, std::vector<std::vector<Entity>>& results) const
+{
+    results.resize(count);
+    runBatch(count, [this, frusta, &results](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            results[i].clear();
+            overlapFrustum(frusta[i], results[i]);
+        }
+    });
+}
+
+// Leaves of a subtree are contiguous: the leftmost leaf starts the run, the rightmost ends it
+void SpatialIndex::subtreeRange(const std::vector<BvhNode>& nodes, uint32_t node, uint32_t& first, uint32_t& end)
+{
+    uint32_t leftmost = node;
+    while (nodes[leftmost].count == 0)
+        leftmost = nodes[leftmost].first;
+    uint32_t rightmost = node;
+    while (nodes[rightmost].count == 0)
+        rightmost = nodes[rightmost].first + 1;
+    first = nodes[leftmost].first;
+    end = nodes[rightmost].first + nodes[rightmost].count;
+}
+
+SpatialIndexStats SpatialIndex::getStats() const
+{
+    SpatialIndexStats current = stats;
+    current.meshTrees = 0;
+    current.meshTreeBytes = 0;
+    for (const std::shared_ptr<const MeshCollision>& collision : front->sharedGeometry)
+    {
+        if (collision->isBuilt())
+        {
+            ++current.meshTrees;
+            current.meshTreeBytes += collision->treeBytes();
+        }
+    }
+    return current;
+}
+
+void SpatialIndex::report(std::ostream& out) const
+{
+    const SpatialIndexStats current = getStats();
+    out << "Spatial index: " << current.objects << " objects, " << current.nodes << " nodes, depth " << current.depth
+        << "; " << current.builds << " builds (last " << current.buildMs << " ms), " << current.refits
+        << " refits (last " << current.refitMs << " ms)" << std::endl;
+    out << "  " << current.meshTrees << " of " << current.meshes << " meshes with a triangle BVH ("
+        << (current.meshTreeBytes >> 10) << " KB)" << std::endl;
+}
@@ -0,0 +1,272 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include "bvh.h"
+#include "entity_registry.h"
+#include "job_system.h"
+#include "mesh_collision.h"
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @struct Ray
+ * @brief Rayo de una consulta de @ref SpatialIndex.
+ */
+struct Ray {
+    glm::vec3 origin;       /**< Origen en el mundo */
+    glm::vec3 direction;    /**< Dirección normalizada (las distancias se miden en ella) */
+    float maxDistance = std::numeric_limits<float>::max(); /**< Distancia máxima */
+};
+
+/**
+ * @struct RayHit
+ * @brief Objeto más cercano que corta un rayo.
+ */
+struct RayHit {
+    static constexpr uint32_t kNoTriangle = 0xFFFFFFFFu;
+
+    Entity entity;                      /**< Entidad cortada (inválida si no hay corte) */
+    float distance = 0.0f;              /**< Distancia al corte */
+    uint32_t triangle = kNoTriangle;    /**< Triángulo cortado, o kNoTriangle si el corte es con la esfera envolvente */
+
+    /**
+     * @brief Indica si el rayo cortó algo.
+     */
+    bool hit() const { return entity.valid(); }
+};
+
+/**
+ * @struct SpatialIndexStats
+ * @brief Tamaño y coste de mantenimiento del índice espacial.
+ */
+struct SpatialIndexStats {
+    size_t objects = 0;         /**< Objetos indexados */
+    size_t nodes = 0;           /**< Nodos del BVH de objetos */
+    uint32_t depth = 0;         /**< Profundidad del BVH de objetos */
+    size_t meshes = 0;          /**< Mallas distintas con geometría en CPU */
+    size_t meshTrees = 0;       /**< De ellas, con BVH de triángulos ya construido */
+    size_t meshTreeBytes = 0;   /**< Bytes de esos BVH */
+    uint64_t builds = 0;        /**< Reconstrucciones completas */
+    uint64_t refits = 0;        /**< Reajustes de cajas sin reconstruir */
+    double buildMs = 0.0;       /**< Duración de la última reconstrucción */
+    double refitMs = 0.0;       /**< Duración del último reajuste */
+};
+
+/**
+ * @class SpatialIndex
+ * @brief BVH sobre las esferas envolventes de los objetos dibujables para consultas de rayo, esfera y frustum.
+ *
+ * @ref update toma una instantánea de las entidades con malla y esfera del registro. Si
+ * el conjunto de entidades no cambió solo reajusta, en el momento, las cajas de las que se
+ * movieron; si cambió, reconstruye el BVH (SAH con cubos) en una tarea del @ref JobSystem
+ * activo sobre una segunda instantánea, y un @ref update posterior la publica cuando la
+ * tarea termina. Mientras tanto las consultas siguen viendo la instantánea anterior, que
+ * puede ir unos frames por detrás del registro (entidades ya destruidas incluidas). Sin
+ * sistema activo, o sin trabajadores, la reconstrucción se hace dentro de @ref update.
+ *
+ * Hilos: las consultas leen únicamente la instantánea publicada, así que pueden hacerse
+ * desde cualquier número de hilos a la vez, también mientras la reconstrucción avanza en
+ * segundo plano (no la toca). Lo único que no puede solaparse con ellas es la llamada a
+ * @ref update (o @ref build), que reajusta y publica la instantánea en el hilo de OpenGL:
+ * hay que consultar desde ese hilo entre dos llamadas o desde tareas que terminen antes de
+ * la siguiente. El registro puede cambiar entretanto sin afectarlas.
+ *
+ * Los rayos exactos se refinan contra los triángulos: el rayo pasa a espacio de la malla y
+ * recorre el BVH de triángulos de su @ref MeshCollision, que se construye la primera vez
+ * que un rayo llega a esa malla. La instantánea comparte la geometría de las mallas, que
+ * sigue viva aunque la malla se descargue antes de que se publique otra.
+ */
+class SpatialIndex {
+public:
+    SpatialIndex() = default;
+
+    /**
+     * @brief Destructor. Espera a la reconstrucción en curso, si la hay.
+     */
+    ~SpatialIndex();
+
+    SpatialIndex(const SpatialIndex&) = delete;
+    SpatialIndex& operator=(const SpatialIndex&) = delete;
+
+    /**
+     * @brief Actualiza la instantánea con las esferas del mundo del último @ref EntityRegistry::update. Hilo de OpenGL.
+     *
+     * Publica la reconstrucción terminada, si la hay; reajusta la instantánea publicada o,
+     * si el conjunto de entidades cambió, lanza una reconstrucción (solo una a la vez).
+     *
+     * @param registry Registro de la escena.
+     */
+    void update(const EntityRegistry& registry);
+
+    /**
+     * @brief Reconstruye la instantánea desde esferas sueltas, sin registro ni mallas, y la publica.
+     *
+     * Síncrona: espera a la reconstrucción en curso y descarta su resultado. Los rayos solo
+     * llegan a la esfera envolvente (@ref RayHit::triangle queda en @ref RayHit::kNoTriangle).
+     * El siguiente @ref update desde un registro la reconstruye.
+     *
+     * @param objects Entidad de cada objeto.
+     * @param spheres Centro (xyz) y radio (w) en el mundo de cada objeto.
+     * @param count Número de objetos.
+     */
+    void build(const Entity* objects, const glm::vec4* spheres, size_t count);
+
+    /**
+     * @brief Objetos indexados.
+     */
+    size_t size() const { return front->entities.size(); }
+
+    /**
+     * @brief Objeto más cercano que corta un rayo.
+     * @param ray Rayo.
+     * @param hit Resultado.
+     * @param exact Refina contra los triángulos de las mallas con geometría en CPU; si no, basta la esfera.
+     * @return true si hay corte.
+     */
+    bool raycast(const Ray& ray, RayHit& hit, bool exact = true) const;
+
+    /**
+     * @brief Lote de rayos, repartido entre los trabajadores del @ref JobSystem activo.
+     * @param rays Rayos.
+     * @param count Número de rayos.
+     * @param hits Resultado de cada rayo (@p count elementos).
+     * @param exact Como en @ref raycast.
+     */
+    void raycast(const Ray* rays, size_t count, RayHit* hits, bool exact = true) const;
+
+    /**
+     * @brief Añade a @p out los objetos cuya esfera envolvente toca una esfera.
+     * @param center Centro en el mundo.
+     * @param radius Radio.
+     * @param out Entidades encontradas (se añaden sin vaciar el vector).
+     */
+    void overlapSphere(const glm::vec3& center, float radius, std::vector<Entity>& out) const;
+
+    /**
+     * @brief Lote de consultas de esfera, repartido entre los trabajadores.
+     * @param centers Centros.
+     * @param radii Radios.
+     * @param count Número de consultas.
+     * @param results Entidades de cada consulta (se redimensiona a @p count).
+     */
+    void overlapSpheres(const glm::vec3* centers, const float* radii, size_t count,
+                        std::vector<std::vector<Entity>>& results) const;
+
+    /**
+     * @brief Añade a @p out los objetos cuya esfera envolvente toca un frustum.
+     *
+     * Los subárboles enteros dentro del frustum se añaden sin probar cada objeto.
+     *
+     * @param frustum Planos del volumen.
+     * @param out Entidades encontradas (se añaden sin vaciar el vector).
+     */
+    void overlapFrustum(const Frustum& frustum, std::vector<Entity>& out) const;
+
+    /**
+     * @brief Lote de consultas de frustum, repartido entre los trabajadores.
+     * @param frusta Volúmenes.
+     * @param count Número de consultas.
+     * @param results Entidades de cada consulta (se redimensiona a @p count).
+     */
+    void overlapFrusta(const Frustum* frusta, size_t count, std::vector<std::vector<Entity>>& results) const;
+
+    /**
+     * @brief Devuelve los contadores; los de los BVH de triángulos se recalculan al llamar.
+     */
+    SpatialIndexStats getStats() const;
+
+    /**
+     * @brief Escribe tamaño, profundidad y coste de mantenimiento del índice.
+     * @param out Flujo de salida.
+     */
+    void report(std::ostream& out) const;
+
+private:
+    /**
+     * @struct Snapshot
+     * @brief BVH de objetos y copia de sus datos; el índice alterna entre dos.
+     */
+    struct Snapshot {
+        std::vector<BvhNode> nodes;                 /**< BVH de objetos */
+
+        // En el orden de hojas del BVH
+        std::vector<glm::vec3> mins;                /**< Esquina mínima de la caja de cada esfera */
+        std::vector<glm::vec3> maxs;                /**< Esquina máxima */
+        std::vector<glm::vec3> centers;             /**< Centro de la esfera en el mundo */
+        std::vector<float> radii;                   /**< Radio de la esfera en el mundo */
+        std::vector<Entity> entities;               /**< Entidad de cada objeto */
+        std::vector<const MeshCollision*> geometry; /**< Geometría en CPU de su malla (puede ser nula) */
+        std::vector<uint32_t> sources;              /**< Posición del objeto en el orden del registro */
+
+        // En el orden del pool de mallas: el reajuste la compara en línea con el registro
+        std::vector<Entity> sourceEntities;         /**< Entidades */
+        std::vector<const Mesh*> sourceMeshes;      /**< Malla de cada una */
+        std::vector<glm::vec4> sourceSpheres;       /**< Centro y radio en el mundo */
+        std::vector<glm::mat4> worlds;              /**< Matriz de modelo (solo la leen los rayos exactos) */
+        std::vector<const MeshCollision*> sourceGeometry; /**< Geometría de cada una, tomada en el hilo de OpenGL */
+        std::vector<uint32_t> slots;                /**< Posición en el orden de hojas de cada una */
+        std::vector<std::shared_ptr<const MeshCollision>> sharedGeometry; /**< Mantiene viva la geometría referenciada */
+        float builtArea = 0.0f;                     /**< Área de la raíz al reconstruir (el reajuste la degrada) */
+        uint32_t depth = 0;                         /**< Profundidad del BVH */
+        double buildMs = 0.0;                       /**< Duración de la reconstrucción */
+
+        // Auxiliares de la reconstrucción: conservan su capacidad entre una y otra
+        std::vector<glm::vec3> boxMins;             /**< Caja de cada esfera, en el orden del pool */
+        std::vector<glm::vec3> boxMaxs;             /**< Esquina máxima */
+        std::vector<uint32_t> order;                /**< Orden de hojas que devuelve el BVH */
+        BvhBuildScratch bvhScratch;                 /**< Memoria de @ref Bvh::build */
+    };
+
+    Snapshot snapshots[2];
+    Snapshot* front = &snapshots[0];            /**< Instantánea publicada: la que leen las consultas */
+    Snapshot* back = &snapshots[1];             /**< Instantánea que se reconstruye */
+    JobCounter rebuildJob;                      /**< Reconstrucción en segundo plano */
+    JobSystem* rebuildSystem = nullptr;         /**< Sistema que la ejecuta (nulo si no hay ninguna en curso) */
+
+    // Auxiliares de @ref update (solo el hilo de OpenGL)
+    std::vector<Entity> gatheredEntities;       /**< Entidades dibujables del registro */
+    std::vector<const Mesh*> gatheredMeshes;    /**< Sus mallas */
+    std::vector<uint32_t> boundsIndices;        /**< Su índice en el pool de esferas */
+    std::vector<uint32_t> transformIndices;     /**< Su índice en el pool de transformaciones */
+
+    SpatialIndexStats stats;                    /**< Contadores (solo el hilo de OpenGL) */
+
+    /**
+     * @brief Lanza la reconstrucción de @c back con lo recogido por @ref update, o la hace aquí sin trabajadores.
+     */
+    void startRebuild(const EntityRegistry& registry);
+
+    /**
+     * @brief Espera a la reconstrucción en curso, si la hay.
+     */
+    void waitRebuild();
+
+    /**
+     * @brief Publica @c back: pasa a ser la instantánea de las consultas.
+     */
+    void publish();
+
+    /**
+     * @brief Reconstruye el BVH y el orden de hojas de una instantánea desde sus datos en orden del pool.
+     *
+     * No lee el registro ni las mallas, así que puede ejecutarse en cualquier hilo.
+     */
+    static void rebuild(Snapshot& snapshot);
+
+    /**
+     * @brief Copia las esferas que cambiaron en la instantánea publicada y reajusta sus cajas.
+     * @return false si el reajuste degradó el BVH y conviene reconstruirlo.
+     */
+    bool refit(const EntityRegistry& registry);
+
+    /**
+     * @brief Rango del orden de hojas que cubre el subárbol de un nodo.
+     */
+    static void subtreeRange(const std::vector<BvhNode>& nodes, uint32_t node, uint32_t& first, uint32_t& end);
+};
+
+#endif // SPATIAL_INDEX_H
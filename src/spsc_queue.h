@@ -0,0 +1,57 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @class SpscQueue
+ * @brief Cola circular sin bloqueos para un único productor y un único consumidor.
+ *
+ * El productor solo escribe @c tail y el consumidor solo escribe @c head, de modo que
+ * basta con pares acquire/release sobre los índices; ningún hilo espera al otro.
+ *
+ * @tparam T Tipo de los elementos (copiable).
+ * @tparam Capacity Número de elementos; debe ser potencia de dos.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    /**
+     * @brief Añade un elemento. Solo desde el hilo productor.
+     * @return false si la cola está llena (el elemento se descarta).
+     */
+    bool push(const T& item)
+    {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity)
+            return false;
+        items[t & (Capacity - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Extrae el elemento más antiguo. Solo desde el hilo consumidor.
+     * @return false si la cola está vacía.
+     */
+    bool pop(T& item)
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        item = items[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<T, Capacity> items{};            /**< Almacenamiento circular */
+    alignas(64) std::atomic<size_t> head{0};    /**< Siguiente elemento a leer (consumidor) */
+    alignas(64) std::atomic<size_t> tail{0};    /**< Siguiente hueco a escribir (productor) */
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,134 @@
+// TaskGraph.cpp
+
+#include "task_graph.h"
+#include "job_system.h"
+#include <algorithm>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+TaskGraph::TaskGraph() = default;
+TaskGraph::~TaskGraph()
+{
+    // Tasks still in flight reference the nodes
+    if (pending)
+        finish();
+}
+
+TaskGraph::TaskId TaskGraph::add(const std::string& name, std::function<void()> fn, TaskAffinity affinity,
+                                 std::initializer_list<TaskId> dependencies)
+{
+    const TaskId id = nodes.size();
+    auto node = std::make_unique<Node>();
+    node->name = name;
+    node->fn = std::move(fn);
+    node->affinity = affinity;
+    nodes.push_back(std::move(node));
+    for (TaskId dependency : dependencies)
+        addDependency(id, dependency);
+    return id;
+}
+
+void TaskGraph::addDependency(TaskId task, TaskId dependency)
+{
+    // Dependencies on earlier tasks only: insertion order stays topological and no cycle can form
+    if (task >= nodes.size() || dependency >= task)
+    {
+        std::cerr << "TaskGraph: invalid dependency " << dependency << " for task " << task << std::endl;
+        return;
+    }
+    nodes[task]->dependencies.push_back(dependency);
+    nodes[dependency]->successors.push_back(task);
+}
+
+void TaskGraph::execute(Node& node)
+{
+    const Clock::time_point start = Clock::now();
+    if (node.fn)
+        node.fn();
+    const Clock::time_point end = Clock::now();
+    node.durationMs = std::chrono::duration<double, std::milli>(end - start).count();
+    node.endMs = std::chrono::duration<double, std::milli>(end - startTime).count();
+}
+
+// Runs a node on the right thread, then releases every successor whose last dependency it was
+void TaskGraph::submit(JobSystem& jobs, TaskId id)
+{
+    Node& node = *nodes[id];
+    auto task = [this, &jobs, &node]() {
+        execute(node);
+        for (TaskId successor : node.successors)
+        {
+            if (nodes[successor]->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                submit(jobs, successor);
+        }
+        // Successors are already counted in pending, so the graph cannot look finished early
+        completed.fetch_add(1, std::memory_order_release);
+    };
+    if (node.affinity == TaskAffinity::GLThread)
+        jobs.scheduleOnGLThread(task, pending.get());
+    else
+        jobs.schedule(task, pending.get());
+}
+
+void TaskGraph::start()
+{
+    if (pending)
+        finish();
+
+    startTime = Clock::now();
+    completed.store(0, std::memory_order_relaxed);
+
+    JobSystem* jobs = JobSystem::active();
+    if (!jobs)
+    {
+        for (auto& node : nodes)
+        {
+            execute(*node);
+            completed.fetch_add(1, std::memory_order_release);
+        }
+        return;
+    }
+
+    pending = std::make_unique<JobCounter>();
+    for (auto& node : nodes)
+        node->remaining.store(static_cast<int>(node->dependencies.size()), std::memory_order_relaxed);
+    for (TaskId id = 0; id < nodes.size(); ++id)
+    {
+        if (nodes[id]->dependencies.empty())
+            submit(*jobs, id);
+    }
+}
+
+const TaskGraphStats& TaskGraph::finish()
+{
+    if (pending)
+    {
+        // Waiting from the GL thread also runs the GL-pinned tasks
+        if (JobSystem* jobs = JobSystem::active())
+            jobs->wait(*pending);
+        pending.reset();
+    }
+
+    // Longest chain of durations through the dependencies; insertion order is topological
+    std::vector<double> finishMs(nodes.size(), 0.0);
+    stats = TaskGraphStats();
+    stats.tasks = nodes.size();
+    for (TaskId id = 0; id < nodes.size(); ++id)
+    {
+        double ready = 0.0;
+        for (TaskId dependency : nodes[id]->dependencies)
+            ready = std::max(ready, finishMs[dependency]);
+        finishMs[id] = ready + nodes[id]->durationMs;
+        stats.criticalPathMs = std::max(stats.criticalPathMs, finishMs[id]);
+        stats.totalTaskMs += nodes[id]->durationMs;
+        stats.wallMs = std::max(stats.wallMs, nodes[id]->endMs);
+    }
+    return stats;
+}
+
+const TaskGraphStats& TaskGraph::run()
+{
+    start();
+    return finish();
+}
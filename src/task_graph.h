@@ -0,0 +1,143 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+class JobSystem;
+class JobCounter;
+
+/**
+ * @enum TaskAffinity
+ * @brief Hilo en el que puede ejecutarse una tarea del grafo.
+ */
+enum class TaskAffinity {
+    Any,        /**< Cualquier trabajador (lectura de archivos, decodificación, generación de mallas) */
+    GLThread    /**< Solo el hilo con el contexto OpenGL (subidas, creación de objetos, shaders) */
+};
+
+/**
+ * @struct TaskGraphStats
+ * @brief Tiempos de la última ejecución de un @ref TaskGraph.
+ */
+struct TaskGraphStats {
+    size_t tasks = 0;            /**< Tareas ejecutadas */
+    double wallMs = 0.0;         /**< Duración real de @ref TaskGraph::run */
+    double criticalPathMs = 0.0; /**< Cadena de dependencias más larga (cota inferior de wallMs) */
+    double totalTaskMs = 0.0;    /**< Suma de las duraciones (lo que tardaría en serie) */
+};
+
+/**
+ * @class TaskGraph
+ * @brief Grafo acíclico de tareas con dependencias, ejecutado sobre el @ref JobSystem activo.
+ *
+ * Cada tarea se lanza en cuanto terminan todas sus dependencias; las tareas de
+ * @ref TaskAffinity::GLThread se encolan para el hilo de OpenGL, que las ejecuta mientras
+ * espera en @ref run. Así la duración total se acerca a la del camino crítico en lugar de
+ * a la suma de todos los pasos. Sin sistema de tareas activo se ejecuta en serie, en orden
+ * de inserción.
+ *
+ * Las dependencias solo pueden apuntar a tareas añadidas antes, lo que garantiza que el
+ * grafo es acíclico y que el orden de inserción es un orden topológico válido.
+ */
+class TaskGraph {
+public:
+    using TaskId = size_t;
+
+    TaskGraph();
+    ~TaskGraph();
+
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    /**
+     * @brief Añade una tarea.
+     *
+     * @param name Nombre para diagnóstico.
+     * @param fn Trabajo de la tarea.
+     * @param affinity Hilo en el que debe ejecutarse.
+     * @param dependencies Tareas (ya añadidas) que deben terminar antes.
+     * @return TaskId Identificador para usar como dependencia.
+     */
+    TaskId add(const std::string& name, std::function<void()> fn, TaskAffinity affinity = TaskAffinity::Any,
+               std::initializer_list<TaskId> dependencies = {});
+
+    /**
+     * @brief Añade una dependencia a una tarea ya creada.
+     * @param task Tarea que espera.
+     * @param dependency Tarea anterior a @p task.
+     */
+    void addDependency(TaskId task, TaskId dependency);
+
+    /**
+     * @brief Ejecuta el grafo y espera a que termine. Debe llamarse desde el hilo de OpenGL.
+     * @return const TaskGraphStats& Tiempos de la ejecución.
+     */
+    const TaskGraphStats& run();
+
+    /**
+     * @brief Lanza las tareas sin dependencias y vuelve sin esperar.
+     *
+     * Las tareas de OpenGL se ejecutan cuando el hilo de OpenGL llama a
+     * @ref JobSystem::runGLJobs (una vez por frame en el bucle de render). Sin sistema de
+     * tareas activo el grafo se ejecuta completo antes de volver.
+     */
+    void start();
+
+    /**
+     * @brief Indica si todas las tareas lanzadas por @ref start han terminado.
+     */
+    bool isFinished() const { return completed.load(std::memory_order_acquire) == nodes.size(); }
+
+    /**
+     * @brief Tareas terminadas desde el último @ref start.
+     */
+    size_t completedCount() const { return completed.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Espera a que termine la ejecución lanzada por @ref start y calcula sus tiempos.
+     *
+     * Desde el hilo de OpenGL, la espera ejecuta también las tareas fijadas a él.
+     *
+     * @return const TaskGraphStats& Tiempos de la ejecución.
+     */
+    const TaskGraphStats& finish();
+
+    /**
+     * @brief Número de tareas del grafo.
+     */
+    size_t size() const { return nodes.size(); }
+
+private:
+    /**
+     * @struct Node
+     * @brief Tarea del grafo y su estado de ejecución.
+     */
+    struct Node {
+        std::string name;                  /**< Nombre para diagnóstico */
+        std::function<void()> fn;          /**< Trabajo */
+        TaskAffinity affinity;             /**< Hilo permitido */
+        std::vector<TaskId> dependencies;  /**< Tareas anteriores */
+        std::vector<TaskId> successors;    /**< Tareas que esperan a esta */
+        std::atomic<int> remaining{0};     /**< Dependencias sin terminar en la ejecución actual */
+        double durationMs = 0.0;           /**< Duración de la última ejecución */
+        double endMs = 0.0;                /**< Fin de la última ejecución, desde @ref start */
+    };
+
+    std::vector<std::unique_ptr<Node>> nodes; /**< Tareas en orden de inserción */
+    TaskGraphStats stats;                     /**< Tiempos de la última ejecución */
+    std::unique_ptr<JobCounter> pending;      /**< Tareas lanzadas sin terminar (con sistema de tareas) */
+    std::atomic<size_t> completed{0};         /**< Tareas terminadas en la ejecución actual */
+    std::chrono::steady_clock::time_point startTime; /**< Inicio de la ejecución actual */
+
+    void execute(Node& node);
+    void submit(JobSystem& jobs, TaskId id);
+};
+
+#endif // TASK_GRAPH_H
@@ -1,136 +1,343 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include "Texture.h"
+#include "mip_builder.h"
+#include "asset_pack.h"
+#include "texture_streamer.h"
 #include <iostream>
+#include <algorithm>
 
 // Make sure no other file includes STB_IMAGE_IMPLEMENTATION
 
 Texture::Texture(const std::string& path, const std::string& type)
-    : id(0), type(type), path(path)
+    : id(0), internalFormat(0), width(0), height(0), mipLevels(0), type(type), path(path),
+      prepared(false), prepareFailed(false)
 {}
 
 Texture::Texture(const std::vector<std::string>& paths, const std::string& type)
-    : id(0), type(type), paths(paths)
+    : id(0), internalFormat(0), width(0), height(0), mipLevels(0), type(type), paths(paths),
+      prepared(false), prepareFailed(false)
 {}
 
 Texture::~Texture()
 {
-    if (id != 0) {
-        glDeleteTextures(1, &id);
-    }
+    // Retired after the frame's fence; the streamer forgets it then
+    GLResourceManager::deleteTexture(id, storageDesc());
 }
 
 Texture::Texture(Texture&& other) noexcept
-    : id(other.id), type(std::move(other.type)), path(std::move(other.path)), paths(std::move(other.paths))
+    : id(other.id), internalFormat(other.internalFormat), width(other.width), height(other.height),
+      mipLevels(other.mipLevels), type(std::move(other.type)), path(std::move(other.path)), paths(std::move(other.paths)),
+      staged(std::move(other.staged)), prepared(other.prepared), prepareFailed(other.prepareFailed)
 {
     other.id = 0;
+    other.prepared = false;
+    other.prepareFailed = false;
 }
 
 Texture& Texture::operator=(Texture&& other) noexcept
 {
     if (this != &other)
     {
-        if (id != 0)
-        {
-            glDeleteTextures(1, &id);
-        }
+        GLResourceManager::deleteTexture(id, storageDesc());
 
         id = other.id;
+        internalFormat = other.internalFormat;
+        width = other.width;
+        height = other.height;
+        mipLevels = other.mipLevels;
         type = std::move(other.type);
         path = std::move(other.path);
         paths = std::move(other.paths);
+        staged = std::move(other.staged);
+        prepared = other.prepared;
+        prepareFailed = other.prepareFailed;
 
         other.id = 0;
+        other.prepared = false;
+        other.prepareFailed = false;
     }
     return *this;
 }
 
-bool Texture::load()
+GLsizei Texture::mipLevelCount(GLsizei width, GLsizei height)
 {
-    glGenTextures(1, &id);
-    int width, height, nrComponents;
-    bool isHDR = false;
+    GLsizei levels = 1;
+    GLsizei size = std::max(width, height);
+    while (size > 1)
+    {
+        size >>= 1;
+        ++levels;
+    }
+    return levels;
+}
 
-    if (type == "texture_normal" || type == "texture_roughness")
+size_t Texture::bytesPerTexel(GLenum internalFormat)
+{
+    switch (internalFormat)
     {
-        isHDR = true;
-        stbi_set_flip_vertically_on_load(true);
+        case GL_R8:             return 1;
+        case GL_RG8:            return 2;
+        case GL_RG16F:          return 4;
+        case GL_SRGB8_ALPHA8:
+        case GL_RGBA8:          return 4;
+        case GL_RGBA16F:        return 8;
+        default:                return 4;
     }
-    else
+}
+
+GLTextureDesc Texture::storageDesc() const
+{
+    GLTextureDesc desc;
+    desc.target = paths.empty() ? GL_TEXTURE_2D : GL_TEXTURE_CUBE_MAP;
+    desc.levels = mipLevels;
+    desc.internalFormat = internalFormat;
+    desc.width = width;
+    desc.height = height;
+    return desc;
+}
+
+// Packs the first two channels of every pixel so normal maps can live in RG storage;
+// the fragment shader rebuilds Z from the unit-length constraint.
+template <typename T>
+static void packNormalXY(T* data, int pixelCount, int components)
+{
+    for (int i = 0; i < pixelCount; ++i)
+    {
+        data[i * 2 + 0] = data[i * components + 0];
+        data[i * 2 + 1] = data[i * components + 1];
+    }
+}
+
+// Normal and roughness maps are authored as HDR data and stored bottom-up
+static bool isHDRType(const std::string& type)
+{
+    return type == "texture_normal" || type == "texture_roughness";
+}
+
+// Picks the sized internal format, client format and mip filter for a texture type.
+static MipFilterMode selectFormat(const std::string& type, bool isHDR, TextureImage& image)
+{
+    image.dataType = isHDR ? GL_FLOAT : GL_UNSIGNED_BYTE;
+    if (type == "texture_normal")
+    {
+        // Half floats keep HDR normal precision at half the footprint of RGB32F
+        image.internalFormat = isHDR ? GL_RG16F : GL_RG8;
+        image.format = GL_RG;
+        return MipFilterMode::NormalMap;
+    }
+    if (type == "texture_roughness")
     {
-        stbi_set_flip_vertically_on_load(false);
+        // Float source data is normalized to R8 by the driver during the upload
+        image.internalFormat = GL_R8;
+        image.format = GL_RED;
+        return MipFilterMode::Linear;
     }
+    image.internalFormat = GL_SRGB8_ALPHA8;
+    image.format = GL_RGBA;
+    return MipFilterMode::SRGB;
+}
+
+bool Texture::decodeImage(const std::string& path, const std::string& type, TextureImage& image)
+{
+    int w, h, nrComponents;
+    const bool isHDR = isHDRType(type);
+
+    // Decodes run on streaming threads, so the flip flag must not be process-wide
+    stbi_set_flip_vertically_on_load_thread(isHDR ? 1 : 0);
 
-    if (isHDR)
+    // Request exactly the channels the internal format stores
+    int desiredComponents = 4;
+    if (type == "texture_roughness")
+        desiredComponents = 1;
+    else if (type == "texture_normal")
+        desiredComponents = 3;
+
+    void* data = isHDR
+        ? static_cast<void*>(stbi_loadf(path.c_str(), &w, &h, &nrComponents, desiredComponents))
+        : static_cast<void*>(stbi_load(path.c_str(), &w, &h, &nrComponents, desiredComponents));
+    if (!data)
     {
-        float* data = stbi_loadf(path.c_str(), &width, &height, &nrComponents, 0);
-        if (data)
+        std::cerr << (isHDR ? "HDR Texture" : "Texture") << " failed to load at path: " << path
+                  << ": " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+
+    MipFilterMode filterMode = selectFormat(type, isHDR, image);
+
+    // Mips are built on the CPU so they are identical on every driver
+    image.chain = MipBuilder::build(data, w, h, desiredComponents, isHDR, filterMode);
+    stbi_image_free(data);
+
+    const size_t texelSize = isHDR ? sizeof(float) : 1;
+    const int storedComponents = type == "texture_normal" ? 2 : desiredComponents;
+    image.levels.clear();
+    for (MipChain::Level& mip : image.chain.levels)
+    {
+        if (type == "texture_normal")
         {
-            GLenum format;
-            if (nrComponents == 1)
-                format = GL_RED;
-            else if (nrComponents == 3)
-                format = GL_RGB;
-            else if (nrComponents == 4)
-                format = GL_RGBA;
+            if (isHDR)
+                packNormalXY(reinterpret_cast<float*>(mip.bytes.data()), mip.width * mip.height, desiredComponents);
             else
-                format = GL_RGB;
-
-            glBindTexture(GL_TEXTURE_2D, id);
-            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_FLOAT, data);
-            glGenerateMipmap(GL_TEXTURE_2D);
+                packNormalXY(mip.bytes.data(), mip.width * mip.height, desiredComponents);
+        }
+        image.levels.push_back({ mip.width, mip.height, mip.bytes.data(),
+                                 static_cast<size_t>(mip.width) * mip.height * storedComponents * texelSize });
+    }
+    return true;
+}
 
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); 
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+bool Texture::readImage(const std::string& path, const std::string& type, TextureImage& image)
+{
+    if (const AssetPack* pack = AssetPack::mounted())
+    {
+        AssetBlob blob;
+        if (pack->find(path, blob))
+        {
+            if (AssetPack::parseTexture(std::move(blob), image))
+                return true;
+            std::cerr << "Packed texture is not a cooked texture: " << path << std::endl;
+        }
+    }
+    return decodeImage(path, type, image);
+}
 
-            stbi_image_free(data);
-            std::cout << "Loaded HDR texture: " << path << " with ID: " << id << std::endl;
+bool Texture::probeImage(const std::string& path, const std::string& type,
+                         GLsizei& w, GLsizei& h, GLenum& format)
+{
+    if (const AssetPack* pack = AssetPack::mounted())
+    {
+        AssetBlob blob;
+        TextureImage image;
+        if (pack->find(path, blob) && AssetPack::parseTexture(std::move(blob), image) && !image.levels.empty())
+        {
+            w = image.levels[0].width;
+            h = image.levels[0].height;
+            format = image.internalFormat;
             return true;
         }
-        else
-        {
-            std::cerr << "HDR Texture failed to load at path: " << path << ": " << stbi_failure_reason() << std::endl;
-            stbi_image_free(data);
+    }
+
+    int x, y, components;
+    if (!stbi_info(path.c_str(), &x, &y, &components))
+    {
+        std::cerr << "Texture failed to probe at path: " << path << ": " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+    TextureImage image;
+    selectFormat(type, isHDRType(type), image);
+    w = x;
+    h = y;
+    format = image.internalFormat;
+    return true;
+}
+
+bool Texture::loadStreamed(TextureStreamer& streamer)
+{
+    // prepare() already probed the size and format
+    if (!prepared && !probeImage(path, type, width, height, internalFormat))
+        return false;
+    prepared = false;
+    staged.reset();
+    mipLevels = mipLevelCount(width, height);
+
+    // A texture of the same size and format that was released earlier is reused
+    id = GLResourceManager::createTexture(storageDesc());
+
+    // Neutral 1x1 placeholder (grey albedo, flat normal, mid roughness) until real texels stream in
+    const unsigned char neutral[4] = { 128, 128, 128, 255 };
+    GLenum clientFormat = GL_RGBA;
+    if (type == "texture_normal")
+        clientFormat = GL_RG;
+    else if (type == "texture_roughness")
+        clientFormat = GL_RED;
+    glTexSubImage2D(GL_TEXTURE_2D, mipLevels - 1, 0, 0, 1, 1, clientFormat, GL_UNSIGNED_BYTE, neutral);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, mipLevels - 1);
+
+    streamer.enqueue(id, path, type, width, height, mipLevels, internalFormat);
+    std::cout << "Streaming texture: " << path << " with ID: " << id << std::endl;
+    return true;
+}
+
+size_t Texture::getStorageBytes() const
+{
+    if (width <= 0 || height <= 0)
+        return 0;
+    // Before load() the pyramid is not allocated yet; it will hold every level down to 1x1
+    const GLsizei levels = mipLevels > 0 ? mipLevels : mipLevelCount(width, height);
+    size_t bytes = 0;
+    for (GLsizei level = 0; level < levels; ++level)
+    {
+        const size_t w = static_cast<size_t>(std::max(1, width >> level));
+        const size_t h = static_cast<size_t>(std::max(1, height >> level));
+        bytes += w * h * bytesPerTexel(internalFormat);
+    }
+    return bytes;
+}
+
+bool Texture::prepare()
+{
+    prepared = false;
+    prepareFailed = true;
+    if (TextureStreamer::active())
+    {
+        // The streamer decodes the levels itself; only the storage size is needed up front
+        if (!probeImage(path, type, width, height, internalFormat))
             return false;
-        }
     }
     else
     {
-        unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrComponents, 0);
-        if (data)
-        {
-            GLenum format;
-            if (nrComponents == 1)
-                format = GL_RED;
-            else if (nrComponents == 3)
-                format = GL_RGB;
-            else if (nrComponents == 4)
-                format = GL_RGBA;
-            else
-                format = GL_RGB;
+        auto image = std::make_unique<TextureImage>();
+        if (!readImage(path, type, *image) || image->levels.empty())
+            return false;
+        width = image->levels[0].width;
+        height = image->levels[0].height;
+        internalFormat = image->internalFormat;
+        staged = std::move(image);
+    }
+    prepared = true;
+    prepareFailed = false;
+    return true;
+}
 
-            glBindTexture(GL_TEXTURE_2D, id);
-            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-            glGenerateMipmap(GL_TEXTURE_2D);
+bool Texture::load()
+{
+    if (prepareFailed)
+        return false;
 
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); 
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (TextureStreamer* streamer = TextureStreamer::active())
+        return loadStreamed(*streamer);
 
-            stbi_image_free(data);
-            std::cout << "Loaded texture: " << path << " with ID: " << id << std::endl;
-            return true;
-        }
-        else
-        {
-            std::cerr << "Texture failed to load at path: " << path << ": " << stbi_failure_reason() << std::endl;
-            stbi_image_free(data);
+    // Upload what prepare() decoded, or decode here when it was not called
+    std::unique_ptr<TextureImage> owned = std::move(staged);
+    prepared = false;
+    if (!owned)
+    {
+        owned = std::make_unique<TextureImage>();
+        if (!readImage(path, type, *owned) || owned->levels.empty())
             return false;
-        }
     }
+    const TextureImage& image = *owned;
+
+    internalFormat = image.internalFormat;
+    width = image.levels[0].width;
+    height = image.levels[0].height;
+    mipLevels = static_cast<GLsizei>(image.levels.size());
+
+    // Every level is uploaded below, so a recycled texture needs no clearing
+    id = GLResourceManager::createTexture(storageDesc());
+
+    // RG8 and R8 rows are not necessarily 4-byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (GLsizei level = 0; level < mipLevels; ++level)
+    {
+        const TextureImage::Level& mip = image.levels[level];
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, mip.width, mip.height, image.format, image.dataType, mip.data);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    std::cout << "Loaded texture: " << path << " with ID: " << id << std::endl;
+    return true;
 }
 
 bool Texture::loadCubemap()
@@ -141,45 +348,41 @@ bool Texture::loadCubemap()
         return false;
     }
 
-    glGenTextures(1, &id);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, id);
-
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load(false);
     for(unsigned int i = 0; i < paths.size(); ++i)
     {
-        unsigned char *data = stbi_load(paths[i].c_str(), &width, &height, &nrChannels, 0);
-        if(data)
+        TextureImage image;
+        if(readImage(paths[i], type, image) && !image.levels.empty())
         {
-            GLenum format;
-            if(nrChannels == 1)
-                format = GL_RED;
-            else if(nrChannels == 3)
-                format = GL_RGB;
-            else if(nrChannels == 4)
-                format = GL_RGBA;
-            else
-                format = GL_RGB;
+            // Storage for all faces is allocated once, sized from the first face
+            if (i == 0)
+            {
+                width = image.levels[0].width;
+                height = image.levels[0].height;
+                mipLevels = static_cast<GLsizei>(image.levels.size());
+                internalFormat = image.internalFormat;
+                id = GLResourceManager::createTexture(storageDesc());
+            }
+            else if (image.levels[0].width != width || image.levels[0].height != height)
+            {
+                std::cerr << "Cubemap face size mismatch at path: " << paths[i] << std::endl;
+                return false;
+            }
 
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 
-                         0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data
-            );
-            stbi_image_free(data);
+            for (GLsizei level = 0; level < mipLevels; ++level)
+            {
+                const TextureImage::Level& mip = image.levels[level];
+                glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+                                level, 0, 0, mip.width, mip.height, image.format, image.dataType, mip.data
+                );
+            }
         }
         else
         {
             std::cerr << "Cubemap texture failed to load at path: " 
                       << paths[i] << std::endl;
-            stbi_image_free(data);
             return false;
         }
     }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);  
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);  
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
     std::cout << "Loaded cubemap texture with ID: " << id << std::endl;
     return true;
@@ -1,16 +1,58 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <glad/glad.h>
+#include "mip_builder.h"
+#include "gl_resource_manager.h"
+
+/**
+ * @struct TextureImage
+ * @brief Imagen decodificada lista para subir: formato de OpenGL y un puntero por nivel de mipmap.
+ *
+ * Los niveles apuntan directamente al asset pack mapeado (sin copia), a @ref blobStorage
+ * si el blob estaba comprimido, o a @ref chain si la imagen se decodificó desde un archivo suelto.
+ */
+struct TextureImage {
+    /**
+     * @struct Level
+     * @brief Un nivel de mipmap con texels en el formato de cliente.
+     */
+    struct Level {
+        GLsizei width;      /**< Ancho del nivel */
+        GLsizei height;     /**< Alto del nivel */
+        const void* data;   /**< Texels del nivel */
+        size_t size;        /**< Bytes del nivel */
+    };
+
+    GLenum internalFormat = 0;              /**< Formato interno para glTexStorage2D */
+    GLenum format = 0;                      /**< Formato de cliente (GL_RGBA, GL_RG, GL_RED) */
+    GLenum dataType = 0;                    /**< Tipo de cliente (GL_UNSIGNED_BYTE, GL_FLOAT) */
+    std::vector<Level> levels;              /**< Niveles, del 0 (base) al 1x1 */
+    MipChain chain;                         /**< Memoria propia si se decodificó desde disco */
+    std::vector<unsigned char> blobStorage; /**< Memoria propia si el blob del pack estaba comprimido */
+};
+
+class TextureStreamer;
 
 /**
  * @class Texture
  * @brief Representa una textura 2D o un cubemap en OpenGL.
  *
- * La clase @c Texture se encarga de cargar una textura desde disco usando stb_image,
- * subirla a OpenGL, generar mipmaps y configurar parámetros de filtrado y wrapping.
+ * La clase @c Texture se encarga de cargar una textura desde disco usando stb_image
+ * y subirla a OpenGL con almacenamiento inmutable (@c glTexStorage2D) dimensionado a la
+ * cadena completa de mipmaps. El formato interno depende del tipo de textura:
+ * - @c texture_diffuse: @c GL_SRGB8_ALPHA8 (el muestreo devuelve color lineal).
+ * - @c texture_normal: @c GL_RG16F (fuente HDR) o @c GL_RG8; el shader reconstruye Z.
+ * - @c texture_roughness: @c GL_R8.
+ * - @c texture_cubemap: @c GL_SRGB8_ALPHA8 por cara.
+ *
+ * El estado de filtrado y wrapping no vive en la textura sino en los samplers
+ * compartidos de @ref SamplerCache. El objeto de OpenGL se pide y se devuelve a
+ * @ref GLResourceManager: se reutiliza si hay uno con la misma forma y se borra tras la fence
+ * del frame, así que destruir una textura es seguro desde cualquier hilo.
  */
 class Texture {
 public:
@@ -29,7 +71,7 @@ public:
     Texture(const std::vector<std::string>& paths, const std::string& type);
 
     /**
-     * @brief Destructor. Elimina la textura de OpenGL si existe.
+     * @brief Destructor. Devuelve la textura de OpenGL al gestor de recursos si existe.
      */
     ~Texture();
 
@@ -41,9 +83,24 @@ public:
     Texture(Texture&& other) noexcept;
     Texture& operator=(Texture&& other) noexcept;
 
+    /**
+     * @brief Parte de @ref load que no usa OpenGL: lee y decodifica la imagen (o solo la sondea
+     *        si hay un @ref TextureStreamer activo). Puede llamarse desde un trabajador.
+     *
+     * El siguiente @ref load sube lo preparado en lugar de volver a leer el archivo.
+     *
+     * @return true si la imagen está lista para subirse.
+     */
+    bool prepare();
+
     /**
      * @brief Carga una textura 2D desde @ref path en OpenGL.
-     * @return true si la carga fue exitosa, false en caso contrario.
+     *
+     * Si hay un @ref TextureStreamer activo, la textura se reserva con su pirámide completa,
+     * se muestra un placeholder de 1x1 y los niveles se suben de forma progresiva.
+     * Si antes se llamó a @ref prepare, solo queda la parte de OpenGL.
+     *
+     * @return true si la carga (o el registro para streaming) fue exitosa, false en caso contrario.
      */
     bool load();
 
@@ -71,11 +128,94 @@ public:
      */
     const std::string& getPath() const { return path; }
 
+    /**
+     * @brief Obtiene el formato interno con el que se reservó la textura.
+     * @return GLenum Formato interno (ej: GL_SRGB8_ALPHA8), 0 si no está cargada.
+     */
+    GLenum getInternalFormat() const { return internalFormat; }
+
+    /// Dimensiones del nivel base y número de niveles de mipmap reservados.
+    GLsizei getWidth() const { return width; }
+    GLsizei getHeight() const { return height; }
+    GLsizei getMipLevels() const { return mipLevels; }
+
+    /**
+     * @brief Bytes de GPU de la pirámide completa; válido tras @ref prepare (aún sin subir) o @ref load.
+     */
+    size_t getStorageBytes() const;
+
+    /**
+     * @brief Calcula el número de niveles de una cadena completa de mipmaps.
+     * @param width Ancho del nivel base.
+     * @param height Alto del nivel base.
+     * @return GLsizei floor(log2(max(width, height))) + 1.
+     */
+    static GLsizei mipLevelCount(GLsizei width, GLsizei height);
+
+    /**
+     * @brief Bytes por texel de un formato interno (estimación de memoria de GPU).
+     * @param internalFormat Formato interno (ej: GL_RG16F).
+     * @return size_t Bytes por texel.
+     */
+    static size_t bytesPerTexel(GLenum internalFormat);
+
+    /**
+     * @brief Obtiene la imagen de una textura, primero desde el asset pack montado y, si no
+     *        está empaquetada, decodificándola desde el archivo.
+     * @param path Ruta relativa del asset.
+     * @param type Tipo de textura (decide formato interno y filtrado de mipmaps).
+     * @param image Imagen de salida.
+     * @return true si la imagen está disponible.
+     */
+    static bool readImage(const std::string& path, const std::string& type, TextureImage& image);
+
+    /**
+     * @brief Decodifica una imagen desde disco con stb_image y construye su cadena de mipmaps.
+     *
+     * No usa OpenGL; es el mismo camino que usa el constructor del asset pack para cocinar texturas.
+     *
+     * @param path Ruta al archivo de imagen.
+     * @param type Tipo de textura (decide formato interno y filtrado de mipmaps).
+     * @param image Imagen de salida.
+     * @return true si la decodificación fue exitosa.
+     */
+    static bool decodeImage(const std::string& path, const std::string& type, TextureImage& image);
+
+    /**
+     * @brief Lee solo las dimensiones y el formato interno de una imagen, sin decodificarla.
+     * @param path Ruta relativa del asset.
+     * @param type Tipo de textura.
+     * @param width Ancho del nivel 0.
+     * @param height Alto del nivel 0.
+     * @param format Formato interno que tendrá la textura.
+     * @return true si la imagen existe y es legible.
+     */
+    static bool probeImage(const std::string& path, const std::string& type,
+                           GLsizei& width, GLsizei& height, GLenum& format);
+
 private:
+    /**
+     * @brief Reserva la textura y la registra en el streamer para carga progresiva.
+     * @param streamer Streamer que subirá los niveles.
+     * @return true si la textura se registró.
+     */
+    bool loadStreamed(TextureStreamer& streamer);
+
+    /**
+     * @brief Forma del almacenamiento reservado (para devolverlo a @ref GLResourceManager).
+     */
+    GLTextureDesc storageDesc() const;
+
     GLuint id;                  /**< ID de la textura en OpenGL */
+    GLenum internalFormat;      /**< Formato interno de la textura inmutable */
+    GLsizei width, height;      /**< Dimensiones del nivel base */
+    GLsizei mipLevels;          /**< Niveles de mipmap reservados con glTexStorage */
     std::string type;           /**< Tipo de textura (difusa, normal, roughness, cubemap, etc.) */
     std::string path;           /**< Ruta al archivo de imagen (para texturas 2D) */
     std::vector<std::string> paths; /**< Rutas de las 6 caras para cubemap */
+    std::unique_ptr<TextureImage> staged; /**< Imagen decodificada por @ref prepare, pendiente de subir */
+    bool prepared;              /**< @ref prepare terminó con éxito */
+    bool prepareFailed;         /**< @ref prepare falló; @ref load no vuelve a intentarlo */
 };
 
 #endif // TEXTURE_H
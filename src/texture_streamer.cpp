@@ -0,0 +1,296 @@
+// TextureStreamer.cpp
+
+#include "texture_streamer.h"
+#include "job_system.h"
+#include "gl_resource_manager.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+TextureStreamer* TextureStreamer::activeStreamer = nullptr;
+
+TextureStreamer::TextureStreamer(size_t uploadBudgetBytes, size_t residentBudgetBytes)
+    : uploadBudget(uploadBudgetBytes), residentBudget(residentBudgetBytes), residentTotal(0), storageTotal(0),
+      activeBudget(residentBudgetBytes)
+{
+    stats.residentBudgetBytes = residentBudget;
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    if (activeStreamer == this)
+        activeStreamer = nullptr;
+    // Job futures do not join on destruction; decodes read the asset pack, which may go next
+    for (auto& entry : entries)
+        if (entry.second.pending.valid())
+            entry.second.pending.wait();
+}
+
+void TextureStreamer::activate()
+{
+    activeStreamer = this;
+}
+
+TextureStreamer* TextureStreamer::active()
+{
+    return activeStreamer;
+}
+
+size_t TextureStreamer::levelBytes(const Entry& entry, GLint level)
+{
+    size_t w = static_cast<size_t>(std::max(1, entry.width >> level));
+    size_t h = static_cast<size_t>(std::max(1, entry.height >> level));
+    return w * h * Texture::bytesPerTexel(entry.internalFormat);
+}
+
+size_t TextureStreamer::storageBytes(const Entry& entry)
+{
+    size_t bytes = 0;
+    for (GLint level = 0; level < entry.levels; ++level)
+        bytes += levelBytes(entry, level);
+    return bytes;
+}
+
+void TextureStreamer::enqueue(GLuint id, const std::string& path, const std::string& type,
+                              GLsizei width, GLsizei height, GLsizei levels, GLenum internalFormat)
+{
+    Entry& entry = entries[id];
+    entry.path = path;
+    entry.type = type;
+    entry.width = width;
+    entry.height = height;
+    entry.levels = levels;
+    entry.internalFormat = internalFormat;
+    entry.residentBase = levels - 1; // The 1x1 placeholder
+    entry.tailBase = levels - 1;
+    while (entry.tailBase > 0 && std::max(width >> (entry.tailBase - 1), height >> (entry.tailBase - 1)) <= kTailSize)
+        --entry.tailBase;
+    entry.residentBytes = levelBytes(entry, entry.residentBase);
+    entry.screenPixels = 0.0f;
+    entry.priority = 0.0f;
+    entry.desiredBase = entry.tailBase;
+    entry.lastUsedFrame = 0;
+    entry.image.reset();
+    residentTotal += entry.residentBytes;
+    storageTotal += storageBytes(entry);
+    startDecode(entry);
+}
+
+void TextureStreamer::forget(GLuint id)
+{
+    auto it = entries.find(id);
+    if (it == entries.end())
+        return;
+    residentTotal -= it->second.residentBytes;
+    storageTotal -= storageBytes(it->second);
+    // An in-flight decode is abandoned, not joined: it owns copies of its path and type
+    entries.erase(it);
+}
+
+void TextureStreamer::requestDetail(GLuint id, float screenPixels)
+{
+    auto it = entries.find(id);
+    if (it != entries.end())
+        it->second.screenPixels = std::max(it->second.screenPixels, screenPixels);
+}
+
+float TextureStreamer::projectedPixels(float worldSize, float distance, float fovYDegrees, float viewportHeight)
+{
+    float halfHeight = std::max(distance, 0.01f) * std::tan(fovYDegrees * 0.5f * 3.14159265f / 180.0f);
+    return std::min(viewportHeight, worldSize / (2.0f * halfHeight) * viewportHeight);
+}
+
+void TextureStreamer::startDecode(Entry& entry)
+{
+    std::string path = entry.path;
+    std::string type = entry.type;
+    entry.pending = JobSystem::async([path, type]() {
+        auto image = std::make_shared<TextureImage>();
+        if (!Texture::readImage(path, type, *image))
+            image.reset();
+        return image;
+    });
+}
+
+void TextureStreamer::uploadLevel(GLuint id, Entry& entry, GLint level)
+{
+    const TextureImage::Level& mip = entry.image->levels[level];
+    glBindTexture(GL_TEXTURE_2D, id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, mip.width, mip.height, entry.image->format, entry.image->dataType, mip.data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    if (level < entry.residentBase)
+    {
+        size_t bytes = levelBytes(entry, level);
+        entry.residentBytes += bytes;
+        residentTotal += bytes;
+        entry.residentBase = level;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    }
+    stats.uploadedBytesLastFrame += levelBytes(entry, level);
+}
+
+void TextureStreamer::dropFinestLevel(GLuint id, Entry& entry)
+{
+    size_t bytes = levelBytes(entry, entry.residentBase);
+    entry.residentBytes -= bytes;
+    residentTotal -= bytes;
+    stats.evictedBytesLastFrame += bytes;
+    // The storage stays allocated; invalidating the level lets the driver drop its contents
+    glInvalidateTexImage(id, entry.residentBase);
+    ++entry.residentBase;
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry.residentBase);
+}
+
+// Least recently drawn texture with a level above its tail, lowest priority on ties;
+// with keep set, only textures that are strictly less important than it qualify
+TextureStreamer::Entry* TextureStreamer::leastRecentlyUsed(const Entry* keep, GLuint& victimId)
+{
+    Entry* victim = nullptr;
+    for (auto& [id, entry] : entries)
+    {
+        if (&entry == keep || entry.residentBase >= entry.tailBase)
+            continue;
+        if (keep && std::make_pair(entry.lastUsedFrame, entry.priority) >= std::make_pair(keep->lastUsedFrame, keep->priority))
+            continue;
+        if (!victim || std::make_pair(entry.lastUsedFrame, entry.priority) < std::make_pair(victim->lastUsedFrame, victim->priority))
+        {
+            victim = &entry;
+            victimId = id;
+        }
+    }
+    return victim;
+}
+
+void TextureStreamer::update()
+{
+    stats.uploadedBytesLastFrame = 0;
+    stats.evictedBytesLastFrame = 0;
+
+    // Whatever the GPU budget leaves after meshes, fixed textures and pools, capped by our own
+    GLResourceManager* resources = GLResourceManager::active();
+    activeBudget = resources ? std::min(residentBudget, resources->streamingBudget(storageTotal)) : residentBudget;
+
+    // 1. Finished decodes: validate and make the tail resident right away
+    for (auto& [id, entry] : entries)
+    {
+        if (!entry.pending.valid() || entry.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            continue;
+
+        entry.image = entry.pending.get();
+        if (!entry.image)
+        {
+            std::cerr << "Texture streaming failed to decode: " << entry.path << std::endl;
+            continue;
+        }
+        if (static_cast<GLsizei>(entry.image->levels.size()) != entry.levels ||
+            entry.image->levels[0].width != entry.width || entry.image->levels[0].height != entry.height)
+        {
+            std::cerr << "Texture streaming size mismatch: " << entry.path << std::endl;
+            entry.image.reset();
+            continue;
+        }
+        // A re-decode after eviction finds the tail still resident
+        if (entry.residentBase == entry.levels - 1)
+        {
+            for (GLint level = entry.levels - 1; level >= entry.tailBase; --level)
+                uploadLevel(id, entry, level);
+        }
+    }
+
+    // 2. Desired level from last frame's detail requests; unrequested textures keep only their tail
+    for (auto& [id, entry] : entries)
+    {
+        if (entry.screenPixels > 0.0f)
+        {
+            float ratio = static_cast<float>(std::max(entry.width, entry.height)) / entry.screenPixels;
+            GLint level = ratio > 1.0f ? static_cast<GLint>(std::floor(std::log2(ratio))) : 0;
+            entry.desiredBase = std::min(level, entry.tailBase);
+        }
+        else
+        {
+            entry.desiredBase = entry.tailBase;
+        }
+        entry.priority = entry.screenPixels;
+        entry.screenPixels = 0.0f;
+        if (resources)
+            entry.lastUsedFrame = resources->lastUsedFrame(id);
+
+        // Re-decode textures whose CPU image was released before they reached the wanted detail
+        if (entry.residentBase > entry.desiredBase && !entry.image && !entry.pending.valid())
+            startDecode(entry);
+    }
+
+    // 3. Over budget (it shrank or other allocations grew): drop the least recently used detail first
+    while (residentTotal > activeBudget)
+    {
+        GLuint victimId = 0;
+        Entry* victim = leastRecentlyUsed(nullptr, victimId);
+        if (!victim)
+            break;
+        dropFinestLevel(victimId, *victim);
+    }
+
+    // 4. Refine coarse-to-fine by priority within the per-frame upload and resident budgets
+    while (stats.uploadedBytesLastFrame < uploadBudget)
+    {
+        Entry* best = nullptr;
+        GLuint bestId = 0;
+        float bestScore = 0.0f;
+        for (auto& [id, entry] : entries)
+        {
+            if (!entry.image || entry.residentBase <= entry.desiredBase)
+                continue;
+            float score = entry.priority * static_cast<float>(entry.residentBase - entry.desiredBase);
+            if (!best || score > bestScore)
+            {
+                best = &entry;
+                bestId = id;
+                bestScore = score;
+            }
+        }
+        if (!best)
+            break;
+
+        const GLint next = best->residentBase - 1;
+        const size_t bytes = levelBytes(*best, next);
+        bool fits = true;
+        while (residentTotal + bytes > activeBudget)
+        {
+            // Evict the finest level of a texture drawn less recently (or less important) than this one
+            GLuint victimId = 0;
+            Entry* victim = leastRecentlyUsed(best, victimId);
+            if (!victim)
+            {
+                fits = false;
+                break;
+            }
+            dropFinestLevel(victimId, *victim);
+        }
+        if (!fits)
+            break;
+        uploadLevel(bestId, *best, next);
+    }
+
+    // 5. Release CPU images once the wanted detail is resident, then refresh the counters
+    stats.pendingDecodes = 0;
+    stats.streamingTextures = 0;
+    stats.fullyResidentTextures = 0;
+    for (auto& [id, entry] : entries)
+    {
+        if (entry.image && entry.residentBase <= entry.desiredBase)
+            entry.image.reset();
+        if (entry.pending.valid())
+            ++stats.pendingDecodes;
+        if (entry.residentBase > entry.desiredBase)
+            ++stats.streamingTextures;
+        if (entry.residentBase == 0)
+            ++stats.fullyResidentTextures;
+    }
+    stats.residentBytes = residentTotal;
+    stats.residentBudgetBytes = activeBudget;
+    stats.storageBytes = storageTotal;
+}
@@ -0,0 +1,168 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include "Texture.h"
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <glad/glad.h>
+
+/**
+ * @struct TextureStreamerStats
+ * @brief Contadores del streaming de mipmaps, actualizados en cada @ref TextureStreamer::update.
+ */
+struct TextureStreamerStats {
+    size_t residentBytes = 0;          /**< Bytes de niveles subidos y muestreables */
+    size_t residentBudgetBytes = 0;    /**< Límite de bytes residentes (el propio o el que deja el presupuesto de GPU) */
+    size_t storageBytes = 0;           /**< Almacenamiento reservado de todas las texturas (pirámides completas) */
+    size_t evictedBytesLastFrame = 0;  /**< Bytes de niveles descartados en el último update */
+    size_t uploadedBytesLastFrame = 0; /**< Bytes subidos en el último update */
+    int pendingDecodes = 0;            /**< Texturas decodificándose en segundo plano */
+    int streamingTextures = 0;         /**< Texturas por debajo de su nivel de detalle deseado */
+    int fullyResidentTextures = 0;     /**< Texturas con el nivel 0 residente */
+};
+
+/**
+ * @class TextureStreamer
+ * @brief Streaming progresivo de mipmaps: primero los niveles pequeños, luego el detalle por prioridad.
+ *
+ * Cada textura se crea con su pirámide completa (@c glTexStorage2D) pero solo con un
+ * placeholder de 1x1 en el último nivel; @c GL_TEXTURE_BASE_LEVEL restringe el muestreo
+ * a los niveles residentes. La imagen se decodifica en un hilo de fondo; al terminar se
+ * suben de inmediato los niveles de la cola (<= @ref kTailSize) y el resto se refina nivel a
+ * nivel, del más grueso al más fino, según la prioridad que reporta el render (tamaño en
+ * pantalla y distancia a la cámara).
+ *
+ * La subida por frame y el total residente están acotados: si falta presupuesto se
+ * descartan los niveles finos de las texturas usadas hace más tiempo (según los draws que
+ * registra @ref GLResourceManager) y, a igualdad, de menor prioridad. Con un gestor activo el
+ * límite residente es además lo que deja libre su presupuesto de memoria de GPU; si ese
+ * hueco se reduce, el update baja texturas a niveles más gruesos hasta volver a caber, y las
+ * vuelve a refinar cuando se piden de nuevo.
+ *
+ * El almacenamiento inmutable sigue reservado al bajar de nivel: los niveles descartados se
+ * invalidan (@c glInvalidateTexImage) para que el driver pueda reclamar su memoria.
+ */
+class TextureStreamer {
+public:
+    static constexpr GLsizei kTailSize = 64; /**< Niveles con lado <= kTailSize se suben al decodificar */
+
+    /**
+     * @brief Constructor.
+     * @param uploadBudgetBytes Bytes máximos subidos por frame.
+     * @param residentBudgetBytes Bytes máximos residentes entre todas las texturas.
+     */
+    explicit TextureStreamer(size_t uploadBudgetBytes = 8u << 20, size_t residentBudgetBytes = 256u << 20);
+
+    /**
+     * @brief Destructor. Espera las decodificaciones pendientes y se desactiva si estaba activo.
+     */
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    /**
+     * @brief Registra una textura ya reservada y lanza su decodificación en segundo plano.
+     *
+     * @param id ID de la textura OpenGL (con storage inmutable y BASE_LEVEL en el último nivel).
+     * @param path Ruta de la imagen.
+     * @param type Tipo de textura.
+     * @param width Ancho del nivel 0.
+     * @param height Alto del nivel 0.
+     * @param levels Número de niveles reservados.
+     * @param internalFormat Formato interno reservado.
+     */
+    void enqueue(GLuint id, const std::string& path, const std::string& type,
+                 GLsizei width, GLsizei height, GLsizei levels, GLenum internalFormat);
+
+    /**
+     * @brief Olvida una textura (llamado al destruirla).
+     * @param id ID de la textura OpenGL.
+     */
+    void forget(GLuint id);
+
+    /**
+     * @brief Solicita detalle para una textura en el frame actual.
+     *
+     * Puede llamarse varias veces por frame; se conserva la solicitud mayor.
+     *
+     * @param id ID de la textura OpenGL.
+     * @param screenPixels Píxeles de pantalla que ocupa una repetición completa de la textura.
+     */
+    void requestDetail(GLuint id, float screenPixels);
+
+    /**
+     * @brief Integra decodificaciones terminadas y sube niveles por prioridad. Hilo de OpenGL.
+     */
+    void update();
+
+    /**
+     * @brief Devuelve los contadores del último @ref update.
+     */
+    const TextureStreamerStats& getStats() const { return stats; }
+
+    /**
+     * @brief Estima cuántos píxeles de pantalla cubre un tamaño en el mundo.
+     *
+     * @param worldSize Tamaño en unidades del mundo.
+     * @param distance Distancia a la cámara.
+     * @param fovYDegrees Campo de visión vertical en grados.
+     * @param viewportHeight Alto del viewport en píxeles.
+     * @return float Píxeles proyectados (acotado a la altura del viewport).
+     */
+    static float projectedPixels(float worldSize, float distance, float fovYDegrees, float viewportHeight);
+
+    /**
+     * @brief Hace de este streamer el que usa @ref Texture::load para cargar texturas de forma progresiva.
+     */
+    void activate();
+
+    /**
+     * @brief Obtiene el streamer activo.
+     * @return Puntero al streamer, o nullptr si las texturas se cargan de forma síncrona.
+     */
+    static TextureStreamer* active();
+
+private:
+    /**
+     * @struct Entry
+     * @brief Estado de streaming de una textura.
+     */
+    struct Entry {
+        std::string path;             /**< Ruta de la imagen */
+        std::string type;             /**< Tipo de textura */
+        GLsizei width, height;        /**< Dimensiones del nivel 0 */
+        GLsizei levels;               /**< Niveles reservados */
+        GLenum internalFormat;        /**< Formato interno reservado */
+        GLint residentBase;           /**< Nivel más fino subido (BASE_LEVEL actual) */
+        GLint tailBase;               /**< Primer nivel de la cola siempre residente */
+        size_t residentBytes;         /**< Bytes de niveles subidos */
+        float screenPixels;           /**< Mayor solicitud de detalle del frame actual */
+        float priority;               /**< Prioridad calculada en el último update */
+        GLint desiredBase;            /**< Nivel deseado según la solicitud de detalle */
+        uint64_t lastUsedFrame;       /**< Último frame en que un draw la usó (orden LRU) */
+        std::shared_ptr<TextureImage> image;                 /**< Imagen decodificada en CPU */
+        std::future<std::shared_ptr<TextureImage>> pending;  /**< Decodificación en curso */
+    };
+
+    std::unordered_map<GLuint, Entry> entries; /**< Texturas registradas por ID */
+    size_t uploadBudget;                       /**< Bytes por frame */
+    size_t residentBudget;                     /**< Bytes residentes máximos */
+    size_t residentTotal;                      /**< Bytes residentes actuales */
+    size_t storageTotal;                       /**< Bytes reservados (pirámides completas) */
+    size_t activeBudget;                       /**< Límite residente del update en curso */
+    TextureStreamerStats stats;                /**< Contadores del último update */
+
+    static TextureStreamer* activeStreamer;    /**< Streamer usado por Texture::load */
+
+    void startDecode(Entry& entry);
+    void uploadLevel(GLuint id, Entry& entry, GLint level);
+    void dropFinestLevel(GLuint id, Entry& entry);
+    Entry* leastRecentlyUsed(const Entry* keep, GLuint& id);
+    static size_t levelBytes(const Entry& entry, GLint level);
+    static size_t storageBytes(const Entry& entry);
+};
+
+#endif // TEXTURE_STREAMER_H
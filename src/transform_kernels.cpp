@@ -0,0 +1,119 @@
+// TransformKernels.cpp
+
+#include "transform_kernels_simd.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace TransformKernels {
+
+namespace {
+
+std::atomic<int> forcedLevel{-1};
+
+} // namespace
+
+SimdLevel detect()
+{
+    // GCC and Clang check both the CPU bits and that the OS saves the wider registers
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    static const SimdLevel level = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return SimdLevel::AVX512;
+        if (__builtin_cpu_supports("avx2"))
+            return SimdLevel::AVX2;
+        if (__builtin_cpu_supports("sse4.1"))
+            return SimdLevel::SSE41;
+        return SimdLevel::Scalar;
+    }();
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+SimdLevel active()
+{
+    const int forced = forcedLevel.load(std::memory_order_relaxed);
+    return forced < 0 ? detect() : static_cast<SimdLevel>(forced);
+}
+
+void force(SimdLevel level)
+{
+    forcedLevel.store(static_cast<int>(std::min(level, detect())), std::memory_order_relaxed);
+}
+
+const char* name(SimdLevel level)
+{
+    switch (level)
+    {
+        case SimdLevel::SSE41: return "SSE4.1";
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::AVX512: return "AVX-512";
+        default: return "scalar";
+    }
+}
+
+void composeTRS(const TransformBatch& batch, const uint32_t* indices, size_t count, SimdLevel level)
+{
+    switch (level)
+    {
+        case SimdLevel::AVX512: detail::composeTRSAvx512(batch, indices, count); break;
+        case SimdLevel::AVX2: detail::composeTRSAvx2(batch, indices, count); break;
+        case SimdLevel::SSE41: detail::composeTRSSse41(batch, indices, count); break;
+        default: detail::composeTRSScalar(batch, indices, count); break;
+    }
+}
+
+void transformSpheres(const SphereBatch& batch, const uint32_t* sphereIndices, const uint32_t* transformIndices,
+                      size_t count, SimdLevel level)
+{
+    switch (level)
+    {
+        case SimdLevel::AVX512: detail::transformSpheresAvx512(batch, sphereIndices, transformIndices, count); break;
+        case SimdLevel::AVX2: detail::transformSpheresAvx2(batch, sphereIndices, transformIndices, count); break;
+        case SimdLevel::SSE41: detail::transformSpheresSse41(batch, sphereIndices, transformIndices, count); break;
+        default: detail::transformSpheresScalar(batch, sphereIndices, transformIndices, count); break;
+    }
+}
+
+namespace detail {
+
+void composeTRSScalar(const TransformBatch& batch, const uint32_t* indices, size_t count)
+{
+    for (size_t k = 0; k < count; ++k)
+    {
+        const uint32_t i = indices[k];
+        const glm::vec3& scale = batch.scales[i];
+
+        // T * R * S without the generic matrix products; the normal matrix is R * S^-1
+        const glm::mat3 basis = glm::mat3_cast(batch.rotations[i]);
+        batch.worlds[i] = glm::mat4(glm::vec4(basis[0] * scale.x, 0.0f),
+                                    glm::vec4(basis[1] * scale.y, 0.0f),
+                                    glm::vec4(basis[2] * scale.z, 0.0f),
+                                    glm::vec4(batch.positions[i], 1.0f));
+        const glm::vec3 inverseScale = glm::vec3(1.0f) / scale;
+        batch.normals[i] = glm::mat3(basis[0] * inverseScale.x, basis[1] * inverseScale.y, basis[2] * inverseScale.z);
+    }
+}
+
+void transformSpheresScalar(const SphereBatch& batch, const uint32_t* sphereIndices, const uint32_t* transformIndices, size_t count)
+{
+    for (size_t k = 0; k < count; ++k)
+    {
+        const uint32_t i = sphereIndices[k];
+        const glm::mat4& world = batch.worlds[transformIndices[k]];
+
+        // The world matrix carries the scale of every ancestor; the largest axis bounds the sphere
+        const float scale = std::sqrt(std::max(glm::dot(glm::vec3(world[0]), glm::vec3(world[0])),
+                                               std::max(glm::dot(glm::vec3(world[1]), glm::vec3(world[1])),
+                                                        glm::dot(glm::vec3(world[2]), glm::vec3(world[2])))));
+        batch.worldCenters[i] = glm::vec3(world * glm::vec4(batch.localCenters[i], 1.0f));
+        batch.worldRadii[i] = batch.localRadii[i] * scale;
+    }
+}
+
+} // namespace detail
+
+} // namespace TransformKernels
@@ -0,0 +1,105 @@
+#ifndef TRANSFORM_KERNELS_H
+#define TRANSFORM_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+/**
+ * @namespace TransformKernels
+ * @brief Núcleos por lotes del sistema de transformaciones, vectorizados con SSE4.1, AVX2 o AVX-512.
+ *
+ * Trabajan sobre las columnas de los pools de @ref EntityRegistry (un arreglo por campo) y
+ * una lista de índices densos: cada carril del registro vectorial procesa un índice, así
+ * que 4, 8 o 16 entidades se componen a la vez sin reordenar los datos. Las lecturas son
+ * gathers por índice y las escrituras se trasponen en registros (o scatters en AVX-512)
+ * para dejar cada matriz contigua. El resto que no llena un registro pasa por el camino
+ * escalar, que es también la referencia.
+ *
+ * El nivel se elige en tiempo de ejecución según la CPU (@ref detect); cada variante se
+ * compila en su propia unidad con las opciones de su conjunto de instrucciones. Los núcleos
+ * no reservan memoria ni usan hilos: quien los llama reparte los rangos entre trabajadores.
+ */
+namespace TransformKernels {
+
+/**
+ * @enum SimdLevel
+ * @brief Conjunto de instrucciones de los núcleos.
+ */
+enum class SimdLevel {
+    Scalar,     /**< Sin vectorizar (referencia) */
+    SSE41,      /**< 4 carriles */
+    AVX2,       /**< 8 carriles */
+    AVX512      /**< 16 carriles */
+};
+
+/**
+ * @struct TransformBatch
+ * @brief Columnas de entrada y salida de @ref composeTRS (las de @ref TransformComponents).
+ */
+struct TransformBatch {
+    const glm::vec3* positions;   /**< Posición */
+    const glm::quat* rotations;   /**< Rotación (unitaria) */
+    const glm::vec3* scales;      /**< Escala (sin componentes nulas) */
+    glm::mat4* worlds;            /**< Salida: T * R * S */
+    glm::mat3* normals;           /**< Salida: inversa traspuesta de R * S, es decir R * S^-1 */
+};
+
+/**
+ * @struct SphereBatch
+ * @brief Columnas de entrada y salida de @ref transformSpheres (las de @ref BoundsComponents).
+ */
+struct SphereBatch {
+    const glm::mat4* worlds;      /**< Matrices de mundo, indexadas por el índice de transformación */
+    const glm::vec3* localCenters; /**< Centro local */
+    const float* localRadii;      /**< Radio local */
+    glm::vec3* worldCenters;      /**< Salida: centro en el mundo */
+    float* worldRadii;            /**< Salida: radio escalado por el mayor eje de la matriz */
+};
+
+/**
+ * @brief Mejor nivel que soportan la CPU y el sistema operativo.
+ */
+SimdLevel detect();
+
+/**
+ * @brief Nivel que usan las llamadas sin nivel explícito (@ref detect salvo que se fuerce otro).
+ */
+SimdLevel active();
+
+/**
+ * @brief Fuerza el nivel por defecto (acotado a @ref detect). Útil para comparar variantes.
+ */
+void force(SimdLevel level);
+
+/**
+ * @brief Nombre legible de un nivel.
+ */
+const char* name(SimdLevel level);
+
+/**
+ * @brief Compone matriz de mundo y de normales a partir de posición, rotación y escala locales.
+ *
+ * @param batch Columnas.
+ * @param indices Índices densos a calcular (sin repetir).
+ * @param count Número de índices.
+ * @param level Conjunto de instrucciones.
+ */
+void composeTRS(const TransformBatch& batch, const uint32_t* indices, size_t count, SimdLevel level = active());
+
+/**
+ * @brief Pasa esferas locales al mundo.
+ *
+ * @param batch Columnas.
+ * @param sphereIndices Índices densos de las esferas (sin repetir).
+ * @param transformIndices Índice de la matriz de cada esfera.
+ * @param count Número de esferas.
+ * @param level Conjunto de instrucciones.
+ */
+void transformSpheres(const SphereBatch& batch, const uint32_t* sphereIndices, const uint32_t* transformIndices,
+                      size_t count, SimdLevel level = active());
+
+} // namespace TransformKernels
+
+#endif // TRANSFORM_KERNELS_H
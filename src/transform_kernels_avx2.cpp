@@ -0,0 +1,120 @@
+// TransformKernelsAvx2.cpp
+//
+// Built with AVX2 enabled; only called when the CPU supports it.
+
+#include "transform_kernels_simd.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace {
+
+using namespace TransformKernels;
+
+struct Avx2 {
+    using Float = __m256;
+    using Int = __m256i;
+    static constexpr int kWidth = 8;
+
+    static Float set1(float value) { return _mm256_set1_ps(value); }
+    static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+    static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+    static Float div(Float a, Float b) { return _mm256_div_ps(a, b); }
+    static Float max(Float a, Float b) { return _mm256_max_ps(a, b); }
+    static Float sqrt(Float a) { return _mm256_sqrt_ps(a); }
+
+    static Int loadIndices(const uint32_t* indices) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices)); }
+    static Int scaleIndices(Int indices, int stride) { return _mm256_mullo_epi32(indices, _mm256_set1_epi32(stride)); }
+    static Float gather(const float* base, Int offsets) { return _mm256_i32gather_ps(base, offsets, 4); }
+
+    // Rows become lanes: afterwards r[l] holds the eight components of lane l
+    static void transpose8(Float (&r)[8])
+    {
+        const Float t0 = _mm256_unpacklo_ps(r[0], r[1]), t1 = _mm256_unpackhi_ps(r[0], r[1]);
+        const Float t2 = _mm256_unpacklo_ps(r[2], r[3]), t3 = _mm256_unpackhi_ps(r[2], r[3]);
+        const Float t4 = _mm256_unpacklo_ps(r[4], r[5]), t5 = _mm256_unpackhi_ps(r[4], r[5]);
+        const Float t6 = _mm256_unpacklo_ps(r[6], r[7]), t7 = _mm256_unpackhi_ps(r[6], r[7]);
+        const Float s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        const Float s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        const Float s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0)), s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+        const Float s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0)), s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+        r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+        r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+        r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+        r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+        r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+        r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+        r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+        r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+    }
+
+    // Eight components at a time, one contiguous half matrix per lane
+    static void storeMat4(float* out, const uint32_t* indices, const Float (&c)[16])
+    {
+        for (int half = 0; half < 2; ++half)
+        {
+            Float r[8];
+            for (int i = 0; i < 8; ++i)
+                r[i] = c[half * 8 + i];
+            transpose8(r);
+            for (int lane = 0; lane < kWidth; ++lane)
+                _mm256_storeu_ps(out + indices[lane] * detail::kMat4Stride + half * 8, r[lane]);
+        }
+    }
+
+    // Components 0-7 transposed (they fit inside the 9-float matrix); the ninth one lane at a time
+    static void storeMat3(float* out, const uint32_t* indices, const Float (&c)[9])
+    {
+        Float r[8];
+        for (int i = 0; i < 8; ++i)
+            r[i] = c[i];
+        transpose8(r);
+        for (int lane = 0; lane < kWidth; ++lane)
+            _mm256_storeu_ps(out + indices[lane] * detail::kMat3Stride, r[lane]);
+        storeFloat(out + 8, indices, c[8], detail::kMat3Stride);
+    }
+
+    // A wide store would overwrite the next vec3, which may belong to another job
+    static void storeVec3(float* out, const uint32_t* indices, const Float (&c)[3])
+    {
+        for (int component = 0; component < 3; ++component)
+            storeFloat(out + component, indices, c[component], detail::kVec3Stride);
+    }
+
+    static void storeFloat(float* out, const uint32_t* indices, Float value, int stride = 1)
+    {
+        alignas(32) float lanes[kWidth];
+        _mm256_store_ps(lanes, value);
+        for (int lane = 0; lane < kWidth; ++lane)
+            out[indices[lane] * stride] = lanes[lane];
+    }
+};
+
+} // namespace
+
+void TransformKernels::detail::composeTRSAvx2(const TransformBatch& batch, const uint32_t* indices, size_t count)
+{
+    composeTRSWide<Avx2>(batch, indices, count);
+}
+
+void TransformKernels::detail::transformSpheresAvx2(const SphereBatch& batch, const uint32_t* sphereIndices,
+                                                    const uint32_t* transformIndices, size_t count)
+{
+    transformSpheresWide<Avx2>(batch, sphereIndices, transformIndices, count);
+}
+
+#else
+
+void TransformKernels::detail::composeTRSAvx2(const TransformBatch& batch, const uint32_t* indices, size_t count)
+{
+    composeTRSScalar(batch, indices, count);
+}
+
+void TransformKernels::detail::transformSpheresAvx2(const SphereBatch& batch, const uint32_t* sphereIndices,
+                                                    const uint32_t* transformIndices, size_t count)
+{
+    transformSpheresScalar(batch, sphereIndices, transformIndices, count);
+}
+
+#endif
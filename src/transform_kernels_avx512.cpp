@@ -0,0 +1,72 @@
+// TransformKernelsAvx512.cpp
+//
+// Built with AVX-512F enabled; only called when the CPU supports it.
+
+#include "transform_kernels_simd.h"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+namespace {
+
+using namespace TransformKernels;
+
+struct Avx512 {
+    using Float = __m512;
+    using Int = __m512i;
+    static constexpr int kWidth = 16;
+
+    static Float set1(float value) { return _mm512_set1_ps(value); }
+    static Float add(Float a, Float b) { return _mm512_add_ps(a, b); }
+    static Float sub(Float a, Float b) { return _mm512_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm512_mul_ps(a, b); }
+    static Float div(Float a, Float b) { return _mm512_div_ps(a, b); }
+    static Float max(Float a, Float b) { return _mm512_max_ps(a, b); }
+    static Float sqrt(Float a) { return _mm512_sqrt_ps(a); }
+
+    static Int loadIndices(const uint32_t* indices) { return _mm512_loadu_si512(indices); }
+    static Int scaleIndices(Int indices, int stride) { return _mm512_mullo_epi32(indices, _mm512_set1_epi32(stride)); }
+    static Float gather(const float* base, Int offsets) { return _mm512_i32gather_ps(offsets, base, 4); }
+
+    // Sixteen lanes would need a 16x16 transpose; scatters write each component in place instead
+    template <int Components, int Stride>
+    static void scatter(float* out, const uint32_t* indices, const Float (&c)[Components])
+    {
+        const Int offsets = scaleIndices(loadIndices(indices), Stride);
+        for (int component = 0; component < Components; ++component)
+            _mm512_i32scatter_ps(out + component, offsets, c[component], 4);
+    }
+
+    static void storeMat4(float* out, const uint32_t* indices, const Float (&c)[16]) { scatter<16, detail::kMat4Stride>(out, indices, c); }
+    static void storeMat3(float* out, const uint32_t* indices, const Float (&c)[9]) { scatter<9, detail::kMat3Stride>(out, indices, c); }
+    static void storeVec3(float* out, const uint32_t* indices, const Float (&c)[3]) { scatter<3, detail::kVec3Stride>(out, indices, c); }
+    static void storeFloat(float* out, const uint32_t* indices, Float value) { _mm512_i32scatter_ps(out, loadIndices(indices), value, 4); }
+};
+
+} // namespace
+
+void TransformKernels::detail::composeTRSAvx512(const TransformBatch& batch, const uint32_t* indices, size_t count)
+{
+    composeTRSWide<Avx512>(batch, indices, count);
+}
+
+void TransformKernels::detail::transformSpheresAvx512(const SphereBatch& batch, const uint32_t* sphereIndices,
+                                                      const uint32_t* transformIndices, size_t count)
+{
+    transformSpheresWide<Avx512>(batch, sphereIndices, transformIndices, count);
+}
+
+#else
+
+void TransformKernels::detail::composeTRSAvx512(const TransformBatch& batch, const uint32_t* indices, size_t count)
+{
+    composeTRSScalar(batch, indices, count);
+}
+
+void TransformKernels::detail::transformSpheresAvx512(const SphereBatch& batch, const uint32_t* sphereIndices,
+                                                      const uint32_t* transformIndices, size_t count)
+{
+    transformSpheresScalar(batch, sphereIndices, transformIndices, count);
+}
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef TRANSFORM_KERNELS_SIMD_H
+#define TRANSFORM_KERNELS_SIMD_H
+
+#include "transform_kernels.h"
+
+/**
+ * @namespace TransformKernels::detail
+ * @brief Variantes por conjunto de instrucciones y el cuerpo común que las genera. Uso interno.
+ *
+ * Cada variante instancia @ref composeTRSWide y @ref transformSpheresWide con un tipo de
+ * operaciones (@c S) que define el ancho y envuelve los intrínsecos:
+ * - @c Float, @c Int, @c kWidth
+ * - @c set1, @c add, @c sub, @c mul, @c div, @c max, @c sqrt
+ * - @c loadIndices, @c scaleIndices (índice por zancada en floats), @c gather
+ * - @c storeMat4, @c storeMat3, @c storeVec3, @c storeFloat (por índice)
+ */
+namespace TransformKernels {
+namespace detail {
+
+void composeTRSScalar(const TransformBatch& batch, const uint32_t* indices, size_t count);
+void composeTRSSse41(const TransformBatch& batch, const uint32_t* indices, size_t count);
+void composeTRSAvx2(const TransformBatch& batch, const uint32_t* indices, size_t count);
+void composeTRSAvx512(const TransformBatch& batch, const uint32_t* indices, size_t count);
+
+void transformSpheresScalar(const SphereBatch& batch, const uint32_t* sphereIndices, const uint32_t* transformIndices, size_t count);
+void transformSpheresSse41(const SphereBatch& batch, const uint32_t* sphereIndices, const uint32_t* transformIndices, size_t count);
+void transformSpheresAvx2(const SphereBatch& batch, const uint32_t* sphereIndices, const uint32_t* transformIndices, size_t count);
+void transformSpheresAvx512(const SphereBatch& batch, const uint32_t* sphereIndices, const uint32_t* transformIndices, size_t count);
+
+constexpr int kVec3Stride = sizeof(glm::vec3) / sizeof(float);   /**< Floats por vec3 */
+constexpr int kQuatStride = sizeof(glm::quat) / sizeof(float);   /**< Floats por quat */
+constexpr int kMat3Stride = sizeof(glm::mat3) / sizeof(float);   /**< Floats por mat3 */
+constexpr int kMat4Stride = sizeof(glm::mat4) / sizeof(float);   /**< Floats por mat4 */
+
+/**
+ * @struct QuatLayout
+ * @brief Posición de cada componente dentro de glm::quat (depende de la configuración de glm).
+ */
+struct QuatLayout {
+    int x, y, z, w;
+};
+
+inline QuatLayout quatLayout()
+{
+    static const glm::quat probe;
+    const float* base = reinterpret_cast<const float*>(&probe);
+    return {static_cast<int>(&probe.x - base), static_cast<int>(&probe.y - base),
+            static_cast<int>(&probe.z - base), static_cast<int>(&probe.w - base)};
+}
+
+// Same math as the scalar path, one entity per lane; the remainder goes through the scalar path
+template <typename S>
+void composeTRSWide(const TransformBatch& batch, const uint32_t* indices, size_t count)
+{
+    using V = typename S::Float;
+    using I = typename S::Int;
+    const float* position = reinterpret_cast<const float*>(batch.positions);
+    const float* rotation = reinterpret_cast<const float*>(batch.rotations);
+    const float* scale = reinterpret_cast<const float*>(batch.scales);
+    const QuatLayout q = quatLayout();
+    const V zero = S::set1(0.0f);
+    const V one = S::set1(1.0f);
+    const V two = S::set1(2.0f);
+
+    size_t k = 0;
+    for (; k + S::kWidth <= count; k += S::kWidth)
+    {
+        const I lanes = S::loadIndices(indices + k);
+        const I vec3Lanes = S::scaleIndices(lanes, kVec3Stride);
+        const I quatLanes = S::scaleIndices(lanes, kQuatStride);
+
+        const V px = S::gather(position, vec3Lanes), py = S::gather(position + 1, vec3Lanes), pz = S::gather(position + 2, vec3Lanes);
+        const V sx = S::gather(scale, vec3Lanes), sy = S::gather(scale + 1, vec3Lanes), sz = S::gather(scale + 2, vec3Lanes);
+        const V qx = S::gather(rotation + q.x, quatLanes), qy = S::gather(rotation + q.y, quatLanes);
+        const V qz = S::gather(rotation + q.z, quatLanes), qw = S::gather(rotation + q.w, quatLanes);
+
+        // Rotation basis as glm::mat3_cast builds it
+        const V xx = S::mul(qx, qx), yy = S::mul(qy, qy), zz = S::mul(qz, qz);
+        const V xy = S::mul(qx, qy), xz = S::mul(qx, qz), yz = S::mul(qy, qz);
+        const V wx = S::mul(qw, qx), wy = S::mul(qw, qy), wz = S::mul(qw, qz);
+        const V r00 = S::sub(one, S::mul(two, S::add(yy, zz)));
+        const V r01 = S::mul(two, S::add(xy, wz));
+        const V r02 = S::mul(two, S::sub(xz, wy));
+        const V r10 = S::mul(two, S::sub(xy, wz));
+        const V r11 = S::sub(one, S::mul(two, S::add(xx, zz)));
+        const V r12 = S::mul(two, S::add(yz, wx));
+        const V r20 = S::mul(two, S::add(xz, wy));
+        const V r21 = S::mul(two, S::sub(yz, wx));
+        const V r22 = S::sub(one, S::mul(two, S::add(xx, yy)));
+
+        const V world[16] = {
+            S::mul(r00, sx), S::mul(r01, sx), S::mul(r02, sx), zero,
+            S::mul(r10, sy), S::mul(r11, sy), S::mul(r12, sy), zero,
+            S::mul(r20, sz), S::mul(r21, sz), S::mul(r22, sz), zero,
+            px, py, pz, one};
+        const V ix = S::div(one, sx), iy = S::div(one, sy), iz = S::div(one, sz);
+        const V normal[9] = {
+            S::mul(r00, ix), S::mul(r01, ix), S::mul(r02, ix),
+            S::mul(r10, iy), S::mul(r11, iy), S::mul(r12, iy),
+            S::mul(r20, iz), S::mul(r21, iz), S::mul(r22, iz)};
+        S::storeMat4(reinterpret_cast<float*>(batch.worlds), indices + k, world);
+        S::storeMat3(reinterpret_cast<float*>(batch.normals), indices + k, normal);
+    }
+    composeTRSScalar(batch, indices + k, count - k);
+}
+
+template <typename S>
+void transformSpheresWide(const SphereBatch& batch, const uint32_t* sphereIndices, const uint32_t* transformIndices, size_t count)
+{
+    using V = typename S::Float;
+    using I = typename S::Int;
+    const float* world = reinterpret_cast<const float*>(batch.worlds);
+    const float* center = reinterpret_cast<const float*>(batch.localCenters);
+
+    size_t k = 0;
+    for (; k + S::kWidth <= count; k += S::kWidth)
+    {
+        const I spheres = S::loadIndices(sphereIndices + k);
+        const I matrices = S::scaleIndices(S::loadIndices(transformIndices + k), kMat4Stride);
+        const I centers = S::scaleIndices(spheres, kVec3Stride);
+
+        V m[12];
+        for (int column = 0; column < 4; ++column)
+            for (int row = 0; row < 3; ++row)
+                m[column * 3 + row] = S::gather(world + column * 4 + row, matrices);
+        const V cx = S::gather(center, centers), cy = S::gather(center + 1, centers), cz = S::gather(center + 2, centers);
+        const V radius = S::gather(batch.localRadii, spheres);
+
+        V out[3];
+        for (int row = 0; row < 3; ++row)
+            out[row] = S::add(S::add(S::mul(m[row], cx), S::mul(m[3 + row], cy)),
+                              S::add(S::mul(m[6 + row], cz), m[9 + row]));
+
+        // Largest squared axis length, then one square root
+        V axis[3];
+        for (int column = 0; column < 3; ++column)
+            axis[column] = S::add(S::add(S::mul(m[column * 3], m[column * 3]), S::mul(m[column * 3 + 1], m[column * 3 + 1])),
+                                  S::mul(m[column * 3 + 2], m[column * 3 + 2]));
+        const V scale = S::sqrt(S::max(axis[0], S::max(axis[1], axis[2])));
+
+        S::storeVec3(reinterpret_cast<float*>(batch.worldCenters), sphereIndices + k, out);
+        S::storeFloat(batch.worldRadii, sphereIndices + k, S::mul(radius, scale));
+    }
+    transformSpheresScalar(batch, sphereIndices + k, transformIndices + k, count - k);
+}
+
+} // namespace detail
+} // namespace TransformKernels
+
+#endif // TRANSFORM_KERNELS_SIMD_H
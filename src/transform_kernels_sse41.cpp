@@ -0,0 +1,108 @@
+// TransformKernelsSse41.cpp
+//
+// Built with SSE4.1 enabled; only called when the CPU supports it.
+
+#include "transform_kernels_simd.h"
+
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+
+namespace {
+
+using namespace TransformKernels;
+
+struct Sse41 {
+    using Float = __m128;
+    using Int = __m128i;
+    static constexpr int kWidth = 4;
+
+    static Float set1(float value) { return _mm_set1_ps(value); }
+    static Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+    static Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+    static Float div(Float a, Float b) { return _mm_div_ps(a, b); }
+    static Float max(Float a, Float b) { return _mm_max_ps(a, b); }
+    static Float sqrt(Float a) { return _mm_sqrt_ps(a); }
+
+    static Int loadIndices(const uint32_t* indices) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices)); }
+    static Int scaleIndices(Int indices, int stride) { return _mm_mullo_epi32(indices, _mm_set1_epi32(stride)); }
+
+    // No gather instruction: four scalar loads
+    static Float gather(const float* base, Int offsets)
+    {
+        return _mm_setr_ps(base[_mm_extract_epi32(offsets, 0)], base[_mm_extract_epi32(offsets, 1)],
+                           base[_mm_extract_epi32(offsets, 2)], base[_mm_extract_epi32(offsets, 3)]);
+    }
+
+    // Each group of four components transposes into one column per lane
+    static void storeMat4(float* out, const uint32_t* indices, const Float (&c)[16])
+    {
+        for (int column = 0; column < 4; ++column)
+        {
+            Float r0 = c[column * 4], r1 = c[column * 4 + 1], r2 = c[column * 4 + 2], r3 = c[column * 4 + 3];
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(out + indices[0] * detail::kMat4Stride + column * 4, r0);
+            _mm_storeu_ps(out + indices[1] * detail::kMat4Stride + column * 4, r1);
+            _mm_storeu_ps(out + indices[2] * detail::kMat4Stride + column * 4, r2);
+            _mm_storeu_ps(out + indices[3] * detail::kMat4Stride + column * 4, r3);
+        }
+    }
+
+    // Components 0-7 as two transposed quads; the ninth one lane at a time
+    static void storeMat3(float* out, const uint32_t* indices, const Float (&c)[9])
+    {
+        for (int group = 0; group < 2; ++group)
+        {
+            Float r0 = c[group * 4], r1 = c[group * 4 + 1], r2 = c[group * 4 + 2], r3 = c[group * 4 + 3];
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(out + indices[0] * detail::kMat3Stride + group * 4, r0);
+            _mm_storeu_ps(out + indices[1] * detail::kMat3Stride + group * 4, r1);
+            _mm_storeu_ps(out + indices[2] * detail::kMat3Stride + group * 4, r2);
+            _mm_storeu_ps(out + indices[3] * detail::kMat3Stride + group * 4, r3);
+        }
+        storeFloat(out + 8, indices, c[8], detail::kMat3Stride);
+    }
+
+    // A four-wide store would overwrite the next vec3, which may belong to another job
+    static void storeVec3(float* out, const uint32_t* indices, const Float (&c)[3])
+    {
+        for (int component = 0; component < 3; ++component)
+            storeFloat(out + component, indices, c[component], detail::kVec3Stride);
+    }
+
+    static void storeFloat(float* out, const uint32_t* indices, Float value, int stride = 1)
+    {
+        alignas(16) float lanes[kWidth];
+        _mm_store_ps(lanes, value);
+        for (int lane = 0; lane < kWidth; ++lane)
+            out[indices[lane] * stride] = lanes[lane];
+    }
+};
+
+} // namespace
+
+void TransformKernels::detail::composeTRSSse41(const TransformBatch& batch, const uint32_t* indices, size_t count)
+{
+    composeTRSWide<Sse41>(batch, indices, count);
+}
+
+void TransformKernels::detail::transformSpheresSse41(const SphereBatch& batch, const uint32_t* sphereIndices,
+                                                     const uint32_t* transformIndices, size_t count)
+{
+    transformSpheresWide<Sse41>(batch, sphereIndices, transformIndices, count);
+}
+
+#else
+
+void TransformKernels::detail::composeTRSSse41(const TransformBatch& batch, const uint32_t* indices, size_t count)
+{
+    composeTRSScalar(batch, indices, count);
+}
+
+void TransformKernels::detail::transformSpheresSse41(const SphereBatch& batch, const uint32_t* sphereIndices,
+                                                     const uint32_t* transformIndices, size_t count)
+{
+    transformSpheresScalar(batch, sphereIndices, transformIndices, count);
+}
+
+#endif
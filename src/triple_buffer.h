@@ -0,0 +1,68 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @class TripleBuffer
+ * @brief Intercambio sin bloqueos del último valor publicado entre un escritor y un lector.
+ *
+ * El escritor rellena su copia privada y la publica; el lector toma la publicación más
+ * reciente cuando quiere. Ninguno espera al otro: si el escritor publica varias veces entre
+ * dos lecturas, el lector solo ve la última, y si no publica, el lector conserva la anterior.
+ *
+ * @tparam T Tipo del valor (se copia entero, conviene que sea pequeño).
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    /**
+     * @brief Constructor. Las tres copias empiezan con el mismo valor, así el lector siempre tiene uno válido.
+     */
+    explicit TripleBuffer(const T& initial = T())
+        : slots{initial, initial, initial}
+    {
+    }
+
+    /**
+     * @brief Copia privada del escritor, para rellenarla antes de @ref publish.
+     */
+    T& back() { return slots[backIndex]; }
+
+    /**
+     * @brief Publica la copia del escritor y le entrega la anterior publicación sin leer o ya leída.
+     */
+    void publish()
+    {
+        backIndex = middle.exchange(static_cast<uint8_t>(backIndex | kFresh), std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    /**
+     * @brief Toma la última publicación, si hay una nueva. Solo desde el hilo lector.
+     * @return true si @ref front cambió.
+     */
+    bool update()
+    {
+        if ((middle.load(std::memory_order_relaxed) & kFresh) == 0)
+            return false;
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+
+    /**
+     * @brief Valor que el lector tiene en uso.
+     */
+    const T& front() const { return slots[frontIndex]; }
+
+private:
+    static constexpr uint8_t kIndexMask = 0x3; /**< Bits del índice de la copia intermedia */
+    static constexpr uint8_t kFresh = 0x4;     /**< La copia intermedia aún no se ha leído */
+
+    T slots[3];                          /**< Copias del lector, intermedia y del escritor */
+    uint8_t frontIndex = 0;              /**< Copia del lector */
+    uint8_t backIndex = 1;               /**< Copia del escritor */
+    std::atomic<uint8_t> middle{2};      /**< Copia intermedia y bit de publicación nueva */
+};
+
+#endif // TRIPLE_BUFFER_H
@@ -0,0 +1,625 @@
+// VirtualTexture.cpp
+
+#include "virtual_texture.h"
+#include "asset_pack.h"
+#include "job_system.h"
+#include "shader_manager.h"
+#include "Constants.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+// Decodes one page tile on a worker thread; an empty result marks a missing or malformed tile
+std::vector<unsigned char> decodeTile(const std::string& path, int slotSize)
+{
+    stbi_set_flip_vertically_on_load_thread(0);
+
+    int width = 0, height = 0, channels = 0;
+    stbi_uc* pixels = nullptr;
+    AssetBlob blob;
+    const AssetPack* pack = AssetPack::mounted();
+    if (pack && pack->find(path, blob) && blob.kind == AssetKind::Raw)
+        pixels = stbi_load_from_memory(blob.data, static_cast<int>(blob.size), &width, &height, &channels, 4);
+    else
+        pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+
+    std::vector<unsigned char> bytes;
+    if (pixels && width == slotSize && height == slotSize)
+        bytes.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(pixels);
+    return bytes;
+}
+
+bool isPowerOfTwo(int value)
+{
+    return value > 0 && (value & (value - 1)) == 0;
+}
+
+} // namespace
+
+VirtualTexture::VirtualTexture(int physicalPagesPerSide, int uploadsPerFrame, int maxPendingLoads)
+    : ready(false), virtualSize(0), pageSize(0), border(0), levels(0),
+      physicalPagesPerSide(std::min(std::max(physicalPagesPerSide, 2), 256)),
+      uploadsPerFrame(uploadsPerFrame), maxPendingLoads(maxPendingLoads),
+      worldOrigin(0.0f), worldSize(1.0f),
+      pageTableTexture(0), physicalTexture(0), feedbackFBO(0), feedbackColor(0), feedbackDepth(0),
+      feedbackWidth(0), feedbackHeight(0), savedViewport{0, 0, 0, 0},
+      readbackHead(0), readbackTail(0), readbackBytes(0), frameIndex(0)
+{
+}
+
+VirtualTexture::~VirtualTexture()
+{
+    release();
+}
+
+uint32_t VirtualTexture::pageKey(int level, int x, int y)
+{
+    return (static_cast<uint32_t>(level) << 28) | (static_cast<uint32_t>(y) << 14) | static_cast<uint32_t>(x);
+}
+
+void VirtualTexture::decodeKey(uint32_t key, int& level, int& x, int& y)
+{
+    level = static_cast<int>(key >> 28);
+    y = static_cast<int>((key >> 14) & 0x3FFF);
+    x = static_cast<int>(key & 0x3FFF);
+}
+
+std::string VirtualTexture::tilePath(int level, int x, int y) const
+{
+    return tileDirectory + "/" + std::to_string(level) + "/" + std::to_string(x) + "_" + std::to_string(y) + ".tga";
+}
+
+bool VirtualTexture::readDescriptor(const std::string& path)
+{
+    std::string text;
+    AssetBlob blob;
+    const AssetPack* pack = AssetPack::mounted();
+    if (pack && pack->find(path, blob))
+    {
+        text.assign(reinterpret_cast<const char*>(blob.data), blob.size);
+    }
+    else
+    {
+        std::ifstream file(path);
+        if (!file)
+            return false;
+        std::stringstream stream;
+        stream << file.rdbuf();
+        text = stream.str();
+    }
+
+    std::istringstream lines(text);
+    std::string key;
+    int value = 0;
+    virtualSize = pageSize = border = 0;
+    while (lines >> key >> value)
+    {
+        if (key == "size")        virtualSize = value;
+        else if (key == "page")   pageSize = value;
+        else if (key == "border") border = value;
+    }
+
+    if (pageSize <= 0 || border < 0 || virtualSize < pageSize || virtualSize % pageSize != 0
+        || !isPowerOfTwo(virtualSize / pageSize) || virtualSize / pageSize > 0x3FFF)
+    {
+        std::cerr << "Invalid virtual texture descriptor: " << path << std::endl;
+        return false;
+    }
+
+    levels = 1;
+    while ((virtualSize / pageSize) >> (levels - 1) > 1)
+        ++levels;
+
+    size_t slash = path.find_last_of('/');
+    tileDirectory = slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+    return true;
+}
+
+bool VirtualTexture::open(const std::string& descriptorPath, const glm::vec2& origin, const glm::vec2& size)
+{
+    release();
+    if (!readDescriptor(descriptorPath))
+        return false;
+
+    worldOrigin = origin;
+    worldSize = size;
+
+    // Page table: one texel per page and one mip per virtual level, so the shader can
+    // texelFetch the entry for any level directly. Both textures go through the resource
+    // manager so they count against the GPU budget and are retired behind a frame fence.
+    const int pagesPerSide = virtualSize / pageSize;
+    pageTableDesc.levels = levels;
+    pageTableDesc.internalFormat = GL_RGBA8UI;
+    pageTableDesc.width = pageTableDesc.height = pagesPerSide;
+    pageTableTexture = GLResourceManager::createTexture(pageTableDesc);
+    // Integer textures are only complete with nearest filtering
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    pageTable.assign(levels, std::vector<unsigned char>());
+    dirty.assign(levels, DirtyRect{INT_MAX, INT_MAX, 0, 0});
+    for (int level = 0; level < levels; ++level)
+    {
+        const int n = pagesAtLevel(level);
+        pageTable[level].assign(static_cast<size_t>(n) * n * 4, 0);
+        markDirty(level, 0, 0, n, n);
+    }
+
+    // Physical atlas: fixed number of bordered slots, independent of the virtual size
+    const int slotSize = pageSize + 2 * border;
+    const int atlasSize = physicalPagesPerSide * slotSize;
+    physicalDesc.levels = 1;
+    physicalDesc.internalFormat = GL_SRGB8_ALPHA8;
+    physicalDesc.width = physicalDesc.height = atlasSize;
+    physicalTexture = GLResourceManager::createTexture(physicalDesc);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    slots.assign(static_cast<size_t>(physicalPagesPerSide) * physicalPagesPerSide, Slot());
+    freeSlots.clear();
+    for (int i = static_cast<int>(slots.size()) - 1; i >= 0; --i)
+        freeSlots.push_back(i);
+    lru.clear();
+    residentPages.clear();
+    failedPages.clear();
+
+    // Feedback target: page requests per pixel at a fraction of the screen resolution
+    feedbackWidth = std::max<GLsizei>(1, WINDOW_WIDTH / kFeedbackDivisor);
+    feedbackHeight = std::max<GLsizei>(1, WINDOW_HEIGHT / kFeedbackDivisor);
+    glGenRenderbuffers(1, &feedbackColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, feedbackColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA16UI, feedbackWidth, feedbackHeight);
+    glGenRenderbuffers(1, &feedbackDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, feedbackDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, feedbackWidth, feedbackHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &feedbackFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, feedbackFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, feedbackColor);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, feedbackDepth);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Virtual texture feedback framebuffer incomplete: 0x" << std::hex << status << std::dec << std::endl;
+        release();
+        return false;
+    }
+
+    readbackBytes = static_cast<GLsizeiptr>(feedbackWidth) * feedbackHeight * 4 * sizeof(GLushort);
+    for (Readback& readback : readbacks)
+    {
+        readback.buffer = GLResourceManager::createBuffer(GL_PIXEL_PACK_BUFFER, readbackBytes, nullptr, GL_STREAM_READ);
+        readback.fence = nullptr;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readbackHead = readbackTail = 0;
+
+    feedbackShader = ShaderManager::create("assets/shaders/vt_feedback_vertex_shader.glsl",
+                                           "assets/shaders/vt_feedback_fragment_shader.glsl",
+                                           std::string(), WarmUpTarget::UnsignedFeedback);
+
+    flushPageTable();
+    ready = true;
+
+    // The single root page is the fallback for the whole world; load it right away
+    requests.assign(1, std::make_pair(pageKey(levels - 1, 0, 0), 1));
+    requestPages();
+    return true;
+}
+
+void VirtualTexture::release()
+{
+    ready = false;
+
+    // Job futures do not join on destruction; wait so no decode outlives the asset pack
+    for (auto& load : pendingLoads)
+        load.second.wait();
+    pendingLoads.clear();
+
+    for (Readback& readback : readbacks)
+    {
+        if (readback.fence)
+            glDeleteSync(readback.fence);
+        GLResourceManager::deleteBuffer(readback.buffer, readbackBytes, GL_STREAM_READ);
+        readback = Readback();
+    }
+    if (feedbackFBO)
+        glDeleteFramebuffers(1, &feedbackFBO);
+    if (feedbackColor)
+        glDeleteRenderbuffers(1, &feedbackColor);
+    if (feedbackDepth)
+        glDeleteRenderbuffers(1, &feedbackDepth);
+    GLResourceManager::deleteTexture(pageTableTexture, pageTableDesc);
+    GLResourceManager::deleteTexture(physicalTexture, physicalDesc);
+    feedbackFBO = feedbackColor = feedbackDepth = 0;
+    pageTableTexture = physicalTexture = 0;
+    feedbackShader.reset();
+
+    pageTable.clear();
+    dirty.clear();
+    slots.clear();
+    freeSlots.clear();
+    lru.clear();
+    residentPages.clear();
+    requests.clear();
+}
+
+void VirtualTexture::setShaderParams(const Shader& shader) const
+{
+    shader.setVec4("vt_worldRect", glm::vec4(worldOrigin.x, worldOrigin.y, 1.0f / worldSize.x, 1.0f / worldSize.y));
+    shader.setVec4("vt_params", glm::vec4((float)virtualSize, (float)pageSize, (float)border, (float)(levels - 1)));
+    shader.setFloat("vt_physicalSize", (float)(physicalPagesPerSide * (pageSize + 2 * border)));
+}
+
+void VirtualTexture::apply(const Shader& shader) const
+{
+    shader.setInt("vt_pageTable", kPageTableUnit);
+    shader.setInt("vt_physical", kPhysicalUnit);
+    if (!ready)
+        return;
+
+    setShaderParams(shader);
+    glActiveTexture(GL_TEXTURE0 + kPageTableUnit);
+    glBindTexture(GL_TEXTURE_2D, pageTableTexture);
+    glBindSampler(kPageTableUnit, 0);
+    glActiveTexture(GL_TEXTURE0 + kPhysicalUnit);
+    glBindTexture(GL_TEXTURE_2D, physicalTexture);
+    glBindSampler(kPhysicalUnit, 0);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+const Shader* VirtualTexture::beginFeedback(const glm::mat4& view, const glm::mat4& projection)
+{
+    // All readbacks still in flight: skip this frame rather than stall on the GPU
+    if (!ready || readbacks[readbackHead].fence)
+        return nullptr;
+
+    glGetIntegerv(GL_VIEWPORT, savedViewport);
+    glBindFramebuffer(GL_FRAMEBUFFER, feedbackFBO);
+    glViewport(0, 0, feedbackWidth, feedbackHeight);
+    const GLuint noRequest[4] = {0, 0, 0, 0};
+    glClearBufferuiv(GL_COLOR, 0, noRequest);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    feedbackShader->use();
+    feedbackShader->setMat4("view", view);
+    feedbackShader->setMat4("projection", projection);
+    setShaderParams(*feedbackShader);
+    // Derivatives are kFeedbackDivisor times larger at the reduced resolution
+    feedbackShader->setFloat("vt_feedbackBias", -std::log2((float)kFeedbackDivisor));
+    return feedbackShader.get();
+}
+
+void VirtualTexture::endFeedback()
+{
+    Readback& readback = readbacks[readbackHead];
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, feedbackWidth, feedbackHeight, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readbackHead = (readbackHead + 1) % kReadbackCount;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+}
+
+void VirtualTexture::update()
+{
+    if (!ready)
+        return;
+
+    ++frameIndex;
+    stats.loadedLastFrame = 0;
+    stats.evictedLastFrame = 0;
+
+    collectFeedback();
+    requestPages();
+    uploadFinishedPages();
+    flushPageTable();
+
+    stats.physicalPages = static_cast<int>(slots.size());
+    stats.residentPages = static_cast<int>(residentPages.size());
+    stats.requestedPages = static_cast<int>(requests.size());
+    stats.pendingLoads = static_cast<int>(pendingLoads.size());
+    stats.failedPages = static_cast<int>(failedPages.size());
+}
+
+// Sorts page keys and turns runs of equal keys into (key, count) pairs
+void VirtualTexture::countKeys(FrameVector<uint32_t>& keys, FrameVector<std::pair<uint32_t, int>>& counted)
+{
+    std::sort(keys.begin(), keys.end());
+    for (size_t i = 0; i < keys.size();)
+    {
+        size_t run = i;
+        while (run < keys.size() && keys[run] == keys[i])
+            ++run;
+        counted.emplace_back(keys[i], static_cast<int>(run - i));
+        i = run;
+    }
+}
+
+// Consumes every readback whose fence has signaled, never waiting on one that has not
+void VirtualTexture::collectFeedback()
+{
+    const size_t texelCount = static_cast<size_t>(feedbackWidth) * feedbackHeight;
+    while (readbacks[readbackTail].fence)
+    {
+        Readback& readback = readbacks[readbackTail];
+        GLenum status = glClientWaitSync(readback.fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+            break;
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+        readbackTail = (readbackTail + 1) % kReadbackCount;
+        if (status == GL_WAIT_FAILED)
+            continue;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        const GLushort* texels = static_cast<const GLushort*>(
+            glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, texelCount * 4 * sizeof(GLushort), GL_MAP_READ_BIT));
+        if (texels)
+        {
+            // One key per covered pixel in the frame arena, then counted by sorting
+            FrameVector<uint32_t> keys = frameVector<uint32_t>();
+            keys.reserve(texelCount);
+            for (size_t i = 0; i < texelCount; ++i)
+            {
+                const GLushort* texel = texels + i * 4;
+                if (texel[3] == 0)
+                    continue;
+                int level = std::min<int>(texel[2], levels - 1);
+                int last = pagesAtLevel(level) - 1;
+                keys.push_back(pageKey(level, std::min<int>(texel[0], last), std::min<int>(texel[1], last)));
+            }
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+            // Every visible page also needs its coarser ancestors as fallbacks while it streams in
+            FrameVector<std::pair<uint32_t, int>> counted = frameVector<std::pair<uint32_t, int>>();
+            countKeys(keys, counted);
+            const size_t visible = counted.size();
+            for (size_t i = 0; i < visible; ++i)
+            {
+                int level, x, y;
+                decodeKey(counted[i].first, level, x, y);
+                while (++level < levels)
+                {
+                    x >>= 1;
+                    y >>= 1;
+                    counted.emplace_back(pageKey(level, x, y), counted[i].second);
+                }
+            }
+
+            // Merge duplicate ancestors; the member keeps its capacity from frame to frame
+            std::sort(counted.begin(), counted.end());
+            requests.clear();
+            for (const auto& request : counted)
+            {
+                if (!requests.empty() && requests.back().first == request.first)
+                    requests.back().second += request.second;
+                else
+                    requests.push_back(request);
+            }
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+}
+
+// Refreshes the LRU position of resident pages and starts tile decodes for missing ones
+void VirtualTexture::requestPages()
+{
+    FrameVector<std::pair<uint32_t, int>> missing = frameVector<std::pair<uint32_t, int>>();
+    for (const auto& [key, count] : requests)
+    {
+        auto resident = residentPages.find(key);
+        if (resident != residentPages.end())
+        {
+            Slot& slot = slots[resident->second];
+            slot.lastUsedFrame = frameIndex;
+            if (!slot.pinned)
+                lru.splice(lru.begin(), lru, slot.lruPos);
+            continue;
+        }
+        if (pendingLoads.count(key) || failedPages.count(key))
+            continue;
+        missing.emplace_back(key, count);
+    }
+
+    // Coarse pages first so every pixel gets a fallback quickly, then by screen coverage
+    std::sort(missing.begin(), missing.end(), [](const auto& a, const auto& b) {
+        if ((a.first >> 28) != (b.first >> 28))
+            return (a.first >> 28) > (b.first >> 28);
+        return a.second > b.second;
+    });
+
+    const int slotSize = pageSize + 2 * border;
+    for (const auto& request : missing)
+    {
+        if (static_cast<int>(pendingLoads.size()) >= maxPendingLoads)
+            break;
+        int level, x, y;
+        decodeKey(request.first, level, x, y);
+        pendingLoads.emplace(request.first, JobSystem::async([path = tilePath(level, x, y), slotSize]() {
+            return decodeTile(path, slotSize);
+        }));
+    }
+}
+
+void VirtualTexture::uploadFinishedPages()
+{
+    const int slotSize = pageSize + 2 * border;
+    for (auto it = pendingLoads.begin(); it != pendingLoads.end() && stats.loadedLastFrame < uploadsPerFrame;)
+    {
+        if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++it;
+            continue;
+        }
+
+        const uint32_t key = it->first;
+        std::vector<unsigned char> bytes = it->second.get();
+        it = pendingLoads.erase(it);
+        if (bytes.empty())
+        {
+            int level, x, y;
+            decodeKey(key, level, x, y);
+            std::cerr << "Failed to load virtual texture tile: " << tilePath(level, x, y) << std::endl;
+            failedPages.insert(key);
+            continue;
+        }
+
+        // With every slot in use this frame the page is dropped; the next feedback asks for it again
+        int slot = acquireSlot();
+        if (slot < 0)
+            break;
+
+        glBindTexture(GL_TEXTURE_2D, physicalTexture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0,
+                        (slot % physicalPagesPerSide) * slotSize, (slot / physicalPagesPerSide) * slotSize,
+                        slotSize, slotSize, GL_RGBA, GL_UNSIGNED_BYTE, bytes.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+        mapPage(key, slot);
+        ++stats.loadedLastFrame;
+    }
+}
+
+int VirtualTexture::acquireSlot()
+{
+    if (!freeSlots.empty())
+    {
+        int slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    }
+
+    if (lru.empty())
+        return -1;
+    int victim = lru.back();
+    if (slots[victim].lastUsedFrame >= frameIndex)
+        return -1;
+
+    lru.pop_back();
+    unmapPage(slots[victim].page);
+    ++stats.evictedLastFrame;
+    return victim;
+}
+
+// Points every entry under the page's footprint that falls back to something coarser at the new slot
+void VirtualTexture::mapPage(uint32_t page, int slotIndex)
+{
+    int level, x, y;
+    decodeKey(page, level, x, y);
+
+    Slot& slot = slots[slotIndex];
+    slot.page = page;
+    slot.lastUsedFrame = frameIndex;
+    slot.pinned = level == levels - 1;
+    if (!slot.pinned)
+    {
+        lru.push_front(slotIndex);
+        slot.lruPos = lru.begin();
+    }
+    residentPages[page] = slotIndex;
+
+    const unsigned char sx = static_cast<unsigned char>(slotIndex % physicalPagesPerSide);
+    const unsigned char sy = static_cast<unsigned char>(slotIndex / physicalPagesPerSide);
+    for (int l = level; l >= 0; --l)
+    {
+        const int shift = level - l;
+        const int n = pagesAtLevel(l);
+        const int x0 = x << shift, y0 = y << shift;
+        const int x1 = (x + 1) << shift, y1 = (y + 1) << shift;
+        for (int py = y0; py < y1; ++py)
+        {
+            unsigned char* entry = &pageTable[l][(static_cast<size_t>(py) * n + x0) * 4];
+            for (int px = x0; px < x1; ++px, entry += 4)
+            {
+                if (entry[3] == 0 || entry[2] > level)
+                {
+                    entry[0] = sx;
+                    entry[1] = sy;
+                    entry[2] = static_cast<unsigned char>(level);
+                    entry[3] = 255;
+                }
+            }
+        }
+        markDirty(l, x0, y0, x1, y1);
+    }
+}
+
+// Entries that pointed at the evicted page fall back to whatever now covers its parent
+void VirtualTexture::unmapPage(uint32_t page)
+{
+    int level, x, y;
+    decodeKey(page, level, x, y);
+    residentPages.erase(page);
+
+    unsigned char fallback[4] = {0, 0, 0, 0};
+    if (level + 1 < levels)
+    {
+        const int parentPages = pagesAtLevel(level + 1);
+        const unsigned char* parent = &pageTable[level + 1][(static_cast<size_t>(y >> 1) * parentPages + (x >> 1)) * 4];
+        std::copy(parent, parent + 4, fallback);
+    }
+
+    for (int l = level; l >= 0; --l)
+    {
+        const int shift = level - l;
+        const int n = pagesAtLevel(l);
+        const int x0 = x << shift, y0 = y << shift;
+        const int x1 = (x + 1) << shift, y1 = (y + 1) << shift;
+        for (int py = y0; py < y1; ++py)
+        {
+            unsigned char* entry = &pageTable[l][(static_cast<size_t>(py) * n + x0) * 4];
+            for (int px = x0; px < x1; ++px, entry += 4)
+            {
+                if (entry[3] != 0 && entry[2] == level)
+                    std::copy(fallback, fallback + 4, entry);
+            }
+        }
+        markDirty(l, x0, y0, x1, y1);
+    }
+}
+
+void VirtualTexture::markDirty(int level, int x0, int y0, int x1, int y1)
+{
+    DirtyRect& rect = dirty[level];
+    rect.x0 = std::min(rect.x0, x0);
+    rect.y0 = std::min(rect.y0, y0);
+    rect.x1 = std::max(rect.x1, x1);
+    rect.y1 = std::max(rect.y1, y1);
+}
+
+// Uploads the changed region of each page table level in one call per level
+void VirtualTexture::flushPageTable()
+{
+    glBindTexture(GL_TEXTURE_2D, pageTableTexture);
+    for (int level = 0; level < levels; ++level)
+    {
+        DirtyRect& rect = dirty[level];
+        if (rect.x1 <= rect.x0 || rect.y1 <= rect.y0)
+            continue;
+
+        const int n = pagesAtLevel(level);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, n);
+        glTexSubImage2D(GL_TEXTURE_2D, level, rect.x0, rect.y0, rect.x1 - rect.x0, rect.y1 - rect.y0,
+                        GL_RGBA_INTEGER, GL_UNSIGNED_BYTE,
+                        &pageTable[level][(static_cast<size_t>(rect.y0) * n + rect.x0) * 4]);
+        rect = DirtyRect{INT_MAX, INT_MAX, 0, 0};
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
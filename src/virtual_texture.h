@@ -0,0 +1,206 @@
+#ifndef VIRTUAL_TEXTURE_H
+#define VIRTUAL_TEXTURE_H
+
+#include "Shader.h"
+#include "frame_allocator.h"
+#include "gl_resource_manager.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/**
+ * @struct VirtualTextureStats
+ * @brief Contadores de la caché de páginas, actualizados en cada @ref VirtualTexture::update.
+ */
+struct VirtualTextureStats {
+    int physicalPages = 0;      /**< Páginas que caben en el atlas físico */
+    int residentPages = 0;      /**< Páginas cargadas en el atlas */
+    int requestedPages = 0;     /**< Páginas distintas pedidas por el último feedback */
+    int pendingLoads = 0;       /**< Páginas decodificándose en segundo plano */
+    int loadedLastFrame = 0;    /**< Páginas subidas en el último update */
+    int evictedLastFrame = 0;   /**< Páginas expulsadas en el último update */
+    int failedPages = 0;        /**< Páginas cuyo tile no pudo leerse */
+};
+
+/**
+ * @class VirtualTexture
+ * @brief Textura virtual para el terreno: tabla de páginas, atlas físico con LRU y feedback en GPU.
+ *
+ * La textura virtual (cuadrada, potencia de dos) se divide en páginas de @c pageSize texels
+ * por nivel de mip; cada página es un tile en disco (@c <dir>/<nivel>/<x>_<y>.tga, con
+ * @c border texels de borde para el filtrado bilineal) generado por @c vt_tile_builder.
+ *
+ * - El atlas físico tiene un número fijo de ranuras: la memoria de GPU no depende del
+ *   tamaño del mundo. Las páginas se expulsan por LRU; la página raíz queda fija.
+ * - La tabla de páginas (@c GL_RGBA8UI, un mip por nivel virtual) guarda para cada página
+ *   la ranura y el nivel de la página residente más fina que la cubre.
+ * - Un pase de feedback a baja resolución escribe la página que necesita cada píxel; se lee
+ *   con PBOs y fences unos frames después, sin bloquear el render.
+ * - Los tiles se decodifican en hilos de fondo y se suben con un límite por frame.
+ */
+class VirtualTexture {
+public:
+    static constexpr GLuint kPageTableUnit = 8;   /**< Unidad de textura de la tabla de páginas */
+    static constexpr GLuint kPhysicalUnit = 9;    /**< Unidad de textura del atlas físico */
+    static constexpr int kFeedbackDivisor = 8;    /**< Reducción de resolución del pase de feedback */
+    static constexpr int kReadbackCount = 3;      /**< PBOs en vuelo para la lectura del feedback */
+
+    /**
+     * @brief Constructor.
+     * @param physicalPagesPerSide Ranuras por lado del atlas físico (máximo 256).
+     * @param uploadsPerFrame Páginas subidas como máximo por frame.
+     * @param maxPendingLoads Decodificaciones de tiles en vuelo como máximo.
+     */
+    explicit VirtualTexture(int physicalPagesPerSide = 16, int uploadsPerFrame = 8, int maxPendingLoads = 16);
+
+    /**
+     * @brief Destructor. Libera los recursos de OpenGL y espera las decodificaciones pendientes.
+     */
+    ~VirtualTexture();
+
+    VirtualTexture(const VirtualTexture&) = delete;
+    VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+    /**
+     * @brief Lee el descriptor de la textura virtual y crea los recursos de GPU.
+     *
+     * @param descriptorPath Ruta del descriptor (@c terrain.vt) generado por @c vt_tile_builder.
+     * @param worldOrigin Esquina (x, z) del mundo que cubre la textura.
+     * @param worldSize Tamaño (x, z) del mundo que cubre la textura.
+     * @return true si la textura quedó lista para usarse.
+     */
+    bool open(const std::string& descriptorPath, const glm::vec2& worldOrigin, const glm::vec2& worldSize);
+
+    /**
+     * @brief Indica si la textura está abierta y puede muestrearse.
+     */
+    bool isReady() const { return ready; }
+
+    /**
+     * @brief Asigna las unidades de los samplers y, si está lista, enlaza la tabla y el atlas.
+     *
+     * Debe llamarse con la variante @c VIRTUAL_TEXTURE activa antes de dibujar el terreno.
+     *
+     * @param shader Variante del shader que muestrea la textura virtual.
+     */
+    void apply(const Shader& shader) const;
+
+    /**
+     * @brief Procesa el feedback leído, lanza la decodificación de tiles y sube páginas. Hilo de OpenGL.
+     */
+    void update();
+
+    /**
+     * @brief Prepara el pase de feedback (framebuffer reducido y shader de feedback).
+     *
+     * @param view Matriz de vista.
+     * @param projection Matriz de proyección.
+     * @return Shader con el que dibujar el terreno, o nullptr si no hay PBO libre este frame.
+     */
+    const Shader* beginFeedback(const glm::mat4& view, const glm::mat4& projection);
+
+    /**
+     * @brief Termina el pase de feedback: lanza la lectura asíncrona y restaura el framebuffer.
+     */
+    void endFeedback();
+
+    /**
+     * @brief Devuelve los contadores del último @ref update.
+     */
+    const VirtualTextureStats& getStats() const { return stats; }
+
+private:
+    /**
+     * @struct Slot
+     * @brief Ranura del atlas físico.
+     */
+    struct Slot {
+        uint32_t page = 0;                  /**< Página que ocupa la ranura */
+        uint64_t lastUsedFrame = 0;         /**< Último frame en que el feedback la pidió */
+        bool pinned = false;                /**< La página raíz nunca se expulsa */
+        std::list<int>::iterator lruPos;    /**< Posición en la lista LRU (si no está fija) */
+    };
+
+    /**
+     * @struct Readback
+     * @brief Lectura asíncrona del framebuffer de feedback.
+     */
+    struct Readback {
+        GLuint buffer = 0;                  /**< PBO de destino */
+        GLsync fence = nullptr;             /**< Fence de la lectura en curso */
+    };
+
+    /**
+     * @struct DirtyRect
+     * @brief Región modificada de un nivel de la tabla de páginas.
+     */
+    struct DirtyRect {
+        int x0, y0, x1, y1;                 /**< Rango semiabierto [x0, x1) x [y0, y1) */
+    };
+
+    bool ready;
+    std::string tileDirectory;              /**< Directorio de los tiles */
+    int virtualSize;                        /**< Lado de la textura virtual en texels */
+    int pageSize;                           /**< Texels útiles por lado de página */
+    int border;                             /**< Texels de borde por lado de página */
+    int levels;                             /**< Niveles virtuales (el último tiene una página) */
+    int physicalPagesPerSide;               /**< Ranuras por lado del atlas */
+    int uploadsPerFrame;                    /**< Páginas subidas por frame */
+    int maxPendingLoads;                    /**< Decodificaciones en vuelo */
+    glm::vec2 worldOrigin;                  /**< Esquina del mundo cubierta */
+    glm::vec2 worldSize;                    /**< Tamaño del mundo cubierto */
+
+    GLuint pageTableTexture;                /**< Tabla de páginas (GL_RGBA8UI con mips) */
+    GLuint physicalTexture;                 /**< Atlas físico de páginas */
+    GLTextureDesc pageTableDesc;            /**< Forma de la tabla de páginas (para liberarla) */
+    GLTextureDesc physicalDesc;             /**< Forma del atlas físico (para liberarlo) */
+    GLuint feedbackFBO;                     /**< Framebuffer del pase de feedback */
+    GLuint feedbackColor;                   /**< Color del feedback (GL_RGBA16UI) */
+    GLuint feedbackDepth;                   /**< Profundidad del feedback */
+    GLsizei feedbackWidth, feedbackHeight;  /**< Resolución del feedback */
+    GLint savedViewport[4];                 /**< Viewport a restaurar tras el feedback */
+    std::unique_ptr<Shader> feedbackShader; /**< Shader que escribe la página pedida por píxel */
+    Readback readbacks[kReadbackCount];     /**< Anillo de lecturas */
+    int readbackHead, readbackTail;         /**< Siguiente lectura a lanzar / a consumir */
+    GLsizeiptr readbackBytes;               /**< Bytes de cada PBO de lectura */
+
+    std::vector<std::vector<unsigned char>> pageTable; /**< Copia en CPU de la tabla, por nivel */
+    std::vector<DirtyRect> dirty;                      /**< Región por subir, por nivel */
+    std::vector<Slot> slots;                           /**< Ranuras del atlas */
+    std::vector<int> freeSlots;                        /**< Ranuras sin página */
+    std::list<int> lru;                                /**< Ranuras de la más a la menos reciente */
+    std::unordered_map<uint32_t, int> residentPages;   /**< Página -> ranura */
+    std::unordered_map<uint32_t, std::future<std::vector<unsigned char>>> pendingLoads; /**< Tiles en decodificación */
+    std::unordered_set<uint32_t> failedPages;          /**< Páginas sin tile válido */
+    std::vector<std::pair<uint32_t, int>> requests;    /**< Páginas pedidas por el último feedback y sus píxeles (orden de clave) */
+    uint64_t frameIndex;                               /**< Contador de updates */
+    VirtualTextureStats stats;                         /**< Contadores del último update */
+
+    static uint32_t pageKey(int level, int x, int y);
+    static void decodeKey(uint32_t key, int& level, int& x, int& y);
+    int pagesAtLevel(int level) const { return (virtualSize / pageSize) >> level; }
+    std::string tilePath(int level, int x, int y) const;
+
+    bool readDescriptor(const std::string& path);
+    void setShaderParams(const Shader& shader) const;
+    static void countKeys(FrameVector<uint32_t>& keys, FrameVector<std::pair<uint32_t, int>>& counted);
+    void collectFeedback();
+    void requestPages();
+    void uploadFinishedPages();
+    int acquireSlot();
+    void mapPage(uint32_t page, int slot);
+    void unmapPage(uint32_t page);
+    void markDirty(int level, int x0, int y0, int x1, int y1);
+    void flushPageTable();
+    void release();
+};
+
+#endif // VIRTUAL_TEXTURE_H
@@ -0,0 +1,119 @@
+#ifndef WORK_STEALING_DEQUE_H
+#define WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @class WorkStealingDeque
+ * @brief Deque de Chase-Lev de capacidad fija: el dueño apila y desapila por abajo, los demás roban por arriba.
+ *
+ * Sigue la formulación para modelos de memoria débiles de Lê, Pop, Cohen y Zappa Nardelli
+ * (PPoPP 2013). El dueño solo compite con los ladrones por el último elemento. La
+ * capacidad no crece: si el deque está lleno, @ref push falla y el llamante ejecuta la
+ * tarea directamente.
+ *
+ * @tparam T Tipo de los elementos (un puntero: se guarda en un @c std::atomic).
+ */
+template <typename T>
+class WorkStealingDeque {
+public:
+    /**
+     * @brief Constructor.
+     * @param capacity Elementos como máximo; se redondea a potencia de dos.
+     */
+    explicit WorkStealingDeque(int64_t capacity = 4096)
+    {
+        int64_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        mask = size - 1;
+        buffer = std::make_unique<std::atomic<T>[]>(static_cast<size_t>(size));
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    /**
+     * @brief Apila un elemento. Solo desde el hilo dueño.
+     * @return false si el deque está lleno.
+     */
+    bool push(T item)
+    {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        if (b - t > mask)
+            return false;
+        buffer[b & mask].store(item, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Desapila el elemento más reciente. Solo desde el hilo dueño.
+     * @return El elemento, o T() si el deque está vacío o un ladrón se llevó el último.
+     */
+    T pop()
+    {
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        T item = T();
+        if (t <= b)
+        {
+            item = buffer[b & mask].load(std::memory_order_relaxed);
+            if (t == b)
+            {
+                // Last element: race the thieves for it
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    item = T();
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        }
+        else
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /**
+     * @brief Roba el elemento más antiguo. Desde cualquier hilo.
+     * @return El elemento, o T() si está vacío o se perdió la carrera con otro hilo.
+     */
+    T steal()
+    {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return T();
+
+        T item = buffer[t & mask].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return T();
+        return item;
+    }
+
+    /**
+     * @brief Número aproximado de elementos (solo orientativo con ladrones activos).
+     */
+    int64_t size() const
+    {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_relaxed);
+        return b > t ? b - t : 0;
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> top{0};     /**< Extremo de los ladrones */
+    alignas(64) std::atomic<int64_t> bottom{0};  /**< Extremo del dueño */
+    std::unique_ptr<std::atomic<T>[]> buffer;    /**< Almacenamiento circular */
+    int64_t mask;                                /**< Capacidad - 1 */
+};
+
+#endif // WORK_STEALING_DEQUE_H
@@ -0,0 +1,135 @@
+// WorldFile.cpp
+
+#include "world_file.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+constexpr char kMagic[4] = { 'L', 'H', 'W', 'D' };
+constexpr uint64_t kAlignment = 16;
+
+uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+WorldFile::WorldFile(const std::string& path)
+    : file(path), header(nullptr), cells(nullptr)
+{
+    if (!file.isOpen())
+        return;
+
+    if (!validate())
+    {
+        std::cerr << "ERROR::WORLD_FILE::INVALID_FILE: " << path << std::endl;
+        header = nullptr;
+        cells = nullptr;
+        file.close();
+    }
+}
+
+bool WorldFile::validate()
+{
+    const size_t mappedSize = file.size();
+    if (mappedSize < sizeof(WorldFileHeader))
+        return false;
+    const WorldFileHeader* candidate = reinterpret_cast<const WorldFileHeader*>(file.data());
+    if (std::memcmp(candidate->magic, kMagic, sizeof(kMagic)) != 0 || candidate->version != WorldFileHeader::kVersion)
+        return false;
+    if (candidate->fileSize != mappedSize || !(candidate->cellSize > 0.0f))
+        return false;
+
+    const uint64_t cellCount = static_cast<uint64_t>(candidate->cellsX) * candidate->cellsZ;
+    if (candidate->cellsOffset % kAlignment != 0 || candidate->cellsOffset > mappedSize ||
+        cellCount > (mappedSize - candidate->cellsOffset) / sizeof(WorldCell))
+        return false;
+    if (candidate->stringsOffset > mappedSize || candidate->stringsSize > mappedSize - candidate->stringsOffset)
+        return false;
+
+    // Every cell's path lies inside the string table
+    const WorldCell* grid = reinterpret_cast<const WorldCell*>(file.data() + candidate->cellsOffset);
+    for (uint64_t i = 0; i < cellCount; ++i)
+    {
+        if (static_cast<uint64_t>(grid[i].nameOffset) + grid[i].nameLength > candidate->stringsSize)
+            return false;
+    }
+    header = candidate;
+    cells = grid;
+    return true;
+}
+
+std::string WorldFile::cellPath(const WorldCell& cell) const
+{
+    const char* strings = reinterpret_cast<const char*>(file.data() + header->stringsOffset);
+    return std::string(strings + cell.nameOffset, cell.nameLength);
+}
+
+void WorldFile::Writer::addCell(int32_t x, int32_t z, const std::string& path, uint32_t nodeCount, uint32_t instanceCount,
+                                float minY, float maxY)
+{
+    WorldCell cell{};
+    cell.nameOffset = static_cast<uint32_t>(strings.size());
+    cell.nameLength = static_cast<uint32_t>(path.size());
+    cell.nodeCount = nodeCount;
+    cell.instanceCount = instanceCount;
+    cell.minY = minY;
+    cell.maxY = maxY;
+    strings += path;
+    cells.push_back({ x, z, cell });
+}
+
+bool WorldFile::Writer::write(const std::string& path, float cellSize) const
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        std::cerr << "ERROR::WORLD_FILE::CANNOT_WRITE: " << path << std::endl;
+        return false;
+    }
+
+    // Smallest grid holding every cell; the rest stay empty
+    WorldFileHeader fileHeader{};
+    std::memcpy(fileHeader.magic, kMagic, sizeof(kMagic));
+    fileHeader.version = WorldFileHeader::kVersion;
+    fileHeader.cellSize = cellSize;
+    if (!cells.empty())
+    {
+        int32_t maxX = cells[0].x, maxZ = cells[0].z;
+        fileHeader.minCellX = cells[0].x;
+        fileHeader.minCellZ = cells[0].z;
+        for (const PendingCell& pending : cells)
+        {
+            fileHeader.minCellX = std::min(fileHeader.minCellX, pending.x);
+            fileHeader.minCellZ = std::min(fileHeader.minCellZ, pending.z);
+            maxX = std::max(maxX, pending.x);
+            maxZ = std::max(maxZ, pending.z);
+        }
+        fileHeader.cellsX = static_cast<uint32_t>(maxX - fileHeader.minCellX + 1);
+        fileHeader.cellsZ = static_cast<uint32_t>(maxZ - fileHeader.minCellZ + 1);
+    }
+    std::vector<WorldCell> grid(static_cast<size_t>(fileHeader.cellsX) * fileHeader.cellsZ, WorldCell{});
+    for (const PendingCell& pending : cells)
+    {
+        const size_t index = static_cast<size_t>(pending.z - fileHeader.minCellZ) * fileHeader.cellsX +
+                             static_cast<size_t>(pending.x - fileHeader.minCellX);
+        grid[index] = pending.cell;
+    }
+
+    fileHeader.cellsOffset = alignUp(sizeof(WorldFileHeader), kAlignment);
+    fileHeader.stringsOffset = fileHeader.cellsOffset + grid.size() * sizeof(WorldCell);
+    fileHeader.stringsSize = strings.size();
+    fileHeader.fileSize = fileHeader.stringsOffset + fileHeader.stringsSize;
+
+    const char padding[kAlignment] = {};
+    out.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+    out.write(padding, static_cast<std::streamsize>(fileHeader.cellsOffset - sizeof(fileHeader)));
+    if (!grid.empty())
+        out.write(reinterpret_cast<const char*>(grid.data()), static_cast<std::streamsize>(grid.size() * sizeof(WorldCell)));
+    out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,147 @@
+#ifndef WORLD_FILE_H
+#define WORLD_FILE_H
+
+#include "mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @struct WorldFileHeader
+ * @brief Cabecera del manifiesto de un mundo dividido en celdas (ver @ref WorldFile).
+ *
+ * Detrás de la cabecera va la rejilla completa de @ref WorldCell, fila a fila en Z, y la
+ * tabla de cadenas con las rutas de las escenas de cada celda. Little-endian.
+ */
+struct WorldFileHeader {
+    char magic[4];              /**< "LHWD" */
+    uint32_t version;           /**< Versión del formato (@ref kVersion) */
+    float cellSize;             /**< Lado de cada celda en XZ */
+    int32_t minCellX;           /**< Índice X de la primera columna de la rejilla */
+    int32_t minCellZ;           /**< Índice Z de la primera fila de la rejilla */
+    uint32_t cellsX;            /**< Columnas */
+    uint32_t cellsZ;            /**< Filas */
+    uint32_t reserved;          /**< Reservado, 0 */
+    uint64_t cellsOffset;       /**< Offset de la rejilla de celdas */
+    uint64_t stringsOffset;     /**< Offset de la tabla de cadenas */
+    uint64_t stringsSize;       /**< Bytes de la tabla de cadenas */
+    uint64_t fileSize;          /**< Tamaño total del archivo */
+
+    static constexpr uint32_t kVersion = 1;
+};
+
+/**
+ * @struct WorldCell
+ * @brief Una celda de la rejilla: la escena compilada con su contenido.
+ *
+ * La celda (x, z) cubre [x, x + 1) * @ref WorldFileHeader::cellSize en X y lo mismo en Z.
+ * Las celdas vacías tienen @c nameLength 0.
+ */
+struct WorldCell {
+    uint32_t nameOffset;    /**< Offset de la ruta de la escena en la tabla de cadenas */
+    uint32_t nameLength;    /**< Longitud de la ruta (relativa al manifiesto) */
+    uint32_t nodeCount;     /**< Nodos de la escena de la celda */
+    uint32_t instanceCount; /**< Instancias de la escena de la celda */
+    float minY;             /**< Altura mínima de los nodos instanciados */
+    float maxY;             /**< Altura máxima de los nodos instanciados */
+    uint32_t reserved[2];   /**< Reservado, 0 */
+};
+
+static_assert(sizeof(WorldFileHeader) == 64, "WorldFileHeader layout is part of the file format");
+static_assert(sizeof(WorldCell) == 32, "WorldCell layout is part of the file format");
+
+/**
+ * @class WorldFile
+ * @brief Manifiesto de un mundo por celdas mapeado en memoria (lo escribe tools/scene_compiler.cpp).
+ *
+ * Cada celda es una escena compilada (@ref SceneFile) con sus nodos, sus instancias y las
+ * mallas y texturas que estas usan, que @ref WorldStreamer carga y descarga según la cámara.
+ * La rejilla es densa, así que buscar la celda de un punto es un acceso directo al mapeo.
+ */
+class WorldFile {
+public:
+    /**
+     * @brief Abre y mapea un manifiesto.
+     * @param path Ruta al archivo.
+     */
+    explicit WorldFile(const std::string& path);
+
+    WorldFile(const WorldFile&) = delete;
+    WorldFile& operator=(const WorldFile&) = delete;
+
+    /**
+     * @brief Indica si el archivo se abrió y su contenido es consistente.
+     */
+    bool isOpen() const { return header != nullptr; }
+
+    float cellSize() const { return header->cellSize; }
+    int32_t minCellX() const { return header->minCellX; }
+    int32_t minCellZ() const { return header->minCellZ; }
+    uint32_t cellsX() const { return header->cellsX; }
+    uint32_t cellsZ() const { return header->cellsZ; }
+
+    /**
+     * @brief Celda por su posición en la rejilla.
+     * @param index Índice en la rejilla: (z - minCellZ) * cellsX + (x - minCellX).
+     */
+    const WorldCell& cell(size_t index) const { return cells[index]; }
+
+    /**
+     * @brief Número de celdas de la rejilla, vacías incluidas.
+     */
+    size_t cellCount() const { return static_cast<size_t>(header->cellsX) * header->cellsZ; }
+
+    /**
+     * @brief Ruta de la escena de una celda, relativa al manifiesto.
+     */
+    std::string cellPath(const WorldCell& cell) const;
+
+    /**
+     * @class Writer
+     * @brief Construye un manifiesto a partir de las celdas no vacías.
+     */
+    class Writer {
+    public:
+        /**
+         * @brief Añade una celda.
+         * @param x Índice X de la celda.
+         * @param z Índice Z de la celda.
+         * @param path Ruta de la escena de la celda, relativa al manifiesto.
+         * @param nodeCount Nodos de la escena.
+         * @param instanceCount Instancias de la escena.
+         * @param minY Altura mínima de su contenido.
+         * @param maxY Altura máxima de su contenido.
+         */
+        void addCell(int32_t x, int32_t z, const std::string& path, uint32_t nodeCount, uint32_t instanceCount,
+                     float minY, float maxY);
+
+        /**
+         * @brief Escribe el manifiesto con la rejilla mínima que contiene todas las celdas.
+         * @param path Ruta del archivo de salida.
+         * @param cellSize Lado de cada celda.
+         * @return true si se escribió correctamente.
+         */
+        bool write(const std::string& path, float cellSize) const;
+
+    private:
+        struct PendingCell {
+            int32_t x, z;
+            WorldCell cell;
+        };
+        std::vector<PendingCell> cells;     /**< Celdas en el orden en que se añadieron */
+        std::string strings;                /**< Tabla de cadenas */
+    };
+
+private:
+    MappedFile file;                    /**< Archivo mapeado */
+    const WorldFileHeader* header;      /**< Cabecera dentro del mapeo (nula si no es válido) */
+    const WorldCell* cells;             /**< Rejilla dentro del mapeo */
+
+    /**
+     * @brief Valida la cabecera, la rejilla y las rutas de las celdas tras mapear el archivo.
+     */
+    bool validate();
+};
+
+#endif // WORLD_FILE_H
@@ -0,0 +1,389 @@
+// WorldStreamer.cpp
+
+#include "world_streamer.h"
+#include "Constants.h"
+#include "job_system.h"
+#include "texture_streamer.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+double millisecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+WorldStreamer::WorldStreamer(EntityRegistry& registry, size_t budgetBytes)
+    : registry(registry), budget(budgetBytes), lastPosition(0.0f), velocity(0.0f)
+{
+}
+
+WorldStreamer::~WorldStreamer()
+{
+    // Job futures do not join on destruction; reads touch the asset pack and the texture streamer
+    for (auto& entry : cells)
+    {
+        if (entry.second.pending.valid())
+            entry.second.pending.wait();
+        if (entry.second.resident)
+            unload(entry.second);
+    }
+}
+
+bool WorldStreamer::open(const std::string& manifestPath)
+{
+    auto file = std::make_unique<WorldFile>(manifestPath);
+    if (!file->isOpen())
+        return false;
+    world = std::move(file);
+    directory = std::filesystem::path(manifestPath).parent_path().string();
+    return true;
+}
+
+float WorldStreamer::cellDistance(uint32_t index, const glm::vec3& point) const
+{
+    const float size = world->cellSize();
+    const float minX = static_cast<float>(world->minCellX() + static_cast<int32_t>(index % world->cellsX())) * size;
+    const float minZ = static_cast<float>(world->minCellZ() + static_cast<int32_t>(index / world->cellsX())) * size;
+    const float dx = std::max({ minX - point.x, 0.0f, point.x - (minX + size) });
+    const float dz = std::max({ minZ - point.z, 0.0f, point.z - (minZ + size) });
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+void WorldStreamer::gatherCandidates(const glm::vec3& point, bool required, const glm::vec3& camera)
+{
+    // Only the window of cells the radius can reach is visited, however large the world is
+    const float size = world->cellSize();
+    const int64_t cellsX = world->cellsX(), cellsZ = world->cellsZ();
+    const int64_t x0 = std::max<int64_t>(0, static_cast<int64_t>(std::floor((point.x - loadRadius) / size)) - world->minCellX());
+    const int64_t x1 = std::min<int64_t>(cellsX - 1, static_cast<int64_t>(std::floor((point.x + loadRadius) / size)) - world->minCellX());
+    const int64_t z0 = std::max<int64_t>(0, static_cast<int64_t>(std::floor((point.z - loadRadius) / size)) - world->minCellZ());
+    const int64_t z1 = std::min<int64_t>(cellsZ - 1, static_cast<int64_t>(std::floor((point.z + loadRadius) / size)) - world->minCellZ());
+    for (int64_t z = z0; z <= z1; ++z)
+    {
+        for (int64_t x = x0; x <= x1; ++x)
+        {
+            const uint32_t index = static_cast<uint32_t>(z * cellsX + x);
+            if (world->cell(index).nameLength == 0)
+                continue;
+            const float distance = cellDistance(index, point);
+            if (distance > loadRadius)
+                continue;
+            // Prefetch ranks behind every required cell and skips the ones already required
+            if (required)
+                candidates.push_back({ index, distance, true });
+            else if (cellDistance(index, camera) > loadRadius)
+                candidates.push_back({ index, loadRadius + distance, false });
+        }
+    }
+}
+
+size_t WorldStreamer::estimateBytes(uint32_t index) const
+{
+    auto it = measuredBytes.find(index);
+    if (it != measuredBytes.end())
+        return it->second;
+    return measuredBytes.empty() ? 0 : measuredTotal / measuredBytes.size();
+}
+
+bool WorldStreamer::makeRoom(size_t bytes, float priority, size_t reserved)
+{
+    while (residentBytes + reserved + bytes > budget)
+    {
+        auto farthest = cells.end();
+        for (auto it = cells.begin(); it != cells.end(); ++it)
+        {
+            if (it->second.resident && it->second.priority > priority &&
+                (farthest == cells.end() || it->second.priority > farthest->second.priority))
+                farthest = it;
+        }
+        if (farthest == cells.end())
+            return false;
+        unload(farthest->second);
+        cells.erase(farthest);
+        ++stats.evictions;
+    }
+    return true;
+}
+
+std::unique_ptr<WorldStreamer::CellLoad> WorldStreamer::readCell(const std::string& path)
+{
+    auto load = std::make_unique<CellLoad>();
+    load->file = std::make_unique<SceneFile>(path);
+    if (!load->file->isOpen())
+        return nullptr;
+
+    // Each cell owns its meshes and textures; everything is measured before the GL thread sees it
+    const SceneFile& file = *load->file;
+    load->sources.resize(file.assetCount());
+    load->textures.resize(file.assetCount());
+    load->readable.assign(file.assetCount(), false);
+    for (uint32_t a = 0; a < file.assetCount(); ++a)
+    {
+        const SceneAsset& asset = file.assets()[a];
+        if (asset.kind != SceneAssetKind::Mesh || asset.instanceCount == 0 || !load->sources[a].read(file.assetName(asset)))
+            continue;
+        load->readable[a] = true;
+        load->bytes += load->sources[a].geometryBytes();
+
+        const std::string texture = file.assetTexture(asset);
+        if (!texture.empty())
+        {
+            load->textures[a].emplace_back(texture, "texture_diffuse");
+            if (load->textures[a].back().prepare())
+                load->bytes += load->textures[a].back().getStorageBytes();
+        }
+    }
+    return load;
+}
+
+void WorldStreamer::commit(Cell& cell, CellLoad& load)
+{
+    // Parents come first in the cell's scene, as in any compiled scene
+    const SceneFile& file = *load.file;
+    const SceneNode* nodes = file.nodes();
+    const size_t nodeCount = file.nodeCount();
+    cell.entities.reserve(nodeCount);
+    for (size_t i = 0; i < nodeCount; ++i)
+    {
+        const SceneNode& node = nodes[i];
+        const Entity parent = node.parent < i ? cell.entities[node.parent] : Entity();
+        cell.entities.push_back(registry.createNode(sceneVec3(node.position), parent, sceneQuat(node.rotation), sceneVec3(node.scale)));
+    }
+
+    for (uint32_t a = 0; a < file.assetCount(); ++a)
+    {
+        if (!load.readable[a])
+            continue;
+        for (Texture& texture : load.textures[a])
+        {
+            if (!texture.load())
+                std::cerr << "Failed to load texture: " << texture.getPath() << std::endl;
+        }
+        cell.meshes.push_back(load.sources[a].upload(std::move(load.textures[a])));
+        const Mesh& mesh = *cell.meshes.back();
+
+        const SceneAsset& asset = file.assets()[a];
+        const SceneInstance* instances = file.instances() + asset.firstInstance;
+        for (uint32_t i = 0; i < asset.instanceCount; ++i)
+        {
+            if (instances[i].node < nodeCount)
+                registry.makeRenderable(cell.entities[instances[i].node], mesh, (instances[i].flags & SceneInstance::kDoubleSided) != 0);
+        }
+    }
+    cell.resident = true;
+    residentBytes += cell.bytes;
+}
+
+void WorldStreamer::unload(Cell& cell)
+{
+    // Entities go before the meshes they point at; GL objects are retired after their fence
+    for (Entity entity : cell.entities)
+        registry.destroy(entity);
+    cell.entities = std::vector<Entity>();
+    cell.meshes = std::vector<std::unique_ptr<Mesh>>();
+    cell.resident = false;
+    residentBytes -= cell.bytes;
+    cell.bytes = 0;
+}
+
+bool WorldStreamer::update(const Camera& camera, float time)
+{
+    if (!world)
+        return false;
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const double frameMs = hasLastPosition ? millisecondsBetween(lastUpdate, now) : 0.0;
+    lastUpdate = now;
+    stats.commitMs = 0.0;
+    stats.budgetBytes = budget;
+
+    // Camera velocity from position deltas, smoothed so one uneven frame does not swing the prefetch
+    const glm::vec3 position = camera.Position;
+    const float dt = time - lastTime;
+    if (hasLastPosition && dt > 0.0f)
+        velocity += ((position - lastPosition) / dt - velocity) * 0.25f;
+    hasLastPosition = true;
+    lastPosition = position;
+    lastTime = time;
+    const glm::vec3 ahead = position + glm::vec3(velocity.x, 0.0f, velocity.z) * prefetchSeconds;
+    const bool prefetching = glm::length(ahead - position) > world->cellSize() * 0.1f;
+
+    // A lowered ceiling takes effect right away, farthest cells first
+    makeRoom(0, -1.0f, 0);
+
+    // 1. Cells wanted this frame: around the camera, then around where it is heading
+    candidates.clear();
+    gatherCandidates(position, true, position);
+    stats.requiredCells = static_cast<int>(candidates.size());
+    if (prefetching)
+        gatherCandidates(ahead, false, position);
+    stats.prefetchCells = static_cast<int>(candidates.size()) - stats.requiredCells;
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.priority < b.priority; });
+
+    // 2. Re-rank the cells we hold; the ones left behind (with half a cell of hysteresis) are dropped
+    const float keepRadius = loadRadius + world->cellSize() * 0.5f;
+    scratch.clear();
+    for (auto& [index, cell] : cells)
+    {
+        const float distance = cellDistance(index, position);
+        const float aheadDistance = prefetching ? cellDistance(index, ahead) : std::numeric_limits<float>::max();
+        cell.priority = std::min(distance, loadRadius + aheadDistance);
+        cell.wanted = distance <= keepRadius || aheadDistance <= keepRadius;
+        if (cell.resident && cell.prefetched && distance <= loadRadius)
+        {
+            ++stats.prefetchHits;
+            cell.prefetched = false;
+        }
+        if (!cell.wanted && cell.resident)
+        {
+            unload(cell);
+            ++stats.unloads;
+            scratch.push_back(index);
+        }
+    }
+    for (uint32_t index : scratch)
+        cells.erase(index);
+
+    // 3. Finished reads, nearest first: cells no longer wanted or too large for the ceiling are dropped
+    scratch.clear();
+    for (auto& [index, cell] : cells)
+    {
+        if (!cell.resident && cell.pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            scratch.push_back(index);
+    }
+    std::sort(scratch.begin(), scratch.end(), [this](uint32_t a, uint32_t b) { return cells[a].priority < cells[b].priority; });
+    int commits = 0;
+    bool committed = false;
+    for (uint32_t index : scratch)
+    {
+        Cell& cell = cells[index];
+        if (cell.wanted && commits == maxCommitsPerFrame)
+            continue;
+
+        std::unique_ptr<CellLoad> load = cell.pending.get();
+        reservedBytes -= cell.bytes;
+        cell.bytes = 0;
+        if (!load)
+        {
+            std::cerr << "World cell failed to load: " << world->cellPath(world->cell(index)) << std::endl;
+            ++stats.failedLoads;
+            cells.erase(index);
+            continue;
+        }
+        auto measured = measuredBytes.emplace(index, load->bytes);
+        if (measured.second)
+            measuredTotal += load->bytes;
+        if (!cell.wanted)
+        {
+            cells.erase(index);
+            continue;
+        }
+        if (!makeRoom(load->bytes, cell.priority, 0))
+        {
+            ++stats.rejectedLoads;
+            cells.erase(index);
+            continue;
+        }
+
+        const std::chrono::steady_clock::time_point commitStart = std::chrono::steady_clock::now();
+        cell.bytes = load->bytes;
+        commit(cell, *load);
+        const std::chrono::steady_clock::time_point commitEnd = std::chrono::steady_clock::now();
+        stats.commitMs += millisecondsBetween(commitStart, commitEnd);
+
+        const double loadMs = millisecondsBetween(cell.requested, commitEnd);
+        totalLoadMs += loadMs;
+        stats.maxLoadMs = std::max(stats.maxLoadMs, loadMs);
+        ++stats.loads;
+        if (cell.prefetched)
+            ++stats.prefetchLoads;
+        stats.averageLoadMs = totalLoadMs / static_cast<double>(stats.loads);
+        ++commits;
+        committed = true;
+    }
+
+    // 4. Start reads for the most important missing cells while there are slots and room under the ceiling
+    int inFlight = 0;
+    for (const auto& entry : cells)
+        inFlight += entry.second.resident ? 0 : 1;
+    for (const Candidate& candidate : candidates)
+    {
+        if (inFlight >= maxLoadsInFlight)
+            break;
+        if (cells.count(candidate.index))
+            continue;
+        const size_t estimate = estimateBytes(candidate.index);
+        if (!makeRoom(estimate, candidate.priority, reservedBytes))
+        {
+            ++stats.deferredLoads;
+            break;
+        }
+
+        Cell& cell = cells[candidate.index];
+        cell.prefetched = !candidate.required;
+        cell.priority = candidate.priority;
+        cell.requested = now;
+        cell.bytes = estimate;
+        reservedBytes += estimate;
+        const std::string path = (std::filesystem::path(directory) / world->cellPath(world->cell(candidate.index))).string();
+        cell.pending = JobSystem::async([path]() { return readCell(path); });
+        ++inFlight;
+    }
+
+    // 5. Residency, and how long required cells kept the camera waiting
+    stats.missingCells = 0;
+    for (const Candidate& candidate : candidates)
+    {
+        if (!candidate.required)
+            break;
+        auto it = cells.find(candidate.index);
+        if (it == cells.end() || !it->second.resident)
+            ++stats.missingCells;
+    }
+    if (stats.missingCells > 0)
+    {
+        ++stats.stallFrames;
+        stats.stallMs += frameMs;
+    }
+    stats.residentCells = 0;
+    for (const auto& entry : cells)
+        stats.residentCells += entry.second.resident ? 1 : 0;
+    stats.loadingCells = static_cast<int>(cells.size()) - stats.residentCells;
+    stats.residentBytes = residentBytes;
+    stats.peakResidentBytes = std::max(stats.peakResidentBytes, residentBytes);
+
+    // Cell textures refine like any other: by how large their meshes look from the camera
+    if (TextureStreamer* streamer = TextureStreamer::active())
+    {
+        for (const auto& [index, cell] : cells)
+        {
+            if (!cell.resident)
+                continue;
+            const float distance = cellDistance(index, position);
+            for (const std::unique_ptr<Mesh>& mesh : cell.meshes)
+                mesh->requestTextureDetail(*streamer, TextureStreamer::projectedPixels(2.0f * mesh->getBoundsRadius(), distance,
+                                                                                       camera.Zoom, (float)WINDOW_HEIGHT));
+        }
+    }
+    return committed;
+}
+
+void WorldStreamer::report(std::ostream& out) const
+{
+    out << "World streaming: " << stats.residentCells << " cells resident, " << stats.loadingCells << " loading; "
+        << (stats.residentBytes >> 10) << " KB of " << (stats.budgetBytes >> 10) << " KB ceiling (peak "
+        << (stats.peakResidentBytes >> 10) << " KB)" << std::endl;
+    out << "  " << stats.loads << " loads (" << stats.prefetchLoads << " by prefetch, " << stats.prefetchHits << " prefetch hits), "
+        << stats.unloads << " unloads, " << stats.evictions << " evictions, " << stats.deferredLoads << " deferred, "
+        << stats.rejectedLoads << " rejected, " << stats.failedLoads << " failed" << std::endl;
+    out << "  load latency " << stats.averageLoadMs << " ms average, " << stats.maxLoadMs << " ms max; "
+        << stats.stallFrames << " frames (" << stats.stallMs << " ms) with required cells missing" << std::endl;
+}
@@ -0,0 +1,236 @@
+#ifndef WORLD_STREAMER_H
+#define WORLD_STREAMER_H
+
+#include "Camera.h"
+#include "Mesh.h"
+#include "Texture.h"
+#include "entity_registry.h"
+#include "mesh_source.h"
+#include "scene_file.h"
+#include "world_file.h"
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @struct WorldStreamerStats
+ * @brief Residencia y esperas del streaming de celdas, actualizados en cada @ref WorldStreamer::update.
+ */
+struct WorldStreamerStats {
+    int requiredCells = 0;          /**< Celdas no vacías dentro del radio de carga de la cámara */
+    int prefetchCells = 0;          /**< Celdas pedidas por adelantado en la dirección del movimiento */
+    int missingCells = 0;           /**< Celdas requeridas que aún no son residentes */
+    int residentCells = 0;          /**< Celdas dibujables */
+    int loadingCells = 0;           /**< Celdas leyéndose en segundo plano */
+    size_t residentBytes = 0;       /**< Bytes de GPU de las celdas residentes (mallas y texturas) */
+    size_t peakResidentBytes = 0;   /**< Máximo de @ref residentBytes */
+    size_t budgetBytes = 0;         /**< Techo de bytes residentes */
+    uint64_t loads = 0;             /**< Celdas que llegaron a ser residentes */
+    uint64_t prefetchLoads = 0;     /**< De ellas, pedidas por prefetch antes de ser requeridas */
+    uint64_t prefetchHits = 0;      /**< Celdas de prefetch que ya eran residentes al volverse requeridas */
+    uint64_t unloads = 0;           /**< Celdas descargadas al alejarse la cámara */
+    uint64_t evictions = 0;         /**< Celdas descargadas para hacer sitio bajo el techo */
+    uint64_t deferredLoads = 0;     /**< Updates en los que una carga esperó por falta de sitio */
+    uint64_t rejectedLoads = 0;     /**< Celdas leídas que al medirlas no cabían y se descartaron */
+    uint64_t failedLoads = 0;       /**< Celdas cuya escena no se pudo abrir */
+    uint64_t stallFrames = 0;       /**< Updates con alguna celda requerida sin cargar */
+    double stallMs = 0.0;           /**< Tiempo real acumulado de esos updates */
+    double averageLoadMs = 0.0;     /**< Media desde que se pide una celda hasta que es dibujable */
+    double maxLoadMs = 0.0;         /**< Máximo de lo anterior */
+    double commitMs = 0.0;          /**< Tiempo del hilo de OpenGL creando celdas en el último update */
+};
+
+/**
+ * @class WorldStreamer
+ * @brief Carga y descarga las celdas de un mundo (@ref WorldFile) alrededor de la cámara.
+ *
+ * Se requieren las celdas a menos de @ref setLoadRadius de la cámara en XZ; con la cámara en
+ * movimiento se piden además las que rodean el punto donde estará dentro de
+ * @ref setPrefetchSeconds, con menor prioridad. Cada celda se lee en un trabajador (mapea su
+ * escena, lee sus mallas y prepara sus texturas) y después, en el hilo de OpenGL, sube mallas
+ * y texturas y crea sus nodos y entidades dibujables en el registro. Las celdas son
+ * independientes: cada una es dueña de sus mallas y texturas y las libera al descargarse.
+ *
+ * Los bytes residentes nunca superan el techo de @ref setBudget: antes de leer una celda se
+ * reserva su tamaño conocido (el medido la última vez, o la media de las celdas medidas) y,
+ * antes de subirla, se comprueba su tamaño exacto. Si no cabe se descargan las celdas
+ * residentes más lejanas que ella; si ni así cabe, la carga espera (o se descarta si ya se leyó).
+ * Las celdas se descargan al salir del radio de carga más un margen de media celda.
+ */
+class WorldStreamer {
+public:
+    /**
+     * @brief Constructor.
+     * @param registry Registro en el que se crean las entidades de las celdas; debe vivir más que el streamer.
+     * @param budgetBytes Techo de bytes de GPU residentes entre todas las celdas.
+     */
+    explicit WorldStreamer(EntityRegistry& registry, size_t budgetBytes = 128u << 20);
+
+    /**
+     * @brief Destructor. Espera las lecturas en curso y descarga todas las celdas.
+     */
+    ~WorldStreamer();
+
+    WorldStreamer(const WorldStreamer&) = delete;
+    WorldStreamer& operator=(const WorldStreamer&) = delete;
+
+    /**
+     * @brief Abre el manifiesto de un mundo. Las rutas de las celdas son relativas a él.
+     * @param manifestPath Ruta del manifiesto (.world).
+     * @return true si el manifiesto es válido.
+     */
+    bool open(const std::string& manifestPath);
+
+    /**
+     * @brief Indica si hay un mundo abierto.
+     */
+    bool isOpen() const { return world != nullptr; }
+
+    /**
+     * @brief Fija el techo de bytes residentes; las celdas más lejanas se descargan en el siguiente update si se supera.
+     */
+    void setBudget(size_t bytes) { budget = bytes; }
+
+    /**
+     * @brief Fija la distancia en XZ hasta la que las celdas son requeridas.
+     */
+    void setLoadRadius(float radius) { loadRadius = radius; }
+
+    /**
+     * @brief Fija cuántos segundos de movimiento se adelanta el prefetch.
+     */
+    void setPrefetchSeconds(float seconds) { prefetchSeconds = seconds; }
+
+    /**
+     * @brief Integra las lecturas terminadas, descarga lo lejano y lanza las lecturas que faltan. Hilo de OpenGL.
+     *
+     * La velocidad de la cámara sale de la diferencia de posiciones entre llamadas (suavizada).
+     *
+     * @param camera Cámara activa.
+     * @param time Tiempo de simulación.
+     * @return true si alguna celda se volvió dibujable (sus materiales pueden necesitar variantes nuevas).
+     */
+    bool update(const Camera& camera, float time);
+
+    /**
+     * @brief Devuelve los contadores del último @ref update.
+     */
+    const WorldStreamerStats& getStats() const { return stats; }
+
+    /**
+     * @brief Escribe residencia, memoria, cargas y esperas.
+     * @param out Flujo de salida.
+     */
+    void report(std::ostream& out) const;
+
+private:
+    /**
+     * @struct CellLoad
+     * @brief Lo que un trabajador leyó de una celda, pendiente de subirse.
+     */
+    struct CellLoad {
+        std::unique_ptr<SceneFile> file;            /**< Escena de la celda, mapeada */
+        std::vector<MeshSource> sources;            /**< Geometría de cada asset de malla */
+        std::vector<std::vector<Texture>> textures; /**< Texturas preparadas de cada asset de malla */
+        std::vector<bool> readable;                 /**< El asset se leyó y se puede instanciar */
+        size_t bytes = 0;                           /**< Bytes de GPU que ocupará la celda */
+    };
+
+    /**
+     * @struct Cell
+     * @brief Celda leyéndose o residente.
+     */
+    struct Cell {
+        bool resident = false;                      /**< Ya es dibujable (si no, se está leyendo) */
+        bool prefetched = false;                    /**< Se pidió por prefetch y aún no ha sido requerida */
+        bool wanted = true;                         /**< Sigue dentro del radio de carga con margen */
+        float priority = 0.0f;                      /**< Distancia efectiva: menor es más importante */
+        size_t bytes = 0;                           /**< Reserva mientras se lee; tamaño exacto al ser residente */
+        std::chrono::steady_clock::time_point requested; /**< Cuándo se pidió */
+        std::future<std::unique_ptr<CellLoad>> pending; /**< Lectura en curso */
+        std::vector<Entity> entities;               /**< Nodos de la celda en el registro */
+        std::vector<std::unique_ptr<Mesh>> meshes;  /**< Mallas de la celda (con sus texturas) */
+    };
+
+    /**
+     * @struct Candidate
+     * @brief Celda que el update quiere residente.
+     */
+    struct Candidate {
+        uint32_t index;     /**< Índice en la rejilla */
+        float priority;     /**< Distancia efectiva */
+        bool required;      /**< Dentro del radio de carga de la cámara (si no, prefetch) */
+    };
+
+    EntityRegistry& registry;                           /**< Registro de las entidades de las celdas */
+    std::unique_ptr<WorldFile> world;                   /**< Manifiesto mapeado */
+    std::string directory;                              /**< Directorio del manifiesto */
+    std::unordered_map<uint32_t, Cell> cells;           /**< Celdas leyéndose o residentes, por índice en la rejilla */
+    std::unordered_map<uint32_t, size_t> measuredBytes; /**< Tamaño medido de cada celda ya leída */
+    std::vector<Candidate> candidates;                  /**< Celdas deseadas en el update actual */
+    std::vector<uint32_t> scratch;                      /**< Índices temporales del update */
+
+    size_t budget;                  /**< Techo de bytes residentes */
+    float loadRadius = 150.0f;      /**< Radio de las celdas requeridas */
+    float prefetchSeconds = 2.0f;   /**< Adelanto del prefetch */
+    int maxLoadsInFlight = 4;       /**< Lecturas simultáneas */
+    int maxCommitsPerFrame = 2;     /**< Celdas subidas por update */
+
+    size_t residentBytes = 0;       /**< Bytes de las celdas residentes */
+    size_t reservedBytes = 0;       /**< Reservas de las celdas leyéndose */
+    size_t measuredTotal = 0;       /**< Suma de @ref measuredBytes (para la estimación media) */
+    double totalLoadMs = 0.0;       /**< Suma de tiempos de carga */
+    bool hasLastPosition = false;   /**< Ya hubo un update (hay velocidad) */
+    glm::vec3 lastPosition;         /**< Posición de la cámara en el update anterior */
+    float lastTime = 0.0f;          /**< Tiempo de simulación del update anterior */
+    glm::vec3 velocity;             /**< Velocidad suavizada de la cámara */
+    std::chrono::steady_clock::time_point lastUpdate; /**< Tiempo real del update anterior */
+    WorldStreamerStats stats;       /**< Contadores */
+
+    /**
+     * @brief Distancia en XZ de un punto a la celda.
+     */
+    float cellDistance(uint32_t index, const glm::vec3& point) const;
+
+    /**
+     * @brief Añade a @ref candidates las celdas no vacías a menos de @ref loadRadius de un punto.
+     */
+    void gatherCandidates(const glm::vec3& point, bool required, const glm::vec3& camera);
+
+    /**
+     * @brief Bytes que se reservan para leer una celda.
+     */
+    size_t estimateBytes(uint32_t index) const;
+
+    /**
+     * @brief Descarga celdas residentes menos importantes que @p priority, la más lejana primero, hasta que quepan @p bytes más.
+     * @param bytes Bytes que se quieren añadir.
+     * @param priority Prioridad de quien pide sitio.
+     * @param reserved Bytes ya comprometidos además de los residentes (reservas de lecturas en curso).
+     * @return true si caben.
+     */
+    bool makeRoom(size_t bytes, float priority, size_t reserved);
+
+    /**
+     * @brief Lee la escena de una celda, sus mallas y sus texturas. Trabajador.
+     */
+    static std::unique_ptr<CellLoad> readCell(const std::string& path);
+
+    /**
+     * @brief Sube lo leído y crea los nodos y entidades de la celda. Hilo de OpenGL.
+     */
+    void commit(Cell& cell, CellLoad& load);
+
+    /**
+     * @brief Destruye las entidades y libera mallas y texturas de una celda residente.
+     */
+    void unload(Cell& cell);
+};
+
+#endif // WORLD_STREAMER_H
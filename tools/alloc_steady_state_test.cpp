@@ -0,0 +1,96 @@
+// AllocSteadyStateTest.cpp
+//
+// Checks that the render-path building blocks stop touching the heap once warmed up.
+// Built only with ALLOC_TRACKING=ON and run by CTest; exits non-zero on any violation or
+// on any allocation churn: RENDER_NO_ALLOC only watches the render thread, so the heap
+// counters of every thread (workers included) must also stay still over the steady frames.
+// Usage: alloc_steady_state_test [--warmup N] [--frames N]
+// Frames mimic the render loop: parallelFor over per-item work on the job system and
+// FrameString / frameVector temporaries in the frame arena, inside RENDER_NO_ALLOC.
+
+#include "alloc_tracker.h"
+#include "frame_allocator.h"
+#include "job_system.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+void runFrame(JobSystem& jobs, FrameAllocator& frameAllocator, std::vector<float>& values, size_t frame)
+{
+    AllocTracker::beginFrame();
+    frameAllocator.beginFrame();
+    {
+        RENDER_NO_ALLOC();
+
+        jobs.parallelFor(0, values.size(), 256, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                values[i] = values[i] * 0.5f + static_cast<float>(frame);
+        });
+
+        // Uniform names are built like Scene::Render builds them, past the small-string buffer
+        FrameVector<FrameString> names = frameVector<FrameString>();
+        for (int light = 0; light < 10; ++light)
+        {
+            FrameString name = frameString("pointLights[");
+            name += static_cast<char>('0' + light);
+            name.append("].position_with_a_long_suffix");
+            names.push_back(std::move(name));
+        }
+    }
+    AllocTracker::endFrame();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int warmupFrames = 60;
+    int frames = 240;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            warmupFrames = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frames = std::atoi(argv[++i]);
+    }
+
+    JobSystem jobs;
+    jobs.activate();
+    FrameAllocator frameAllocator;
+    frameAllocator.activate();
+    std::vector<float> values(64 * 1024, 1.0f);
+
+    // Warm-up lets the job pool and the arenas grow to their steady size
+    for (int frame = 0; frame < warmupFrames; ++frame)
+        runFrame(jobs, frameAllocator, values, frame);
+
+    const AllocCounters before = AllocTracker::globalCounters();
+    AllocTracker::armNoAlloc(true);
+    for (int frame = 0; frame < frames; ++frame)
+        runFrame(jobs, frameAllocator, values, warmupFrames + frame);
+    AllocTracker::armNoAlloc(false);
+    const AllocCounters after = AllocTracker::globalCounters();
+
+    const uint64_t violations = AllocTracker::noAllocViolations();
+    if (violations != 0)
+    {
+        std::cerr << "ERROR::ALLOC_STEADY_STATE::NO_ALLOC_VIOLATED\n"
+                  << violations << " heap allocations inside RENDER_NO_ALLOC over " << frames << " frames" << std::endl;
+        AllocTracker::report(std::cerr);
+        return EXIT_FAILURE;
+    }
+    if (after.allocations != before.allocations)
+    {
+        std::cerr << "ERROR::ALLOC_STEADY_STATE::CHURN\n"
+                  << after.allocations - before.allocations << " allocations ("
+                  << after.bytes - before.bytes << " bytes) on all threads over " << frames << " frames" << std::endl;
+        AllocTracker::report(std::cerr);
+        return EXIT_FAILURE;
+    }
+    std::printf("%d steady frames on %u workers without heap allocations\n", frames, jobs.workerCount());
+    return EXIT_SUCCESS;
+}
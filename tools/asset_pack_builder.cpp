@@ -0,0 +1,126 @@
+// AssetPackBuilder.cpp
+//
+// Cooks the project assets into a single memory-mappable archive.
+// Usage: asset_pack_builder <output.pak> [--compress] [--terrain <tile directory>]
+// Run from the directory that contains assets/; asset names are the relative paths
+// the runtime loaders ask for (e.g. "assets/shaders/phong_vertex_shader.glsl").
+// --terrain adds the virtual texture tiles written by vt_tile_builder as assets/terrain/.
+
+#include "asset_pack.h"
+#include "geometry.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+// Texture type from the file layout, mirroring what Plane, Lighthouse and Scene request
+static std::string textureTypeFor(const fs::path& path)
+{
+    const std::string generic = path.generic_string();
+    const std::string stem = path.stem().string();
+    if (generic.find("/skybox/") != std::string::npos)
+        return "texture_cubemap";
+    if (stem.find("_nor") != std::string::npos)
+        return "texture_normal";
+    if (stem.find("_rough") != std::string::npos)
+        return "texture_roughness";
+    return "texture_diffuse";
+}
+
+static bool isImage(const fs::path& path)
+{
+    const std::string ext = path.extension().string();
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".tga" || ext == ".hdr" || ext == ".exr";
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: asset_pack_builder <output.pak> [--compress] [--terrain <tile directory>]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::string output = argv[1];
+    bool compress = false;
+    fs::path terrainDir;
+    for (int i = 2; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--compress")
+            compress = true;
+        else if (std::string(argv[i]) == "--terrain" && i + 1 < argc)
+            terrainDir = argv[++i];
+    }
+
+    if (!fs::is_directory("assets"))
+    {
+        std::cerr << "assets/ directory not found in " << fs::current_path() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    AssetPack::Writer writer;
+    size_t cooked = 0;
+
+    for (const auto& item : fs::recursive_directory_iterator("assets"))
+    {
+        if (!item.is_regular_file())
+            continue;
+        const fs::path& path = item.path();
+        const std::string name = path.generic_string();
+
+        if (path.extension() == ".glsl")
+        {
+            std::ifstream file(path, std::ios::binary);
+            std::vector<unsigned char> source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            writer.add(name, AssetKind::Shader, std::move(source), compress);
+            ++cooked;
+        }
+        else if (isImage(path))
+        {
+            TextureImage image;
+            if (!Texture::decodeImage(name, textureTypeFor(path), image))
+            {
+                std::cerr << "Skipping texture: " << name << std::endl;
+                continue;
+            }
+            writer.add(name, AssetKind::Texture, AssetPack::cookTexture(image), compress);
+            ++cooked;
+        }
+    }
+
+    // Virtual texture tiles are decoded per page at runtime, so they stay raw files
+    if (!terrainDir.empty())
+    {
+        if (!fs::is_directory(terrainDir))
+        {
+            std::cerr << "Terrain tile directory not found: " << terrainDir << std::endl;
+            return EXIT_FAILURE;
+        }
+        for (const auto& item : fs::recursive_directory_iterator(terrainDir))
+        {
+            if (!item.is_regular_file())
+                continue;
+            const std::string name = "assets/terrain/" + fs::relative(item.path(), terrainDir).generic_string();
+            std::ifstream file(item.path(), std::ios::binary);
+            std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            writer.add(name, AssetKind::Raw, std::move(bytes), compress);
+            ++cooked;
+        }
+    }
+
+    for (const std::string& name : Geometry::builtinMeshNames())
+    {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        Geometry::generateBuiltinMesh(name, vertices, indices);
+        writer.add(name, AssetKind::Mesh, AssetPack::cookMesh(vertices, indices), compress);
+        ++cooked;
+    }
+
+    if (!writer.write(output))
+        return EXIT_FAILURE;
+
+    std::cout << "Wrote " << cooked << " assets to " << output << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+// JobSystemBench.cpp
+//
+// Measures how the job system scales with the number of threads.
+// Usage: job_system_bench [--max-threads N] [--items N] [--runs N]
+// For every thread count (1, 2, 4, ... up to --max-threads) runs three parallelFor workloads
+// and prints the median time, the speedup over one thread and the parallel efficiency:
+//  - cull:    sphere-vs-frustum tests, cheap and memory bound
+//  - animate: a few transcendental functions per item, compute bound
+//  - uneven:  cost grows with the index, so static bands would leave threads idle
+// Thread counts above the core count oversubscribe the machine and are marked with '*'.
+
+#include "job_system.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Sphere { float x, y, z, radius; };
+struct PlaneEq { float a, b, c, d; };
+
+double medianMs(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+template <typename Fn>
+double timeRuns(int runs, Fn&& fn)
+{
+    std::vector<double> samples;
+    for (int r = 0; r < runs; ++r)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return medianMs(samples);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int maxThreads = 64;
+    size_t items = 1 << 20;
+    int runs = 7;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string option = argv[i];
+        if (option == "--max-threads")
+            maxThreads = std::max(1, std::atoi(argv[i + 1]));
+        else if (option == "--items")
+            items = static_cast<size_t>(std::max(1, std::atoi(argv[i + 1])));
+        else if (option == "--runs")
+            runs = std::max(1, std::atoi(argv[i + 1]));
+    }
+
+    // Deterministic inputs shared by every thread count
+    std::vector<Sphere> spheres(items);
+    for (size_t i = 0; i < items; ++i)
+    {
+        float t = static_cast<float>(i);
+        spheres[i] = {std::sin(t) * 100.0f, std::cos(t * 0.7f) * 20.0f, std::sin(t * 1.3f) * 100.0f, 1.0f + (i % 7)};
+    }
+    const PlaneEq planes[6] = {
+        {1, 0, 0, 50}, {-1, 0, 0, 50}, {0, 1, 0, 10}, {0, -1, 0, 30}, {0, 0, 1, 80}, {0, 0, -1, 80}};
+    std::vector<unsigned char> visible(items);
+    std::vector<float> animated(items);
+
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("Hardware threads: %u, items: %zu, runs: %d (median)\n\n", cores, items, runs);
+    std::printf("%8s %12s %8s %6s %12s %8s %6s %12s %8s %6s\n",
+                "threads", "cull ms", "speedup", "eff", "animate ms", "speedup", "eff", "uneven ms", "speedup", "eff");
+
+    double base[3] = {0.0, 0.0, 0.0};
+    std::vector<int> counts;
+    for (int threads = 1; threads < maxThreads; threads *= 2)
+        counts.push_back(threads);
+    counts.push_back(maxThreads);
+
+    for (int threads : counts)
+    {
+        // The calling thread helps in parallelFor, so N threads means N - 1 workers
+        JobSystem jobs(threads - 1);
+
+        const double cull = timeRuns(runs, [&]() {
+            jobs.parallelFor(0, items, 1024, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const Sphere& s = spheres[i];
+                    bool inside = true;
+                    for (const PlaneEq& p : planes)
+                        inside = inside && (p.a * s.x + p.b * s.y + p.c * s.z + p.d >= -s.radius);
+                    visible[i] = inside;
+                }
+            });
+        });
+
+        const double animate = timeRuns(runs, [&]() {
+            jobs.parallelFor(0, items, 256, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    float t = static_cast<float>(i) * 0.001f;
+                    animated[i] = std::sin(t) * std::cos(t * 0.5f) + std::exp(-t * 0.01f) * std::atan2(t, 1.0f);
+                }
+            });
+        });
+
+        const size_t unevenItems = std::max<size_t>(1, items / 64);
+        const double uneven = timeRuns(runs, [&]() {
+            jobs.parallelFor(0, unevenItems, 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    float acc = 0.0f;
+                    const size_t work = 16 + i * 128 / unevenItems * 16;
+                    for (size_t k = 0; k < work; ++k)
+                        acc += std::sin(static_cast<float>(k + i));
+                    animated[i] = acc;
+                }
+            });
+        });
+
+        const double times[3] = {cull, animate, uneven};
+        if (threads == 1)
+            std::copy(times, times + 3, base);
+
+        std::printf("%7d%c", threads, static_cast<unsigned>(threads) > cores ? '*' : ' ');
+        for (int w = 0; w < 3; ++w)
+        {
+            const double speedup = base[w] / times[w];
+            std::printf(" %12.3f %7.2fx %5.0f%%", times[w], speedup, 100.0 * speedup / threads);
+        }
+        std::printf("\n");
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+// SpatialIndexBench.cpp
+//
+// Measures the spatial index on a large synthetic world.
+// Usage: spatial_index_bench [--objects N] [--queries N] [--runs N] [--threads N]
+// Scatters --objects spheres over a 4 km square, builds the index from them and times
+// batches of --queries ray, sphere and frustum queries. Each batch runs on one thread
+// (no active job system) and then spread over --threads threads; the brute-force column
+// is a linear scan over every object answering the same queries, for scale.
+// Rays stop at the bounding spheres: the synthetic objects carry no triangles.
+
+#include "job_system.h"
+#include "spatial_index.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+
+double medianMs(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+template <typename Fn>
+double timeRuns(int runs, Fn&& fn)
+{
+    std::vector<double> samples;
+    for (int r = 0; r < runs; ++r)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return medianMs(samples);
+}
+
+// Same test as the index uses for its leaves
+float rayEntry(const Ray& ray, const glm::vec4& sphere)
+{
+    const glm::vec3 offset = ray.origin - glm::vec3(sphere);
+    const float b = glm::dot(offset, ray.direction);
+    const float c = glm::dot(offset, offset) - sphere.w * sphere.w;
+    if (c <= 0.0f)
+        return 0.0f;
+    const float discriminant = b * b - c;
+    if (b > 0.0f || discriminant < 0.0f)
+        return -1.0f;
+    return -b - std::sqrt(discriminant);
+}
+
+void printRow(const char* name, size_t queries, double oneMs, double manyMs, double scanMs, double results)
+{
+    const double perQuery = 1000.0 / static_cast<double>(queries);
+    std::printf("%-8s %12.2f %12.2f %8.2fx %14.1f %8.0fx %10.1f\n", name, oneMs * perQuery, manyMs * perQuery,
+                oneMs / manyMs, scanMs * perQuery, scanMs / oneMs, results);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t objects = 100000;
+    size_t queries = 4096;
+    int runs = 5;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string option = argv[i];
+        if (option == "--objects")
+            objects = static_cast<size_t>(std::max(1, std::atoi(argv[i + 1])));
+        else if (option == "--queries")
+            queries = static_cast<size_t>(std::max(1, std::atoi(argv[i + 1])));
+        else if (option == "--runs")
+            runs = std::max(1, std::atoi(argv[i + 1]));
+        else if (option == "--threads")
+            threads = std::max(1, std::atoi(argv[i + 1]));
+    }
+
+    // Deterministic world: mostly props near the ground, a few large landmarks
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> ground(-2000.0f, 2000.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<Entity> entities(objects);
+    std::vector<glm::vec4> spheres(objects);
+    for (size_t i = 0; i < objects; ++i)
+    {
+        entities[i].id = static_cast<uint32_t>(i);
+        const float radius = i % 100 == 0 ? 10.0f + 40.0f * unit(random) : 0.5f + 3.0f * unit(random);
+        spheres[i] = glm::vec4(ground(random), radius + 2.0f * unit(random), ground(random), radius);
+    }
+
+    // Queries from a walker's point of view: eye height, looking roughly along the ground
+    std::vector<Ray> rays(queries);
+    std::vector<glm::vec3> centers(queries);
+    std::vector<float> radii(queries);
+    std::vector<Frustum> frusta(queries);
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+    for (size_t q = 0; q < queries; ++q)
+    {
+        const glm::vec3 eye(ground(random), 2.0f, ground(random));
+        const float angle = 6.2831853f * unit(random);
+        const glm::vec3 forward(std::cos(angle), -0.05f * unit(random), std::sin(angle));
+        rays[q] = Ray{eye, glm::normalize(forward), 1000.0f};
+        centers[q] = eye;
+        radii[q] = 5.0f + 45.0f * unit(random);
+        frusta[q] = Frustum::fromMatrix(projection * glm::lookAt(eye, eye + forward, glm::vec3(0.0f, 1.0f, 0.0f)));
+    }
+
+    SpatialIndex index;
+    const double buildMs = timeRuns(runs, [&]() { index.build(entities.data(), spheres.data(), objects); });
+    const SpatialIndexStats stats = index.getStats();
+    std::printf("Objects: %zu, queries per batch: %zu, runs: %d (median), threads: %d\n", objects, queries, runs, threads);
+    std::printf("Build: %.2f ms, %zu nodes, depth %u\n\n", buildMs, stats.nodes, stats.depth);
+
+    std::vector<RayHit> hits(queries);
+    std::vector<std::vector<Entity>> results;
+    auto rayBatch = [&]() { index.raycast(rays.data(), queries, hits.data()); };
+    auto sphereBatch = [&]() { index.overlapSpheres(centers.data(), radii.data(), queries, results); };
+    auto frustumBatch = [&]() { index.overlapFrusta(frusta.data(), queries, results); };
+
+    // One thread first: no job system is active yet, so the batches run inline
+    const double rayOne = timeRuns(runs, rayBatch);
+    const double sphereOne = timeRuns(runs, sphereBatch);
+    const double frustumOne = timeRuns(runs, frustumBatch);
+
+    // The calling thread helps in parallelFor, so N threads means N - 1 workers
+    JobSystem jobs(threads - 1);
+    jobs.activate();
+    const double rayMany = timeRuns(runs, rayBatch);
+    size_t rayHits = 0;
+    for (const RayHit& hit : hits)
+        rayHits += hit.hit() ? 1 : 0;
+    const double sphereMany = timeRuns(runs, sphereBatch);
+    size_t sphereResults = 0;
+    for (const std::vector<Entity>& found : results)
+        sphereResults += found.size();
+    const double frustumMany = timeRuns(runs, frustumBatch);
+    size_t frustumResults = 0;
+    for (const std::vector<Entity>& found : results)
+        frustumResults += found.size();
+
+    // Linear scans answering the same queries, on one thread
+    volatile size_t sink = 0;
+    const double rayScan = timeRuns(1, [&]() {
+        for (const Ray& ray : rays)
+        {
+            float closest = ray.maxDistance;
+            size_t found = objects;
+            for (size_t i = 0; i < objects; ++i)
+            {
+                const float entry = rayEntry(ray, spheres[i]);
+                if (entry >= 0.0f && entry < closest)
+                {
+                    closest = entry;
+                    found = i;
+                }
+            }
+            sink = sink + found;
+        }
+    });
+    const double sphereScan = timeRuns(1, [&]() {
+        for (size_t q = 0; q < queries; ++q)
+        {
+            size_t found = 0;
+            for (size_t i = 0; i < objects; ++i)
+            {
+                const glm::vec3 offset = glm::vec3(spheres[i]) - centers[q];
+                const float reach = spheres[i].w + radii[q];
+                found += glm::dot(offset, offset) <= reach * reach ? 1 : 0;
+            }
+            sink = sink + found;
+        }
+    });
+    const double frustumScan = timeRuns(1, [&]() {
+        for (const Frustum& frustum : frusta)
+        {
+            size_t found = 0;
+            for (size_t i = 0; i < objects; ++i)
+                found += frustum.intersectsSphere(glm::vec3(spheres[i]), spheres[i].w) ? 1 : 0;
+            sink = sink + found;
+        }
+    });
+
+    std::printf("%-8s %12s %12s %9s %14s %9s %10s\n",
+                "query", "1 thread us", "N threads us", "speedup", "scan us", "vs scan", "results");
+    printRow("ray", queries, rayOne, rayMany, rayScan, static_cast<double>(rayHits) / queries);
+    printRow("sphere", queries, sphereOne, sphereMany, sphereScan, static_cast<double>(sphereResults) / queries);
+    printRow("frustum", queries, frustumOne, frustumMany, frustumScan, static_cast<double>(frustumResults) / queries);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+// TransformKernelsBench.cpp
+//
+// Compares the batch transform kernels against the plain glm path.
+// Usage: transform_kernels_bench [--items N] [--runs N] [--threads N]
+// For the glm baseline and every kernel level the CPU supports, times over --items entities:
+//  - compose: TRS into a world matrix plus its normal matrix
+//               (glm: translate * mat4_cast * scale and transpose(inverse(mat3)))
+//  - spheres: local bounding spheres into world space
+// Each is timed on one thread and split across --threads with the job system (median of --runs).
+// The last column is the largest difference from the scalar kernel, as a correctness check.
+
+#include "job_system.h"
+#include "transform_kernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+
+using TransformKernels::SimdLevel;
+
+double medianMs(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+template <typename Fn>
+double timeRuns(int runs, Fn&& fn)
+{
+    std::vector<double> samples;
+    for (int r = 0; r < runs; ++r)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return medianMs(samples);
+}
+
+float maxDifference(const float* a, const float* b, size_t count)
+{
+    float worst = 0.0f;
+    for (size_t i = 0; i < count; ++i)
+        worst = std::max(worst, std::abs(a[i] - b[i]));
+    return worst;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t items = 1 << 18;
+    int runs = 9;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string option = argv[i];
+        if (option == "--items")
+            items = static_cast<size_t>(std::max(1, std::atoi(argv[i + 1])));
+        else if (option == "--runs")
+            runs = std::max(1, std::atoi(argv[i + 1]));
+        else if (option == "--threads")
+            threads = std::max(1, std::atoi(argv[i + 1]));
+    }
+
+    // Deterministic inputs: unit rotations and non-zero scales, as the transform pool holds
+    std::vector<glm::vec3> positions(items), scales(items), localCenters(items);
+    std::vector<glm::quat> rotations(items);
+    std::vector<float> localRadii(items);
+    std::vector<uint32_t> indices(items);
+    for (size_t i = 0; i < items; ++i)
+    {
+        const float t = static_cast<float>(i);
+        positions[i] = glm::vec3(std::sin(t) * 100.0f, std::cos(t * 0.7f) * 20.0f, std::sin(t * 1.3f) * 100.0f);
+        scales[i] = glm::vec3(0.5f + (i % 5) * 0.25f, 1.0f + (i % 3) * 0.5f, 0.75f + (i % 7) * 0.1f);
+        rotations[i] = glm::normalize(glm::quat(std::cos(t * 0.1f), std::sin(t * 0.2f), std::cos(t * 0.3f), std::sin(t * 0.5f)));
+        localCenters[i] = glm::vec3(0.0f, 0.5f * (i % 4), 0.0f);
+        localRadii[i] = 1.0f + (i % 9);
+        indices[i] = static_cast<uint32_t>(i);
+    }
+    std::vector<glm::mat4> worlds(items), referenceWorlds(items);
+    std::vector<glm::mat3> normals(items), referenceNormals(items);
+    std::vector<glm::vec3> worldCenters(items), referenceCenters(items);
+    std::vector<float> worldRadii(items), referenceRadii(items);
+
+    const TransformKernels::TransformBatch composeBatch{positions.data(), rotations.data(), scales.data(), worlds.data(), normals.data()};
+    const TransformKernels::SphereBatch sphereBatch{worlds.data(), localCenters.data(), localRadii.data(),
+                                                    worldCenters.data(), worldRadii.data()};
+
+    // The calling thread helps in parallelFor, so N threads means N - 1 workers
+    JobSystem jobs(threads - 1);
+    const size_t grain = 4096;
+    auto split = [&](const std::function<void(size_t, size_t)>& range) {
+        jobs.parallelFor(0, items, grain, range);
+    };
+
+    // glm baseline: generic matrix products and a full inverse per entity
+    auto glmCompose = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            worlds[i] = glm::translate(glm::mat4(1.0f), positions[i]) * glm::mat4_cast(rotations[i]) * glm::scale(glm::mat4(1.0f), scales[i]);
+            normals[i] = glm::transpose(glm::inverse(glm::mat3(worlds[i])));
+        }
+    };
+    auto glmSpheres = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const glm::mat4& world = worlds[i];
+            worldCenters[i] = glm::vec3(world * glm::vec4(localCenters[i], 1.0f));
+            worldRadii[i] = localRadii[i] * std::max(glm::length(glm::vec3(world[0])),
+                                                     std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+        }
+    };
+
+    std::printf("Items: %zu, runs: %d (median), threads: %d, detected: %s\n\n", items, runs, threads,
+                TransformKernels::name(TransformKernels::detect()));
+    std::printf("%-8s %12s %8s %12s %8s %12s %8s %12s %8s %10s\n", "path", "compose ms", "speedup", "x threads", "speedup",
+                "spheres ms", "speedup", "x threads", "speedup", "max diff");
+
+    double base[4] = {0.0, 0.0, 0.0, 0.0};
+    auto printRow = [&](const char* label, const double (&times)[4], float difference) {
+        std::printf("%-8s", label);
+        for (int w = 0; w < 4; ++w)
+            std::printf(" %12.3f %7.2fx", times[w], base[w] / times[w]);
+        if (difference < 0.0f)
+            std::printf(" %10s\n", "-");
+        else
+            std::printf(" %10.2e\n", difference);
+    };
+
+    {
+        const double times[4] = {
+            timeRuns(runs, [&]() { glmCompose(0, items); }),
+            timeRuns(runs, [&]() { split(glmCompose); }),
+            timeRuns(runs, [&]() { glmSpheres(0, items); }),
+            timeRuns(runs, [&]() { split(glmSpheres); })};
+        std::copy(times, times + 4, base);
+        printRow("glm", times, -1.0f);
+    }
+
+    const SimdLevel levels[] = {SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512};
+    for (SimdLevel level : levels)
+    {
+        if (level > TransformKernels::detect())
+            break;
+        auto compose = [&](size_t begin, size_t end) {
+            TransformKernels::composeTRS(composeBatch, indices.data() + begin, end - begin, level);
+        };
+        auto spheres = [&](size_t begin, size_t end) {
+            TransformKernels::transformSpheres(sphereBatch, indices.data() + begin, indices.data() + begin, end - begin, level);
+        };
+        const double times[4] = {
+            timeRuns(runs, [&]() { compose(0, items); }),
+            timeRuns(runs, [&]() { split(compose); }),
+            timeRuns(runs, [&]() { spheres(0, items); }),
+            timeRuns(runs, [&]() { split(spheres); })};
+
+        float difference = 0.0f;
+        if (level == SimdLevel::Scalar)
+        {
+            referenceWorlds = worlds;
+            referenceNormals = normals;
+            referenceCenters = worldCenters;
+            referenceRadii = worldRadii;
+        }
+        else
+        {
+            difference = std::max({maxDifference(&worlds[0][0][0], &referenceWorlds[0][0][0], items * 16),
+                                   maxDifference(&normals[0][0][0], &referenceNormals[0][0][0], items * 9),
+                                   maxDifference(&worldCenters[0][0], &referenceCenters[0][0], items * 3),
+                                   maxDifference(worldRadii.data(), referenceRadii.data(), items)});
+        }
+        printRow(TransformKernels::name(level), times, difference);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+// VtTileBuilder.cpp
+//
+// Slices a large terrain image into virtual texture page tiles.
+// Usage: vt_tile_builder <source image> <output dir> [--page N] [--border N]
+// Writes <output dir>/<level>/<x>_<y>.tga for every mip level down to a single page,
+// each page padded with a border of neighbouring texels for bilinear filtering, and the
+// <output dir>/terrain.vt descriptor read by VirtualTexture::open.
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "mip_builder.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Uncompressed 32-bit TGA, top-left origin; stb_image reads it back without a flip
+static bool writeTga(const fs::path& path, const std::vector<unsigned char>& rgba, int size)
+{
+    unsigned char header[18] = {};
+    header[2] = 2;
+    header[12] = static_cast<unsigned char>(size & 0xFF);
+    header[13] = static_cast<unsigned char>(size >> 8);
+    header[14] = static_cast<unsigned char>(size & 0xFF);
+    header[15] = static_cast<unsigned char>(size >> 8);
+    header[16] = 32;
+    header[17] = 0x28;
+
+    std::vector<unsigned char> bgra(rgba.size());
+    for (size_t i = 0; i < rgba.size(); i += 4)
+    {
+        bgra[i + 0] = rgba[i + 2];
+        bgra[i + 1] = rgba[i + 1];
+        bgra[i + 2] = rgba[i + 0];
+        bgra[i + 3] = rgba[i + 3];
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(bgra.data()), static_cast<std::streamsize>(bgra.size()));
+    return static_cast<bool>(file);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: vt_tile_builder <source image> <output dir> [--page N] [--border N]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::string source = argv[1];
+    const fs::path output = argv[2];
+    int pageSize = 128;
+    int border = 4;
+    for (int i = 3; i + 1 < argc; i += 2)
+    {
+        const std::string option = argv[i];
+        if (option == "--page")
+            pageSize = std::stoi(argv[i + 1]);
+        else if (option == "--border")
+            border = std::stoi(argv[i + 1]);
+    }
+
+    int width = 0, height = 0, channels = 0;
+    unsigned char* pixels = stbi_load(source.c_str(), &width, &height, &channels, 4);
+    if (!pixels)
+    {
+        std::cerr << "Failed to load " << source << ": " << stbi_failure_reason() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const int pagesPerSide = pageSize > 0 ? width / pageSize : 0;
+    if (width != height || pageSize <= 0 || border < 0 || width % pageSize != 0
+        || pagesPerSide == 0 || (pagesPerSide & (pagesPerSide - 1)) != 0)
+    {
+        std::cerr << "Source must be square with a power-of-two number of " << pageSize << "px pages, got "
+                  << width << "x" << height << std::endl;
+        stbi_image_free(pixels);
+        return EXIT_FAILURE;
+    }
+
+    MipChain chain = MipBuilder::build(pixels, width, height, 4, false, MipFilterMode::SRGB);
+    stbi_image_free(pixels);
+
+    const int slotSize = pageSize + 2 * border;
+    std::vector<unsigned char> tile(static_cast<size_t>(slotSize) * slotSize * 4);
+    size_t written = 0;
+    int levels = 0;
+
+    for (int level = 0; (width >> level) >= pageSize; ++level, ++levels)
+    {
+        const MipChain::Level& mip = chain.levels[level];
+        const int pages = mip.width / pageSize;
+        const fs::path levelDir = output / std::to_string(level);
+        fs::create_directories(levelDir);
+
+        for (int py = 0; py < pages; ++py)
+        {
+            for (int px = 0; px < pages; ++px)
+            {
+                // Border texels come from the neighbouring pages, clamped at the world edge
+                for (int y = 0; y < slotSize; ++y)
+                {
+                    int sy = std::clamp(py * pageSize - border + y, 0, mip.height - 1);
+                    for (int x = 0; x < slotSize; ++x)
+                    {
+                        int sx = std::clamp(px * pageSize - border + x, 0, mip.width - 1);
+                        const unsigned char* src = &mip.bytes[(static_cast<size_t>(sy) * mip.width + sx) * 4];
+                        std::copy(src, src + 4, &tile[(static_cast<size_t>(y) * slotSize + x) * 4]);
+                    }
+                }
+
+                const fs::path path = levelDir / (std::to_string(px) + "_" + std::to_string(py) + ".tga");
+                if (!writeTga(path, tile, slotSize))
+                {
+                    std::cerr << "Failed to write " << path << std::endl;
+                    return EXIT_FAILURE;
+                }
+                ++written;
+            }
+        }
+    }
+
+    std::ofstream descriptor(output / "terrain.vt");
+    descriptor << "size " << width << "\n"
+               << "page " << pageSize << "\n"
+               << "border " << border << "\n";
+    if (!descriptor)
+    {
+        std::cerr << "Failed to write " << (output / "terrain.vt") << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Wrote " << written << " tiles in " << levels << " levels to " << output << std::endl;
+    return EXIT_SUCCESS;
+}